@@ -50,3 +50,54 @@
 // Quil Server
 #define QUIL_SERVER_URL "wss://myquilbot-f12yc2ys80pc.deno.dev/ws"
 
+// Ask the server for IMA-ADPCM (4:1) mic uplink; falls back to PCM16 if
+// the server does not acknowledge it
+#define QUIL_UPLINK_ADPCM 1
+
+// Ask the server for MP3 response audio, decoded on-device; falls back to
+// PCM16 if the server does not acknowledge it
+#define QUIL_DOWNLINK_MP3 1
+
+
+// Drop silent mic frames (VAD-gated discontinuous transmission); silence is
+// replaced by small comfort-noise markers once the server acknowledges it
+#define QUIL_UPLINK_DTX 1
+
+// Spectral noise suppression on the mic uplink (default; can be switched at
+// runtime through /api/config {"ns":true|false})
+#define QUIL_NOISE_SUPPRESSION 1
+
+// Mic AGC target: speech RMS in dB below full scale
+#define QUIL_AGC_TARGET_DBFS 20
+
+// Rate the server exchanges audio at (its auth reply may override). The mic
+// and speaker run at I2S_SAMPLE_RATE_MIC/SPEAKER and are resampled to it.
+#define QUIL_SESSION_SAMPLE_RATE 24000
+
+// Stages of the mic (DC blocker, 80 Hz high-pass, pre-emphasis) and speaker
+// (high-pass, presence EQ, volume, limiter) DSP chains to skip, bit N =
+// stage N; /api/config {"micBypass":n,"spkBypass":n} changes them at runtime
+#define QUIL_MIC_DSP_BYPASS (1 << 2)
+#define QUIL_SPEAKER_DSP_BYPASS 0
+
+// Mic audio kept from before wake and while the server connects (ADPCM,
+// ~13 kB per second at 24 kHz); sent ahead of the live stream. 0 disables.
+#define QUIL_PREROLL_MS 1500
+
+// When the server socket is open (ConnectionPolicy_t in types.h); stored in
+// NVS by /api/config {"connPolicy":0|1|2}. On-demand frees the ~40 kB a TLS
+// session holds between conversations, always-connected takes the handshake
+// off the time to first audio.
+#define QUIL_CONNECTION_POLICY CONN_POLICY_ON_DEMAND
+
+// Ask the server for binary framing (core/h/WireProtocol.h): sequence
+// numbers and timestamps on every audio message, binary control opcodes.
+// Falls back to bare audio and JSON control if not acknowledged.
+#define QUIL_BINARY_FRAMING 1
+
+// I2S DMA profile (I2SDmaProfile_t in hal/h/I2S.h) per mode: long buffers
+// keep interrupts down on the clock face, short ones take latency out of
+// conversations. /api/config {"dmaClock":n,"dmaConversation":n} changes them
+// until reboot, from the next mode change.
+#define QUIL_DMA_PROFILE_CLOCK I2S_DMA_ROBUST
+#define QUIL_DMA_PROFILE_CONVERSATION I2S_DMA_BALANCED
@@ -28,3 +28,10 @@ typedef enum {
   THEME_DEFAULT,   // Elaborate theme with date bars
   THEME_COMPACT    // Simple compact theme
 } DisplayTheme_t;
+
+typedef enum {
+  CONN_POLICY_ON_DEMAND,     // Connect on wake, disconnect after each conversation
+  CONN_POLICY_EARLY_ENERGY,  // Connect when the mic level crosses a pre-threshold
+  CONN_POLICY_ALWAYS,        // Stay connected between conversations
+  CONN_POLICY_COUNT
+} ConnectionPolicy_t;
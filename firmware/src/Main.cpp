@@ -12,6 +12,8 @@
 #include "modules/WebPortal.h"
 #include "modules/Input.h"
 #include "modules/Audio.h"
+#include "modules/AudioCapture.h"
+#include "modules/LatencyTrace.h"
 #include "modules/AnimationManager.h"
 #include "modules/BatteryManager.h"
 #include "modules/ConversationManager.h"
@@ -22,6 +24,40 @@
 // Global flag for first boot mode
 static bool g_isFirstBoot = false;
 
+// Early-energy connections not followed by a wake are closed after this
+static const unsigned long EARLY_CONNECT_HOLD_MS = 15000;
+static unsigned long g_earlyEnergyTime = 0;
+
+// Clock mode: open or close the server socket ahead of wake per the policy
+static void ConnectionPolicyUpdate(bool earlyEnergy) {
+  ConnectionPolicy_t policy = RealtimeVoiceGetConnectionPolicy();
+  bool started = RealtimeVoiceIsStarted();
+  
+  if (policy == CONN_POLICY_ALWAYS) {
+    if (!started && WifiIsConnected()) {
+      RealtimeVoiceConnect(QUIL_SERVER_URL);
+    }
+  } else if (policy == CONN_POLICY_EARLY_ENERGY) {
+    if (earlyEnergy) {
+      if (!started && WifiIsConnected()) {
+        Serial.println("[Main] Early energy - warming up server connection");
+        RealtimeVoiceConnect(QUIL_SERVER_URL);
+      }
+      g_earlyEnergyTime = millis();
+    } else if (started && millis() - g_earlyEnergyTime > EARLY_CONNECT_HOLD_MS) {
+      Serial.println("[Main] No wake after early energy - closing connection");
+      RealtimeVoiceDisconnect();
+    }
+  } else if (started) {
+    // Policy changed to on-demand while idle
+    RealtimeVoiceDisconnect();
+  }
+  
+  if (RealtimeVoiceIsStarted()) {
+    RealtimeVoiceLoop();
+  }
+}
+
 void setup() {
   Serial.begin(115200);
   delay(100);
@@ -184,6 +220,11 @@ void loop() {
   // Animation playback
   if (AnimIsPlaying()) {
     AnimUpdate();
+    // The conversation animation loops; keep the socket and the mic
+    // pre-roll moving underneath it
+    if (mode == MODE_CONVERSATION) {
+      RealtimeVoiceLoop();
+    }
     delay(10);
     return;
   }
@@ -203,7 +244,9 @@ void loop() {
     // Check timeout - return to clock
     if (ConversationTimedOut()) {
       RealtimeVoiceStopListening();
-      RealtimeVoiceDisconnect();  // Free WebSocket memory
+      if (RealtimeVoiceGetConnectionPolicy() != CONN_POLICY_ALWAYS) {
+        RealtimeVoiceDisconnect();  // Free WebSocket memory
+      }
       ConversationEnd();
       StateSetMode(MODE_CLOCK);
       AudioStartListening();  // Resume wake detection
@@ -217,24 +260,31 @@ void loop() {
       AudioStartListening();
     }
     
-    // Read mic to update RMS for wake detection
-    uint8_t audio[256];
-    size_t len = AudioReadBuffer(audio, sizeof(audio));
-    (void)len; // We just need to update the internal RMS
-    
-    // Check for wake (voice activity)
-    if (WakeDetect()) {
-      Serial.println("[Main] Wake detected - starting conversation");
-      Serial.printf("[Main] Free heap: %d bytes\n", ESP.getFreeHeap());
-      
-      StateSetMode(MODE_CONVERSATION);
-      ConversationStart();
-      
-      // Connect to server if not connected
-      if (!RealtimeVoiceIsConnected()) {
-        RealtimeVoiceConnect(QUIL_SERVER_URL);
+    // Run wake detection over every frame captured since the last pass
+    static int16_t audio[AUDIO_FRAME_SAMPLES];
+    bool earlyEnergy = false;
+    while (AudioReadBuffer((uint8_t*)audio, sizeof(audio)) > 0) {
+      // Check for wake (voice activity)
+      if (WakeDetect()) {
+        LatencyTraceBegin();
+        Serial.println("[Main] Wake detected - starting conversation");
+        Serial.printf("[Main] Free heap: %d bytes\n", ESP.getFreeHeap());
+        
+        StateSetMode(MODE_CONVERSATION);
+        ConversationStart();
+        
+        // Connect to server unless the policy already has
+        if (!RealtimeVoiceIsStarted()) {
+          RealtimeVoiceConnect(QUIL_SERVER_URL);
+        }
+        RealtimeVoiceStartListening();
+        break;
       }
-      RealtimeVoiceStartListening();
+      earlyEnergy = earlyEnergy || WakeEarlyEnergy();
+    }
+    
+    if (StateGetMode() == MODE_CLOCK) {
+      ConnectionPolicyUpdate(earlyEnergy);
     }
     
     TimeUpdate();
@@ -0,0 +1,132 @@
+#include "../h/WireProtocol.h"
+
+void WirePutU32(uint8_t* Out, uint32_t Value) {
+  Out[0] = (uint8_t)Value;
+  Out[1] = (uint8_t)(Value >> 8);
+  Out[2] = (uint8_t)(Value >> 16);
+  Out[3] = (uint8_t)(Value >> 24);
+}
+
+uint32_t WireGetU32(const uint8_t* In) {
+  return (uint32_t)In[0] | ((uint32_t)In[1] << 8) | ((uint32_t)In[2] << 16) | ((uint32_t)In[3] << 24);
+}
+
+size_t WireWriteHeader(const WireHeader_t* Header, uint8_t* Out) {
+  Out[0] = Header->Type;
+  Out[1] = Header->Codec;
+  Out[2] = Header->Flags;
+  Out[3] = WIRE_VERSION;
+  WirePutU32(Out + 4, Header->Seq);
+  WirePutU32(Out + 8, Header->TimestampUs);
+  return WIRE_HEADER_BYTES;
+}
+
+// Payload size rule per type: exact size, or -1 for "any"
+static int PayloadRule(uint8_t Type, bool* Known) {
+  *Known = true;
+  switch (Type) {
+    case WIRE_AUDIO: return -1;
+    case WIRE_COMFORT_NOISE: return 1;
+    case WIRE_END_OF_SPEECH:
+    case WIRE_PING:
+    case WIRE_INTERRUPT:
+    case WIRE_PONG:
+    case WIRE_RESPONSE_COMPLETE:
+    case WIRE_AUDIO_COMMITTED: return 0;
+    case WIRE_PREROLL_START:
+    case WIRE_PREROLL_END: return 4;
+    case WIRE_ERROR: return -1;
+    default:
+      *Known = false;
+      return 0;
+  }
+}
+
+bool WireParse(const uint8_t* Data, size_t Length, WireHeader_t* Header,
+               const uint8_t** Payload, size_t* PayloadBytes) {
+  if (!Data || Length < WIRE_HEADER_BYTES) return false;
+  if (Data[3] != WIRE_VERSION) return false;
+
+  bool Known;
+  int Rule = PayloadRule(Data[0], &Known);
+  if (!Known) return false;
+  size_t Bytes = Length - WIRE_HEADER_BYTES;
+  if (Rule >= 0 && Bytes != (size_t)Rule) return false;
+
+  uint8_t Codec = Data[1];
+  if (Data[0] == WIRE_AUDIO) {
+    if (Codec < WIRE_CODEC_PCM16 || Codec > WIRE_CODEC_MP3 || Bytes == 0) return false;
+    if (Codec == WIRE_CODEC_PCM16 && Bytes % 2 != 0) return false;
+  } else if (Codec != WIRE_CODEC_NONE) {
+    return false;
+  }
+
+  Header->Type = Data[0];
+  Header->Codec = Codec;
+  Header->Flags = Data[2];
+  Header->Seq = WireGetU32(Data + 4);
+  Header->TimestampUs = WireGetU32(Data + 8);
+  *Payload = Data + WIRE_HEADER_BYTES;
+  *PayloadBytes = Bytes;
+  return true;
+}
+
+static const uint32_t JITTER_CLAMP_US = 10000000;
+
+void WireRxReset(WireRxStats_t* Stats) {
+  Stats->Started = false;
+  Stats->NextSeq = 0;
+  Stats->Seen = 0;
+  Stats->Received = 0;
+  Stats->Lost = 0;
+  Stats->Late = 0;
+  Stats->Duplicates = 0;
+  Stats->LastTimestampUs = 0;
+  Stats->LastArrivalUs = 0;
+  Stats->JitterUs16 = 0;
+}
+
+void WireRxTrack(WireRxStats_t* Stats, const WireHeader_t* Header, uint32_t ArrivalUs) {
+  if (!Stats->Started) {
+    Stats->Started = true;
+    Stats->Seen = 1;
+  } else {
+    int32_t Ahead = (int32_t)(Header->Seq - Stats->NextSeq);
+    if (Ahead < 0) {
+      uint32_t Back = (uint32_t)(-(Ahead + 1));  // Behind the newest
+      if (Back >= WIRE_RX_WINDOW) {
+        // Too old to tell from a repeat: late, but Lost is left alone
+        Stats->Received++;
+        Stats->Late++;
+        return;
+      }
+      uint32_t Bit = (uint32_t)1 << Back;
+      if (Stats->Seen & Bit) {
+        Stats->Duplicates++;
+        return;
+      }
+      // Counted as lost when it was skipped; it turned up after all
+      Stats->Seen |= Bit;
+      Stats->Received++;
+      Stats->Late++;
+      if (Stats->Lost > 0) Stats->Lost--;
+      return;
+    }
+    Stats->Lost += (uint32_t)Ahead;
+    Stats->Seen = (uint32_t)Ahead + 1 >= WIRE_RX_WINDOW ? 1 : (Stats->Seen << (Ahead + 1)) | 1;
+
+    // RFC 3550: J += (|D| - J) / 16, D = arrival spacing - send spacing
+    int32_t D = (int32_t)((ArrivalUs - Stats->LastArrivalUs) - (Header->TimestampUs - Stats->LastTimestampUs));
+    uint32_t Magnitude = D < 0 ? (uint32_t)-(int64_t)D : (uint32_t)D;
+    if (Magnitude > JITTER_CLAMP_US) Magnitude = JITTER_CLAMP_US;  // Clock jumps, long stalls
+    Stats->JitterUs16 += Magnitude - ((Stats->JitterUs16 + 8) >> 4);
+  }
+  Stats->Received++;
+  Stats->NextSeq = Header->Seq + 1;
+  Stats->LastTimestampUs = Header->TimestampUs;
+  Stats->LastArrivalUs = ArrivalUs;
+}
+
+uint32_t WireRxJitterUs(const WireRxStats_t* Stats) {
+  return Stats->JitterUs16 >> 4;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Wire Protocol ---
+// Binary framing for the realtime voice socket, used in both directions
+// once the server echoes "framing":"quil1" in its auth reply (JSON text
+// messages and bare audio stay the fallback). Every binary WebSocket
+// message starts with a 12-byte little-endian header:
+//   uint8  Type       WireType_t
+//   uint8  Codec      WireCodec_t (audio), 0 otherwise
+//   uint8  Flags      WIRE_FLAG_*
+//   uint8  Version    WIRE_VERSION
+//   uint32 Seq        +1 per message sent in this direction, any type
+//   uint32 Timestamp  Microseconds, wrapping: capture time of the first
+//                     sample for uplink audio, send time otherwise
+// followed by the payload. Pure C++ so it builds on the host.
+
+#define WIRE_HEADER_BYTES 12
+#define WIRE_VERSION 1
+#define WIRE_FRAMING_NAME "quil1"
+
+typedef enum {
+  // Media
+  WIRE_AUDIO = 0x01,             // Codec payload
+  WIRE_COMFORT_NOISE = 0x02,     // uint8 noise level, dB below full scale
+  // Device -> server control
+  WIRE_END_OF_SPEECH = 0x10,
+  WIRE_PING = 0x11,
+  WIRE_INTERRUPT = 0x12,
+  WIRE_PREROLL_START = 0x13,     // uint32 frames that follow
+  WIRE_PREROLL_END = 0x14,       // uint32 frames sent
+  // Server -> device control
+  WIRE_PONG = 0x20,
+  WIRE_RESPONSE_COMPLETE = 0x21,
+  WIRE_AUDIO_COMMITTED = 0x22,
+  WIRE_ERROR = 0x2F              // UTF-8 message
+} WireType_t;
+
+typedef enum {
+  WIRE_CODEC_NONE = 0,
+  WIRE_CODEC_PCM16 = 1,
+  WIRE_CODEC_IMA_ADPCM = 2,
+  WIRE_CODEC_MP3 = 3
+} WireCodec_t;
+
+#define WIRE_FLAG_PREROLL 0x01        // Buffered audio from before the stream
+#define WIRE_FLAG_DISCONTINUITY 0x02  // First audio after a gap (DTX, reset)
+#define WIRE_FLAG_END 0x04            // Last audio of a response
+
+typedef struct {
+  uint8_t Type;
+  uint8_t Codec;
+  uint8_t Flags;
+  uint32_t Seq;
+  uint32_t TimestampUs;
+} WireHeader_t;
+
+// Serialise Header into Out (WIRE_HEADER_BYTES); returns WIRE_HEADER_BYTES
+size_t WireWriteHeader(const WireHeader_t* Header, uint8_t* Out);
+
+// Validate and split one message. False for anything malformed: short,
+// wrong version, unknown type or codec, or a payload of the wrong size for
+// its type. Payload points into Data.
+bool WireParse(const uint8_t* Data, size_t Length, WireHeader_t* Header,
+               const uint8_t** Payload, size_t* PayloadBytes);
+
+// Little-endian payload helpers
+void WirePutU32(uint8_t* Out, uint32_t Value);
+uint32_t WireGetU32(const uint8_t* In);
+
+// Receive-side sequence and timing statistics. A bitmap of the last
+// WIRE_RX_WINDOW sequence numbers tells a late message from a repeat, so
+// only skipped ones that turn up after all come off Lost.
+#define WIRE_RX_WINDOW 32
+
+typedef struct {
+  bool Started;
+  uint32_t NextSeq;
+  uint32_t Seen;           // Bit N: NextSeq - 1 - N arrived
+  uint32_t Received;       // Distinct messages
+  uint32_t Lost;           // Skipped sequence numbers still missing
+  uint32_t Late;           // Arrived after a later message
+  uint32_t Duplicates;     // Arrived again
+  uint32_t LastTimestampUs;
+  uint32_t LastArrivalUs;
+  uint32_t JitterUs16;     // RFC 3550 interarrival jitter, x16
+} WireRxStats_t;
+
+void WireRxReset(WireRxStats_t* Stats);
+void WireRxTrack(WireRxStats_t* Stats, const WireHeader_t* Header, uint32_t ArrivalUs);
+uint32_t WireRxJitterUs(const WireRxStats_t* Stats);
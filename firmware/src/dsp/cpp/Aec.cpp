@@ -0,0 +1,394 @@
+#include "../h/Aec.h"
+#include "../h/AudioKernels.h"
+#include "../h/Fft.h"
+#include <string.h>
+
+static const int32_t STEP_Q15 = 8192;                  // Per-bin NLMS step 0.25
+static const uint64_t BIN_POWER_DELTA = (uint64_t)AEC_FFT_SIZE * 32 * 32;  // Regularization, reference RMS 32
+static const uint32_t FAR_MIN_ENERGY = 100 * 100;      // Mean square for "speaker playing"
+static const uint32_t CONVERGED_RATIO = 8;             // ~9 dB ERLE
+static const uint32_t DIVERGED_RATIO = 2;              // ~3 dB ERLE
+static const int32_t DOUBLE_TALK_LOG2 = 2 << 10;       // Residual 6 dB above the expected level
+static const int32_t EXPECTED_ERLE_MAX_LOG2 = 6 << 10; // Expect at most 18 dB of cancellation
+static const int SHORT_SHIFT = 4;                      // Double-talk energy averaging (~21 ms)
+static const int SLOW_SHIFT = 6;                       // Near-end speech energy averaging (~85 ms)
+static const uint16_t DOUBLE_TALK_HOLD_BLOCKS = 75;    // 100 ms hangover
+static const uint16_t DOUBLE_TALK_RESET_BLOCKS = 750;  // 1 s of "double talk" = echo path change
+static const int32_t ERROR_LIMIT_RATIO = 4;            // Update error clip, x residual RMS
+static const int32_t WEIGHT_LIMIT = 1 << 29;           // |W| < 32
+static const int64_t UPDATE_LIMIT = 1 << 22;           // Per-block weight change < 0.25
+static const uint16_t DELAY_WINDOW = 1536;             // Decimated samples per delay decision (0.5 s at 24 kHz)
+static const int64_t DELAY_PEAK_RATIO = 4;             // Correlation peak over its mean magnitude
+static const int32_t DELAY_PRE_SAMPLES = 2 * AEC_BLOCK;  // Filter start ahead of the peak
+
+void AecInit(Aec_t* Aec) {
+  DspFftInit();
+  memset(Aec, 0, sizeof(*Aec));
+  Aec->Candidate = -1;
+}
+
+void AecResetHistory(Aec_t* Aec) {
+  memset(Aec->Reference, 0, sizeof(Aec->Reference));
+  memset(Aec->SpectrumRe, 0, sizeof(Aec->SpectrumRe));
+  memset(Aec->SpectrumIm, 0, sizeof(Aec->SpectrumIm));
+  memset(Aec->SpectrumExp, 0, sizeof(Aec->SpectrumExp));
+  memset(Aec->BinPower, 0, sizeof(Aec->BinPower));
+  Aec->DecimateRef = 0;
+  Aec->DecimateMic = 0;
+  Aec->DecimateFill = 0;
+  memset(Aec->DecimatedRef, 0, sizeof(Aec->DecimatedRef));
+  Aec->WindowFill = 0;
+  Aec->WindowRefEnergy = 0;
+  memset(Aec->Correlation, 0, sizeof(Aec->Correlation));
+  memset(Aec->Smoothed, 0, sizeof(Aec->Smoothed));
+  Aec->Candidate = -1;
+}
+
+// Value * 2^Shift, rounded
+static inline int64_t Scale(int64_t Value, int Shift) {
+  if (Shift >= 0) return Value * ((int64_t)1 << Shift);
+  if (Shift <= -63) return 0;
+  return (Value + ((int64_t)1 << (-Shift - 1))) >> -Shift;
+}
+
+static inline int32_t Clamp32(int64_t Value, int64_t Limit) {
+  return (int32_t)(Value > Limit ? Limit : (Value < -Limit ? -Limit : Value));
+}
+
+// Move partition Age to Age - Shift (positive Shift: the filter starts
+// later); partitions shifted in are empty
+static void ShiftPartitions(Aec_t* Aec, int Shift) {
+  for (int I = 0; I < AEC_PARTITIONS; I++) {
+    int Age = Shift > 0 ? I : AEC_PARTITIONS - 1 - I;
+    int From = Age + Shift;
+    bool Keep = From >= 0 && From < AEC_PARTITIONS;
+    int Slot = (Aec->Newest + Age) % AEC_PARTITIONS;
+    int FromSlot = Keep ? (Aec->Newest + From) % AEC_PARTITIONS : 0;
+    if (Keep) {
+      memcpy(Aec->WeightRe[Age], Aec->WeightRe[From], sizeof(Aec->WeightRe[0]));
+      memcpy(Aec->WeightIm[Age], Aec->WeightIm[From], sizeof(Aec->WeightIm[0]));
+      memcpy(Aec->SpectrumRe[Slot], Aec->SpectrumRe[FromSlot], sizeof(Aec->SpectrumRe[0]));
+      memcpy(Aec->SpectrumIm[Slot], Aec->SpectrumIm[FromSlot], sizeof(Aec->SpectrumIm[0]));
+      Aec->SpectrumExp[Slot] = Aec->SpectrumExp[FromSlot];
+    } else {
+      memset(Aec->WeightRe[Age], 0, sizeof(Aec->WeightRe[0]));
+      memset(Aec->WeightIm[Age], 0, sizeof(Aec->WeightIm[0]));
+      memset(Aec->SpectrumRe[Slot], 0, sizeof(Aec->SpectrumRe[0]));
+      memset(Aec->SpectrumIm[Slot], 0, sizeof(Aec->SpectrumIm[0]));
+      Aec->SpectrumExp[Slot] = 0;
+    }
+  }
+}
+
+// A window of correlation is complete: when its peak stands out and agrees
+// with the previous window's, start the filter just ahead of it
+static void DecideDelay(Aec_t* Aec) {
+  bool Far = Aec->WindowRefEnergy / DELAY_WINDOW >= FAR_MIN_ENERGY / 4;
+  if (Far) {
+    for (int K = 0; K < AEC_LAGS; K++) {
+      Aec->Smoothed[K] += Aec->Correlation[K] - Aec->Smoothed[K] / 4;
+    }
+  }
+  memset(Aec->Correlation, 0, sizeof(Aec->Correlation));
+  Aec->WindowFill = 0;
+  Aec->WindowRefEnergy = 0;
+  if (!Far) return;
+
+  // The echo may come back inverted, so look at magnitudes
+  int64_t Peak = 0, Sum = 0;
+  int Lag = 0;
+  for (int K = 0; K < AEC_LAGS; K++) {
+    int64_t M = Aec->Smoothed[K] < 0 ? -Aec->Smoothed[K] : Aec->Smoothed[K];
+    Sum += M;
+    if (M > Peak) {
+      Peak = M;
+      Lag = K;
+    }
+  }
+  if (Peak == 0 || Peak / DELAY_PEAK_RATIO < Sum / AEC_LAGS) {
+    Aec->Candidate = -1;
+    return;
+  }
+  bool Agrees = Aec->Candidate >= 0 && Lag - Aec->Candidate <= 1 && Aec->Candidate - Lag <= 1;
+  Aec->Candidate = (int16_t)Lag;
+  if (!Agrees) return;
+
+  int32_t Target = Lag * AEC_DECIMATION - DELAY_PRE_SAMPLES;
+  if (Target < 0) Target = 0;
+  Target -= Target % AEC_BLOCK;
+  if (Target != Aec->Delay) {
+    ShiftPartitions(Aec, (Target - (int32_t)Aec->Delay) / AEC_BLOCK);
+    Aec->Delay = (uint16_t)Target;
+  }
+  Aec->DelayValid = true;
+}
+
+// Correlate AEC_DECIMATION-sample averages of the mic with those of the
+// reference at every lag up to AEC_DELAY_MAX
+static void DSP_HOT SearchDelay(Aec_t* Aec, const int16_t* Ref, const int16_t* Mic) {
+  for (size_t N = 0; N < AEC_BLOCK; N++) {
+    Aec->DecimateRef += Ref[N];
+    Aec->DecimateMic += Mic[N];
+    if (++Aec->DecimateFill < AEC_DECIMATION) continue;
+    int32_t R = Aec->DecimateRef / AEC_DECIMATION;
+    int32_t M = Aec->DecimateMic / AEC_DECIMATION;
+    Aec->DecimateRef = 0;
+    Aec->DecimateMic = 0;
+    Aec->DecimateFill = 0;
+
+    uint16_t Pos = (uint16_t)((Aec->DecimatedPos + 1) % AEC_LAGS);
+    Aec->DecimatedPos = Pos;
+    Aec->DecimatedRef[Pos] = (int16_t)R;
+    Aec->WindowRefEnergy += (uint64_t)(R * R);
+    // Lag K pairs the mic with the reference K steps back in the ring
+    const int16_t* History = Aec->DecimatedRef;
+    int64_t* Corr = Aec->Correlation;
+    for (int K = 0; K <= Pos; K++) Corr[K] += M * History[Pos - K];
+    for (int K = Pos + 1; K < AEC_LAGS; K++) Corr[K] += M * History[AEC_LAGS + Pos - K];
+
+    if (++Aec->WindowFill >= DELAY_WINDOW) DecideDelay(Aec);
+  }
+}
+
+// Constrain one partition back to AEC_BLOCK taps, as a linear (not
+// circular) convolution needs. Doing one per block keeps the cost low.
+static void ConstrainPartition(Aec_t* Aec, int Partition) {
+  int32_t Re[AEC_FFT_SIZE], Im[AEC_FFT_SIZE];
+  int32_t* Wr = Aec->WeightRe[Partition];
+  int32_t* Wi = Aec->WeightIm[Partition];
+  for (int K = 0; K < AEC_BINS; K++) {
+    Re[K] = Wr[K];
+    Im[K] = Wi[K];
+  }
+  for (int K = AEC_BINS; K < AEC_FFT_SIZE; K++) {
+    Re[K] = Wr[AEC_FFT_SIZE - K];
+    Im[K] = -Wi[AEC_FFT_SIZE - K];
+  }
+  DspFftQ31(Re, Im, AEC_FFT_LOG2, true);
+  for (int N = 0; N < AEC_FFT_SIZE; N++) {
+    if (N >= AEC_BLOCK) Re[N] = 0;
+    Im[N] = 0;
+  }
+  DspFftQ31(Re, Im, AEC_FFT_LOG2, false);
+  for (int K = 0; K < AEC_BINS; K++) {
+    Wr[K] = Clamp32(Re[K], WEIGHT_LIMIT);
+    Wi[K] = Clamp32(Im[K], WEIGHT_LIMIT);
+  }
+}
+
+// Near-end speech shows up as residual well above what the converged
+// filter leaves of the mic energy, and above the residual it usually
+// leaves at all: echo onsets start near the noise floor, where nothing is
+// cancelled. Blocks are too short to judge alone, so Mic and Residual are
+// energies averaged over several.
+static bool ResidualUnexplained(const Aec_t* Aec, uint64_t Mic, uint64_t Residual) {
+  if (!Aec->FarActive || !Aec->Converged || Mic == 0) return false;
+  int32_t Floor = DspLog2Q10(Aec->SmoothedResidual);
+  int32_t Erle = DspLog2Q10(Aec->SmoothedMic) - Floor;
+  if (Erle > EXPECTED_ERLE_MAX_LOG2) Erle = EXPECTED_ERLE_MAX_LOG2;
+  int32_t Expected = DspLog2Q10(Mic) - Erle;
+  if (Expected < Floor) Expected = Floor;
+  return DspLog2Q10(Residual) > Expected + DOUBLE_TALK_LOG2;
+}
+
+static void DSP_HOT ProcessBlock(Aec_t* Aec, const int16_t* Ref, int16_t* Mic) {
+  SearchDelay(Aec, Ref, Mic);
+
+  // Store the block, then transform the two blocks ending Delay samples
+  // before it (overlap-save)
+  size_t Pos = Aec->Head;
+  for (size_t N = 0; N < AEC_BLOCK; N++) {
+    Aec->Reference[Pos] = Ref[N];
+    if (++Pos == AEC_HISTORY) Pos = 0;
+  }
+  Aec->Head = (uint16_t)Pos;
+
+  int16_t Re[AEC_FFT_SIZE], Im[AEC_FFT_SIZE];
+  uint64_t RefEnergy = 0;
+  Pos = (Pos + 2 * AEC_HISTORY - Aec->Delay - AEC_FFT_SIZE) % AEC_HISTORY;
+  for (size_t N = 0; N < AEC_FFT_SIZE; N++) {
+    Re[N] = Aec->Reference[Pos];
+    Im[N] = 0;
+    if (N >= AEC_BLOCK) RefEnergy += (uint32_t)(Re[N] * Re[N]);
+    if (++Pos == AEC_HISTORY) Pos = 0;
+  }
+  int Shift = DspNormalizeQ15(Re, AEC_FFT_SIZE);
+  int Exponent = DspFftQ15(Re, Im, AEC_FFT_LOG2) - Shift;
+
+  Aec->Newest = (uint8_t)((Aec->Newest + AEC_PARTITIONS - 1) % AEC_PARTITIONS);
+  Aec->SpectrumExp[Aec->Newest] = (int8_t)Exponent;
+  int16_t* Xr = Aec->SpectrumRe[Aec->Newest];
+  int16_t* Xi = Aec->SpectrumIm[Aec->Newest];
+  for (int K = 0; K < AEC_BINS; K++) {
+    Xr[K] = Re[K];
+    Xi[K] = Im[K];
+    int64_t Power = Scale((int64_t)Re[K] * Re[K] + (int64_t)Im[K] * Im[K], 2 * Exponent);
+    Aec->BinPower[K] += Power - (int64_t)Aec->BinPower[K] / AEC_PARTITIONS;
+  }
+
+  // Echo spectrum: sum over partitions of weights x reference spectra,
+  // in true units x 2^24
+  int64_t Yr[AEC_BINS], Yi[AEC_BINS];
+  memset(Yr, 0, sizeof(Yr));
+  memset(Yi, 0, sizeof(Yi));
+  for (int P = 0; P < AEC_PARTITIONS; P++) {
+    int Slot = (Aec->Newest + P) % AEC_PARTITIONS;
+    const int16_t* Sr = Aec->SpectrumRe[Slot];
+    const int16_t* Si = Aec->SpectrumIm[Slot];
+    const int32_t* Wr = Aec->WeightRe[P];
+    const int32_t* Wi = Aec->WeightIm[P];
+    int Exp = Aec->SpectrumExp[Slot];
+    for (int K = 0; K < AEC_BINS; K++) {
+      int64_t R = (int64_t)Wr[K] * Sr[K] - (int64_t)Wi[K] * Si[K];
+      int64_t I = (int64_t)Wr[K] * Si[K] + (int64_t)Wi[K] * Sr[K];
+      Yr[K] += Scale(R, Exp);
+      Yi[K] += Scale(I, Exp);
+    }
+  }
+
+  // Back to the time domain as conj(FFT(conj(Y))) / N, with the spectrum
+  // scaled into 14 bits first
+  int64_t Peak = 0;
+  for (int K = 0; K < AEC_BINS; K++) {
+    int64_t R = Yr[K] < 0 ? -Yr[K] : Yr[K];
+    int64_t I = Yi[K] < 0 ? -Yi[K] : Yi[K];
+    if (R > Peak) Peak = R;
+    if (I > Peak) Peak = I;
+  }
+  int YShift = 0;
+  while ((Peak >> YShift) >= (1 << 14)) YShift++;
+  for (int K = 0; K < AEC_BINS; K++) {
+    Re[K] = (int16_t)Scale(Yr[K], -YShift);
+    Im[K] = (int16_t)-Scale(Yi[K], -YShift);
+  }
+  for (int K = AEC_BINS; K < AEC_FFT_SIZE; K++) {
+    Re[K] = Re[AEC_FFT_SIZE - K];
+    Im[K] = (int16_t)-Im[AEC_FFT_SIZE - K];
+  }
+  int EchoShift = DspFftQ15(Re, Im, AEC_FFT_LOG2) + YShift - 24 - AEC_FFT_LOG2;
+
+  // Adaptation follows the previous block's decision, so near-end speech
+  // freezes the taps within a few milliseconds
+  bool Adapt = Aec->FarActive && !Aec->DoubleTalk;
+  uint64_t MicEnergy = 0, ResidualEnergy = 0;
+
+  // Once converged, clip the error driving the update to a few times the
+  // usual residual so the onset of near-end speech cannot throw the taps
+  // off before the detector reacts
+  int32_t ErrorLimit = 32767;
+  if (Aec->Converged) {
+    ErrorLimit = (int32_t)DspIsqrt64(Aec->SmoothedResidual / AEC_BLOCK) * ERROR_LIMIT_RATIO + 1;
+  }
+
+  // Residual, kept in the second half of Re (zero-padded) for the update
+  for (size_t N = 0; N < AEC_BLOCK; N++) {
+    int32_t D = Mic[N];
+    int32_t E = DspSat16(D - (int32_t)Scale(Re[AEC_BLOCK + N], EchoShift));
+    Mic[N] = (int16_t)E;
+    MicEnergy += (uint32_t)(D * D);
+    ResidualEnergy += (uint32_t)(E * E);
+    Re[N] = 0;
+    Re[AEC_BLOCK + N] = (int16_t)(E > ErrorLimit ? ErrorLimit : (E < -ErrorLimit ? -ErrorLimit : E));
+  }
+
+  if (Adapt) {
+    memset(Im, 0, sizeof(Im));
+    int ErrShift = DspNormalizeQ15(Re, AEC_FFT_SIZE);
+    int ErrExponent = DspFftQ15(Re, Im, AEC_FFT_LOG2) - ErrShift;
+
+    // Normalized step per bin, G = mu * E / (|X|^2 + delta): a 32-bit
+    // mantissa and a power-of-two exponent
+    int32_t Gr[AEC_BINS], Gi[AEC_BINS];
+    int GExp[AEC_BINS];
+    for (int K = 0; K < AEC_BINS; K++) {
+      uint64_t Power = Aec->BinPower[K] + BIN_POWER_DELTA;
+      int PowerShift = 0;
+      while ((Power >> PowerShift) >= (1 << 16)) PowerShift++;
+      uint32_t Inverse = 0xFFFFFFFFu / (uint32_t)(Power >> PowerShift);  // 2^32 / mantissa
+      Gr[K] = (int32_t)(((int64_t)Re[K] * Inverse * STEP_Q15) >> 16);
+      Gi[K] = (int32_t)(((int64_t)Im[K] * Inverse * STEP_Q15) >> 16);
+      GExp[K] = ErrExponent - 32 - PowerShift - 15 + 16;
+    }
+
+    // W += conj(X) G for every partition, in Q24
+    for (int P = 0; P < AEC_PARTITIONS; P++) {
+      int Slot = (Aec->Newest + P) % AEC_PARTITIONS;
+      const int16_t* Sr = Aec->SpectrumRe[Slot];
+      const int16_t* Si = Aec->SpectrumIm[Slot];
+      int32_t* Wr = Aec->WeightRe[P];
+      int32_t* Wi = Aec->WeightIm[P];
+      int Exp = Aec->SpectrumExp[Slot] + 24;
+      for (int K = 0; K < AEC_BINS; K++) {
+        int64_t R = (int64_t)Sr[K] * Gr[K] + (int64_t)Si[K] * Gi[K];
+        int64_t I = (int64_t)Sr[K] * Gi[K] - (int64_t)Si[K] * Gr[K];
+        Wr[K] = Clamp32(Wr[K] + (int64_t)Clamp32(Scale(R, Exp + GExp[K]), UPDATE_LIMIT), WEIGHT_LIMIT);
+        Wi[K] = Clamp32(Wi[K] + (int64_t)Clamp32(Scale(I, Exp + GExp[K]), UPDATE_LIMIT), WEIGHT_LIMIT);
+      }
+    }
+    ConstrainPartition(Aec, Aec->Constrain);
+    Aec->Constrain = (uint8_t)((Aec->Constrain + 1) % AEC_PARTITIONS);
+  }
+
+  // Double-talk decision for the next block: the short averages freeze
+  // adaptation within milliseconds, the slow ones count towards NearEnd
+  Aec->FarActive = RefEnergy / AEC_BLOCK >= FAR_MIN_ENERGY;
+  Aec->ShortMic += (int64_t)(MicEnergy - Aec->ShortMic) >> SHORT_SHIFT;
+  Aec->ShortResidual += (int64_t)(ResidualEnergy - Aec->ShortResidual) >> SHORT_SHIFT;
+  Aec->SlowMic += (int64_t)(MicEnergy - Aec->SlowMic) >> SLOW_SHIFT;
+  Aec->SlowResidual += (int64_t)(ResidualEnergy - Aec->SlowResidual) >> SLOW_SHIFT;
+  bool NearSpeech = ResidualUnexplained(Aec, Aec->ShortMic, Aec->ShortResidual);
+  if (ResidualUnexplained(Aec, Aec->SlowMic, Aec->SlowResidual)) Aec->NearBlocks++;
+  // Track cancellation on echo-only blocks
+  if (Adapt && !NearSpeech) {
+    Aec->SmoothedMic += (int64_t)(MicEnergy - Aec->SmoothedMic) >> 6;
+    Aec->SmoothedResidual += (int64_t)(ResidualEnergy - Aec->SmoothedResidual) >> 6;
+    if (Aec->SmoothedMic > Aec->SmoothedResidual * CONVERGED_RATIO) {
+      Aec->Converged = true;
+    } else if (Aec->SmoothedMic < Aec->SmoothedResidual * DIVERGED_RATIO) {
+      Aec->Converged = false;
+    }
+  }
+
+  if (NearSpeech) {
+    Aec->DoubleTalkHold = DOUBLE_TALK_HOLD_BLOCKS;
+  } else if (Aec->DoubleTalkHold > 0) {
+    Aec->DoubleTalkHold--;
+  }
+  Aec->DoubleTalk = Aec->DoubleTalkHold > 0;
+  if (Aec->DoubleTalk) {
+    if (++Aec->DoubleTalkBlocks >= DOUBLE_TALK_RESET_BLOCKS) {
+      // Too long for speech over the speaker: assume the echo path moved
+      Aec->Converged = false;
+      Aec->DoubleTalkHold = 0;
+      Aec->DoubleTalkBlocks = 0;
+    }
+  } else {
+    Aec->DoubleTalkBlocks = 0;
+  }
+}
+
+void AecProcess(Aec_t* Aec, const int16_t* Ref, int16_t* Mic, size_t Count) {
+  size_t Blocks = Count / AEC_BLOCK;
+  Aec->NearBlocks = 0;
+  while (Count >= AEC_BLOCK) {
+    ProcessBlock(Aec, Ref, Mic);
+    Ref += AEC_BLOCK;
+    Mic += AEC_BLOCK;
+    Count -= AEC_BLOCK;
+  }
+  Aec->NearEnd = Blocks > 0 && Aec->NearBlocks * 2 >= Blocks;
+  // A partial block is not cancelled, but the reference stays continuous
+  size_t Pos = Aec->Head;
+  for (size_t N = 0; N < Count; N++) {
+    Aec->Reference[Pos] = Ref[N];
+    if (++Pos == AEC_HISTORY) Pos = 0;
+  }
+  Aec->Head = (uint16_t)Pos;
+}
+
+int32_t AecErleDb(const Aec_t* Aec) {
+  if (Aec->SmoothedResidual == 0) return 0;
+  // 10 * log10(a / b) = 3.0103 * (log2 a - log2 b)
+  int32_t Log2Ratio = DspLog2Q10(Aec->SmoothedMic) - DspLog2Q10(Aec->SmoothedResidual);
+  return Log2Ratio * 3083 / (1024 * 1024);
+}
@@ -0,0 +1,159 @@
+#include "../h/Agc.h"
+#include "../h/AudioKernels.h"
+#include <math.h>
+#include <string.h>
+
+// Output peaks are held below this (-1 dBFS)
+static const int32_t CEILING = 29204;
+static const int32_t MIN_GAIN = AGC_GAIN_ONE / 4;
+// Level gain smoothing per block: ~10 ms attack, ~650 ms release
+static const int ATTACK_SHIFT = 2;
+static const int RELEASE_SHIFT = 8;
+// Level smoothing per block (~80 ms): a block is shorter than a pitch
+// period, so on its own it follows the pulses rather than the syllable
+static const int POWER_SHIFT = 5;
+// Levels within this factor (6 dB) of the noise floor do not raise the gain
+static const uint32_t GATE_MARGIN = 2;
+
+void AgcInit(Agc_t* Agc, uint32_t SampleRate, uint8_t TargetDbfs, int32_t InitialGain, int32_t MaxGain) {
+  memset(Agc, 0, sizeof(*Agc));
+  uint32_t Block = SampleRate / 400;
+  Agc->Block = (uint16_t)(Block < 1 ? 1 : (Block > AGC_MAX_BLOCK ? AGC_MAX_BLOCK : Block));
+  Agc->TargetRms = (uint16_t)lround(32767.0 * pow(10.0, -TargetDbfs / 20.0));
+  Agc->MaxGain = MaxGain > AGC_MAX_GAIN ? AGC_MAX_GAIN : MaxGain;
+  if (InitialGain > Agc->MaxGain) InitialGain = Agc->MaxGain;
+  Agc->LevelGain = InitialGain << 6;
+  Agc->Applied = InitialGain;
+  Agc->NoiseFloor = UINT32_MAX;
+}
+
+// Largest Q10 gain that keeps Peak under the ceiling
+static int32_t LimitFor(int32_t Peak, int32_t MaxGain) {
+  if (Peak == 0) return MaxGain;
+  int32_t Limit = (CEILING * AGC_GAIN_ONE) / Peak;
+  return Limit < MaxGain ? Limit : MaxGain;
+}
+
+static void DSP_HOT UpdateLevel(Agc_t* Agc, const int16_t* Block, size_t Count, int32_t* Peak) {
+  uint64_t Energy = 0;
+  int32_t Max = 0;
+  for (size_t I = 0; I < Count; I++) {
+    int32_t S = Block[I];
+    Energy += (uint32_t)(S * S);
+    if (S < 0) S = -S;
+    if (S > Max) Max = S;
+  }
+  *Peak = Max;
+
+  uint32_t Power = (uint32_t)(Energy / Count);
+  if (Power > Agc->Power) {
+    Agc->Power += (Power - Agc->Power) >> POWER_SHIFT;
+  } else {
+    Agc->Power -= (Agc->Power - Power) >> POWER_SHIFT;
+  }
+  uint32_t Rms = DspIsqrt64(Agc->Power);
+
+  // Floor drops at once and creeps back up (~1.5 dB/s), like the VAD's
+  uint32_t Level = Rms << 8;
+  if (Level < Agc->NoiseFloor) {
+    Agc->NoiseFloor = Level;
+  } else {
+    Agc->NoiseFloor += (Agc->NoiseFloor >> 11) + 1;
+  }
+
+  int32_t Desired = Rms ? (int32_t)(((uint32_t)Agc->TargetRms * AGC_GAIN_ONE) / Rms) : Agc->MaxGain;
+  if (Desired > Agc->MaxGain) Desired = Agc->MaxGain;
+  if (Desired < MIN_GAIN) Desired = MIN_GAIN;
+
+  int32_t Current = Agc->LevelGain >> 6;
+  if (Desired < Current) {
+    Agc->LevelGain += ((Desired << 6) - Agc->LevelGain) >> ATTACK_SHIFT;
+  } else if (Level > Agc->NoiseFloor * GATE_MARGIN) {
+    Agc->LevelGain += ((Desired << 6) - Agc->LevelGain) >> RELEASE_SHIFT;
+  }
+}
+
+// Level and limit from the complete block In, then ramp the gain across
+// the previous block into Out
+static void DSP_HOT ProcessBlock(Agc_t* Agc, const int16_t* In, int16_t* Out) {
+  const size_t Block = Agc->Block;
+  int32_t Peak;
+  UpdateLevel(Agc, In, Block, &Peak);
+
+  // The delayed block is already covered by the previous gain; this
+  // one must also fit the block arriving next
+  int32_t Gain = Agc->LevelGain >> 6;
+  int32_t Limit = LimitFor(Agc->DelayPeak, Agc->MaxGain);
+  int32_t Ahead = LimitFor(Peak, Agc->MaxGain);
+  if (Ahead < Limit) Limit = Ahead;
+  if (Limit < Gain) {
+    Gain = Limit;
+    Agc->LimitedBlocks++;
+  }
+
+  int32_t From = Agc->Applied;
+  int32_t Step = (Gain - From) / (int32_t)Block;
+  for (size_t I = 0; I < Block; I++) {
+    From += Step;
+    // Full scale times a Q10 gain near 64 needs more than 32 bits
+    int32_t Value = (int32_t)(((int64_t)Agc->Delay[I] * From + (AGC_GAIN_ONE / 2)) >> 10);
+    if (Value > 32767 || Value < -32768) Agc->Clipped++;
+    Out[I] = DspSat16(Value);
+  }
+
+  memcpy(Agc->Delay, In, Block * sizeof(int16_t));
+  Agc->DelayPeak = (int16_t)Peak;
+  Agc->Applied = Gain;
+  Agc->Samples += Block;
+}
+
+// Move up to Count ready samples to Out
+static size_t TakeReady(Agc_t* Agc, int16_t* Out, size_t Count) {
+  size_t Taken = Count < Agc->ReadyCount ? Count : Agc->ReadyCount;
+  memcpy(Out, Agc->Ready, Taken * sizeof(int16_t));
+  Agc->ReadyCount -= Taken;
+  memmove(Agc->Ready, Agc->Ready + Taken, Agc->ReadyCount * sizeof(int16_t));
+  return Taken;
+}
+
+void DSP_HOT AgcProcess(Agc_t* Agc, int16_t* Samples, size_t Count) {
+  const size_t Block = Agc->Block;
+  size_t Read = 0;
+  size_t Written = 0;
+
+  while (Read < Count) {
+    size_t Take = Block - Agc->PendingCount;
+    if (Take > Count - Read) Take = Count - Read;
+    memcpy(Agc->Pending + Agc->PendingCount, Samples + Read, Take * sizeof(int16_t));
+    Agc->PendingCount += Take;
+    Read += Take;
+    // Output only ever overwrites input already gathered
+    Written += TakeReady(Agc, Samples + Written, Read - Written);
+
+    if (Agc->PendingCount == Block) {
+      ProcessBlock(Agc, Agc->Pending, Agc->Ready + Agc->ReadyCount);
+      Agc->ReadyCount += Block;
+      Agc->PendingCount = 0;
+      Written += TakeReady(Agc, Samples + Written, Read - Written);
+    }
+  }
+
+  // Held back input leaves a gap: fill it, and the lag grows by as much
+  memset(Samples + Written, 0, (Count - Written) * sizeof(int16_t));
+}
+
+int16_t AgcGainDb10(const Agc_t* Agc) {
+  // 200 log10(g / 1024) = 60.2 * (log2 g - 10)
+  int32_t Log = DspLog2Q10((uint64_t)Agc->Applied) - (10 << 10);
+  return (int16_t)(Log * 602 / 10240);
+}
+
+uint32_t AgcClipPpm(const Agc_t* Agc) {
+  return Agc->Samples ? (uint32_t)((uint64_t)Agc->Clipped * 1000000 / Agc->Samples) : 0;
+}
+
+void AgcResetStats(Agc_t* Agc) {
+  Agc->Samples = 0;
+  Agc->Clipped = 0;
+  Agc->LimitedBlocks = 0;
+}
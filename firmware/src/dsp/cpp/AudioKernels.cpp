@@ -0,0 +1,61 @@
+#include "../h/AudioKernels.h"
+
+uint64_t DSP_HOT DspEnergy(const int16_t* Samples, size_t Count) {
+  // Four independent accumulators lets the compiler keep everything in
+  // registers and overlap the multiplies
+  uint64_t Acc0 = 0, Acc1 = 0, Acc2 = 0, Acc3 = 0;
+  size_t I = 0;
+
+  for (; I + 4 <= Count; I += 4) {
+    int32_t S0 = Samples[I];
+    int32_t S1 = Samples[I + 1];
+    int32_t S2 = Samples[I + 2];
+    int32_t S3 = Samples[I + 3];
+    Acc0 += (uint32_t)(S0 * S0);
+    Acc1 += (uint32_t)(S1 * S1);
+    Acc2 += (uint32_t)(S2 * S2);
+    Acc3 += (uint32_t)(S3 * S3);
+  }
+
+  for (; I < Count; I++) {
+    int32_t S = Samples[I];
+    Acc0 += (uint32_t)(S * S);
+  }
+
+  return Acc0 + Acc1 + Acc2 + Acc3;
+}
+
+uint32_t DspIsqrt64(uint64_t Value) {
+  uint64_t Result = 0;
+  uint64_t Bit = (uint64_t)1 << 62;
+
+  while (Bit > Value) Bit >>= 2;
+
+  while (Bit != 0) {
+    if (Value >= Result + Bit) {
+      Value -= Result + Bit;
+      Result = (Result >> 1) + Bit;
+    } else {
+      Result >>= 1;
+    }
+    Bit >>= 2;
+  }
+  return (uint32_t)Result;
+}
+
+uint32_t DspRmsFromEnergy(uint64_t Energy, size_t Count) {
+  if (Count == 0) return 0;
+  return DspIsqrt64(Energy / Count);
+}
+
+int32_t DSP_HOT DspLog2Q10(uint64_t Value) {
+  if (Value <= 1) return 0;
+
+  int32_t Msb = 63;
+  while (!(Value & ((uint64_t)1 << Msb))) Msb--;
+
+  // Mantissa m in [0, 1), Q10; log2(1 + m) ~= m + 0.3467 * m * (1 - m)
+  int32_t M = Msb >= 10 ? (int32_t)((Value >> (Msb - 10)) & 1023) : (int32_t)((Value << (10 - Msb)) & 1023);
+  int32_t Correction = (355 * M * (1024 - M)) >> 20;
+  return (Msb << 10) + M + Correction;
+}
@@ -0,0 +1,112 @@
+#include "../h/DspBench.h"
+#include "../h/AudioKernels.h"
+#include "../h/DspChain.h"
+#include "../h/DspStages.h"
+#include "../h/NoiseSuppressor.h"
+#include <math.h>
+#include <string.h>
+
+static int16_t Input[DSP_BENCH_MAX_FRAME];
+static int16_t Before[DSP_BENCH_MAX_FRAME];
+static int16_t After[DSP_BENCH_MAX_FRAME];
+static uint32_t Seed = 1;
+
+static uint32_t NextRandom() {
+  Seed = Seed * 1664525u + 1013904223u;
+  return Seed >> 8;
+}
+
+// Previous wake RMS: float sum of squares over the bytes, then sqrt
+static float ReferenceRms(const int16_t* Samples, size_t Count) {
+  const uint8_t* Buf = (const uint8_t*)Samples;
+  float Sum = 0;
+  for (size_t I = 0; I < Count * 2 - 1; I += 2) {
+    int16_t Sample = (Buf[I + 1] << 8) | Buf[I];
+    Sum += (float)Sample * Sample;
+  }
+  return sqrt(Sum / Count);
+}
+
+// Previous downlink volume: multiply and divide per sample
+static void ReferenceVolume(const int16_t* In, int16_t* Out, size_t Count, uint8_t Volume) {
+  for (size_t I = 0; I < Count; I++) {
+    int32_t Sample = In[I];
+    Sample = (Sample * Volume) / 100;
+    Out[I] = (int16_t)Sample;
+  }
+}
+
+static bool WithinOne(const int16_t* A, const int16_t* B, size_t Count) {
+  for (size_t I = 0; I < Count; I++) {
+    int32_t Diff = (int32_t)A[I] - B[I];
+    if (Diff > 1 || Diff < -1) return false;
+  }
+  return true;
+}
+
+void DspBenchKernels(size_t FrameSamples, int Runs, DspBenchResult_t Results[DSP_BENCH_COUNT]) {
+  if (FrameSamples > DSP_BENCH_MAX_FRAME) FrameSamples = DSP_BENCH_MAX_FRAME;
+  if (FrameSamples == 0 || Runs < 1) Runs = 0;
+
+  // Wake: the raw mic frame the gate measures (no gain since the AGC
+  // moved to the uplink)
+  DspBenchResult_t* Mic = &Results[DSP_BENCH_WAKE_RMS];
+  uint64_t BeforeSum = 0, AfterSum = 0;
+  Mic->Name = "Wake RMS";
+  Mic->Match = true;
+  for (int R = 0; R < Runs; R++) {
+    for (size_t I = 0; I < FrameSamples; I++) Input[I] = (int16_t)((NextRandom() & 0x7FF) - 1024);
+
+    uint32_t Start = DspCycles();
+    float OldRms = ReferenceRms(Input, FrameSamples);
+    BeforeSum += DspCycles() - Start;
+
+    Start = DspCycles();
+    uint32_t NewRms = DspRmsFromEnergy(DspEnergy(Input, FrameSamples), FrameSamples);
+    AfterSum += DspCycles() - Start;
+
+    if (fabsf(OldRms - NewRms) > 1.0f) Mic->Match = false;
+  }
+  Mic->Before = Runs ? (uint32_t)(BeforeSum / Runs) : 0;
+  Mic->After = Runs ? (uint32_t)(AfterSum / Runs) : 0;
+
+  // Downlink: full-scale PCM at 70% volume, through the gain stage the
+  // speaker chain applies it with, in a chain of its own
+  DspBenchResult_t* Volume = &Results[DSP_BENCH_DOWNLINK_VOLUME];
+  DspChain<DspGainStage> Gain;
+  Gain.Stage<0>().Set(70 * DSP_Q15_ONE / 100, 0);
+  BeforeSum = 0;
+  AfterSum = 0;
+  Volume->Name = "Downlink volume";
+  Volume->Match = true;
+  for (int R = 0; R < Runs; R++) {
+    for (size_t I = 0; I < FrameSamples; I++) Input[I] = (int16_t)NextRandom();
+
+    uint32_t Start = DspCycles();
+    ReferenceVolume(Input, Before, FrameSamples, 70);
+    BeforeSum += DspCycles() - Start;
+
+    Start = DspCycles();
+    Gain.Process(Input, After, FrameSamples);
+    AfterSum += DspCycles() - Start;
+
+    if (!WithinOne(Before, After, FrameSamples)) Volume->Match = false;
+  }
+  Volume->Before = Runs ? (uint32_t)(BeforeSum / Runs) : 0;
+  Volume->After = Runs ? (uint32_t)(AfterSum / Runs) : 0;
+}
+
+uint32_t DspBenchNoiseSuppressor(size_t FrameSamples, int Runs) {
+  static Ns_t Ns;
+  if (Runs < 1 || !NsInit(&Ns, FrameSamples)) return 0;
+
+  // Let the noise estimate settle, then time steady-state frames
+  uint64_t Sum = 0;
+  for (int R = -10; R < Runs; R++) {
+    for (size_t I = 0; I < FrameSamples; I++) Input[I] = (int16_t)((NextRandom() & 0x7FF) - 1024);
+    uint32_t Start = DspCycles();
+    NsProcess(&Ns, Input);
+    if (R >= 0) Sum += DspCycles() - Start;
+  }
+  return (uint32_t)(Sum / Runs);
+}
@@ -0,0 +1,30 @@
+#include "../h/DspStages.h"
+#include <math.h>
+
+static int32_t ToQ28(double Value) {
+  return (int32_t)lround(Value * (1 << 28));
+}
+
+static void SetCoefficients(DspBiquad* Filter, double B0, double B1, double B2, double A0, double A1, double A2) {
+  Filter->B0 = ToQ28(B0 / A0);
+  Filter->B1 = ToQ28(B1 / A0);
+  Filter->B2 = ToQ28(B2 / A0);
+  Filter->A1 = ToQ28(A1 / A0);
+  Filter->A2 = ToQ28(A2 / A0);
+  Filter->Reset();
+}
+
+void DspBiquadHighPass(DspBiquad* Filter, uint32_t SampleRate, float CutoffHz, float Q) {
+  double W = 2.0 * M_PI * CutoffHz / SampleRate;
+  double Alpha = sin(W) / (2.0 * Q);
+  double C = cos(W);
+  SetCoefficients(Filter, (1.0 + C) / 2.0, -(1.0 + C), (1.0 + C) / 2.0, 1.0 + Alpha, -2.0 * C, 1.0 - Alpha);
+}
+
+void DspBiquadPeaking(DspBiquad* Filter, uint32_t SampleRate, float CenterHz, float Q, float GainDb) {
+  double A = pow(10.0, GainDb / 40.0);
+  double W = 2.0 * M_PI * CenterHz / SampleRate;
+  double Alpha = sin(W) / (2.0 * Q);
+  double C = cos(W);
+  SetCoefficients(Filter, 1.0 + Alpha * A, -2.0 * C, 1.0 - Alpha * A, 1.0 + Alpha / A, -2.0 * C, 1.0 - Alpha / A);
+}
@@ -0,0 +1,142 @@
+#include "../h/Fft.h"
+#include <math.h>
+
+// Largest magnitude a butterfly input may have: outputs grow by at most
+// 1 + sqrt(2) per stage
+static const int16_t STAGE_GUARD = 12288;
+
+// cos/sin of -2*pi*k/N for the largest N, Q15
+static int16_t TwiddleCos[DSP_FFT_MAX_SIZE / 2];
+static int16_t TwiddleSin[DSP_FFT_MAX_SIZE / 2];
+static bool TwiddleReady = false;
+
+void DspFftInit() {
+  if (TwiddleReady) return;
+  for (int K = 0; K < DSP_FFT_MAX_SIZE / 2; K++) {
+    double Angle = 2.0 * M_PI * K / DSP_FFT_MAX_SIZE;
+    TwiddleCos[K] = DspSat16((int32_t)lround(cos(Angle) * 32767.0));
+    TwiddleSin[K] = DspSat16((int32_t)lround(-sin(Angle) * 32767.0));
+  }
+  TwiddleReady = true;
+}
+
+static int16_t PeakMagnitude(const int16_t* Re, const int16_t* Im, size_t N) {
+  int32_t Peak = 0;
+  for (size_t I = 0; I < N; I++) {
+    int32_t R = Re[I] < 0 ? -Re[I] : Re[I];
+    int32_t M = Im[I] < 0 ? -Im[I] : Im[I];
+    if (R > Peak) Peak = R;
+    if (M > Peak) Peak = M;
+  }
+  return (int16_t)(Peak > 32767 ? 32767 : Peak);
+}
+
+template <typename T>
+static void BitReverse(T* Re, T* Im, size_t N) {
+  for (size_t I = 1, J = 0; I < N; I++) {
+    size_t Bit = N >> 1;
+    for (; J & Bit; Bit >>= 1) J ^= Bit;
+    J ^= Bit;
+    if (I < J) {
+      T Swap = Re[I]; Re[I] = Re[J]; Re[J] = Swap;
+      Swap = Im[I]; Im[I] = Im[J]; Im[J] = Swap;
+    }
+  }
+}
+
+static int32_t Sat32(int64_t Value) {
+  if (Value > INT32_MAX) return INT32_MAX;
+  if (Value < INT32_MIN) return INT32_MIN;
+  return (int32_t)Value;
+}
+
+int DSP_HOT DspFftQ15(int16_t* Re, int16_t* Im, uint8_t Log2N) {
+  size_t N = (size_t)1 << Log2N;
+  int Exponent = 0;
+
+  BitReverse(Re, Im, N);
+
+  for (uint8_t Stage = 1; Stage <= Log2N; Stage++) {
+    // Scale the whole block only when this stage could overflow
+    int Shift = PeakMagnitude(Re, Im, N) >= STAGE_GUARD ? 1 : 0;
+    Exponent += Shift;
+
+    size_t Half = (size_t)1 << (Stage - 1);
+    size_t Stride = (size_t)DSP_FFT_MAX_SIZE >> Stage;
+    for (size_t Start = 0; Start < N; Start += Half << 1) {
+      for (size_t K = 0; K < Half; K++) {
+        int32_t Wr = TwiddleCos[K * Stride];
+        int32_t Wi = TwiddleSin[K * Stride];
+        size_t A = Start + K;
+        size_t B = A + Half;
+
+        int32_t Br = Re[B], Bi = Im[B];
+        int32_t Tr = (Br * Wr - Bi * Wi + (1 << 14)) >> 15;
+        int32_t Ti = (Br * Wi + Bi * Wr + (1 << 14)) >> 15;
+        int32_t Ar = Re[A], Ai = Im[A];
+
+        Re[A] = (int16_t)((Ar + Tr) >> Shift);
+        Im[A] = (int16_t)((Ai + Ti) >> Shift);
+        Re[B] = (int16_t)((Ar - Tr) >> Shift);
+        Im[B] = (int16_t)((Ai - Ti) >> Shift);
+      }
+    }
+  }
+  return Exponent;
+}
+
+void DSP_HOT DspFftQ31(int32_t* Re, int32_t* Im, uint8_t Log2N, bool Inverse) {
+  size_t N = (size_t)1 << Log2N;
+  BitReverse(Re, Im, N);
+
+  // The inverse uses the conjugate twiddles and halves each stage
+  int Shift = Inverse ? 1 : 0;
+  int64_t Round = Inverse ? 1 : 0;
+  for (uint8_t Stage = 1; Stage <= Log2N; Stage++) {
+    size_t Half = (size_t)1 << (Stage - 1);
+    size_t Stride = (size_t)DSP_FFT_MAX_SIZE >> Stage;
+    for (size_t Start = 0; Start < N; Start += Half << 1) {
+      for (size_t K = 0; K < Half; K++) {
+        int64_t Wr = TwiddleCos[K * Stride];
+        int64_t Wi = Inverse ? -TwiddleSin[K * Stride] : TwiddleSin[K * Stride];
+        size_t A = Start + K;
+        size_t B = A + Half;
+
+        int64_t Br = Re[B], Bi = Im[B];
+        int64_t Tr = (Br * Wr - Bi * Wi + (1 << 14)) >> 15;
+        int64_t Ti = (Br * Wi + Bi * Wr + (1 << 14)) >> 15;
+        int64_t Ar = Re[A], Ai = Im[A];
+
+        Re[A] = Sat32((Ar + Tr + Round) >> Shift);
+        Im[A] = Sat32((Ai + Ti + Round) >> Shift);
+        Re[B] = Sat32((Ar - Tr + Round) >> Shift);
+        Im[B] = Sat32((Ai - Ti + Round) >> Shift);
+      }
+    }
+  }
+}
+
+int DspNormalizeQ15(int16_t* Samples, size_t Count) {
+  int32_t Peak = 0;
+  for (size_t I = 0; I < Count; I++) {
+    int32_t M = Samples[I] < 0 ? -Samples[I] : Samples[I];
+    if (M > Peak) Peak = M;
+  }
+  if (Peak == 0) return 0;
+
+  int Shift = 0;
+  while ((Peak << (Shift + 1)) < STAGE_GUARD) Shift++;
+  if (Shift == 0) return 0;
+
+  for (size_t I = 0; I < Count; I++) {
+    Samples[I] = (int16_t)(Samples[I] * (1 << Shift));
+  }
+  return Shift;
+}
+
+void DSP_HOT DspFftPower(const int16_t* Re, const int16_t* Im, uint32_t* Power, size_t Count) {
+  for (size_t K = 0; K < Count; K++) {
+    int32_t R = Re[K], I = Im[K];
+    Power[K] = (uint32_t)(R * R) + (uint32_t)(I * I);
+  }
+}
@@ -0,0 +1,107 @@
+#include "../h/ImaAdpcm.h"
+
+static const int8_t IndexTable[16] = {
+  -1, -1, -1, -1, 2, 4, 6, 8,
+  -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int16_t StepTable[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+  19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+  130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+  337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+  876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+  2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+  5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+  15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static inline int ClampIndex(int Index) {
+  if (Index < 0) return 0;
+  if (Index > 88) return 88;
+  return Index;
+}
+
+static inline uint8_t EncodeSample(int32_t* Predictor, int* Index, int16_t Sample) {
+  int32_t Step = StepTable[*Index];
+  int32_t Diff = Sample - *Predictor;
+  uint8_t Code = 0;
+
+  if (Diff < 0) {
+    Code = 8;
+    Diff = -Diff;
+  }
+
+  int32_t Delta = Step >> 3;
+  if (Diff >= Step) { Code |= 4; Diff -= Step; Delta += Step; }
+  Step >>= 1;
+  if (Diff >= Step) { Code |= 2; Diff -= Step; Delta += Step; }
+  Step >>= 1;
+  if (Diff >= Step) { Code |= 1; Delta += Step; }
+
+  *Predictor = DspSat16(*Predictor + ((Code & 8) ? -Delta : Delta));
+  *Index = ClampIndex(*Index + IndexTable[Code]);
+  return Code;
+}
+
+static inline int16_t DecodeSample(int32_t* Predictor, int* Index, uint8_t Code) {
+  int32_t Step = StepTable[*Index];
+  int32_t Delta = Step >> 3;
+  if (Code & 4) Delta += Step;
+  if (Code & 2) Delta += Step >> 1;
+  if (Code & 1) Delta += Step >> 2;
+
+  *Predictor = DspSat16(*Predictor + ((Code & 8) ? -Delta : Delta));
+  *Index = ClampIndex(*Index + IndexTable[Code]);
+  return (int16_t)*Predictor;
+}
+
+void ImaAdpcmReset(ImaAdpcmState_t* State) {
+  State->Predictor = 0;
+  State->Index = 0;
+}
+
+size_t DSP_HOT ImaAdpcmEncode(ImaAdpcmState_t* State, const int16_t* In, size_t Count, uint8_t* Out) {
+  int32_t Predictor = State->Predictor;
+  int Index = State->Index;
+
+  Out[0] = (uint8_t)(Predictor & 0xFF);
+  Out[1] = (uint8_t)((Predictor >> 8) & 0xFF);
+  Out[2] = (uint8_t)Index;
+  Out[3] = (Count & 1) ? IMA_ADPCM_FLAG_ODD : 0;
+
+  uint8_t* Dest = Out + IMA_ADPCM_HEADER_BYTES;
+  size_t I = 0;
+  for (; I + 2 <= Count; I += 2) {
+    uint8_t Lo = EncodeSample(&Predictor, &Index, In[I]);
+    uint8_t Hi = EncodeSample(&Predictor, &Index, In[I + 1]);
+    *Dest++ = (uint8_t)(Lo | (Hi << 4));
+  }
+  if (I < Count) {
+    *Dest++ = EncodeSample(&Predictor, &Index, In[I]);
+  }
+
+  State->Predictor = (int16_t)Predictor;
+  State->Index = (uint8_t)Index;
+  return Dest - Out;
+}
+
+size_t ImaAdpcmDecode(const uint8_t* In, size_t Bytes, int16_t* Out, size_t MaxSamples) {
+  if (Bytes < IMA_ADPCM_HEADER_BYTES) return 0;
+
+  int32_t Predictor = (int16_t)(In[0] | (In[1] << 8));
+  int Index = ClampIndex(In[2]);
+  size_t Total = (Bytes - IMA_ADPCM_HEADER_BYTES) * 2;
+  if ((In[3] & IMA_ADPCM_FLAG_ODD) && Total > 0) Total--;
+  if (Total > MaxSamples) Total = MaxSamples;
+
+  size_t Samples = 0;
+  for (size_t B = IMA_ADPCM_HEADER_BYTES; Samples < Total; B++) {
+    Out[Samples++] = DecodeSample(&Predictor, &Index, In[B] & 0x0F);
+    if (Samples < Total) {
+      Out[Samples++] = DecodeSample(&Predictor, &Index, In[B] >> 4);
+    }
+  }
+  return Samples;
+}
@@ -0,0 +1,49 @@
+#include "../h/Jitter.h"
+
+static const int64_t NEW_STREAM_GAP_US = 1000000;  // Silence between responses
+static const uint32_t UNDERRUN_STEP_US = 20000;    // Extra depth per underrun
+
+void JitterInit(Jitter_t* Jitter, uint32_t MinTargetUs, uint32_t MaxTargetUs) {
+  Jitter->StreamStartUs = 0;
+  Jitter->LastArrivalUs = 0;
+  Jitter->StreamMediaUs = 0;
+  Jitter->LastMediaUs = 0;
+  Jitter->JitterUs = 0;
+  Jitter->PeakLatenessUs = 0;
+  Jitter->MinTargetUs = MinTargetUs;
+  Jitter->MaxTargetUs = MaxTargetUs;
+}
+
+void JitterOnArrival(Jitter_t* Jitter, int64_t ArrivalUs, uint32_t MediaUs) {
+  if (Jitter->LastArrivalUs == 0 || ArrivalUs - Jitter->LastArrivalUs > NEW_STREAM_GAP_US) {
+    Jitter->StreamStartUs = ArrivalUs;
+    Jitter->StreamMediaUs = 0;
+  } else {
+    // Spacing versus the previous chunk's duration
+    int64_t Deviation = (ArrivalUs - Jitter->LastArrivalUs) - Jitter->LastMediaUs;
+    uint32_t Magnitude = (uint32_t)(Deviation < 0 ? -Deviation : Deviation);
+    Jitter->JitterUs += ((int32_t)Magnitude - (int32_t)Jitter->JitterUs) / 16;
+
+    // How far behind a real-time stream started at the first arrival
+    int64_t Lateness = ArrivalUs - (Jitter->StreamStartUs + (int64_t)Jitter->StreamMediaUs);
+    if (Lateness > (int64_t)Jitter->PeakLatenessUs) {
+      Jitter->PeakLatenessUs = (uint32_t)Lateness;
+    } else {
+      Jitter->PeakLatenessUs -= Jitter->PeakLatenessUs >> 8;
+    }
+  }
+
+  Jitter->StreamMediaUs += MediaUs;
+  Jitter->LastMediaUs = MediaUs;
+  Jitter->LastArrivalUs = ArrivalUs;
+}
+
+void JitterOnUnderrun(Jitter_t* Jitter) {
+  Jitter->PeakLatenessUs += UNDERRUN_STEP_US;
+}
+
+uint32_t JitterTargetUs(const Jitter_t* Jitter) {
+  uint32_t Spread = Jitter->PeakLatenessUs > 2 * Jitter->JitterUs ? Jitter->PeakLatenessUs : 2 * Jitter->JitterUs;
+  uint32_t Target = Jitter->MinTargetUs + Spread;
+  return Target > Jitter->MaxTargetUs ? Jitter->MaxTargetUs : Target;
+}
@@ -0,0 +1,175 @@
+#include "../h/NoiseSuppressor.h"
+#include "../h/Fft.h"
+#include "../h/AudioKernels.h"
+#include <math.h>
+#include <string.h>
+
+// log2 of E[power] minus E[log2 power] for noise-like bins: the estimate
+// averages log power, which sits 0.83 log2 units below the mean power
+static const int32_t LOG_BIAS = 852;
+// Mean clamped a-posteriori SNR (Q10 log2) above which a hop is speech
+static const int32_t SPEECH_SCORE = 1024;
+static const int32_t SCORE_CLAMP = 4 << 10;
+// While speech is present the estimate may only creep up (Q10 per hop)
+static const int32_t NOISE_RISE = 2;
+static const uint16_t CALIBRATION_HOPS = 10;
+// Noise is subtracted this many times over: single subtraction leaves
+// most noise bins only lightly attenuated
+static const double OVER_SUBTRACTION = 3.0;
+
+// Gain versus a-posteriori SNR in steps of 1/8 log2 unit (0.375 dB)
+static const int GAIN_STEPS = 128;
+static const int GAIN_STEP_SHIFT = 7;
+static uint16_t GainTable[GAIN_STEPS];
+
+static uint16_t WindowLength = 0;
+static int16_t Window[NS_MAX_FRAME];  // sqrt-Hann, Q15
+
+// Working buffers: Re and Im back to back so both normalise together
+static int16_t Buffer[2 * NS_FFT_SIZE];
+static int32_t BinLog[NS_BINS];
+
+static void BuildTables(size_t Length) {
+  DspFftInit();
+  if (WindowLength == Length) return;
+
+  // Periodic sqrt-Hann: analysis x synthesis sums to one at 50% overlap
+  for (size_t I = 0; I < Length; I++) {
+    double Hann = 0.5 - 0.5 * cos(2.0 * M_PI * I / Length);
+    Window[I] = DspSat16((int32_t)lround(32767.0 * sqrt(Hann)));
+  }
+
+  // Power spectral subtraction: |G|^2 = 1 - a N/P, floored
+  double Floor = pow(10.0, -NS_MAX_ATTENUATION_DB / 20.0);
+  for (int I = 0; I < GAIN_STEPS; I++) {
+    double Ratio = pow(2.0, (double)I / (1 << (10 - GAIN_STEP_SHIFT)));
+    double Gain = Ratio > OVER_SUBTRACTION ? sqrt(1.0 - OVER_SUBTRACTION / Ratio) : 0.0;
+    if (Gain < Floor) Gain = Floor;
+    GainTable[I] = (uint16_t)lround(32767.0 * Gain);
+  }
+  WindowLength = (uint16_t)Length;
+}
+
+bool NsInit(Ns_t* Ns, size_t FrameSamples) {
+  if (FrameSamples < 2 || FrameSamples > NS_MAX_FRAME || FrameSamples % 2 != 0) return false;
+  BuildTables(FrameSamples);
+  Ns->FrameSamples = (uint16_t)FrameSamples;
+  Ns->Hop = (uint16_t)(FrameSamples / 2);
+  NsReset(Ns);
+  return true;
+}
+
+void NsReset(Ns_t* Ns) {
+  Ns->Calibration = CALIBRATION_HOPS;
+  Ns->Speech = false;
+  Ns->MeanGainQ15 = 32767;
+  memset(Ns->NoiseLog, 0, sizeof(Ns->NoiseLog));
+  for (int K = 0; K < NS_BINS; K++) Ns->Gain[K] = 32767;
+  memset(Ns->Input, 0, sizeof(Ns->Input));
+  memset(Ns->Overlap, 0, sizeof(Ns->Overlap));
+}
+
+// Per-bin noise tracking and gains for one hop's log power spectrum
+static void DSP_HOT UpdateGains(Ns_t* Ns) {
+  if (Ns->Calibration > 0) {
+    // Seed from the first hops; pass audio through meanwhile
+    bool First = Ns->Calibration == CALIBRATION_HOPS;
+    for (int K = 0; K < NS_BINS; K++) {
+      Ns->NoiseLog[K] = First ? BinLog[K] : Ns->NoiseLog[K] + ((BinLog[K] - Ns->NoiseLog[K]) >> 2);
+    }
+    Ns->Calibration--;
+    return;
+  }
+
+  int32_t Score = 0;
+  for (int K = 1; K < NS_BINS; K++) {
+    int32_t Snr = BinLog[K] - Ns->NoiseLog[K] - LOG_BIAS;
+    Score += Snr < 0 ? 0 : (Snr > SCORE_CLAMP ? SCORE_CLAMP : Snr);
+  }
+  Ns->Speech = Score / (NS_BINS - 1) > SPEECH_SCORE;
+
+  uint32_t GainSum = 0;
+  for (int K = 0; K < NS_BINS; K++) {
+    int32_t Log = BinLog[K];
+    int32_t Snr = Log - Ns->NoiseLog[K] - LOG_BIAS;
+    int Step = Snr <= 0 ? 0 : Snr >> GAIN_STEP_SHIFT;
+    uint16_t Target = GainTable[Step < GAIN_STEPS ? Step : GAIN_STEPS - 1];
+
+    // Open at once, close over a couple of hops to limit musical noise
+    Ns->Gain[K] = Target >= Ns->Gain[K] ? Target : (uint16_t)((Ns->Gain[K] + Target) >> 1);
+    GainSum += Ns->Gain[K];
+
+    if (!Ns->Speech || Log < Ns->NoiseLog[K]) {
+      Ns->NoiseLog[K] += (Log - Ns->NoiseLog[K]) >> 4;
+    } else {
+      Ns->NoiseLog[K] += NOISE_RISE;
+    }
+  }
+  Ns->MeanGainQ15 = (uint16_t)(GainSum / NS_BINS);
+}
+
+static void DSP_HOT ProcessHop(Ns_t* Ns, int16_t* Samples) {
+  const size_t Hop = Ns->Hop;
+  const size_t Length = Ns->FrameSamples;
+  int16_t* Re = Buffer;
+  int16_t* Im = Buffer + NS_FFT_SIZE;
+
+  memmove(Ns->Input, Ns->Input + Hop, Hop * sizeof(int16_t));
+  memcpy(Ns->Input + Hop, Samples, Hop * sizeof(int16_t));
+
+  for (size_t I = 0; I < Length; I++) {
+    Re[I] = (int16_t)((Ns->Input[I] * Window[I] + (1 << 14)) >> 15);
+  }
+  memset(Re + Length, 0, (NS_FFT_SIZE - Length) * sizeof(int16_t));
+  memset(Im, 0, NS_FFT_SIZE * sizeof(int16_t));
+
+  int Shift = DspNormalizeQ15(Re, Length);
+  int Exponent = DspFftQ15(Re, Im, NS_FFT_LOG2) - Shift;
+
+  for (int K = 0; K < NS_BINS; K++) {
+    int32_t R = Re[K], I = Im[K];
+    uint32_t Power = (uint32_t)(R * R) + (uint32_t)(I * I);
+    BinLog[K] = DspLog2Q10((uint64_t)Power + 1) + 2 * Exponent * 1024;
+  }
+  UpdateGains(Ns);
+
+  // Apply the gains and rebuild the conjugate-symmetric upper half,
+  // conjugated for the inverse: IDFT(X) = conj(DFT(conj(X))) / N
+  for (int K = 0; K < NS_BINS; K++) {
+    int32_t G = Ns->Gain[K];
+    Re[K] = (int16_t)((Re[K] * G + (1 << 14)) >> 15);
+    Im[K] = (int16_t)(-((Im[K] * G + (1 << 14)) >> 15));
+  }
+  for (int K = 1; K < NS_FFT_SIZE / 2; K++) {
+    Re[NS_FFT_SIZE - K] = Re[K];
+    Im[NS_FFT_SIZE - K] = (int16_t)-Im[K];
+  }
+
+  int InverseShift = DspNormalizeQ15(Buffer, 2 * NS_FFT_SIZE);
+  Exponent += DspFftQ15(Re, Im, NS_FFT_LOG2) - InverseShift - NS_FFT_LOG2;
+
+  // Synthesis window carries the Q15 scale; fold the exponent into it
+  int Down = 15 - Exponent;
+  for (size_t I = 0; I < Length; I++) {
+    int64_t Value = (int64_t)Re[I] * Window[I];
+    Value = Down > 0 ? (Value + ((int64_t)1 << (Down - 1))) >> Down : Value * ((int64_t)1 << -Down);
+    int32_t Sample = (int32_t)(Value > 65535 ? 65535 : (Value < -65536 ? -65536 : Value));
+    if (I < Hop) {
+      Samples[I] = DspSat16(Ns->Overlap[I] + Sample);
+    } else {
+      Ns->Overlap[I - Hop] = DspSat16(Sample);
+    }
+  }
+}
+
+void NsProcess(Ns_t* Ns, int16_t* Frame) {
+  ProcessHop(Ns, Frame);
+  ProcessHop(Ns, Frame + Ns->Hop);
+}
+
+uint8_t NsAttenuationDb(const Ns_t* Ns) {
+  if (Ns->MeanGainQ15 == 0) return NS_MAX_ATTENUATION_DB;
+  // 20 log10(32768 / g) = 6.02 * (15 - log2 g)
+  int32_t Log = (15 << 10) - DspLog2Q10(Ns->MeanGainQ15);
+  return (uint8_t)(Log <= 0 ? 0 : Log * 602 / 102400);
+}
@@ -0,0 +1,80 @@
+#include "../h/Plc.h"
+#include <string.h>
+
+static const size_t MATCH_WINDOW = 240;  // Samples compared per candidate lag
+
+void PlcInit(Plc_t* Plc) {
+  memset(Plc, 0, sizeof(*Plc));
+}
+
+void PlcRemember(Plc_t* Plc, const int16_t* Samples, size_t Count) {
+  if (Count >= PLC_HISTORY) {
+    memcpy(Plc->History, Samples + Count - PLC_HISTORY, PLC_HISTORY * sizeof(int16_t));
+    Plc->Filled = PLC_HISTORY;
+    return;
+  }
+  memmove(Plc->History, Plc->History + Count, (PLC_HISTORY - Count) * sizeof(int16_t));
+  memcpy(Plc->History + PLC_HISTORY - Count, Samples, Count * sizeof(int16_t));
+  Plc->Filled = Plc->Filled + Count > PLC_HISTORY ? PLC_HISTORY : Plc->Filled + Count;
+}
+
+// Lag with the best normalized correlation between the newest samples and
+// the ones a period earlier
+static uint16_t FindPeriod(const int16_t* History) {
+  const int16_t* Tail = History + PLC_HISTORY - MATCH_WINDOW;
+  uint64_t BestScore = 0;
+  uint16_t Best = PLC_MAX_PERIOD;
+
+  for (uint16_t Lag = PLC_MIN_PERIOD; Lag <= PLC_MAX_PERIOD; Lag++) {
+    const int16_t* Past = Tail - Lag;
+    int64_t Cross = 0;
+    uint64_t Energy = 1;
+    for (size_t I = 0; I < MATCH_WINDOW; I++) {
+      Cross += (int32_t)Tail[I] * Past[I];
+      Energy += (uint32_t)((int32_t)Past[I] * Past[I]);
+    }
+    if (Cross <= 0) continue;
+    // Cross^2 / Energy, scaled down so the square fits in 64 bits
+    uint64_t Scaled = (uint64_t)(Cross >> 8);
+    uint64_t Score = Scaled * Scaled / Energy;
+    if (Score > BestScore) {
+      BestScore = Score;
+      Best = Lag;
+    }
+  }
+  return Best;
+}
+
+size_t PlcConceal(Plc_t* Plc, int16_t* Out, size_t Count) {
+  if (Plc->Filled < PLC_HISTORY) return 0;
+  if (Plc->Period == 0) {
+    Plc->Period = FindPeriod(Plc->History);
+    Plc->Phase = 0;
+    Plc->Concealed = 0;
+  }
+
+  const int16_t* Cycle = Plc->History + PLC_HISTORY - Plc->Period;
+  size_t Written = 0;
+  while (Written < Count && Plc->Concealed < PLC_FADE_SAMPLES) {
+    int32_t Gain = (int32_t)(((PLC_FADE_SAMPLES - Plc->Concealed) << 15) / PLC_FADE_SAMPLES);
+    Out[Written++] = (int16_t)((Cycle[Plc->Phase] * Gain) >> 15);
+    if (++Plc->Phase == Plc->Period) Plc->Phase = 0;
+    Plc->Concealed++;
+  }
+  if (Written > 0) Plc->Resume = true;
+  return Written;
+}
+
+bool PlcResume(Plc_t* Plc, int16_t* Samples, size_t Count) {
+  Plc->Period = 0;
+  if (Plc->Resume) {
+    Plc->Resume = false;
+    Plc->FadeIn = PLC_RESUME_SAMPLES;
+  }
+
+  size_t I = 0;
+  for (; I < Count && Plc->FadeIn > 0; I++, Plc->FadeIn--) {
+    Samples[I] = (int16_t)((Samples[I] * (int32_t)(PLC_RESUME_SAMPLES - Plc->FadeIn)) / PLC_RESUME_SAMPLES);
+  }
+  return Plc->FadeIn > 0;
+}
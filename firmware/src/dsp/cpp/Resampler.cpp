@@ -0,0 +1,171 @@
+#include "../h/Resampler.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Passband edge as a fraction of the lower Nyquist frequency, and the
+// Kaiser window shape (about 60 dB stopband at 24 taps per phase)
+static const double CUTOFF = 0.9;
+static const double KAISER_BETA = 6.0;
+
+static uint32_t Gcd(uint32_t A, uint32_t B) {
+  while (B != 0) {
+    uint32_t T = A % B;
+    A = B;
+    B = T;
+  }
+  return A;
+}
+
+// Zeroth-order modified Bessel function, for the Kaiser window
+static double BesselI0(double X) {
+  double Sum = 1.0;
+  double Term = 1.0;
+  for (int K = 1; K < 32; K++) {
+    Term *= (X / (2.0 * K)) * (X / (2.0 * K));
+    Sum += Term;
+    if (Term < Sum * 1e-12) break;
+  }
+  return Sum;
+}
+
+// Prototype h[n] at Phases times the input rate, n = Tap * Phases + Phase,
+// stored per phase with the newest input first; Count may add one phase
+// past the last (the first, a sample later) to interpolate towards. Each
+// phase is normalised to unity DC gain so no phase-dependent ripple leaks
+// into the output.
+static void DesignFilter(Resampler_t* Resampler, uint32_t Phases, uint32_t Count) {
+  size_t Length = (size_t)RESAMPLER_TAPS * Phases;
+  double Center = (Length - 1) / 2.0;
+  double Ratio = (double)Resampler->OutRate / Resampler->InRate;
+  double Fc = CUTOFF * 0.5 / Phases * (Ratio < 1.0 ? Ratio : 1.0);
+  double Norm = BesselI0(KAISER_BETA);
+
+  for (uint32_t P = 0; P < Count; P++) {
+    double Taps[RESAMPLER_TAPS];
+    double Sum = 0.0;
+    for (int K = 0; K < RESAMPLER_TAPS; K++) {
+      double N = (double)K * Phases + P;
+      double X = N - Center;
+      double Sinc = X == 0.0 ? 1.0 : sin(2.0 * M_PI * Fc * X) / (2.0 * M_PI * Fc * X);
+      double R = X / (Center + 0.5);
+      double Window = R * R < 1.0 ? BesselI0(KAISER_BETA * sqrt(1.0 - R * R)) / Norm : 0.0;
+      Taps[K] = Sinc * Window;
+      Sum += Taps[K];
+    }
+
+    int16_t* Out = Resampler->Coeffs + P * RESAMPLER_TAPS;
+    int32_t Total = 0;
+    int Peak = 0;
+    for (int K = 0; K < RESAMPLER_TAPS; K++) {
+      Out[K] = DspSat16((int32_t)lround(32768.0 * Taps[K] / Sum));
+      Total += Out[K];
+      if (Out[K] > Out[Peak]) Peak = K;
+    }
+    // Put the rounding error on the largest tap
+    Out[Peak] = DspSat16(Out[Peak] + 32768 - Total);
+  }
+}
+
+bool ResamplerInit(Resampler_t* Resampler, uint32_t InRate, uint32_t OutRate) {
+  ResamplerFree(Resampler);
+  Resampler->InRate = InRate;
+  Resampler->OutRate = OutRate;
+  ResamplerReset(Resampler);
+  if (InRate == 0 || OutRate == 0 || InRate > UINT16_MAX || OutRate > UINT16_MAX) return false;
+  if (InRate == OutRate) return true;
+
+  uint32_t Divisor = Gcd(InRate, OutRate);
+  uint32_t Up = OutRate / Divisor;
+  uint32_t Down = InRate / Divisor;
+  // Too many phases for a table of its own: interpolate in a finer one
+  uint32_t Phases = Up <= RESAMPLER_MAX_PHASES ? Up : RESAMPLER_MAX_PHASES;
+  uint32_t Count = Phases == Up ? Phases : Phases + 1;
+
+  Resampler->Coeffs = (int16_t*)DspMalloc(Count * RESAMPLER_TAPS * sizeof(int16_t));
+  if (!Resampler->Coeffs) return false;
+  Resampler->Up = (uint16_t)Up;
+  Resampler->Down = (uint16_t)Down;
+  Resampler->Phases = (uint16_t)Phases;
+  DesignFilter(Resampler, Phases, Count);
+  return true;
+}
+
+void ResamplerFree(Resampler_t* Resampler) {
+  free(Resampler->Coeffs);
+  Resampler->Coeffs = NULL;
+  Resampler->Up = 1;
+  Resampler->Down = 1;
+  Resampler->Phases = 1;
+}
+
+void ResamplerReset(Resampler_t* Resampler) {
+  memset(Resampler->Delay, 0, sizeof(Resampler->Delay));
+  Resampler->Pos = 0;
+  Resampler->Phase = 0;
+}
+
+size_t ResamplerMaxOutput(const Resampler_t* Resampler, size_t InCount) {
+  if (ResamplerIsBypass(Resampler)) return InCount;
+  return (InCount * Resampler->Up) / Resampler->Down + 1;
+}
+
+size_t ResamplerMaxInput(const Resampler_t* Resampler, size_t OutCapacity) {
+  if (ResamplerIsBypass(Resampler)) return OutCapacity;
+  if (OutCapacity == 0) return 0;
+  return ((OutCapacity - 1) * Resampler->Down) / Resampler->Up;
+}
+
+DSP_HOT static inline int16_t Dot(const int16_t* Coeffs, const int16_t* Window) {
+  int32_t Acc = 1 << 14;
+  for (int K = 0; K < RESAMPLER_TAPS; K++) {
+    Acc += (int32_t)Coeffs[K] * Window[K];
+  }
+  return DspSat16(Acc >> 15);
+}
+
+DSP_HOT size_t ResamplerProcess(Resampler_t* Resampler, const int16_t* In, size_t InCount, int16_t* Out) {
+  if (ResamplerIsBypass(Resampler)) {
+    if (Out != In) memmove(Out, In, InCount * sizeof(int16_t));
+    return InCount;
+  }
+
+  const uint32_t Up = Resampler->Up;
+  const uint32_t Down = Resampler->Down;
+  const uint32_t Phases = Resampler->Phases;
+  const bool Exact = Phases == Up;
+  uint32_t Phase = Resampler->Phase;
+  uint16_t Pos = Resampler->Pos;
+  size_t Produced = 0;
+
+  for (size_t I = 0; I < InCount; I++) {
+    Pos = Pos == 0 ? RESAMPLER_TAPS - 1 : Pos - 1;
+    Resampler->Delay[Pos] = In[I];
+    Resampler->Delay[Pos + RESAMPLER_TAPS] = In[I];
+
+    // Every output that falls between this input and the next
+    if (Exact) {
+      while (Phase < Up) {
+        Out[Produced++] = Dot(Resampler->Coeffs + Phase * RESAMPLER_TAPS, Resampler->Delay + Pos);
+        Phase += Down;
+      }
+    } else {
+      while (Phase < Up) {
+        // Between table phases Index and Index + 1, Frac (Q15) of the way
+        uint32_t Scaled = Phase * Phases;
+        uint32_t Index = Scaled / Up;
+        int32_t Frac = (int32_t)(((Scaled - Index * Up) << 15) / Up);
+        const int16_t* Coeffs = Resampler->Coeffs + Index * RESAMPLER_TAPS;
+        int32_t A = Dot(Coeffs, Resampler->Delay + Pos);
+        int32_t B = Dot(Coeffs + RESAMPLER_TAPS, Resampler->Delay + Pos);
+        Out[Produced++] = DspSat16(A + (((B - A) * Frac + (1 << 14)) >> 15));
+        Phase += Down;
+      }
+    }
+    Phase -= Up;
+  }
+
+  Resampler->Phase = Phase;
+  Resampler->Pos = Pos;
+  return Produced;
+}
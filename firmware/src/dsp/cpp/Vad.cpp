@@ -0,0 +1,125 @@
+#include "../h/Vad.h"
+
+// Decision thresholds, on the first-difference energy
+static const uint32_t MIN_ENERGY = 60 * 60;      // Absolute floor (RMS 60)
+static const uint32_t ENERGY_MARGIN = 2;         // +3 dB over mean noise: candidate
+static const uint32_t STRONG_MARGIN = 32;        // +15 dB over mean noise: speech
+static const uint16_t ZCR_MIN = 5;               // Per mille; below = rumble
+static const uint16_t ZCR_MAX = 400;             // Above = hiss
+static const uint16_t HIGH_RATIO_MIN = 16;       // Q12 (~0.004, centroid ~250 Hz); below = fan/HVAC
+static const uint16_t HIGH_RATIO_MAX = 4915;     // Q12 (~1.2); above = hiss
+static const uint16_t CALIBRATION_FRAMES = 10;
+
+void VadInit(Vad_t* Vad, uint16_t HangoverFrames) {
+  Vad->NoiseFloor = MIN_ENERGY;
+  Vad->HighFloor = MIN_ENERGY;
+  Vad->Calibration = CALIBRATION_FRAMES;
+  Vad->HangoverFrames = HangoverFrames;
+  Vad->Hangover = 0;
+  Vad->Speech = false;
+  Vad->Energy = 0;
+  Vad->HighEnergy = 0;
+  Vad->ZcrPerMille = 0;
+  Vad->HighRatioQ12 = 0;
+}
+
+bool DSP_HOT VadProcess(Vad_t* Vad, const int16_t* Frame, size_t Count) {
+  if (Count < 2) return Vad->Hangover > 0;
+
+  // One pass: energy, first-difference (high-band) energy, zero crossings
+  uint64_t Energy = 0;
+  uint64_t HighEnergy = 0;
+  uint32_t Crossings = 0;
+  int32_t Prev = Frame[0];
+  Energy += (uint32_t)(Prev * Prev);
+  for (size_t I = 1; I < Count; I++) {
+    int32_t S = Frame[I];
+    int32_t D = S - Prev;
+    Energy += (uint32_t)(S * S);
+    HighEnergy += (uint64_t)((int64_t)D * D);
+    Crossings += (uint32_t)((S ^ Prev) < 0);
+    Prev = S;
+  }
+
+  uint32_t Mean = (uint32_t)(Energy / Count);
+  uint32_t High = (uint32_t)(HighEnergy / Count);
+  Vad->Energy = Mean;
+  Vad->HighEnergy = High;
+  Vad->ZcrPerMille = (uint16_t)(Crossings * 1000 / Count);
+  uint64_t Ratio = Energy ? (HighEnergy << 12) / Energy : 0;
+  Vad->HighRatioQ12 = (uint16_t)(Ratio > 0xFFFF ? 0xFFFF : Ratio);
+
+  // Seed the floors from the first frames instead of guessing
+  if (Vad->Calibration > 0) {
+    uint32_t Seen = CALIBRATION_FRAMES - Vad->Calibration;
+    Vad->NoiseFloor = Seen == 0 ? Mean : (uint32_t)(((uint64_t)Vad->NoiseFloor * Seen + Mean) / (Seen + 1));
+    Vad->HighFloor = Seen == 0 ? High : (uint32_t)(((uint64_t)Vad->HighFloor * Seen + High) / (Seen + 1));
+    if (Vad->HighFloor < MIN_ENERGY / 4) Vad->HighFloor = MIN_ENERGY / 4;
+    Vad->Calibration--;
+    Vad->Speech = false;
+    return false;
+  }
+
+  // Decide on the first-difference energy: it keeps the formants but takes
+  // mains hum (and the bursts of it noise suppression lets through) down
+  // by 15-25 dB against them
+  uint64_t Floor = Vad->HighFloor;
+  bool Speech = false;
+  if (High >= MIN_ENERGY) {
+    if (High > Floor * STRONG_MARGIN) {
+      Speech = true;
+    } else if (High > Floor * ENERGY_MARGIN) {
+      // Moderate energy: only speech-like spectra count
+      Speech = Vad->ZcrPerMille >= ZCR_MIN && Vad->ZcrPerMille <= ZCR_MAX &&
+               Vad->HighRatioQ12 >= HIGH_RATIO_MIN && Vad->HighRatioQ12 <= HIGH_RATIO_MAX;
+    }
+  }
+  Vad->Speech = Speech;
+
+  // Decision floor: follows the mean of the noise, not its dips, so the
+  // margins hold against noise that flickers (noise suppression leaves
+  // plenty). Loud frames still pull it up very slowly, so a louder new
+  // background cannot lock the detector in speech.
+  if (Speech || High > Floor * ENERGY_MARGIN) {
+    Vad->HighFloor += (High - Vad->HighFloor) >> 12;
+  } else if (High < Vad->HighFloor) {
+    Vad->HighFloor -= (Vad->HighFloor - High) >> 2;
+  } else {
+    Vad->HighFloor += (High - Vad->HighFloor) >> 4;
+  }
+  if (Vad->HighFloor < MIN_ENERGY / 4) Vad->HighFloor = MIN_ENERGY / 4;
+
+  // Full-band floor, for the comfort-noise level only: follows drops
+  // quickly and creeps up slowly
+  if (Mean < Vad->NoiseFloor) {
+    Vad->NoiseFloor -= (Vad->NoiseFloor - Mean) >> 2;
+  } else {
+    Vad->NoiseFloor += (Mean - Vad->NoiseFloor) >> (Speech ? 12 : 6);
+  }
+
+  // Every speech frame re-arms the hangover, so pauses between words and
+  // weak syllables inside a talkspurt are carried across
+  if (Speech) {
+    Vad->Hangover = Vad->HangoverFrames;
+    return true;
+  }
+  if (Vad->Hangover > 0) {
+    Vad->Hangover--;
+    return true;
+  }
+  return false;
+}
+
+uint8_t VadNoiseLevelDb(const Vad_t* Vad) {
+  // 10*log10(32767^2 / floor) using integer log2 (1 bit ~ 3 dB)
+  uint32_t Floor = Vad->NoiseFloor ? Vad->NoiseFloor : 1;
+  int Bits = 0;
+  while (Floor > 1) {
+    Floor >>= 1;
+    Bits++;
+  }
+  int Db = (30 - Bits) * 3;
+  if (Db < 0) Db = 0;
+  if (Db > 96) Db = 96;
+  return (uint8_t)Db;
+}
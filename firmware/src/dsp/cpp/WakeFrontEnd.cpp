@@ -0,0 +1,85 @@
+#include "../h/WakeFrontEnd.h"
+#include "../h/AudioKernels.h"
+
+const WakeParams_t WAKE_DEFAULT_PARAMS = {
+  300.0f,  // MinThreshold
+  2.5f,    // ThresholdMultiplier
+  0.98f,   // AmbientDecay
+  0.05f,   // AmbientRise
+  1.6f,    // EarlyEnergyMultiplier
+  3,       // RequiredFrames
+  20       // CalibrationFrames
+};
+
+static const float INITIAL_AMBIENT = 200.0f;
+static const float INITIAL_THRESHOLD = 500.0f;
+
+void MicChainDesign(MicChain_t* Chain, uint32_t SampleRate, uint32_t BypassMask) {
+  DspBiquadHighPass(&Chain->Stage<1>(), SampleRate, MIC_HIGHPASS_HZ, 0.707f);
+  Chain->BypassMask = BypassMask;
+}
+
+void WakeFrontEndInit(WakeFrontEnd_t* Wake, uint32_t SampleRate, size_t FrameSamples) {
+  Wake->Params = WAKE_DEFAULT_PARAMS;
+  Wake->SampleRate = SampleRate;
+  Wake->FrameSamples = FrameSamples;
+  Wake->ConditionCycles = 0;
+  WakeFrontEndReset(Wake);
+}
+
+void WakeFrontEndReset(WakeFrontEnd_t* Wake) {
+  Wake->Rms = 0.0f;
+  Wake->Ambient = INITIAL_AMBIENT;
+  Wake->Threshold = INITIAL_THRESHOLD;
+  Wake->Consecutive = 0;
+  Wake->CalibrationCount = 0;
+  Wake->Calibrated = false;
+  Wake->EarlyEnergy = false;
+}
+
+void WakeFrontEndProcess(WakeFrontEnd_t* Wake, const int16_t* Frame) {
+  size_t Count = Wake->FrameSamples;
+
+  // The raw level: the gate's thresholds predate any conditioning
+  uint32_t Start = DspCycles();
+  uint64_t Energy = DspEnergy(Frame, Count);
+  Wake->Rms = (float)DspRmsFromEnergy(Energy, Count) * WAKE_RMS_SCALE;
+  Wake->ConditionCycles = DspCycles() - Start;
+}
+
+static float MaxF(float A, float B) {
+  return A > B ? A : B;
+}
+
+WakeEvent_t WakeFrontEndDetect(WakeFrontEnd_t* Wake) {
+  const WakeParams_t* P = &Wake->Params;
+  float Rms = Wake->Rms;
+
+  if (!Wake->Calibrated) {
+    Wake->Ambient = (Wake->Ambient * Wake->CalibrationCount + Rms) / (Wake->CalibrationCount + 1);
+    Wake->CalibrationCount++;
+    if (Wake->CalibrationCount < P->CalibrationFrames) return WAKE_EVENT_NONE;
+    Wake->Calibrated = true;
+    Wake->Threshold = MaxF(P->MinThreshold, Wake->Ambient * P->ThresholdMultiplier);
+    return WAKE_EVENT_CALIBRATED;
+  }
+
+  Wake->Threshold = MaxF(P->MinThreshold, Wake->Ambient * P->ThresholdMultiplier);
+  Wake->EarlyEnergy = Rms > MaxF(P->MinThreshold * 0.5f, Wake->Ambient * P->EarlyEnergyMultiplier);
+
+  if (Rms > Wake->Threshold) {
+    Wake->Consecutive++;
+    if (Wake->Consecutive >= P->RequiredFrames) {
+      Wake->Consecutive = 0;
+      return WAKE_EVENT_WAKE;
+    }
+  } else {
+    Wake->Consecutive = 0;
+    if (Rms < Wake->Ambient) {
+      Wake->Ambient = Wake->Ambient * P->AmbientDecay + Rms * (1.0f - P->AmbientDecay);
+    } else if (Rms < Wake->Threshold * 0.7f) {
+      Wake->Ambient = Wake->Ambient * (1.0f - P->AmbientRise) + Rms * P->AmbientRise;
+    }
+  }
+  return WAKE_EVENT_NONE;
+}
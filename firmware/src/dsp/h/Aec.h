@@ -0,0 +1,93 @@
+#pragma once
+#include "DspCommon.h"
+
+// --- Acoustic Echo Canceller ---
+// Partitioned-block frequency-domain adaptive filter (overlap-save, one
+// block per partition) that models the speaker-to-mic path from the
+// far-end reference and subtracts its estimate from the mic signal. Each
+// bin is normalized by its own reference power, and one partition per
+// block is constrained back to a linear convolution, so the long tail
+// converges about as fast as a short time-domain filter would.
+//
+// The reference may run up to AEC_DELAY_MAX samples ahead of the echo: a
+// cross-correlation of the decimated mic and reference signals finds the
+// bulk delay and the filter starts just before it, so its taps cover the
+// room rather than timing slack. A delay change shifts the partitions,
+// keeping what was learned.
+//
+// Each block's residual feeds a double-talk detector that freezes
+// adaptation (with hangover) as soon as near-end speech appears. The same
+// test on energies averaged over ~85 ms decides whether the user is really
+// talking (NearEnd): single blocks of reverberant tail the filter cannot
+// reach are enough to freeze it, but not to interrupt the assistant.
+// Integer only: block-floating-point Q15 spectra, Q24 weights, 64-bit
+// accumulation.
+
+#define AEC_BLOCK 32            // Samples per block and partition (1.3 ms at 24 kHz)
+#define AEC_PARTITIONS 64
+#define AEC_TAPS (AEC_BLOCK * AEC_PARTITIONS)  // Echo tail: 85 ms at 24 kHz
+#define AEC_FFT_LOG2 6
+#define AEC_FFT_SIZE (1 << AEC_FFT_LOG2)       // Two blocks
+#define AEC_BINS (AEC_FFT_SIZE / 2 + 1)
+
+#define AEC_DELAY_MAX 2048      // Bulk delay search range (85 ms at 24 kHz)
+#define AEC_DECIMATION 8        // Delay search resolution
+#define AEC_LAGS (AEC_DELAY_MAX / AEC_DECIMATION)
+#define AEC_HISTORY (AEC_DELAY_MAX + 2 * AEC_BLOCK)
+
+typedef struct {
+  // Filter: partition 0 covers the AEC_BLOCK samples from Delay on
+  int32_t WeightRe[AEC_PARTITIONS][AEC_BINS];  // Q24
+  int32_t WeightIm[AEC_PARTITIONS][AEC_BINS];
+  int16_t SpectrumRe[AEC_PARTITIONS][AEC_BINS];  // Reference blocks, a ring
+  int16_t SpectrumIm[AEC_PARTITIONS][AEC_BINS];
+  int8_t SpectrumExp[AEC_PARTITIONS];  // True spectrum = stored << exponent
+  uint8_t Newest;                      // Ring slot of the latest block
+  uint8_t Constrain;                   // Partition constrained next
+  uint64_t BinPower[AEC_BINS];         // |X|^2 over about AEC_PARTITIONS blocks
+  // Reference delay line (a ring over the last AEC_HISTORY samples)
+  int16_t Reference[AEC_HISTORY];
+  uint16_t Head;              // Next write position
+  uint16_t Delay;             // Samples between the reference and partition 0
+  bool DelayValid;            // Delay comes from the correlation, not the default
+  // Bulk delay search on AEC_DECIMATION-sample averages
+  int32_t DecimateRef, DecimateMic;
+  uint8_t DecimateFill;
+  int16_t DecimatedRef[AEC_LAGS];  // Ring
+  uint16_t DecimatedPos;
+  uint16_t WindowFill;
+  uint64_t WindowRefEnergy;
+  int64_t Correlation[AEC_LAGS];   // This window
+  int64_t Smoothed[AEC_LAGS];      // Across windows
+  int16_t Candidate;               // Lag the last window peaked at, -1 if none
+  // Echo tracking and double talk
+  uint64_t SmoothedMic;       // Mic / residual energy while adapting (ERLE tracking)
+  uint64_t SmoothedResidual;
+  uint64_t ShortMic;          // The same over the last few blocks (double talk)
+  uint64_t ShortResidual;
+  uint64_t SlowMic;           // And over ~85 ms (near-end speech)
+  uint64_t SlowResidual;
+  uint16_t DoubleTalkHold;    // Blocks left before adaptation resumes
+  uint16_t DoubleTalkBlocks;  // Consecutive blocks flagged as double talk
+  bool Converged;             // Filter achieves useful cancellation
+  bool FarActive;             // Last block had far-end signal
+  bool DoubleTalk;            // Near-end speech over the echo (with hangover)
+  uint16_t NearBlocks;        // Blocks of the current AecProcess call with near-end speech
+  bool NearEnd;               // Near-end speech through at least half of the last call
+} Aec_t;
+
+void AecInit(Aec_t* Aec);
+
+// Forget the reference history and delay search (after a gap in playback);
+// keeps the taps and the delay in use
+void AecResetHistory(Aec_t* Aec);
+
+// Cancel echo from Mic in place. Ref[n] is the speaker sample played at the
+// time Mic[n] was captured, moved up to AEC_DELAY_MAX samples earlier; the
+// echo may lag it by anything in that range. Count should be a multiple of
+// AEC_BLOCK (every 20 ms frame at the usual rates is); a partial block at
+// the end only feeds the reference history.
+void AecProcess(Aec_t* Aec, const int16_t* Ref, int16_t* Mic, size_t Count);
+
+// Echo return loss enhancement while adapting, in dB
+int32_t AecErleDb(const Aec_t* Aec);
@@ -0,0 +1,52 @@
+#pragma once
+#include "DspCommon.h"
+
+// --- Automatic Gain Control ---
+// Block-based AGC with a look-ahead peak limiter for the mic path. Audio
+// is delayed by one 2.5 ms block: the level gain follows the RMS towards
+// the target (fast attack, slow release, held while the input sits at the
+// noise floor), and the applied gain is capped so neither the delayed
+// block nor the one behind it can exceed the ceiling. The gain ramps
+// linearly across each block, so it never steps.
+
+#define AGC_MAX_BLOCK 128        // 2.5 ms up to 51.2 kHz
+#define AGC_GAIN_ONE 1024        // Gains are Q10
+#define AGC_MAX_GAIN (512 * AGC_GAIN_ONE - 1)  // 54 dB: speech at 3 m is ~-70 dBFS raw
+#define AGC_INITIAL_GAIN (32 * AGC_GAIN_ONE)  // The old fixed x32 mic boost
+
+typedef struct {
+  uint16_t Block;
+  uint16_t TargetRms;
+  int32_t MaxGain;           // Q10
+  int32_t LevelGain;         // Smoothed AGC gain, Q16
+  int32_t Applied;           // Gain at the end of the last output block, Q10
+  uint32_t Power;            // Mean square, smoothed over ~80 ms
+  uint32_t NoiseFloor;       // RMS floor (Q8), gates gain increases
+  int16_t Delay[AGC_MAX_BLOCK];  // Previous input block, output next
+  int16_t DelayPeak;
+  int16_t Pending[AGC_MAX_BLOCK];    // Input of the block being gathered
+  uint16_t PendingCount;
+  int16_t Ready[2 * AGC_MAX_BLOCK];  // Output not yet handed back (under a block between calls)
+  uint16_t ReadyCount;
+  // Diagnostics
+  uint32_t Samples;
+  uint32_t Clipped;          // Samples that still hit full scale
+  uint32_t LimitedBlocks;    // Blocks where the limiter overrode the AGC
+} Agc_t;
+
+// TargetDbfs: output RMS in dB below full scale. InitialGain and MaxGain
+// are Q10.
+void AgcInit(Agc_t* Agc, uint32_t SampleRate, uint8_t TargetDbfs, int32_t InitialGain, int32_t MaxGain);
+
+// Apply the gain in place. Output lags input by one block. Count may be
+// any length: a partial block is carried into the next call. When a call
+// holds back more input than any before it, the output is padded with that
+// much silence, so the lag grows by less than one more block in all.
+void AgcProcess(Agc_t* Agc, int16_t* Samples, size_t Count);
+
+// Applied gain in dB, x10 (e.g. 301 = 30.1 dB)
+int16_t AgcGainDb10(const Agc_t* Agc);
+
+// Clipped samples per million since the last reset
+uint32_t AgcClipPpm(const Agc_t* Agc);
+void AgcResetStats(Agc_t* Agc);
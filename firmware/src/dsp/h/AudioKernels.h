@@ -0,0 +1,20 @@
+#pragma once
+#include "DspCommon.h"
+
+// --- Audio Kernels ---
+// Per-frame PCM16 building blocks shared by the mic and speaker paths.
+
+// Sum of squares. One pass, integer only.
+uint64_t DspEnergy(const int16_t* Samples, size_t Count);
+
+// Integer square root (floor)
+uint32_t DspIsqrt64(uint64_t Value);
+
+// RMS from a sum of squares over Count samples
+uint32_t DspRmsFromEnergy(uint64_t Energy, size_t Count);
+
+// log2(Value) in Q10 (within 0.01); 0 for Value <= 1
+int32_t DspLog2Q10(uint64_t Value);
+
+// Unity Q15 gain
+#define DSP_Q15_ONE 32768
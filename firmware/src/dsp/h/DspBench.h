@@ -0,0 +1,32 @@
+#pragma once
+#include "DspCommon.h"
+
+// --- Kernel Benchmark ---
+// Per-frame cost of the audio kernels against the loops they replaced,
+// which are kept here only for the comparison. Costs are in DspCycles
+// units: CPU cycles on the device (AudioBenchmarkKernels, built with
+// -DAUDIO_KERNEL_BENCH), nanoseconds on the host (tools/kernel_bench).
+
+typedef enum {
+  DSP_BENCH_WAKE_RMS,         // Wake gate RMS: float byte-wise pass vs DspEnergy
+  DSP_BENCH_DOWNLINK_VOLUME,  // Volume: multiply and divide by 100 vs the speaker chain's DspGainStage
+  DSP_BENCH_COUNT
+} DspBenchKernel_t;
+
+typedef struct {
+  const char* Name;
+  uint32_t Before;  // Average per frame, previous loop
+  uint32_t After;   // Average per frame, current kernel
+  bool Match;       // Outputs agree (within one LSB of the old rounding)
+} DspBenchResult_t;
+
+#define DSP_BENCH_MAX_FRAME 2048
+
+// Time Runs random frames of FrameSamples (up to DSP_BENCH_MAX_FRAME)
+// through each pair
+void DspBenchKernels(size_t FrameSamples, int Runs, DspBenchResult_t Results[DSP_BENCH_COUNT]);
+
+// Average cost per frame of NsProcess on noise, once the estimate has
+// settled. The suppressor has no earlier loop to compare with. Returns 0
+// if NsInit rejects FrameSamples.
+uint32_t DspBenchNoiseSuppressor(size_t FrameSamples, int Runs);
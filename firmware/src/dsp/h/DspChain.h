@@ -0,0 +1,123 @@
+#pragma once
+#include "DspCommon.h"
+
+// --- DSP Chain ---
+// Stages composed at compile time: DspChain<A, B, C> runs every stage on
+// one sample before moving to the next, so a frame is a single loop with
+// the stage bodies inlined and no virtual dispatch. A stage is any struct
+// with
+//   int32_t Tick(int32_t X);      // one sample, 17-bit headroom
+//   void Reset();
+//   static const char* Name();
+// Samples travel between stages as int32 and are saturated to 16 bits at
+// the end. Bit N of BypassMask skips stage N at runtime. With Profile set
+// the frame runs stage by stage instead (saturating in between) so each
+// stage's cycles can be measured.
+
+#define DSP_CHAIN_MAX_STAGES 8
+
+template <typename... Stages>
+struct DspChainNode;
+
+template <>
+struct DspChainNode<> {
+  inline int32_t Tick(int32_t X, uint32_t) { return X; }
+  inline void Reset() {}
+  inline void RunEach(int16_t*, size_t, uint32_t, uint32_t*) {}
+  static const char* Name(size_t) { return ""; }
+};
+
+template <typename Head, typename... Tail>
+struct DspChainNode<Head, Tail...> {
+  Head Stage;
+  DspChainNode<Tail...> Rest;
+
+  inline int32_t Tick(int32_t X, uint32_t Bypass) {
+    if (!(Bypass & 1)) X = Stage.Tick(X);
+    return Rest.Tick(X, Bypass >> 1);
+  }
+
+  inline void Reset() {
+    Stage.Reset();
+    Rest.Reset();
+  }
+
+  // One loop per stage, timed
+  inline void RunEach(int16_t* Samples, size_t Count, uint32_t Bypass, uint32_t* Cycles) {
+    if (!(Bypass & 1)) {
+      uint32_t Start = DspCycles();
+      for (size_t I = 0; I < Count; I++) Samples[I] = DspSat16(Stage.Tick(Samples[I]));
+      uint32_t Spent = DspCycles() - Start;
+      *Cycles = *Cycles ? (*Cycles * 15 + Spent) / 16 : Spent;
+    } else {
+      *Cycles = 0;
+    }
+    Rest.RunEach(Samples, Count, Bypass >> 1, Cycles + 1);
+  }
+
+  static const char* Name(size_t Index) {
+    return Index == 0 ? Head::Name() : DspChainNode<Tail...>::Name(Index - 1);
+  }
+};
+
+// Type and storage of stage I
+template <size_t I, typename... Stages>
+struct DspChainAt;
+
+template <typename Head, typename... Tail>
+struct DspChainAt<0, Head, Tail...> {
+  typedef Head Type;
+  static Head& Get(DspChainNode<Head, Tail...>& Node) { return Node.Stage; }
+};
+
+template <size_t I, typename Head, typename... Tail>
+struct DspChainAt<I, Head, Tail...> {
+  typedef typename DspChainAt<I - 1, Tail...>::Type Type;
+  static Type& Get(DspChainNode<Head, Tail...>& Node) { return DspChainAt<I - 1, Tail...>::Get(Node.Rest); }
+};
+
+template <typename... Stages>
+class DspChain {
+ public:
+  static const size_t STAGE_COUNT = sizeof...(Stages);
+  static_assert(STAGE_COUNT > 0 && STAGE_COUNT <= DSP_CHAIN_MAX_STAGES, "DspChain needs 1..8 stages");
+
+  uint32_t BypassMask = 0;
+  bool Profile = false;
+  uint32_t StageCycles[STAGE_COUNT] = {0};  // Average per frame, while profiling
+  uint32_t FrameCycles = 0;                 // Average per frame, whole chain
+
+  template <size_t I>
+  typename DspChainAt<I, Stages...>::Type& Stage() {
+    return DspChainAt<I, Stages...>::Get(Nodes);
+  }
+
+  static const char* StageName(size_t Index) {
+    return Index < STAGE_COUNT ? DspChainNode<Stages...>::Name(Index) : "";
+  }
+
+  void Reset() { Nodes.Reset(); }
+
+  // In and Out may alias
+  void Process(const int16_t* In, int16_t* Out, size_t Count) {
+    uint32_t Start = DspCycles();
+    uint32_t Bypass = BypassMask;
+    if (Profile) {
+      if (Out != In) {
+        for (size_t I = 0; I < Count; I++) Out[I] = In[I];
+      }
+      Nodes.RunEach(Out, Count, Bypass, StageCycles);
+    } else {
+      for (size_t I = 0; I < Count; I++) {
+        Out[I] = DspSat16(Nodes.Tick(In[I], Bypass));
+      }
+    }
+    uint32_t Spent = DspCycles() - Start;
+    FrameCycles = FrameCycles ? (FrameCycles * 15 + Spent) / 16 : Spent;
+  }
+
+  void Process(int16_t* Samples, size_t Count) { Process(Samples, Samples, Count); }
+
+ private:
+  DspChainNode<Stages...> Nodes;
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+// Shared helpers for the fixed-point audio kernels. Kept free of Arduino
+// headers so the kernels also build on a desktop toolchain.
+
+#ifdef ESP32
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <xtensa/hal.h>
+// Hot kernels run from IRAM to avoid flash cache misses
+#define DSP_HOT IRAM_ATTR
+static inline uint32_t DspCycles() { return xthal_get_ccount(); }
+// Tables and state go to PSRAM when the board has it; release with free()
+static inline void* DspMalloc(size_t Bytes) {
+  void* Block = heap_caps_malloc(Bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  return Block ? Block : malloc(Bytes);
+}
+#else
+#include <chrono>
+#define DSP_HOT
+// Host builds report nanoseconds instead of CPU cycles
+static inline uint32_t DspCycles() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+static inline void* DspMalloc(size_t Bytes) { return malloc(Bytes); }
+#endif
+
+static inline int16_t DspSat16(int32_t Value) {
+  if (Value > 32767) return 32767;
+  if (Value < -32768) return -32768;
+  return (int16_t)Value;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include "DspCommon.h"
+
+// --- DSP Chain Stages ---
+// Per-sample building blocks for DspChain. Tick bodies live here so they
+// inline into the chain loop; coefficient design (float, init only) is in
+// DspStages.cpp.
+
+// Intermediate headroom between stages (17 bits)
+static inline int32_t DspClamp17(int64_t Value) {
+  if (Value > 65535) return 65535;
+  if (Value < -65536) return -65536;
+  return (int32_t)Value;
+}
+
+// First-order DC blocker: y = x - x[-1] + R y[-1], pole at R
+struct DspDcBlocker {
+  int32_t Pole = 32604;  // Q15, 0.995 (~19 Hz at 24 kHz)
+  int32_t PrevIn = 0;
+  int32_t PrevOut = 0;   // Q8 for precision
+
+  inline int32_t Tick(int32_t X) {
+    int64_t Y = ((int64_t)(X - PrevIn) << 8) + (((int64_t)PrevOut * Pole) >> 15);
+    PrevIn = X;
+    PrevOut = (int32_t)Y;
+    return DspClamp17((Y + 128) >> 8);
+  }
+  void Reset() { PrevIn = 0; PrevOut = 0; }
+  static const char* Name() { return "dc"; }
+};
+
+// Direct form I biquad with Q28 coefficients (a0 normalised to 1). The
+// rounding residue is fed back into the next sample; without it a
+// low-cutoff high-pass parks on a DC offset of up to a thousand counts.
+struct DspBiquad {
+  int32_t B0 = 1 << 28, B1 = 0, B2 = 0, A1 = 0, A2 = 0;
+  int32_t X1 = 0, X2 = 0, Y1 = 0, Y2 = 0;
+  int32_t Residue = 0;
+
+  inline int32_t Tick(int32_t X) {
+    int64_t Acc = (int64_t)B0 * X + (int64_t)B1 * X1 + (int64_t)B2 * X2
+                - (int64_t)A1 * Y1 - (int64_t)A2 * Y2 + Residue;
+    int32_t Y = DspClamp17(Acc >> 28);
+    Residue = (int32_t)(Acc & ((1 << 28) - 1));
+    X2 = X1;
+    X1 = X;
+    Y2 = Y1;
+    Y1 = Y;
+    return Y;
+  }
+  void Reset() { X1 = X2 = Y1 = Y2 = Residue = 0; }
+  static const char* Name() { return "biquad"; }
+};
+
+// Named flavours so chain reports tell them apart
+struct DspHighPass : DspBiquad {
+  static const char* Name() { return "highpass"; }
+};
+struct DspPeakingEq : DspBiquad {
+  static const char* Name() { return "eq"; }
+};
+
+// RBJ cookbook designs
+void DspBiquadHighPass(DspBiquad* Filter, uint32_t SampleRate, float CutoffHz, float Q);
+void DspBiquadPeaking(DspBiquad* Filter, uint32_t SampleRate, float CenterHz, float Q, float GainDb);
+
+// y = x - a x[-1]: tilts the spectrum up for ASR front ends
+struct DspPreEmphasis {
+  int32_t Coeff = 31785;  // Q15, 0.97
+  int32_t Prev = 0;
+
+  inline int32_t Tick(int32_t X) {
+    int32_t Y = X - ((Coeff * Prev + (1 << 14)) >> 15);
+    Prev = X;
+    return DspClamp17(Y);
+  }
+  void Reset() { Prev = 0; }
+  static const char* Name() { return "preemph"; }
+};
+
+// Q15 gain (32768 = unity, up to 2x) with a linear ramp to each new target
+struct DspGainStage {
+  int32_t Current = 32768 << 8;  // Q23 so short ramps still move
+  int32_t Target = 32768 << 8;
+  int32_t Step = 0;
+
+  inline int32_t Tick(int32_t X) {
+    if (Current != Target) {
+      Current += Step;
+      if ((Step > 0 && Current > Target) || (Step < 0 && Current < Target)) Current = Target;
+    }
+    return DspClamp17(((int64_t)X * Current + (1 << 22)) >> 23);
+  }
+  void Set(int32_t GainQ15, uint32_t RampSamples) {
+    if (GainQ15 < 0) GainQ15 = 0;
+    if (GainQ15 > 65535) GainQ15 = 65535;
+    Target = GainQ15 << 8;
+    Step = RampSamples ? (Target - Current) / (int32_t)RampSamples : 0;
+    if (Step == 0) Current = Target;
+  }
+  int32_t Get() const { return Target >> 8; }
+  void Reset() { Current = Target; }
+  static const char* Name() { return "gain"; }
+};
+
+// Zero-latency peak limiter: the gain drops at once to keep |y| under
+// the ceiling and recovers exponentially
+struct DspLimiterStage {
+  int32_t Ceiling = 31129;  // -0.45 dBFS
+  int32_t Gain = 32768;     // Q15
+  uint8_t ReleaseShift = 10;  // ~40 ms at 24 kHz
+  uint32_t Limited = 0;     // Samples where the gain was reduced
+
+  inline int32_t Tick(int32_t X) {
+    if (Gain < 32768) {
+      Gain += ((32768 - Gain) >> ReleaseShift) + 1;
+      if (Gain > 32768) Gain = 32768;
+    }
+    int32_t Magnitude = X < 0 ? -X : X;
+    if (((int64_t)Magnitude * Gain) >> 15 > Ceiling) {
+      Gain = (int32_t)(((int64_t)Ceiling << 15) / Magnitude);
+      Limited++;
+    }
+    return (int32_t)(((int64_t)X * Gain) >> 15);
+  }
+  void Reset() { Gain = 32768; }
+  static const char* Name() { return "limiter"; }
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include "DspCommon.h"
+
+// --- Fixed-Point FFT ---
+// In-place radix-2 complex FFT on Q15 data with block floating point: a
+// stage is only scaled down when the data could overflow, and the total
+// shift is returned so callers can recover absolute levels.
+
+#define DSP_FFT_MAX_LOG2 9
+#define DSP_FFT_MAX_SIZE (1 << DSP_FFT_MAX_LOG2)
+
+// Build the twiddle table; call once before the first transform
+void DspFftInit();
+
+// Forward transform of 2^Log2N points. On return the true DFT equals the
+// output shifted left by the returned exponent.
+int DspFftQ15(int16_t* Re, int16_t* Im, uint8_t Log2N);
+
+// Q31 transform for data that needs more than 16 bits (adaptive filter
+// weights). The inverse halves every stage, which is exactly the 1/N of
+// the inverse DFT; the forward transform does not scale, so its input must
+// leave room for the output.
+void DspFftQ31(int32_t* Re, int32_t* Im, uint8_t Log2N, bool Inverse);
+
+// Left-shift a block so its peak uses the Q15 range without reaching the
+// FFT's overflow guard. Returns the shift applied (subtract it from the
+// FFT exponent).
+int DspNormalizeQ15(int16_t* Samples, size_t Count);
+
+// |X[k]|^2 for k = 0..Count-1
+void DspFftPower(const int16_t* Re, const int16_t* Im, uint32_t* Power, size_t Count);
@@ -0,0 +1,29 @@
+#pragma once
+#include "DspCommon.h"
+
+// --- IMA-ADPCM ---
+// 4:1 codec for the mic uplink. Each block is self-contained:
+//   int16 predictor (LE) | uint8 step index | uint8 flags | nibbles
+// followed by one 4-bit code per sample, first sample in the low nibble.
+// IMA_ADPCM_FLAG_ODD marks an odd sample count: the high nibble of the last
+// byte is padding and is not decoded.
+// The header holds the coder state *before* the block, so every sample of
+// the block is coded and a lost block does not corrupt the next one.
+
+#define IMA_ADPCM_HEADER_BYTES 4
+#define IMA_ADPCM_FLAG_ODD 0x01
+#define IMA_ADPCM_BLOCK_BYTES(Samples) (IMA_ADPCM_HEADER_BYTES + ((Samples) + 1) / 2)
+
+typedef struct {
+  int16_t Predictor;
+  uint8_t Index;
+} ImaAdpcmState_t;
+
+void ImaAdpcmReset(ImaAdpcmState_t* State);
+
+// Encode Count samples into Out (IMA_ADPCM_BLOCK_BYTES(Count) bytes).
+// Returns the number of bytes written.
+size_t ImaAdpcmEncode(ImaAdpcmState_t* State, const int16_t* In, size_t Count, uint8_t* Out);
+
+// Decode one block. Returns the number of samples written (at most MaxSamples).
+size_t ImaAdpcmDecode(const uint8_t* In, size_t Bytes, int16_t* Out, size_t MaxSamples);
@@ -0,0 +1,30 @@
+#pragma once
+#include "DspCommon.h"
+
+// --- Jitter Estimator ---
+// Tracks how late downlink chunks arrive relative to a steady real-time
+// stream and turns that into a target buffer depth. Arrivals separated by
+// a long gap start a new stream (a new response); what was learned about
+// the network carries over.
+
+typedef struct {
+  int64_t StreamStartUs;     // Arrival of the first chunk of the stream
+  int64_t LastArrivalUs;
+  uint64_t StreamMediaUs;    // Media time received in this stream
+  uint32_t LastMediaUs;      // Duration of the previous chunk
+  uint32_t JitterUs;         // Smoothed inter-arrival jitter (RFC 3550 style)
+  uint32_t PeakLatenessUs;   // Slowly decaying max of arrival lateness
+  uint32_t MinTargetUs;
+  uint32_t MaxTargetUs;
+} Jitter_t;
+
+void JitterInit(Jitter_t* Jitter, uint32_t MinTargetUs, uint32_t MaxTargetUs);
+
+// A chunk holding MediaUs of audio arrived at ArrivalUs
+void JitterOnArrival(Jitter_t* Jitter, int64_t ArrivalUs, uint32_t MediaUs);
+
+// Playback ran dry mid-stream: the buffer was too shallow
+void JitterOnUnderrun(Jitter_t* Jitter);
+
+// Buffer depth to reach before playback starts, in microseconds
+uint32_t JitterTargetUs(const Jitter_t* Jitter);
@@ -0,0 +1,45 @@
+#pragma once
+#include "DspCommon.h"
+
+// --- Noise Suppressor ---
+// Fixed-point spectral subtraction for the uplink. Each frame is split
+// into two half-frame hops; every hop is sqrt-Hann windowed, transformed
+// with the block floating point FFT, attenuated per bin by a gain looked
+// up from the a-posteriori SNR, and overlap-added back. The noise estimate
+// (log2 power per bin) adapts in non-speech hops and only creeps up during
+// speech.
+// Output lags the input by half a frame. Cost per frame is four 512-point
+// FFTs plus 514 log2 evaluations: DspBenchNoiseSuppressor times it (boot
+// bench and tools/kernel_bench), RealtimeVoicePrintUplinkStats reports the
+// running average on the device, and tools/ns_eval scores SNR gain and the
+// attenuation floor on noisy speech.
+
+#define NS_FFT_LOG2 9
+#define NS_FFT_SIZE (1 << NS_FFT_LOG2)
+#define NS_BINS (NS_FFT_SIZE / 2 + 1)
+#define NS_MAX_FRAME NS_FFT_SIZE
+#define NS_MAX_ATTENUATION_DB 15  // Gain floor; deeper cuts cause musical noise
+
+typedef struct {
+  uint16_t FrameSamples;
+  uint16_t Hop;
+  uint16_t Calibration;           // Hops left that only train the noise estimate
+  bool Speech;                    // Last hop looked like speech
+  uint16_t MeanGainQ15;           // Average bin gain of the last hop, diagnostics
+  int32_t NoiseLog[NS_BINS];      // Noise power per bin, Q10 log2
+  uint16_t Gain[NS_BINS];         // Smoothed gain per bin, Q15
+  int16_t Input[NS_MAX_FRAME];    // Sliding analysis window
+  int16_t Overlap[NS_MAX_FRAME / 2];
+} Ns_t;
+
+// FrameSamples must be even and <= NS_MAX_FRAME. Returns false otherwise.
+bool NsInit(Ns_t* Ns, size_t FrameSamples);
+
+// Forget the noise estimate and the overlap state
+void NsReset(Ns_t* Ns);
+
+// Suppress noise in one frame of FrameSamples, in place
+void NsProcess(Ns_t* Ns, int16_t* Frame);
+
+// Average attenuation applied to the last hop, in dB (0 = none)
+uint8_t NsAttenuationDb(const Ns_t* Ns);
@@ -0,0 +1,36 @@
+#pragma once
+#include "DspCommon.h"
+
+// --- Packet Loss Concealment ---
+// Waveform repetition: when playback runs dry, repeat the last pitch
+// period of what was played with a fade to silence, then fade the real
+// audio back in when it arrives.
+
+#define PLC_HISTORY 768       // Recent output kept for the pitch search
+#define PLC_MIN_PERIOD 60     // 2.5 ms at 24 kHz (400 Hz)
+#define PLC_MAX_PERIOD 360    // 15 ms at 24 kHz (67 Hz)
+#define PLC_FADE_SAMPLES 1440 // 60 ms to silence
+#define PLC_RESUME_SAMPLES 48 // 2 ms fade-in after concealment
+
+typedef struct {
+  int16_t History[PLC_HISTORY];
+  uint16_t Filled;
+  uint16_t Period;      // Repetition period, 0 when not concealing
+  uint16_t Phase;       // Position inside the repeated period
+  uint32_t Concealed;   // Samples generated in the current gap
+  uint16_t FadeIn;      // Samples of fade-in left
+  bool Resume;          // Concealment ran; fade in the next real samples
+} Plc_t;
+
+void PlcInit(Plc_t* Plc);
+
+// Record samples that were played
+void PlcRemember(Plc_t* Plc, const int16_t* Samples, size_t Count);
+
+// Generate up to Count concealment samples. Returns how many were written;
+// 0 once the fade has reached silence.
+size_t PlcConceal(Plc_t* Plc, int16_t* Out, size_t Count);
+
+// Real audio is back: fade Samples in place if concealment ran. Returns
+// true while the fade-in continues into the next block.
+bool PlcResume(Plc_t* Plc, int16_t* Samples, size_t Count);
@@ -0,0 +1,47 @@
+#pragma once
+#include "DspCommon.h"
+
+// --- Polyphase Resampler ---
+// Streaming sample-rate converter between any two rates. A Kaiser windowed
+// sinc prototype is split into phases of RESAMPLER_TAPS Q15 taps. When the
+// reduced ratio Up/Down needs at most RESAMPLER_MAX_PHASES phases, each
+// output costs one RESAMPLER_TAPS dot product. Other ratios (11.025 kHz,
+// odd rates) keep RESAMPLER_MAX_PHASES phases and interpolate between the
+// two nearest, at twice the cost. Equal rates pass through untouched.
+
+#define RESAMPLER_TAPS 24          // Taps per phase
+#define RESAMPLER_MAX_PHASES 160   // Exact for 24 kHz <-> 44.1/22.05/48/16/8 kHz
+
+typedef struct {
+  uint32_t InRate;
+  uint32_t OutRate;
+  uint16_t Up;
+  uint16_t Down;
+  uint16_t Phases;     // Coefficient sets: Up, or RESAMPLER_MAX_PHASES when interpolating
+  uint32_t Phase;      // Output position relative to the newest input, in 1/Up samples
+  uint16_t Pos;        // Newest sample in Delay
+  int16_t* Coeffs;     // Phases (+1 when interpolating) x RESAMPLER_TAPS, NULL when bypassed
+  int16_t Delay[2 * RESAMPLER_TAPS];  // Mirrored so a window is always contiguous
+} Resampler_t;
+
+// Set up (or retune) a converter. The struct must be zeroed before first
+// use. Returns false when a rate is 0 or above 65535 Hz, or memory runs
+// out; the resampler is then left in bypass.
+bool ResamplerInit(Resampler_t* Resampler, uint32_t InRate, uint32_t OutRate);
+void ResamplerFree(Resampler_t* Resampler);
+
+// Clear the history (start of a new stream)
+void ResamplerReset(Resampler_t* Resampler);
+
+static inline bool ResamplerIsBypass(const Resampler_t* Resampler) {
+  return Resampler->Coeffs == NULL;
+}
+
+// Output samples InCount inputs can produce, at most
+size_t ResamplerMaxOutput(const Resampler_t* Resampler, size_t InCount);
+// Inputs that are guaranteed to fit in OutCapacity outputs
+size_t ResamplerMaxInput(const Resampler_t* Resampler, size_t OutCapacity);
+
+// Convert InCount samples; Out needs room for ResamplerMaxOutput(InCount).
+// Returns the number of samples written.
+size_t ResamplerProcess(Resampler_t* Resampler, const int16_t* In, size_t InCount, int16_t* Out);
@@ -0,0 +1,31 @@
+#pragma once
+#include "DspCommon.h"
+
+// --- Voice Activity Detector ---
+// Frame classifier combining first-difference energy above an adaptive
+// noise floor (hum barely registers), zero crossing rate and the ratio of
+// high-band to total energy, with hangover so word endings and short
+// pauses are not chopped.
+
+typedef struct {
+  uint32_t NoiseFloor;      // Mean-square noise estimate
+  uint32_t HighFloor;       // Mean first-difference noise, for the decision
+  uint16_t Calibration;     // Initial frames left that only train the floor
+  uint16_t HangoverFrames;  // Frames kept after the last speech frame
+  uint16_t Hangover;        // Frames of hangover left
+  bool Speech;              // Raw decision for the last frame
+  // Features of the last frame, for diagnostics and tuning
+  uint32_t Energy;          // Mean square
+  uint32_t HighEnergy;      // Mean square of the first difference
+  uint16_t ZcrPerMille;     // Zero crossings per 1000 samples
+  uint16_t HighRatioQ12;    // High-band / total energy, Q12
+} Vad_t;
+
+void VadInit(Vad_t* Vad, uint16_t HangoverFrames);
+
+// Classify one frame. Returns true while speech or hangover is active,
+// i.e. when the frame should be transmitted.
+bool VadProcess(Vad_t* Vad, const int16_t* Frame, size_t Count);
+
+// Rough noise level for comfort-noise markers, in dB below full scale (0..96)
+uint8_t VadNoiseLevelDb(const Vad_t* Vad);
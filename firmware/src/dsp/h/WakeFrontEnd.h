@@ -0,0 +1,68 @@
+#pragma once
+#include "DspCommon.h"
+#include "DspChain.h"
+#include "DspStages.h"
+
+// --- Wake Front End ---
+// Per-frame wake path: the raw frame's RMS and the adaptive gate that
+// looks at it. Nothing downstream uses a conditioned wake frame, so none
+// is made. Kept free of Arduino headers so the host harness in
+// tools/wake_eval runs this exact code over WAV files.
+
+// Uplink mic conditioning ahead of the AGC: DC blocker, high-pass
+// (handling and HVAC rumble), pre-emphasis. Declared here so the host
+// tools build the same chain.
+typedef DspChain<DspDcBlocker, DspHighPass, DspPreEmphasis> MicChain_t;
+#define MIC_HIGHPASS_HZ 80.0f
+void MicChainDesign(MicChain_t* Chain, uint32_t SampleRate, uint32_t BypassMask);
+
+// The gate's thresholds were tuned on the raw mic with the old fixed x32
+// boost, so its RMS is reported on that scale (now without clipping)
+#define WAKE_RMS_SCALE 32
+
+typedef struct {
+  float MinThreshold;           // Gate never opens below this RMS
+  float ThresholdMultiplier;    // Threshold = ambient x this
+  float AmbientDecay;           // Ambient smoothing towards quieter frames
+  float AmbientRise;            // Ambient tracking of frames under 70% of threshold
+  float EarlyEnergyMultiplier;  // Pre-threshold for early connects
+  uint16_t RequiredFrames;      // Consecutive loud frames that open the gate
+  uint16_t CalibrationFrames;   // Initial frames that only train the ambient
+} WakeParams_t;
+
+// Firmware tuning for 20 ms frames
+extern const WakeParams_t WAKE_DEFAULT_PARAMS;
+
+typedef enum {
+  WAKE_EVENT_NONE,
+  WAKE_EVENT_CALIBRATED,  // Ambient estimate ready, gate live from the next frame
+  WAKE_EVENT_WAKE
+} WakeEvent_t;
+
+typedef struct {
+  WakeParams_t Params;
+  uint32_t SampleRate;
+  size_t FrameSamples;
+  // Gate
+  float Rms;                    // Last frame, x32 scale
+  float Ambient;
+  float Threshold;
+  uint16_t Consecutive;
+  uint16_t CalibrationCount;
+  bool Calibrated;
+  bool EarlyEnergy;             // Last frame crossed the pre-threshold
+  // Cost
+  uint32_t ConditionCycles;     // Last frame: RMS
+} WakeFrontEnd_t;
+
+// One-time setup, then a reset. Params start at WAKE_DEFAULT_PARAMS.
+void WakeFrontEndInit(WakeFrontEnd_t* Wake, uint32_t SampleRate, size_t FrameSamples);
+
+// Clear the ambient calibration
+void WakeFrontEndReset(WakeFrontEnd_t* Wake);
+
+// Update Rms from one captured frame
+void WakeFrontEndProcess(WakeFrontEnd_t* Wake, const int16_t* Frame);
+
+// Run the gate on the last processed frame
+WakeEvent_t WakeFrontEndDetect(WakeFrontEnd_t* Wake);
@@ -4,6 +4,15 @@
 
 static uint32_t CurrentMicRate = I2S_SAMPLE_RATE_MIC;
 static uint32_t CurrentSpeakerRate = I2S_SAMPLE_RATE_SPEAKER;
+static QueueHandle_t MicEventQueue = NULL;
+static QueueHandle_t SpeakerEventQueue = NULL;
+
+static const I2SDmaConfig_t DMA_PROFILES[I2S_DMA_PROFILE_COUNT] = {
+  {"low-latency", 4, 240},
+  {"balanced", 4, 480},
+  {"robust", 8, 1024},
+};
+static I2SDmaProfile_t CurrentProfile = I2S_DMA_ROBUST;
 
 bool I2SInitMic() {
   i2s_config_t Cfg = {
@@ -13,8 +22,8 @@ bool I2SInitMic() {
     .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
     .communication_format = I2S_COMM_FORMAT_STAND_I2S,
     .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-    .dma_buf_count = 8,
-    .dma_buf_len = 1024,
+    .dma_buf_count = DMA_PROFILES[CurrentProfile].BufCount,
+    .dma_buf_len = DMA_PROFILES[CurrentProfile].BufLen,
     .use_apll = false,
     .tx_desc_auto_clear = false,
     .fixed_mclk = 0
@@ -27,7 +36,8 @@ bool I2SInitMic() {
     .data_in_num = PIN_I2S_MIC_DOUT
   };
   
-  esp_err_t Result = i2s_driver_install(I2S_NUM_0, &Cfg, 0, NULL);
+  // One event per DMA buffer so the capture task can block on completions
+  esp_err_t Result = i2s_driver_install(I2S_NUM_0, &Cfg, DMA_PROFILES[CurrentProfile].BufCount, &MicEventQueue);
   if (Result != ESP_OK) {
     Serial.printf("[I2S] Mic driver install failed: %d\n", Result);
     return false;
@@ -39,7 +49,7 @@ bool I2SInitMic() {
     return false;
   }
   
-  Serial.printf("[I2S] Mic initialized at %d Hz\n", CurrentMicRate);
+  Serial.printf("[I2S] Mic initialized at %d Hz (%s DMA)\n", CurrentMicRate, DMA_PROFILES[CurrentProfile].Name);
   return true;
 }
 
@@ -51,8 +61,8 @@ bool I2SInitSpeaker() {
     .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
     .communication_format = I2S_COMM_FORMAT_STAND_I2S,
     .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-    .dma_buf_count = 8,
-    .dma_buf_len = 1024,
+    .dma_buf_count = DMA_PROFILES[CurrentProfile].BufCount,
+    .dma_buf_len = DMA_PROFILES[CurrentProfile].BufLen,
     .use_apll = false,
     .tx_desc_auto_clear = true,
     .fixed_mclk = 0
@@ -65,7 +75,8 @@ bool I2SInitSpeaker() {
     .data_in_num = I2S_PIN_NO_CHANGE
   };
   
-  esp_err_t Result = i2s_driver_install(I2S_NUM_1, &Cfg, 0, NULL);
+  // One event per DMA buffer so the playback task can keep the queue topped up
+  esp_err_t Result = i2s_driver_install(I2S_NUM_1, &Cfg, DMA_PROFILES[CurrentProfile].BufCount, &SpeakerEventQueue);
   if (Result != ESP_OK) {
     Serial.printf("[I2S] Speaker driver install failed: %d\n", Result);
     return false;
@@ -77,13 +88,50 @@ bool I2SInitSpeaker() {
     return false;
   }
   
-  Serial.printf("[I2S] Speaker initialized at %d Hz\n", CurrentSpeakerRate);
+  Serial.printf("[I2S] Speaker initialized at %d Hz (%s DMA)\n", CurrentSpeakerRate, DMA_PROFILES[CurrentProfile].Name);
   return true;
 }
 
-size_t I2SReadMic(uint8_t* Buffer, size_t Length) {
+const I2SDmaConfig_t* I2SGetDmaConfig(I2SDmaProfile_t Profile) {
+  if (Profile >= I2S_DMA_PROFILE_COUNT) return NULL;
+  return &DMA_PROFILES[Profile];
+}
+
+bool I2SSetDmaProfile(I2SDmaProfile_t Profile) {
+  if (Profile >= I2S_DMA_PROFILE_COUNT) return false;
+  if (Profile == CurrentProfile) return true;
+  CurrentProfile = Profile;
+
+  // Not installed yet: Init picks the profile up
+  bool Success = true;
+  if (MicEventQueue != NULL) {
+    i2s_driver_uninstall(I2S_NUM_0);
+    MicEventQueue = NULL;
+    Success = I2SInitMic() && Success;
+  }
+  if (SpeakerEventQueue != NULL) {
+    i2s_driver_uninstall(I2S_NUM_1);
+    SpeakerEventQueue = NULL;
+    Success = I2SInitSpeaker() && Success;
+  }
+  return Success;
+}
+
+I2SDmaProfile_t I2SGetDmaProfile() {
+  return CurrentProfile;
+}
+
+uint16_t I2SGetDmaBufCount() {
+  return DMA_PROFILES[CurrentProfile].BufCount;
+}
+
+uint16_t I2SGetDmaBufLen() {
+  return DMA_PROFILES[CurrentProfile].BufLen;
+}
+
+size_t I2SReadMic(uint8_t* Buffer, size_t Length, uint32_t TimeoutMs) {
   size_t BytesRead = 0;
-  esp_err_t Result = i2s_read(I2S_NUM_0, Buffer, Length, &BytesRead, 100 / portTICK_PERIOD_MS);
+  esp_err_t Result = i2s_read(I2S_NUM_0, Buffer, Length, &BytesRead, TimeoutMs / portTICK_PERIOD_MS);
   
   if (Result != ESP_OK) {
     return 0;
@@ -92,9 +140,9 @@ size_t I2SReadMic(uint8_t* Buffer, size_t Length) {
   return BytesRead;
 }
 
-size_t I2SWriteSpeaker(const uint8_t* Data, size_t Length) {
+size_t I2SWriteSpeaker(const uint8_t* Data, size_t Length, uint32_t TimeoutMs) {
   size_t BytesWritten = 0;
-  esp_err_t Result = i2s_write(I2S_NUM_1, Data, Length, &BytesWritten, 100 / portTICK_PERIOD_MS);
+  esp_err_t Result = i2s_write(I2S_NUM_1, Data, Length, &BytesWritten, TimeoutMs / portTICK_PERIOD_MS);
   
   if (Result != ESP_OK) {
     return 0;
@@ -127,4 +175,20 @@ bool I2SSetSampleRate(uint32_t MicRate, uint32_t SpeakerRate) {
   }
   
   return Success;
+}
+
+QueueHandle_t I2SGetMicEventQueue() {
+  return MicEventQueue;
+}
+
+uint32_t I2SGetMicRate() {
+  return CurrentMicRate;
+}
+
+QueueHandle_t I2SGetSpeakerEventQueue() {
+  return SpeakerEventQueue;
+}
+
+uint32_t I2SGetSpeakerRate() {
+  return CurrentSpeakerRate;
 }
\ No newline at end of file
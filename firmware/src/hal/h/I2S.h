@@ -1,12 +1,54 @@
 #pragma once
 
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 
 // I2S Configuration for OpenAI Realtime API
 // Mic: INMP441, Speaker: MAX98357A
 
-#define I2S_SAMPLE_RATE_MIC 24000      // OpenAI Realtime uses 24kHz
+// Hardware rates; the realtime session resamples to the server's rate, so
+// these can be lowered (e.g. -DI2S_SAMPLE_RATE_MIC=16000 for cheaper wake
+// detection). Echo cancellation needs both to match.
+#ifndef I2S_SAMPLE_RATE_MIC
+#define I2S_SAMPLE_RATE_MIC 24000
+#endif
+#ifndef I2S_SAMPLE_RATE_SPEAKER
 #define I2S_SAMPLE_RATE_SPEAKER 24000
+#endif
+
+// DMA ring per direction (buffers x samples per buffer). Capture latency
+// is one buffer (a frame reaches the task once its buffer fills); playback
+// latency is the whole queue. Fewer, shorter buffers cut both at the cost
+// of more interrupts and less slack for a late task.
+typedef enum {
+  I2S_DMA_LOW_LATENCY,  // 4 x 240: 10 ms buffers, 40 ms queue at 24 kHz
+  I2S_DMA_BALANCED,     // 4 x 480: 20 ms buffers (one frame), 80 ms queue
+  I2S_DMA_ROBUST,       // 8 x 1024: 43 ms buffers, 341 ms queue
+  I2S_DMA_PROFILE_COUNT
+} I2SDmaProfile_t;
+
+typedef struct {
+  const char* Name;
+  uint16_t BufCount;
+  uint16_t BufLen;  // Samples per buffer
+} I2SDmaConfig_t;
+
+// Longest buffer of any profile, for statically sized scratch buffers
+#define I2S_DMA_BUF_LEN_MAX 1024
+
+// Buffer layout of a profile (NULL if out of range)
+const I2SDmaConfig_t* I2SGetDmaConfig(I2SDmaProfile_t Profile);
+
+// Select the DMA profile. Before init this only picks what the drivers are
+// installed with; afterwards both drivers are reinstalled at their current
+// rates, so the capture and playback tasks must be stopped first.
+bool I2SSetDmaProfile(I2SDmaProfile_t Profile);
+I2SDmaProfile_t I2SGetDmaProfile();
+
+// Layout the drivers are running with
+uint16_t I2SGetDmaBufCount();
+uint16_t I2SGetDmaBufLen();
 
 // Initialize I2S microphone (INMP441)
 bool I2SInitMic();
@@ -15,12 +57,24 @@ bool I2SInitMic();
 bool I2SInitSpeaker();
 
 // Read audio from microphone
-// Returns number of bytes read
-size_t I2SReadMic(uint8_t* Buffer, size_t Length);
+// Returns number of bytes read (0 = nothing ready within TimeoutMs)
+size_t I2SReadMic(uint8_t* Buffer, size_t Length, uint32_t TimeoutMs = 100);
+
+// Driver event queue for the mic (I2S_EVENT_RX_DONE per filled DMA buffer)
+QueueHandle_t I2SGetMicEventQueue();
 
 // Write audio to speaker
-// Returns number of bytes written
-size_t I2SWriteSpeaker(const uint8_t* Data, size_t Length);
+// Returns number of bytes written (may be short if DMA is full after TimeoutMs)
+size_t I2SWriteSpeaker(const uint8_t* Data, size_t Length, uint32_t TimeoutMs = 100);
+
+// Driver event queue for the speaker (I2S_EVENT_TX_DONE per sent DMA buffer)
+QueueHandle_t I2SGetSpeakerEventQueue();
 
 // Reconfigure I2S sample rate
-bool I2SSetSampleRate(uint32_t MicRate, uint32_t SpeakerRate);
\ No newline at end of file
+bool I2SSetSampleRate(uint32_t MicRate, uint32_t SpeakerRate);
+
+// Current mic sample rate
+uint32_t I2SGetMicRate();
+
+// Current speaker sample rate
+uint32_t I2SGetSpeakerRate();
\ No newline at end of file
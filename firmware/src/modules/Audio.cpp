@@ -1,11 +1,32 @@
 #include "Audio.h"
+#include "AudioCapture.h"
+#include "AudioPlayback.h"
+#include "AudioPreRoll.h"
+#include "AudioDma.h"
+#include "DownlinkDecoder.h"
+#include "LatencyTrace.h"
 #include "hal/h/I2S.h"
+#include "dsp/h/AudioKernels.h"
+#include "dsp/h/DspBench.h"
+#include "dsp/h/ImaAdpcm.h"
+#include "dsp/h/Vad.h"
+#include "dsp/h/Aec.h"
+#include "dsp/h/Resampler.h"
+#include "dsp/h/NoiseSuppressor.h"
+#include "dsp/h/Agc.h"
+#include "dsp/h/DspChain.h"
+#include "dsp/h/DspStages.h"
+#include "dsp/h/WakeFrontEnd.h"
+#include "core/h/WireProtocol.h"
 #include "config.h"
 #include "ConfigStore.h"
 #include "pins.h" 
 #include <WiFi.h>
 #include <WebSocketsClient.h>
 #include <ArduinoJson.h>
+#include <stdarg.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
 
 // =======================
 // Core Audio (VoiceManager)
@@ -14,20 +35,52 @@
 static bool audio_listening = false;
 static float last_rms = 0.0f;
 
+// Wake path (conditioning, gate, keyword spotter); shared with the host
+// evaluation harness
+static WakeFrontEnd_t wake;
+
+// Running average of mic conditioning cost per frame
+static uint32_t kernel_cycles_avg = 0;
+
+static uint32_t AverageCycles(uint32_t avg, uint32_t cycles) {
+  return avg ? (avg * 15 + cycles) / 16 : cycles;
+}
+
+static void RecordKernelCycles(uint32_t cycles) {
+  kernel_cycles_avg = AverageCycles(kernel_cycles_avg, cycles);
+}
+
 void AudioInit() {
+  AudioDmaInit();
   I2SInitMic();
   I2SInitSpeaker();
+  AudioCaptureStart();
+  AudioPlaybackStart();
   audio_listening = false;
+  AudioPreRollInit();
   WakeInit();
   RealtimeVoiceInit();
+#ifdef AUDIO_KERNEL_BENCH
+  AudioBenchmarkKernels();
+#endif
 }
 
 void AudioStartListening() {
   audio_listening = true;
+  AudioCaptureEnable(CAPTURE_CONSUMER_WAKE, true);
 }
 
 void AudioStopListening() {
   audio_listening = false;
+  AudioCaptureEnable(CAPTURE_CONSUMER_WAKE, false);
+}
+
+// During a conversation the uplink consumer has the mic and nothing reads
+// wake frames, so that ring would only overflow. Disabling keeps what it
+// already holds for RealtimeVoiceStartListening to move into the pre-roll.
+void AudioStartConversationListening() {
+  audio_listening = true;
+  AudioCaptureEnable(CAPTURE_CONSUMER_WAKE, false);
 }
 
 bool AudioIsListening() {
@@ -36,181 +89,79 @@ bool AudioIsListening() {
 
 size_t AudioReadBuffer(uint8_t* buf, size_t len) {
   if (!audio_listening) return 0;
+  if (len < AUDIO_FRAME_SAMPLES * sizeof(int16_t)) return 0;
   
-  size_t bytesRead = I2SReadMic(buf, len);
+  // One captured frame per call; 0 once the wake queue is drained
+  AudioFrameInfo_t info;
+  size_t bytesRead = AudioCaptureRead(CAPTURE_CONSUMER_WAKE, (int16_t*)buf, &info) * sizeof(int16_t);
 
-  // AMPLIFY: Boost volume x32
+  // Pre-roll keeps the frame; the wake gate only measures it
   if (bytesRead > 0) {
-      int16_t* samples = (int16_t*)buf;
-      size_t sampleCount = bytesRead / 2;
-      for (size_t i = 0; i < sampleCount; i++) {
-          int32_t val = samples[i];
-          val = val * 32; 
-          if (val > 32767) val = 32767;
-          if (val < -32768) val = -32768;
-          samples[i] = (int16_t)val;
-      }
-  }
-  
-  // Calculate RMS
-  if (bytesRead >= 100) {
-    float sum = 0;
-    for (size_t i = 0; i < bytesRead - 1; i += 2) {
-      int16_t sample = (buf[i+1] << 8) | buf[i];
-      sum += (float)sample * sample;
-    }
-    last_rms = sqrt(sum / (bytesRead / 2));
+    AudioPreRollPush((const int16_t*)buf, &info);
+    WakeFrontEndProcess(&wake, (int16_t*)buf);
+    last_rms = wake.Rms;
+    RecordKernelCycles(wake.ConditionCycles);
   }
   
   return bytesRead;
 }
 
 void AudioPlayResponse(const uint8_t* data, size_t len) {
-  I2SWriteSpeaker(data, len);
+  AudioPlaybackWrite((const int16_t*)data, len / 2);
 }
 
 float AudioGetRms() {
   return last_rms;
 }
 
-// =======================
-// Audio Memory Buffer
-// =======================
-
-// Note: buffer implementation moved here
-AudioMemoryBuffer::AudioMemoryBuffer() {
-    buffer = NULL;
-}
-
-bool AudioMemoryBuffer::init() {
-    if (buffer != NULL) free(buffer);
-    
-    if (psramFound()) {
-        buffer = (int16_t*)ps_malloc(BUFFER_SIZE * sizeof(int16_t));
-    } else {
-        buffer = (int16_t*)malloc(BUFFER_SIZE * sizeof(int16_t));
-    }
-    
-    if (!buffer) {
-        Serial.println("[AudioBuffer] Failed to allocate memory");
-        return false;
-    }
-    
-    clear();
-    Serial.printf("[AudioBuffer] Allocated %d bytes\n", BUFFER_SIZE * sizeof(int16_t));
-    return true;
-}
-
-bool AudioMemoryBuffer::write(const int16_t* data, int length) {
-    if (!buffer || !data) return false;
-    
-    if (samplesAvailable + length > BUFFER_SIZE) {
-        return false; 
-    }
-    
-    for (int i = 0; i < length; i++) {
-        buffer[writeIndex] = data[i];
-        writeIndex = (writeIndex + 1) % BUFFER_SIZE;
-    }
-    samplesAvailable += length;
-    return true;
-}
-
-bool AudioMemoryBuffer::read(int16_t* data, int length) {
-    if (!buffer || !data) return false;
-
-    if (samplesAvailable < length) {
-        return false; 
-    }
-    
-    for (int i = 0; i < length; i++) {
-        data[i] = buffer[readIndex];
-        readIndex = (readIndex + 1) % BUFFER_SIZE;
-    }
-    samplesAvailable -= length;
-    return true;
+uint32_t AudioGetKernelCycles() {
+  return kernel_cycles_avg;
 }
 
-int AudioMemoryBuffer::available() const {
-    if (!buffer) return 0;
-    return samplesAvailable;
-}
-
-void AudioMemoryBuffer::clear() {
-    if (!buffer) return;
-    writeIndex = 0;
-    readIndex = 0;
-    samplesAvailable = 0;
-    memset(buffer, 0, BUFFER_SIZE * sizeof(int16_t));
+#ifdef AUDIO_KERNEL_BENCH
+void AudioBenchmarkKernels() {
+  DspBenchResult_t results[DSP_BENCH_COUNT];
+  DspBenchKernels(AUDIO_FRAME_SAMPLES, 200, results);
+  for (int k = 0; k < DSP_BENCH_COUNT; k++) {
+    Serial.printf("[Bench] %s per %d-sample frame: before=%u cycles, after=%u cycles%s\n",
+      results[k].Name, AUDIO_FRAME_SAMPLES, results[k].Before, results[k].After,
+      results[k].Match ? "" : " (OUTPUT MISMATCH)");
+  }
+  Serial.printf("[Bench] Noise suppression per %d-sample frame: %u cycles\n",
+    AUDIO_FRAME_SAMPLES, DspBenchNoiseSuppressor(AUDIO_FRAME_SAMPLES, 50));
 }
+#endif
 
 // =======================
 // Wake Word Detection
 // =======================
 
-static const float MIN_THRESHOLD = 300.0f;        
-static const float THRESHOLD_MULTIPLIER = 2.5f;   
-static const int REQUIRED_FRAMES = 3;             
-static const float AMBIENT_DECAY = 0.98f;         
-static const float AMBIENT_RISE = 0.05f;          
-
-static float ambientNoise = 200.0f;              
-static float adaptiveThreshold = 500.0f;          
-static int consecutiveFrames = 0;                 
-static float wakeLastConfidence = 0.0f;               
-static bool calibrated = false;                   
-static int calibrationFrames = 0;                 
-static const int CALIBRATION_FRAMES = 20;         
+static float wakeLastConfidence = 0.0f;
 
 void WakeInit() {
-  ambientNoise = 200.0f;
-  adaptiveThreshold = 500.0f;
-  consecutiveFrames = 0;
+  static bool initialized = false;
+  if (!initialized) {
+    WakeFrontEndInit(&wake, I2SGetMicRate(), AUDIO_FRAME_SAMPLES);
+    initialized = true;
+  } else {
+    WakeFrontEndReset(&wake);
+  }
   wakeLastConfidence = 0.0f;
-  calibrated = false;
-  calibrationFrames = 0;
 }
 
 bool WakeDetect() {
   if (!AudioIsListening()) return false;
   
-  float rms = AudioGetRms();
-  wakeLastConfidence = rms;
-  
-  if (!calibrated) {
-    ambientNoise = (ambientNoise * calibrationFrames + rms) / (calibrationFrames + 1);
-    calibrationFrames++;
-    if (calibrationFrames >= CALIBRATION_FRAMES) {
-      calibrated = true;
-      adaptiveThreshold = max(MIN_THRESHOLD, ambientNoise * THRESHOLD_MULTIPLIER);
-      Serial.printf("[Wake] Calibrated: ambient=%.0f, threshold=%.0f\n", ambientNoise, adaptiveThreshold);
-    }
-    return false;
-  }
-  
-  adaptiveThreshold = max(MIN_THRESHOLD, ambientNoise * THRESHOLD_MULTIPLIER);
-  
-  if (rms > adaptiveThreshold) {
-    consecutiveFrames++;
-    if (consecutiveFrames >= REQUIRED_FRAMES) {
-      consecutiveFrames = 0;
-      return true;  
-    }
-  } else {
-    consecutiveFrames = 0;
-    
-    if (rms < ambientNoise) {
-      ambientNoise = ambientNoise * AMBIENT_DECAY + rms * (1.0f - AMBIENT_DECAY);
-    } else if (rms < adaptiveThreshold * 0.7f) {
-      ambientNoise = ambientNoise * (1.0f - AMBIENT_RISE) + rms * AMBIENT_RISE;
-    }
+  wakeLastConfidence = wake.Rms;
+  WakeEvent_t event = WakeFrontEndDetect(&wake);
+  if (event == WAKE_EVENT_CALIBRATED) {
+    Serial.printf("[Wake] Calibrated: ambient=%.0f, threshold=%.0f\n", wake.Ambient, wake.Threshold);
   }
-  
-  return false;
+  return event == WAKE_EVENT_WAKE;
 }
 
 void WakeSetThreshold(float thresh) {
-  adaptiveThreshold = max(thresh, MIN_THRESHOLD);
+  wake.Threshold = max(thresh, wake.Params.MinThreshold);
 }
 
 float WakeGetConfidence() {
@@ -218,71 +169,292 @@ float WakeGetConfidence() {
 }
 
 float WakeGetAmbientNoise() {
-  return ambientNoise;
+  return wake.Ambient;
 }
 
 float WakeGetThreshold() {
-  return adaptiveThreshold;
+  return wake.Threshold;
+}
+
+bool WakeEarlyEnergy() {
+  return wake.EarlyEnergy;
 }
 
 // =======================
 // Realtime Voice AI
 // =======================
 
-static const size_t AUDIO_BUFFER_SIZE = 1024; 
 
 static WebSocketsClient WsClient;
 static bool rt_IsConnected = false;
 static bool rt_IsListening = false;
+static bool rt_SessionReady = false;  // Auth reply received, codecs and rate known
 static uint8_t rt_Volume = 100;
+static volatile int32_t rt_VolumeQ15 = DSP_Q15_ONE;
+static const uint32_t VOLUME_RAMP_MS = 5;
+
+// Speaker chain for the small MAX98357A driver: cut what the cone cannot
+// reproduce (it only distorts), lift the presence band, then volume and a
+// limiter so the boost never clips
+typedef DspChain<DspHighPass, DspPeakingEq, DspGainStage, DspLimiterStage> SpeakerChain_t;
+static const float SPEAKER_HIGHPASS_HZ = 200.0f;
+static const float SPEAKER_EQ_HZ = 2800.0f;
+static const float SPEAKER_EQ_Q = 1.0f;
+static const float SPEAKER_EQ_DB = 3.0f;
+static SpeakerChain_t rt_SpeakerChain;
+static MicChain_t rt_MicChain;
+
+// Outgoing audio is built behind header room: the WebSocket frame header
+// (written by the library with headerToPayload) and then the wire header,
+// so a frame is sent from where it was produced instead of being copied
+// into a send buffer twice. See SendInPlace for what that costs in masking.
+static const size_t TX_HEADROOM = WEBSOCKETS_MAX_HEADER_SIZE + WIRE_HEADER_BYTES;
+
+// Mic frames are read straight into a send buffer: an unresampled PCM16
+// frame goes out in place
+alignas(4) static uint8_t MicTx[TX_HEADROOM + AUDIO_FRAME_SAMPLES * sizeof(int16_t)];
+static int16_t* const MicBuffer = (int16_t*)(MicTx + TX_HEADROOM);
+
+// Uplink codec, switched to IMA-ADPCM only once the server acknowledges it
+static bool rt_UplinkAdpcm = false;
+static ImaAdpcmState_t rt_AdpcmState;
+
+// Sample rate the server exchanges audio at; the mic and speaker keep their
+// own rates and are converted to/from it
+static const uint32_t SESSION_RATE_MAX = 48000;
+static const size_t UPLINK_FRAME_MAX = SESSION_RATE_MAX * AUDIO_FRAME_MS / 1000 + 1;
+static const size_t RESAMPLE_BLOCK_SAMPLES = 512;
+static uint32_t rt_SessionRate = QUIL_SESSION_SAMPLE_RATE;
+static Resampler_t rt_UplinkResampler;
+static Resampler_t rt_DownlinkResampler;
+static int16_t UplinkBuffer[UPLINK_FRAME_MAX];
+static int16_t DownlinkBuffer[RESAMPLE_BLOCK_SAMPLES];
+static size_t rt_ChunkSamples = 0;  // Speaker samples queued from the current chunk
+static uint32_t rt_ResampleCycles = 0;
+
+// Resampled or encoded frames and comfort noise markers, same layout
+alignas(4) static uint8_t TxBuffer[TX_HEADROOM + UPLINK_FRAME_MAX * sizeof(int16_t)];
+static uint8_t* const TxPayload = TxBuffer + TX_HEADROOM;
+
+// Audio bytes moved between buffers unchanged, per direction, since the
+// last stats reset. Reads from the capture ring are unavoidable (it fans
+// out to several consumers); anything else shows up here.
+static uint32_t rt_UplinkCopied = 0;
+static uint32_t rt_DownlinkCopied = 0;
+static unsigned long rt_CopyStatsMs = 0;
+
+// Binary framing (core/h/WireProtocol.h), when the server acknowledges it
+static bool rt_Framing = false;
+static uint32_t rt_TxSeq = 0;
+static bool rt_UplinkGap = true;      // Next audio follows a gap
+static WireRxStats_t rt_RxStats;
+static uint32_t rt_RxMalformed = 0;
 
-static uint8_t MicBuffer[AUDIO_BUFFER_SIZE];
-static AudioMemoryBuffer PlaybackBuffer;       
-static int16_t TempPlaybackChunk[512];         
+// Discontinuous transmission: frames the VAD rejects are not sent; a
+// 3-byte comfort-noise marker ('C','N',level dB) stands in for them
+static bool rt_UplinkDtx = false;
+static Vad_t rt_Vad;
+static const uint16_t VAD_HANGOVER_FRAMES = 300 / AUDIO_FRAME_MS;    // 300 ms
+static const uint32_t DTX_MARKER_FRAMES = 200 / AUDIO_FRAME_MS;      // One marker per 200 ms
+static uint32_t rt_SilentFrames = 0;
+// The VAD is a few frames late on a quiet onset (an unvoiced first
+// syllable), so the frames it withheld last go out ahead of the talkspurt
+static const uint8_t DTX_LOOKBACK_FRAMES = 80 / AUDIO_FRAME_MS;     // 80 ms
+static int16_t rt_Held[DTX_LOOKBACK_FRAMES][AUDIO_FRAME_SAMPLES];
+static AudioFrameInfo_t rt_HeldInfo[DTX_LOOKBACK_FRAMES];
+static uint8_t rt_HeldFirst = 0;  // Oldest held frame
+static uint8_t rt_HeldCount = 0;
+
+// Echo cancellation against what the speaker is playing, so the mic can
+// stay open during responses and the user can talk over them. The state
+// is ~34 KB, so it lives in PSRAM when the board has it; NULL if it could
+// not be allocated, which leaves the uplink without echo cancellation.
+static Aec_t* rt_Aec = NULL;
+static int16_t RefBuffer[AUDIO_FRAME_SAMPLES];
+static bool rt_AecPrimed = false;
+static uint32_t rt_RefIndex = 0;                    // Next reference sample while primed
+static uint32_t rt_AecCycles = 0;
+static const uint32_t AEC_REFERENCE_SLIP_MS = 2;    // Re-align beyond this drift
+static const uint8_t BARGE_IN_FRAMES = 3;           // 60 ms of speech over playback
+static uint8_t rt_BargeInFrames = 0;
+static uint32_t rt_BargeIns = 0;
+
+// Spectral noise suppression (fans, HVAC) ahead of the gain stage;
+// switchable at runtime, re-learns the noise whenever it is turned on
+static Ns_t rt_Ns;
+static volatile bool rt_NoiseSuppression = QUIL_NOISE_SUPPRESSION;
+static bool rt_NsActive = false;
+static bool rt_NsReady = false;
+static uint32_t rt_NsCycles = 0;
+
+// Uplink AGC in place of the fixed boost; keeps its gain between sessions
+static Agc_t rt_Agc;
+
+// Uplink accounting, reset at conversation start
+// Pre-roll: frames from before wake and from the connection wait are sent
+// first, several per pass, between preroll_start/preroll_end markers
+static const size_t PREROLL_FLUSH_FRAMES = 5;  // Per loop pass (~10 ms), so 10x realtime
+static bool rt_PreRollFlushing = false;
+static bool rt_PreRollAnnounced = false;
+static uint32_t rt_PreRollSent = 0;
+
+static uint32_t rt_FramesSent = 0;
+static uint32_t rt_FramesFailed = 0;     // The socket refused them
+static uint32_t rt_FramesSuppressed = 0;
+static uint32_t rt_BytesSent = 0;
+static uint32_t rt_BytesSuppressed = 0;
 
 static unsigned long LastPingTime = 0;
 static const unsigned long PING_INTERVAL = 30000;
 
-static void OnWsEvent(WStype_t Type, uint8_t* Payload, size_t Length);
-static void ProcessAudioChunk(uint8_t* Data, size_t Length);
-static void StreamMicData();
-static void PlayBufferedAudio();
-static void SendInstruction(const char* Msg);
+// Connection policy and what holding a session costs
+static const uint32_t WS_HEARTBEAT_INTERVAL = 15000;
+static const uint32_t WS_PING_FRAME_BYTES = 6;  // Masked empty ping out
+static const uint32_t WS_PONG_FRAME_BYTES = 2;  // Empty pong back
+static ConnectionPolicy_t rt_Policy = QUIL_CONNECTION_POLICY;
+static bool rt_Started = false;
+static uint32_t rt_HeapBeforeConnect = 0;
+static uint32_t rt_ConnectHeap = 0;
+static unsigned long rt_ConnectStartMs = 0;
+static uint32_t rt_ConnectMs = 0;
 
-void RealtimeVoiceInit() {
-  Serial.println("[RealtimeVoice] Initialized");
-  if (!PlaybackBuffer.init()) {
-    Serial.println("[RealtimeVoice] Buffer init failed!");
+// Server endpoint, parsed once per URL
+typedef struct {
+  char Url[64];
+  char Host[64];
+  char Path[32];
+  uint16_t Port;
+  bool UseSSL;
+} ServerEndpoint_t;
+static ServerEndpoint_t rt_Endpoint;
+
+// Connect phases of the last session
+static uint32_t rt_HandshakeMs = 0;  // DNS + TCP + TLS + HTTP upgrade (inside the library)
+static uint32_t rt_ConfigMs = 0;     // config sent to auth received
+static unsigned long rt_ConnectedSinceMs = 0;
+static uint32_t rt_ConnectedMs = 0;       // Closed sessions
+static uint32_t rt_HeartbeatBytes = 0;    // Pings and pongs, both layers, both directions
+
+// Control messages never touch the heap. Incoming text is parsed with
+// ArduinoJson out of a static arena that is dropped before each message;
+// one that does not fit fails as NoMemory instead of falling back to
+// malloc. Outgoing text is formatted into a static buffer behind
+// WEBSOCKETS_MAX_HEADER_SIZE of headroom, so over TLS the library writes
+// the frame header in place rather than allocating a send copy (see
+// SendInPlace).
+class ControlArena : public ArduinoJson::Allocator {
+ public:
+  static const size_t CAPACITY = 3072;
+  size_t Peak = 0;        // High-water mark, bytes
+  uint32_t Overflows = 0; // Allocations that did not fit
+
+  void Reset() {
+    Used = 0;
+    Top = NO_BLOCK;
   }
-  rt_IsConnected = false;
-  rt_IsListening = false;
-  rt_Volume = 100;
-}
-bool RealtimeVoiceConnect(const char* ServerUrl) {
-  static char loadUrl[64];
-  if (!ConfigLoadServerUrl(loadUrl)) {
-    Serial.println("[RealtimeVoice] No server URL configured");
-    return false;
+
+  void* allocate(size_t Size) override {
+    if (Size > CAPACITY || BLOCK_HEADER + Align(Size) > CAPACITY - Used) {
+      Overflows++;
+      return nullptr;
+    }
+    Top = Used;
+    *(uint32_t*)(Buffer + Top) = (uint32_t)Size;
+    Used += BLOCK_HEADER + Align(Size);
+    if (Used > Peak) Peak = Used;
+    return Buffer + Top + BLOCK_HEADER;
   }
+
+  // Only the newest block gives its space back; the rest goes on Reset
+  void deallocate(void* Ptr) override {
+    if (Ptr && Offset(Ptr) == Top) {
+      Used = Top;
+      Top = NO_BLOCK;
+    }
+  }
+
+  void* reallocate(void* Ptr, size_t Size) override {
+    if (!Ptr) return allocate(Size);
+    size_t At = Offset(Ptr);
+    if (At == Top && Size <= CAPACITY && Top + BLOCK_HEADER + Align(Size) <= CAPACITY) {
+      *(uint32_t*)(Buffer + Top) = (uint32_t)Size;
+      Used = Top + BLOCK_HEADER + Align(Size);
+      if (Used > Peak) Peak = Used;
+      return Ptr;
+    }
+    size_t OldSize = *(uint32_t*)(Buffer + At);
+    void* Moved = allocate(Size);
+    if (Moved) memcpy(Moved, Ptr, OldSize < Size ? OldSize : Size);
+    return Moved;
+  }
+
+ private:
+  static const size_t BLOCK_HEADER = 8;  // Size, keeps blocks 8-byte aligned
+  static const size_t NO_BLOCK = (size_t)-1;
+  static size_t Align(size_t Size) { return (Size + 7) & ~(size_t)7; }
+  size_t Offset(const void* Ptr) const { return (const uint8_t*)Ptr - Buffer - BLOCK_HEADER; }
+
+  alignas(8) uint8_t Buffer[CAPACITY];
+  size_t Used = 0;
+  size_t Top = NO_BLOCK;
+};
+static ControlArena rt_RxArena;
+
+static char rt_ControlTx[WEBSOCKETS_MAX_HEADER_SIZE + 192];
+static char* const rt_ControlText = rt_ControlTx + WEBSOCKETS_MAX_HEADER_SIZE;
+static const size_t CONTROL_TEXT_MAX = sizeof(rt_ControlTx) - WEBSOCKETS_MAX_HEADER_SIZE;
+
+// Session config: everything is known at build time
+static const char CONFIG_MESSAGE[] =
+  "{\"type\":\"config\",\"voice\":\"coral\",\"language\":\"en\""
+#if QUIL_UPLINK_ADPCM
+  ",\"uplink_codec\":\"ima_adpcm\""
+#endif
+#if QUIL_UPLINK_DTX
+  ",\"dtx\":true"
+#endif
+#if QUIL_DOWNLINK_MP3
+  ",\"downlink_codec\":\"mp3\""
+#endif
+#if QUIL_BINARY_FRAMING
+  ",\"framing\":\"" WIRE_FRAMING_NAME "\""
+#endif
+  "}";
+
+// Heap at the end of the last handshake, to show drift across a session,
+// and the lowest free heap seen since, logged every HEAP_LOG_MS for soaks
+static const uint32_t HEAP_LOG_MS = 10 * 60 * 1000;
+static uint32_t rt_HeapAtReady = 0;
+static uint32_t rt_HeapMinSinceReady = 0;
+static unsigned long rt_HeapLogMs = 0;
+
+// Frames are only sent from the caller's headroom over TLS; see SendInPlace
+static bool rt_SendInPlace = false;
+
+static void OnWsEvent(WStype_t Type, uint8_t* Payload, size_t Length);
+static void ProcessAudioChunk(const uint8_t* Data, size_t Length);
+static void ProcessFramedMessage(const uint8_t* Data, size_t Length);
+static void StreamMicData();
+static size_t SendControl(WireType_t Type, const char* Msg);
+static size_t SendControlText(const char* Format, ...) __attribute__((format(printf, 1, 2)));
+static void SetSessionRate(uint32_t Rate);
+
+static void ParseServerUrl(const char* Url, ServerEndpoint_t* Ep) {
+  strncpy(Ep->Url, Url, sizeof(Ep->Url) - 1);
+  Ep->Url[sizeof(Ep->Url) - 1] = '\0';
+  Ep->Port = 8000;
+  Ep->UseSSL = false;
   
-  Serial.print("[RealtimeVoice] Connecting to: ");
-  Serial.println(loadUrl);
-  
-  static char Host[64];
-  static char Path[32];
-  uint16_t Port = 8000;
-  bool UseSSL = false;
-  
-  const char* p = loadUrl;
+  const char* p = Url;
   
   if (strncmp(p, "wss://", 6) == 0) {
-    UseSSL = true;
+    Ep->UseSSL = true;
     p += 6;
-    Port = 443;
+    Ep->Port = 443;
   } else if (strncmp(p, "ws://", 5) == 0) {
-    UseSSL = false;
+    Ep->UseSSL = false;
     p += 5;
-    Port = 80;
+    Ep->Port = 80;
   }
   
   const char* pathStart = strchr(p, '/');
@@ -291,42 +463,102 @@ bool RealtimeVoiceConnect(const char* ServerUrl) {
   size_t hostLen;
   if (portStart && (!pathStart || portStart < pathStart)) {
     hostLen = portStart - p;
-    Port = atoi(portStart + 1);
+    Ep->Port = atoi(portStart + 1);
   } else if (pathStart) {
     hostLen = pathStart - p;
   } else {
     hostLen = strlen(p);
   }
-  hostLen = min(hostLen, sizeof(Host) - 1);
-  memcpy(Host, p, hostLen);
-  Host[hostLen] = '\0';
+  hostLen = min(hostLen, sizeof(Ep->Host) - 1);
+  memcpy(Ep->Host, p, hostLen);
+  Ep->Host[hostLen] = '\0';
   
   if (pathStart) {
-    strncpy(Path, pathStart, sizeof(Path) - 1);
-    Path[sizeof(Path) - 1] = '\0';
+    strncpy(Ep->Path, pathStart, sizeof(Ep->Path) - 1);
+    Ep->Path[sizeof(Ep->Path) - 1] = '\0';
   } else {
-    strcpy(Path, "/ws");
+    strcpy(Ep->Path, "/ws");
+  }
+}
+
+static void DesignSpeakerChain(uint32_t Rate) {
+  DspBiquadHighPass(&rt_SpeakerChain.Stage<0>(), Rate, SPEAKER_HIGHPASS_HZ, 0.707f);
+  DspBiquadPeaking(&rt_SpeakerChain.Stage<1>(), Rate, SPEAKER_EQ_HZ, SPEAKER_EQ_Q, SPEAKER_EQ_DB);
+  rt_SpeakerChain.BypassMask = QUIL_SPEAKER_DSP_BYPASS;
+}
+
+void RealtimeVoiceInit() {
+  Serial.println("[RealtimeVoice] Initialized");
+  rt_IsConnected = false;
+  rt_IsListening = false;
+  rt_Volume = 100;
+  rt_VolumeQ15 = DSP_Q15_ONE;
+  MicChainDesign(&rt_MicChain, I2SGetMicRate(), QUIL_MIC_DSP_BYPASS);
+  DesignSpeakerChain(I2SGetSpeakerRate());
+  uint8_t Policy = QUIL_CONNECTION_POLICY;
+  ConfigLoadConnectionPolicy(&Policy);
+  rt_Policy = Policy < CONN_POLICY_COUNT ? (ConnectionPolicy_t)Policy : QUIL_CONNECTION_POLICY;
+  if (!rt_Aec) {
+    if (psramFound()) {
+      rt_Aec = (Aec_t*)ps_malloc(sizeof(Aec_t));
+    } else {
+      rt_Aec = (Aec_t*)malloc(sizeof(Aec_t));
+    }
+    if (rt_Aec) {
+      Serial.printf("[RealtimeVoice] Echo canceller: %u bytes%s\n", (unsigned)sizeof(Aec_t), psramFound() ? " of PSRAM" : "");
+    } else {
+      Serial.println("[RealtimeVoice] No memory for the echo canceller, AEC disabled");
+    }
+  }
+  if (rt_Aec) AecInit(rt_Aec);
+  rt_NsReady = NsInit(&rt_Ns, AUDIO_FRAME_SAMPLES);
+  AgcInit(&rt_Agc, I2SGetMicRate(), QUIL_AGC_TARGET_DBFS, AGC_INITIAL_GAIN, AGC_MAX_GAIN);
+}
+bool RealtimeVoiceConnect(const char* ServerUrl) {
+  static char loadUrl[64];
+  if (!ConfigLoadServerUrl(loadUrl)) {
+    Serial.println("[RealtimeVoice] No server URL configured");
+    return false;
   }
   
-  Serial.printf("[RealtimeVoice] Host: %s, Port: %d, Path: %s, SSL: %s\n", Host, Port, Path, UseSSL ? "Yes" : "No");
+  Serial.print("[RealtimeVoice] Connecting to: ");
+  Serial.println(loadUrl);
+  LatencyTraceMark(LAT_CONNECT_START);
+  
+  ServerEndpoint_t& Ep = rt_Endpoint;
+  if (strcmp(Ep.Url, loadUrl) != 0) {
+    ParseServerUrl(loadUrl, &Ep);
+    Serial.printf("[RealtimeVoice] Host: %s, Port: %d, Path: %s, SSL: %s\n", Ep.Host, Ep.Port, Ep.Path, Ep.UseSSL ? "Yes" : "No");
+  }
   
   WsClient.onEvent(OnWsEvent);
   WsClient.setReconnectInterval(5000);
-  WsClient.enableHeartbeat(15000, 5000, 2); 
+  WsClient.enableHeartbeat(WS_HEARTBEAT_INTERVAL, 5000, 2);
+  
+  rt_Started = true;
+  rt_HeapBeforeConnect = ESP.getFreeHeap();
+  rt_ConnectStartMs = millis();
+  rt_ConnectMs = 0;
+  rt_SendInPlace = Ep.UseSSL;
   
-  if (UseSSL) {
-    WsClient.beginSSL(Host, Port, Path);
+  if (Ep.UseSSL) {
+    WsClient.beginSSL(Ep.Host, Ep.Port, Ep.Path);
   } else {
-    WsClient.begin(Host, Port, Path);
+    WsClient.begin(Ep.Host, Ep.Port, Ep.Path);
   }
   return true;
 }
 
 void RealtimeVoiceDisconnect() {
   WsClient.disconnect();
+  if (rt_IsConnected) rt_ConnectedMs += millis() - rt_ConnectedSinceMs;
+  rt_Started = false;
   rt_IsConnected = false;
+  rt_SessionReady = false;
   rt_IsListening = false;
-  PlaybackBuffer.clear();
+  AudioCaptureEnable(CAPTURE_CONSUMER_UPLINK, false);
+  AudioPlaybackClear();
+  DownlinkDecoderEnd();
   Serial.println("[RealtimeVoice] Disconnected");
 }
 
@@ -334,29 +566,60 @@ bool RealtimeVoiceIsConnected() {
   return rt_IsConnected;
 }
 
+bool RealtimeVoiceIsStarted() {
+  return rt_Started;
+}
+
 void RealtimeVoiceLoop() {
   WsClient.loop();
   
-  if (rt_IsConnected && rt_IsListening) {
+  if (rt_IsListening) {
     StreamMicData();
   }
   
-  PlayBufferedAudio();
-  
   if (rt_IsConnected && (millis() - LastPingTime > PING_INTERVAL)) {
-    SendInstruction("ping");
+    rt_HeartbeatBytes += SendControl(WIRE_PING, "ping");
     LastPingTime = millis();
   }
+  
+  if (rt_SessionReady) {
+    uint32_t Heap = ESP.getFreeHeap();
+    if (Heap < rt_HeapMinSinceReady) rt_HeapMinSinceReady = Heap;
+    if (millis() - rt_HeapLogMs >= HEAP_LOG_MS) {
+      rt_HeapLogMs = millis();
+      Serial.printf("[RealtimeVoice] Heap free=%u, min %u since session ready (%d), %u min connected\n", Heap,
+        rt_HeapMinSinceReady, (int)(rt_HeapMinSinceReady - rt_HeapAtReady), (unsigned)((millis() - rt_ConnectedSinceMs) / 60000));
+    }
+  }
 }
 
 void RealtimeVoiceStartListening() {
-  if (!rt_IsConnected) return;
   rt_IsListening = true;
-  Serial.println("[RealtimeVoice] Started listening");
+  ImaAdpcmReset(&rt_AdpcmState);
+  ResamplerReset(&rt_UplinkResampler);
+  VadInit(&rt_Vad, VAD_HANGOVER_FRAMES);
+  rt_SilentFrames = 0;
+  rt_HeldCount = 0;
+  rt_UplinkGap = true;
+  AudioCaptureEnable(CAPTURE_CONSUMER_UPLINK, true);
+  
+  // Frames the wake loop had not read yet belong to the pre-roll too; the
+  // uplink consumer is already on, so overlapping frames are dropped by Seq
+  AudioFrameInfo_t Info;
+  while (AudioCaptureRead(CAPTURE_CONSUMER_WAKE, MicBuffer, &Info) > 0) {
+    AudioPreRollPush(MicBuffer, &Info);
+  }
+  rt_PreRollFlushing = AudioPreRollInit();
+  rt_PreRollAnnounced = false;
+  Serial.printf("[RealtimeVoice] Started listening (%u ms pre-roll%s)\n",
+    (unsigned)(AudioPreRollFrames() * AUDIO_FRAME_MS), rt_SessionReady ? "" : ", buffering until connected");
 }
 
 void RealtimeVoiceStopListening() {
   rt_IsListening = false;
+  rt_PreRollFlushing = false;
+  AudioPreRollClear();
+  AudioCaptureEnable(CAPTURE_CONSUMER_UPLINK, false);
   Serial.println("[RealtimeVoice] Stopped listening");
 }
 
@@ -366,67 +629,202 @@ bool RealtimeVoiceIsListening() {
 
 void RealtimeVoiceEndOfSpeech() {
   if (!rt_IsConnected) return;
-  SendInstruction("end_of_speech");
+  SendControl(WIRE_END_OF_SPEECH, "end_of_speech");
+  LatencyTraceMark(LAT_END_OF_SPEECH);
   Serial.println("[RealtimeVoice] End of speech signaled");
 }
 
 void RealtimeVoiceInterrupt() {
   if (!rt_IsConnected) return;
   
-  PlaybackBuffer.clear();
+  AudioPlaybackClear();
+  DownlinkDecoderReset();
+  ResamplerReset(&rt_DownlinkResampler);
   
-  JsonDocument Doc;
-  Doc["type"] = "instruction";
-  Doc["msg"] = "INTERRUPT";
-  Doc["audio_end_ms"] = 0; 
-  
-  String Json;
-  serializeJson(Doc, Json);
-  WsClient.sendTXT(Json);
+  if (rt_Framing) {
+    SendControl(WIRE_INTERRUPT, "INTERRUPT");
+  } else {
+    SendControlText("{\"type\":\"instruction\",\"msg\":\"INTERRUPT\",\"audio_end_ms\":0}");
+  }
   
   Serial.println("[RealtimeVoice] Interrupted");
 }
 
 void RealtimeVoiceSetVolume(uint8_t NewVolume) {
   rt_Volume = NewVolume > 100 ? 100 : NewVolume;
+  // Convert once here so the audio path only multiplies and shifts
+  rt_VolumeQ15 = (int32_t)rt_Volume * DSP_Q15_ONE / 100;
+}
+
+void RealtimeVoiceSetNoiseSuppression(bool Enable) {
+  rt_NoiseSuppression = Enable;
+  Serial.printf("[RealtimeVoice] Noise suppression %s\n", Enable ? "on" : "off");
+}
+
+bool RealtimeVoiceGetNoiseSuppression() {
+  return rt_NoiseSuppression;
+}
+
+float RealtimeVoiceGetMicGainDb() {
+  return AgcGainDb10(&rt_Agc) / 10.0f;
+}
+
+uint32_t RealtimeVoiceGetMicClipPpm() {
+  return AgcClipPpm(&rt_Agc);
+}
+
+void RealtimeVoiceSetDspBypass(uint32_t MicMask, uint32_t SpeakerMask) {
+  rt_MicChain.BypassMask = MicMask;
+  rt_SpeakerChain.BypassMask = SpeakerMask;
+}
+
+void RealtimeVoiceGetDspBypass(uint32_t* MicMask, uint32_t* SpeakerMask) {
+  if (MicMask) *MicMask = rt_MicChain.BypassMask;
+  if (SpeakerMask) *SpeakerMask = rt_SpeakerChain.BypassMask;
+}
+
+void RealtimeVoiceSetDspProfiling(bool Enable) {
+  rt_MicChain.Profile = Enable;
+  rt_SpeakerChain.Profile = Enable;
+}
+
+void RealtimeVoiceSetConnectionPolicy(ConnectionPolicy_t Policy) {
+  if (Policy >= CONN_POLICY_COUNT) return;
+  rt_Policy = Policy;
+  ConfigSaveConnectionPolicy((uint8_t)Policy);
+  Serial.printf("[RealtimeVoice] Connection policy: %s\n", RealtimeVoiceConnectionPolicyName(Policy));
+}
+
+ConnectionPolicy_t RealtimeVoiceGetConnectionPolicy() {
+  return rt_Policy;
+}
+
+const char* RealtimeVoiceConnectionPolicyName(ConnectionPolicy_t Policy) {
+  switch (Policy) {
+    case CONN_POLICY_ON_DEMAND: return "on-demand";
+    case CONN_POLICY_EARLY_ENERGY: return "early-energy";
+    case CONN_POLICY_ALWAYS: return "always";
+    default: return "unknown";
+  }
+}
+
+uint32_t RealtimeVoiceGetConnectHeap() {
+  return rt_ConnectHeap;
+}
+
+uint32_t RealtimeVoiceGetConnectMs() {
+  return rt_ConnectMs;
+}
+
+uint32_t RealtimeVoiceGetHeartbeatBytesPerMin() {
+  uint32_t Ms = rt_ConnectedMs + (rt_IsConnected ? millis() - rt_ConnectedSinceMs : 0);
+  return Ms >= 1000 ? (uint32_t)((uint64_t)rt_HeartbeatBytes * 60000 / Ms) : 0;
+}
+
+void RealtimeVoicePrintConnectionStats() {
+  uint32_t Ms = rt_ConnectedMs + (rt_IsConnected ? millis() - rt_ConnectedSinceMs : 0);
+  Serial.printf("[RealtimeVoice] Connection policy=%s, connect=%u ms, session heap=%u bytes, free=%u\n",
+    RealtimeVoiceConnectionPolicyName(rt_Policy), rt_ConnectMs, rt_ConnectHeap, ESP.getFreeHeap());
+  Serial.printf("[RealtimeVoice] Last connect: handshake=%u ms, config=%u ms\n", rt_HandshakeMs, rt_ConfigMs);
+  Serial.printf("[RealtimeVoice] Heartbeat %u bytes over %u s connected (%u bytes/min)\n",
+    rt_HeartbeatBytes, Ms / 1000, RealtimeVoiceGetHeartbeatBytesPerMin());
+  uint32_t Heap = ESP.getFreeHeap();
+  Serial.printf("[RealtimeVoice] Heap free=%u min=%u (%u since session ready) largest=%u, %d since session ready; control arena peak %u/%u, %u overflows\n",
+    Heap, ESP.getMinFreeHeap(), rt_HeapMinSinceReady, ESP.getMaxAllocHeap(), rt_HeapAtReady ? (int)(Heap - rt_HeapAtReady) : 0,
+    (unsigned)rt_RxArena.Peak, (unsigned)ControlArena::CAPACITY, rt_RxArena.Overflows);
 }
 
 uint8_t RealtimeVoiceGetVolume() {
   return rt_Volume;
 }
 
+void RealtimeVoiceResetUplinkStats() {
+  rt_FramesSent = 0;
+  rt_FramesFailed = 0;
+  rt_FramesSuppressed = 0;
+  rt_BytesSent = 0;
+  rt_BytesSuppressed = 0;
+  rt_BargeIns = 0;
+  rt_UplinkCopied = 0;
+  rt_DownlinkCopied = 0;
+  rt_CopyStatsMs = millis();
+  AgcResetStats(&rt_Agc);
+}
+
+template <typename Chain>
+static void PrintChainStats(const char* Label, const Chain& C) {
+  Serial.printf("[RealtimeVoice] %s chain %u cycles/frame, bypass=0x%02x%s\n",
+    Label, C.FrameCycles, C.BypassMask, C.Profile ? "" : " (profiling off)");
+  if (!C.Profile) return;
+  for (size_t I = 0; I < Chain::STAGE_COUNT; I++) {
+    Serial.printf("[RealtimeVoice]   %-8s %s %u cycles\n", Chain::StageName(I),
+      (C.BypassMask >> I) & 1 ? "bypass" : "active", C.StageCycles[I]);
+  }
+}
+
+void RealtimeVoicePrintUplinkStats() {
+  uint32_t Total = rt_BytesSent + rt_BytesSuppressed;
+  Serial.printf("[RealtimeVoice] Uplink frames sent=%u failed=%u suppressed=%u, bytes sent=%u saved=%u (%u%%)\n",
+    rt_FramesSent, rt_FramesFailed, rt_FramesSuppressed, rt_BytesSent, rt_BytesSuppressed,
+    Total ? (uint32_t)((uint64_t)rt_BytesSuppressed * 100 / Total) : 0);
+  Serial.printf("[RealtimeVoice] AEC erle=%d dB, delay=%d samples, %u cycles/frame, barge-ins=%u\n",
+    rt_Aec ? AecErleDb(rt_Aec) : 0, rt_Aec && rt_Aec->DelayValid ? (int)rt_Aec->Delay : -1, rt_AecCycles, rt_BargeIns);
+  Serial.printf("[RealtimeVoice] AGC gain=%d.%d dB, clipped=%u ppm, limited blocks=%u\n",
+    AgcGainDb10(&rt_Agc) / 10, abs(AgcGainDb10(&rt_Agc) % 10), AgcClipPpm(&rt_Agc), rt_Agc.LimitedBlocks);
+  Serial.printf("[RealtimeVoice] Noise suppression %s, %u cycles/frame, attenuation %u dB\n",
+    rt_NsActive ? "on" : "off", rt_NsCycles, rt_NsActive ? NsAttenuationDb(&rt_Ns) : 0);
+  Serial.printf("[RealtimeVoice] Rates mic=%u speaker=%u session=%u Hz, resampler %u cycles/frame\n",
+    I2SGetMicRate(), I2SGetSpeakerRate(), rt_SessionRate, rt_ResampleCycles);
+  Serial.printf("[RealtimeVoice] Pre-roll sent=%u ms\n", (unsigned)(rt_PreRollSent * AUDIO_FRAME_MS));
+  uint32_t Seconds = (millis() - rt_CopyStatsMs) / 1000;
+  Serial.printf("[RealtimeVoice] Copied uplink=%u B/s (capture reads), downlink=%u B/s (staged)\n",
+    Seconds ? rt_UplinkCopied / Seconds : rt_UplinkCopied, Seconds ? rt_DownlinkCopied / Seconds : rt_DownlinkCopied);
+  Serial.printf("[RealtimeVoice] Framing %s: sent=%u, received=%u lost=%u late=%u duplicate=%u malformed=%u, jitter=%u us\n",
+    rt_Framing ? "on" : "off", rt_TxSeq, rt_RxStats.Received, rt_RxStats.Lost, rt_RxStats.Late, rt_RxStats.Duplicates, rt_RxMalformed,
+    WireRxJitterUs(&rt_RxStats));
+  PrintChainStats("Mic", rt_MicChain);
+  PrintChainStats("Speaker", rt_SpeakerChain);
+  Serial.printf("[RealtimeVoice] Speaker limiter engaged on %u samples\n", rt_SpeakerChain.Stage<3>().Limited);
+}
+
 static void OnWsEvent(WStype_t Type, uint8_t* Payload, size_t Length) {
   switch (Type) {
     case WStype_DISCONNECTED:
+      if (rt_IsConnected) rt_ConnectedMs += millis() - rt_ConnectedSinceMs;
       rt_IsConnected = false;
+      rt_SessionReady = false;
       rt_IsListening = false;
+      AudioCaptureEnable(CAPTURE_CONSUMER_UPLINK, false);
       Serial.println("[RealtimeVoice] WebSocket disconnected");
       break;
       
     case WStype_CONNECTED: {
       rt_IsConnected = true;
+      rt_ConnectedSinceMs = millis();
+      rt_HandshakeMs = millis() - rt_ConnectStartMs;
+      LatencyTraceMark(LAT_CONNECTED);
+      rt_SessionReady = false;
+      rt_Framing = false;
+      rt_TxSeq = 0;
+      WireRxReset(&rt_RxStats);
+      rt_UplinkAdpcm = false;
+      rt_UplinkDtx = false;
       LastPingTime = millis();
-      PlaybackBuffer.clear(); 
+      AudioPlaybackClear(); 
       Serial.println("[RealtimeVoice] WebSocket connected");
       
-      JsonDocument configDoc;
-      configDoc["type"] = "config";
-      configDoc["voice"] = "coral";  
-      configDoc["language"] = "en";  
-      
-      String configJson;
-      serializeJson(configDoc, configJson);
-      WsClient.sendTXT(configJson);
+      SendControlText("%s", CONFIG_MESSAGE);
       Serial.println("[RealtimeVoice] Sent config to server");
       break;
     }
       
     case WStype_TEXT: {
-      JsonDocument Doc;
+      rt_RxArena.Reset();
+      JsonDocument Doc(&rt_RxArena);
       DeserializationError Error = deserializeJson(Doc, Payload, Length);
       
       if (Error) {
-        Serial.println("[RealtimeVoice] JSON parse error");
+        Serial.printf("[RealtimeVoice] JSON parse error: %s\n", Error.c_str());
         return;
       }
       
@@ -435,12 +833,52 @@ static void OnWsEvent(WStype_t Type, uint8_t* Payload, size_t Length) {
       
       if (MsgType && strcmp(MsgType, "auth") == 0) {
         Serial.println("[RealtimeVoice] Authenticated with server");
+        const char* Codec = Doc["uplink_codec"];
+        rt_UplinkAdpcm = Codec && strcmp(Codec, "ima_adpcm") == 0;
+        rt_UplinkDtx = Doc["dtx"] | false;
+        Serial.printf("[RealtimeVoice] Uplink codec: %s, DTX: %s\n", rt_UplinkAdpcm ? "ima_adpcm" : "pcm16", rt_UplinkDtx ? "on" : "off");
+        
+        const char* Framing = Doc["framing"];
+        rt_Framing = Framing && strcmp(Framing, WIRE_FRAMING_NAME) == 0;
+        Serial.printf("[RealtimeVoice] Framing: %s\n", rt_Framing ? WIRE_FRAMING_NAME : "none (JSON control)");
+        
+        const char* Downlink = Doc["downlink_codec"];
+        bool UseMp3 = Downlink && strcmp(Downlink, DownlinkCodecName(DOWNLINK_CODEC_MP3)) == 0;
+        if (!DownlinkDecoderBegin(UseMp3 ? DOWNLINK_CODEC_MP3 : DOWNLINK_CODEC_PCM16)) {
+          DownlinkDecoderBegin(DOWNLINK_CODEC_PCM16);
+        }
+        Serial.printf("[RealtimeVoice] Downlink codec: %s\n", DownlinkCodecName(DownlinkDecoderGetCodec()));
+        
+        uint32_t Rate = Doc["sample_rate"] | (uint32_t)QUIL_SESSION_SAMPLE_RATE;
+        SetSessionRate(Rate <= SESSION_RATE_MAX ? Rate : QUIL_SESSION_SAMPLE_RATE);
+        rt_SessionReady = true;
+        
+        // The session's buffers and TLS context are all allocated by now
+        uint32_t Heap = ESP.getFreeHeap();
+        rt_ConnectHeap = rt_HeapBeforeConnect > Heap ? rt_HeapBeforeConnect - Heap : 0;
+        if (rt_ConnectMs == 0) rt_ConnectMs = millis() - rt_ConnectStartMs;
+        rt_ConfigMs = millis() - rt_ConnectedSinceMs;
+        rt_HeapAtReady = Heap;
+        rt_HeapMinSinceReady = Heap;
+        rt_HeapLogMs = millis();
+        Serial.printf("[RealtimeVoice] Session ready after %u ms (handshake %u, config %u), holding %u bytes\n",
+          rt_ConnectMs, rt_HandshakeMs, rt_ConfigMs, rt_ConnectHeap);
+        // Everything a conversation allocates (capture rings, pre-roll, echo
+        // reference and canceller, decoder, TLS) is in place: what is left
+        // of internal RAM is the margin a board without PSRAM runs on
+        Serial.printf("[RealtimeVoice] Heap after start: internal free=%u largest=%u min=%u, PSRAM free=%u\n",
+          heap_caps_get_free_size(MALLOC_CAP_INTERNAL), heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL),
+          heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL), ESP.getFreePsram());
       } else if (MsgType && strcmp(MsgType, "server") == 0) {
         if (Msg && strcmp(Msg, "RESPONSE.COMPLETE") == 0) {
           Serial.println("[RealtimeVoice] AI response complete");
         } else if (Msg && strcmp(Msg, "AUDIO.COMMITTED") == 0) {
+          // The server detected the end of the turn
+          LatencyTraceMark(LAT_END_OF_SPEECH);
           Serial.println("[RealtimeVoice] Audio committed");
         }
+      } else if (MsgType && strcmp(MsgType, "pong") == 0) {
+        rt_HeartbeatBytes += Length;
       } else if (MsgType && strcmp(MsgType, "error") == 0) {
         const char* ErrorMsg = Doc["message"];
         Serial.printf("[RealtimeVoice] Error: %s\n", ErrorMsg ? ErrorMsg : "Unknown");
@@ -449,11 +887,18 @@ static void OnWsEvent(WStype_t Type, uint8_t* Payload, size_t Length) {
     }
       
     case WStype_BIN:
-      ProcessAudioChunk(Payload, Length);
+      if (rt_Framing) {
+        ProcessFramedMessage(Payload, Length);
+      } else {
+        ProcessAudioChunk(Payload, Length);
+      }
       break;
       
     case WStype_PING:
+      break;
+      
     case WStype_PONG:
+      rt_HeartbeatBytes += WS_PING_FRAME_BYTES + WS_PONG_FRAME_BYTES;
       break;
       
     case WStype_ERROR:
@@ -465,62 +910,448 @@ static void OnWsEvent(WStype_t Type, uint8_t* Payload, size_t Length) {
   }
 }
 
-static void ProcessAudioChunk(uint8_t* Data, size_t Length) {
+// Pick up volume changes; the ramp spreads them over a few milliseconds
+static void SyncSpeakerVolume() {
+  DspGainStage& Volume = rt_SpeakerChain.Stage<2>();
+  if (rt_VolumeQ15 != Volume.Get()) {
+    Volume.Set(rt_VolumeQ15, I2SGetSpeakerRate() * VOLUME_RAMP_MS / 1000);
+  }
+}
+
+// Scale decoded/raw PCM by the volume ramp straight into the playback ring
+static void QueuePlaybackPcm(const int16_t* Samples, size_t SampleCount) {
+  SyncSpeakerVolume();
+  
+  size_t Done = 0;
+  while (Done < SampleCount) {
+    size_t Contiguous = 0;
+    int16_t* Dest = AudioPlaybackReserve(SampleCount - Done, &Contiguous);
+    if (!Dest) {
+      Serial.println("[RealtimeVoice] Playback buffer overflow");
+      return;
+    }
+    size_t Count = min(Contiguous, SampleCount - Done);
+    rt_SpeakerChain.Process(Samples + Done, Dest, Count);
+    AudioPlaybackCommit(Count);
+    Done += Count;
+  }
+  rt_ChunkSamples += SampleCount;
+}
+
+// Convert downlink audio at Rate to the speaker rate and queue it
+static void QueueResampledPcm(const int16_t* Samples, size_t SampleCount, uint32_t Rate) {
+  if (Rate != rt_DownlinkResampler.InRate || I2SGetSpeakerRate() != rt_DownlinkResampler.OutRate) {
+    // Never retune the speaker from here: the playback task owns it, and
+    // the echo canceller needs it at the mic rate
+    if (!ResamplerInit(&rt_DownlinkResampler, Rate, I2SGetSpeakerRate())) {
+      Serial.printf("[RealtimeVoice] No resampler for %u -> %u Hz, playing unconverted\n", Rate, I2SGetSpeakerRate());
+    }
+  }
+  
+  if (ResamplerIsBypass(&rt_DownlinkResampler)) {
+    QueuePlaybackPcm(Samples, SampleCount);
+    return;
+  }
+  
+  // Resample into the ring and run the speaker chain there in place; only
+  // a block that would straddle the ring's end is staged in DownlinkBuffer
+  size_t Block = ResamplerMaxInput(&rt_DownlinkResampler, RESAMPLE_BLOCK_SAMPLES);
+  for (size_t Done = 0; Done < SampleCount; Done += Block) {
+    size_t Count = min(Block, SampleCount - Done);
+    size_t Room = ResamplerMaxOutput(&rt_DownlinkResampler, Count);
+    size_t Contiguous = 0;
+    int16_t* Dest = AudioPlaybackReserve(Room, &Contiguous);
+    if (!Dest) {
+      Serial.println("[RealtimeVoice] Playback buffer overflow");
+      return;
+    }
+    if (Contiguous >= Room) {
+      SyncSpeakerVolume();
+      size_t Out = ResamplerProcess(&rt_DownlinkResampler, Samples + Done, Count, Dest);
+      rt_SpeakerChain.Process(Dest, Out);
+      AudioPlaybackCommit(Out);
+      rt_ChunkSamples += Out;
+    } else {
+      size_t Out = ResamplerProcess(&rt_DownlinkResampler, Samples + Done, Count, DownlinkBuffer);
+      rt_DownlinkCopied += Out * sizeof(int16_t);
+      QueuePlaybackPcm(DownlinkBuffer, Out);
+    }
+  }
+}
+
+// Decoder sink: the stream carries its own sample rate
+static void QueueDecodedPcm(const int16_t* Samples, size_t SampleCount) {
+  uint32_t Rate = DownlinkDecoderGetSampleRate();
+  QueueResampledPcm(Samples, SampleCount, Rate != 0 ? Rate : rt_SessionRate);
+}
+
+static void ProcessAudioChunk(const uint8_t* Data, size_t Length) {
+  LatencyTraceMark(LAT_FIRST_DOWNLINK);
+  rt_ChunkSamples = 0;
+  if (DownlinkDecoderGetCodec() != DOWNLINK_CODEC_PCM16) {
+    DownlinkDecoderFeed(Data, Length, QueueDecodedPcm);
+    AudioPlaybackNoteArrival(rt_ChunkSamples);
+    return;
+  }
+
   if (Length % 2 != 0) {
     return;
   }
 
-  int16_t* Samples = (int16_t*)Data;
-  size_t SampleCount = Length / 2;
+  // Leaves the payload untouched
+  QueueResampledPcm((const int16_t*)Data, Length / 2, rt_SessionRate);
+  AudioPlaybackNoteArrival(rt_ChunkSamples);
+}
+
+static void ProcessFramedMessage(const uint8_t* Data, size_t Length) {
+  WireHeader_t Header;
+  const uint8_t* Payload;
+  size_t Bytes;
+  if (!WireParse(Data, Length, &Header, &Payload, &Bytes)) {
+    rt_RxMalformed++;
+    return;
+  }
+  WireRxTrack(&rt_RxStats, &Header, (uint32_t)micros());
+  
+  switch (Header.Type) {
+    case WIRE_AUDIO:
+      ProcessAudioChunk(Payload, Bytes);
+      break;
+    case WIRE_PONG:
+      rt_HeartbeatBytes += Length;
+      break;
+    case WIRE_RESPONSE_COMPLETE:
+      Serial.println("[RealtimeVoice] AI response complete");
+      break;
+    case WIRE_AUDIO_COMMITTED:
+      LatencyTraceMark(LAT_END_OF_SPEECH);
+      Serial.println("[RealtimeVoice] Audio committed");
+      break;
+    case WIRE_ERROR:
+      Serial.printf("[RealtimeVoice] Error: %.*s\n", (int)Bytes, (const char*)Payload);
+      break;
+    default:
+      break;
+  }
+}
+
+// Rate negotiated with the server; mic frames are converted to it
+static void SetSessionRate(uint32_t Rate) {
+  rt_SessionRate = Rate;
+  if (!ResamplerInit(&rt_UplinkResampler, I2SGetMicRate(), Rate)) {
+    Serial.printf("[RealtimeVoice] No resampler for %u -> %u Hz, sending at the mic rate\n", I2SGetMicRate(), Rate);
+  }
+  Serial.printf("[RealtimeVoice] Session rate %u Hz (mic %u, speaker %u)\n", Rate, I2SGetMicRate(), I2SGetSpeakerRate());
+}
+
+// Subtract speaker echo from MicBuffer; false when nothing is playing
+static bool CancelEcho(int64_t CaptureUs) {
+  uint32_t Rate = I2SGetMicRate();
+  uint32_t Index;
+  bool Playing = rt_Aec && I2SGetSpeakerRate() == Rate && AudioPlaybackReferenceIndex(CaptureUs, &Index);
+  bool Slipped = false;
+  if (Playing) {
+    // The playback timing is only good to a DMA buffer, so the reference
+    // is taken that much (and a millisecond) early; the canceller's delay
+    // search finds the echo behind it
+    Index -= min((uint32_t)I2SGetDmaBufLen() + Rate / 1000, (uint32_t)AEC_DELAY_MAX / 2);
+    // Each frame follows on from the last: re-reading the timing every
+    // frame would jitter the reference, which the filter sees as a moving
+    // echo path. Only a real slip re-aligns it.
+    if (rt_AecPrimed) {
+      int32_t Slip = (int32_t)(Index - rt_RefIndex);
+      int32_t Limit = (int32_t)(Rate * AEC_REFERENCE_SLIP_MS / 1000);
+      Slipped = Slip > Limit || Slip < -Limit;
+      if (!Slipped) Index = rt_RefIndex;
+    }
+    Playing = AudioPlaybackCopyReference(Index, RefBuffer, AUDIO_FRAME_SAMPLES);
+  }
+  if (!Playing || Slipped) {
+    // Reference no longer continuous: drop the history, keep the taps
+    if (rt_AecPrimed) {
+      AecResetHistory(rt_Aec);
+      rt_AecPrimed = false;
+    }
+    if (!Playing) return false;
+  }
+  
+  rt_AecPrimed = true;
+  rt_RefIndex = Index + AUDIO_FRAME_SAMPLES;
+  uint32_t Start = DspCycles();
+  AecProcess(rt_Aec, RefBuffer, MicBuffer, AUDIO_FRAME_SAMPLES);
+  rt_AecCycles = AverageCycles(rt_AecCycles, DspCycles() - Start);
+  return true;
+}
+
+// Send Length bytes at Message as one binary frame. False if the socket did
+// not take it.
+// With headerToPayload the library writes its header into the
+// WEBSOCKETS_MAX_HEADER_SIZE bytes in front of Message and sends the
+// payload as it is: the mask bit is set but the key is 0000, so nothing is
+// masked (RFC 6455 5.3 wants a fresh random key per client frame). The
+// key cannot be supplied, and masking the payload here would corrupt it,
+// since the server unmasks with the key in the header. Masking only guards
+// caches and proxies that read plain HTTP, which cannot see inside TLS, so
+// in place is used there. Over plain ws:// the library gets a copy and
+// masks it with a random key, at the cost of a malloc per frame.
+static bool SendInPlace(uint8_t* Message, size_t Length) {
+  if (!rt_SendInPlace) return WsClient.sendBIN(Message, Length);
+  return WsClient.sendBIN(Message - WEBSOCKETS_MAX_HEADER_SIZE, Length, true);
+}
+
+// Send the PayloadBytes at Payload (TX_HEADROOM in front of it) behind a
+// wire header; returns the message size, 0 if the send failed
+static size_t SendFramed(uint8_t* Payload, WireType_t Type, WireCodec_t Codec, uint8_t Flags, uint32_t TimestampUs, size_t PayloadBytes) {
+  WireHeader_t Header;
+  Header.Type = Type;
+  Header.Codec = Codec;
+  Header.Flags = Flags;
+  Header.Seq = rt_TxSeq++;
+  Header.TimestampUs = TimestampUs;
+  uint8_t* Message = Payload - WIRE_HEADER_BYTES;
+  WireWriteHeader(&Header, Message);
+  if (!SendInPlace(Message, WIRE_HEADER_BYTES + PayloadBytes)) return 0;
+  return WIRE_HEADER_BYTES + PayloadBytes;
+}
+
+// Session-rate bytes one uplink frame takes, for the DTX accounting
+static size_t UplinkFrameBytes() {
+  size_t Samples = ResamplerIsBypass(&rt_UplinkResampler) ? AUDIO_FRAME_SAMPLES : rt_SessionRate * AUDIO_FRAME_MS / 1000;
+  return rt_UplinkAdpcm ? IMA_ADPCM_BLOCK_BYTES(Samples) : Samples * sizeof(int16_t);
+}
+
+// Keep a frame DTX withheld, dropping the oldest once the lookback is full
+static void HoldFrame(const AudioFrameInfo_t& Info) {
+  uint8_t Slot = (rt_HeldFirst + rt_HeldCount) % DTX_LOOKBACK_FRAMES;
+  if (rt_HeldCount == DTX_LOOKBACK_FRAMES) {
+    rt_HeldFirst = (rt_HeldFirst + 1) % DTX_LOOKBACK_FRAMES;
+  } else {
+    rt_HeldCount++;
+  }
+  memcpy(rt_Held[Slot], MicBuffer, sizeof(rt_Held[Slot]));
+  rt_HeldInfo[Slot] = Info;
+  rt_UplinkCopied += sizeof(rt_Held[Slot]);
+}
+
+// Resample, encode and send one conditioned frame: MicBuffer, which has
+// header room in front, or a held one. Returns the bytes sent, 0 if the
+// send failed.
+static size_t SendUplinkAudio(int16_t* Samples, const AudioFrameInfo_t& Info) {
+  // Convert to the session rate. PCM16 is resampled straight into the send
+  // buffer; ADPCM needs the samples apart from its output. Withheld frames
+  // are not resampled, so the first after a gap starts from stale history,
+  // under a discontinuity flag.
+  int16_t* Frame = Samples;
+  size_t FrameSamples = AUDIO_FRAME_SAMPLES;
+  if (!ResamplerIsBypass(&rt_UplinkResampler)) {
+    uint32_t Start = DspCycles();
+    Frame = rt_UplinkAdpcm ? UplinkBuffer : (int16_t*)TxPayload;
+    FrameSamples = ResamplerProcess(&rt_UplinkResampler, Samples, AUDIO_FRAME_SAMPLES, Frame);
+    rt_ResampleCycles = DspCycles() - Start;
+  } else if (Samples != MicBuffer && !rt_UplinkAdpcm) {
+    memcpy(TxPayload, Samples, AUDIO_FRAME_SAMPLES * sizeof(int16_t));
+    rt_UplinkCopied += AUDIO_FRAME_SAMPLES * sizeof(int16_t);
+    Frame = (int16_t*)TxPayload;
+  }
   
-  for (size_t I = 0; I < SampleCount; I++) {
-    int32_t Sample = Samples[I];
-    Sample = (Sample * rt_Volume) / 100;
-    Samples[I] = (int16_t)Sample;
+  // PCM16 is sent from wherever the frame ended up; both places have
+  // header room in front
+  uint8_t* Payload = (uint8_t*)Frame;
+  size_t Bytes = FrameSamples * sizeof(int16_t);
+  if (rt_UplinkAdpcm) {
+    Bytes = ImaAdpcmEncode(&rt_AdpcmState, Frame, FrameSamples, TxPayload);
+    Payload = TxPayload;
   }
   
-  if (!PlaybackBuffer.write(Samples, SampleCount)) {
-    Serial.println("[RealtimeVoice] Playback buffer overflow");
+  // Capture lost audio before this frame (a DMA profile switch)
+  if (Info.Flags & AUDIO_FRAME_FLAG_GAP) rt_UplinkGap = true;
+  
+  size_t FrameBytes;
+  if (rt_Framing) {
+    // Capture time and sequence travel with the frame
+    uint8_t Flags = (rt_PreRollFlushing ? WIRE_FLAG_PREROLL : 0) | (rt_UplinkGap ? WIRE_FLAG_DISCONTINUITY : 0);
+    FrameBytes = SendFramed(Payload, WIRE_AUDIO, rt_UplinkAdpcm ? WIRE_CODEC_IMA_ADPCM : WIRE_CODEC_PCM16, Flags, (uint32_t)Info.TimestampUs, Bytes);
+  } else {
+    FrameBytes = SendInPlace(Payload, Bytes) ? Bytes : 0;
+  }
+  if (FrameBytes == 0) {
+    // The server missed this one: flag the next as a discontinuity
+    rt_FramesFailed++;
+    rt_UplinkGap = true;
+    return 0;
+  }
+  LatencyTraceMark(LAT_FIRST_UPLINK);
+  // Pre-roll and held frames are old by design; only live ones show the
+  // DMA's share
+  if (!rt_PreRollFlushing && Samples == MicBuffer) {
+    AudioDmaRecordCaptureToSend((uint32_t)(esp_timer_get_time() - Info.TimestampUs));
   }
+  rt_UplinkGap = false;
+  rt_FramesSent++;
+  rt_BytesSent += FrameBytes;
+  return FrameBytes;
 }
 
-static void StreamMicData() {
-  size_t BytesRead = I2SReadMic(MicBuffer, AUDIO_BUFFER_SIZE);
-
-  // AMPLIFY: Boost volume x32
-  if (BytesRead > 0) {
-      int16_t* samples = (int16_t*)MicBuffer;
-      size_t sampleCount = BytesRead / 2;
-      for (size_t i = 0; i < sampleCount; i++) {
-          int32_t val = samples[i];
-          val = val * 32; 
-          if (val > 32767) val = 32767;
-          if (val < -32768) val = -32768;
-          samples[i] = (int16_t)val;
+// Condition, encode and send the raw frame in MicBuffer
+static void SendMicFrame(const AudioFrameInfo_t& Info) {
+  // Linear conditioning first: the echo path simply includes it
+  rt_MicChain.Process(MicBuffer, AUDIO_FRAME_SAMPLES);
+  
+  // Echo cancellation runs before the (clipping) gain stage
+  bool EchoActive = CancelEcho(Info.TimestampUs);
+  
+  if (rt_NoiseSuppression != rt_NsActive) {
+    rt_NsActive = rt_NoiseSuppression && rt_NsReady;
+    if (rt_NsActive) NsReset(&rt_Ns);
+  }
+  if (rt_NsActive) {
+    uint32_t NsStart = DspCycles();
+    NsProcess(&rt_Ns, MicBuffer);
+    rt_NsCycles = AverageCycles(rt_NsCycles, DspCycles() - NsStart);
+  }
+  
+  uint32_t Start = DspCycles();
+  AgcProcess(&rt_Agc, MicBuffer, AUDIO_FRAME_SAMPLES);
+  RecordKernelCycles(DspCycles() - Start);
+  
+  bool Active = VadProcess(&rt_Vad, MicBuffer, AUDIO_FRAME_SAMPLES);
+  
+  // Barge-in: speech the echo canceller cannot explain, over playback
+  // (once it has found the echo, or any misalignment would count)
+  if (EchoActive && rt_Aec && rt_Aec->DelayValid && rt_Aec->NearEnd && rt_Vad.Speech) {
+    if (++rt_BargeInFrames >= BARGE_IN_FRAMES) {
+      rt_BargeInFrames = 0;
+      rt_BargeIns++;
+      Serial.println("[RealtimeVoice] Barge-in detected");
+      RealtimeVoiceInterrupt();
+    }
+  } else {
+    rt_BargeInFrames = 0;
+  }
+  
+  if (rt_UplinkDtx && !Active) {
+    rt_FramesSuppressed++;
+    rt_BytesSuppressed += UplinkFrameBytes();
+    HoldFrame(Info);
+    // The first silent frame and every DTX_MARKER_FRAMES after it carry a marker
+    if (rt_SilentFrames++ % DTX_MARKER_FRAMES == 0) {
+      size_t MarkerBytes;
+      if (rt_Framing) {
+        TxPayload[0] = VadNoiseLevelDb(&rt_Vad);
+        MarkerBytes = SendFramed(TxPayload, WIRE_COMFORT_NOISE, WIRE_CODEC_NONE, 0, (uint32_t)Info.TimestampUs, 1);
+      } else {
+        TxPayload[0] = 'C';
+        TxPayload[1] = 'N';
+        TxPayload[2] = VadNoiseLevelDb(&rt_Vad);
+        MarkerBytes = SendInPlace(TxPayload, 3) ? 3 : 0;
       }
+      rt_BytesSent += MarkerBytes;
+      rt_BytesSuppressed -= MarkerBytes;
+    }
+    rt_UplinkGap = true;
+    return;
   }
+  rt_SilentFrames = 0;
   
-  if (BytesRead > 0) {
-    WsClient.sendBIN(MicBuffer, BytesRead);
+  // The onset the VAD was late for goes out first, oldest frame first
+  while (rt_HeldCount > 0) {
+    uint8_t Slot = rt_HeldFirst;
+    rt_HeldFirst = (rt_HeldFirst + 1) % DTX_LOOKBACK_FRAMES;
+    rt_HeldCount--;
+    rt_FramesSuppressed--;
+    rt_BytesSuppressed -= UplinkFrameBytes();
+    SendUplinkAudio(rt_Held[Slot], rt_HeldInfo[Slot]);
   }
+  SendUplinkAudio(MicBuffer, Info);
 }
 
-static void PlayBufferedAudio() {
-  const int ChunkSamples = 512; 
+// Bracket the historical frames so the server can tell them from live audio
+static void SendPreRollMarker(WireType_t Type, const char* Msg, uint32_t Frames) {
+  if (rt_Framing) {
+    uint8_t* Message = (uint8_t*)rt_ControlText;
+    WireHeader_t Header = {(uint8_t)Type, WIRE_CODEC_NONE, 0, rt_TxSeq++, (uint32_t)micros()};
+    WireWriteHeader(&Header, Message);
+    WirePutU32(Message + WIRE_HEADER_BYTES, Frames);
+    SendInPlace(Message, WIRE_HEADER_BYTES + 4);
+    return;
+  }
   
-  if (PlaybackBuffer.available() >= ChunkSamples) {
-    if (PlaybackBuffer.read(TempPlaybackChunk, ChunkSamples)) {
-       I2SWriteSpeaker((uint8_t*)TempPlaybackChunk, ChunkSamples * 2);
+  SendControlText("{\"type\":\"instruction\",\"msg\":\"%s\",\"frames\":%u,\"ms\":%u}",
+    Msg, (unsigned)Frames, (unsigned)(Frames * AUDIO_FRAME_MS));
+}
+
+// Next uplink frame from the capture task into MicBuffer
+static bool ReadUplinkFrame(AudioFrameInfo_t* Info) {
+  if (AudioCaptureRead(CAPTURE_CONSUMER_UPLINK, MicBuffer, Info) == 0) return false;
+  rt_UplinkCopied += AUDIO_FRAME_SAMPLES * sizeof(int16_t);
+  return true;
+}
+
+static void StreamMicData() {
+  AudioFrameInfo_t Info;
+  if (rt_PreRollFlushing) {
+    // Live frames queue behind the history until it has been sent, so the
+    // server hears one continuous stream
+    while (ReadUplinkFrame(&Info)) {
+      AudioPreRollPush(MicBuffer, &Info);
+    }
+    if (!rt_IsConnected || !rt_SessionReady) return;
+    
+    if (!rt_PreRollAnnounced) {
+      rt_PreRollAnnounced = true;
+      rt_PreRollSent = 0;
+      if (AudioPreRollFrames() > 0) SendPreRollMarker(WIRE_PREROLL_START, "preroll_start", AudioPreRollFrames());
+    }
+    for (size_t N = 0; N < PREROLL_FLUSH_FRAMES && AudioPreRollPop(MicBuffer, &Info) > 0; N++) {
+      SendMicFrame(Info);
+      rt_PreRollSent++;
+    }
+    if (AudioPreRollFrames() == 0) {
+      rt_PreRollFlushing = false;
+      if (rt_PreRollSent > 0) {
+        SendPreRollMarker(WIRE_PREROLL_END, "preroll_end", rt_PreRollSent);
+        Serial.printf("[RealtimeVoice] Pre-roll sent: %u ms\n", (unsigned)(rt_PreRollSent * AUDIO_FRAME_MS));
+      }
     }
+    return;
+  }
+  
+  // Send every frame the capture task queued since the last pass
+  if (!rt_IsConnected) return;
+  while (ReadUplinkFrame(&Info)) {
+    SendMicFrame(Info);
   }
 }
 
-static void SendInstruction(const char* Msg) {
-  JsonDocument Doc;
-  Doc["type"] = "instruction";
-  Doc["msg"] = Msg;
+// Control message: a binary opcode with framing, else a JSON instruction.
+// Returns the bytes put on the wire (payload plus the masked frame header),
+// 0 if the send failed.
+static size_t SendControl(WireType_t Type, const char* Msg) {
+  if (rt_Framing) {
+    uint8_t* Message = (uint8_t*)rt_ControlText;
+    WireHeader_t Header = {(uint8_t)Type, WIRE_CODEC_NONE, 0, rt_TxSeq++, (uint32_t)micros()};
+    if (!SendInPlace(Message, WireWriteHeader(&Header, Message))) return 0;
+    return WIRE_HEADER_BYTES + WS_PING_FRAME_BYTES;
+  }
   
-  String Json;
-  serializeJson(Doc, Json);
-  WsClient.sendTXT(Json);
+  size_t Len = SendControlText("{\"type\":\"instruction\",\"msg\":\"%s\"}", Msg);
+  return Len ? Len + WS_PING_FRAME_BYTES : 0;
+}
+
+// Format into the headroom buffer and send in place. Returns the text
+// length, 0 if it did not fit or the send failed.
+static size_t SendControlText(const char* Format, ...) {
+  va_list Args;
+  va_start(Args, Format);
+  int Len = vsnprintf(rt_ControlText, CONTROL_TEXT_MAX, Format, Args);
+  va_end(Args);
+  
+  if (Len <= 0 || (size_t)Len >= CONTROL_TEXT_MAX) {
+    Serial.println("[RealtimeVoice] Control message too long, dropped");
+    return 0;
+  }
+  bool Sent = rt_SendInPlace ? WsClient.sendTXT((uint8_t*)rt_ControlTx, (size_t)Len, true)
+                             : WsClient.sendTXT((uint8_t*)rt_ControlText, (size_t)Len);
+  if (!Sent) return 0;
+  return (size_t)Len;
 }
@@ -1,37 +1,25 @@
 #pragma once
 #include <Arduino.h>
 #include <WebSocketsClient.h> // Required for RealtimeVoice public interface if types are exposed, or forward declare
+#include "types.h"
 
 // --- Audio Manager ---
-// Combines VoiceManager, WakeManager, AudioMemoryBuffer, and RealtimeVoice
+// Combines VoiceManager, WakeManager, and RealtimeVoice
+// (I2S tasks live in AudioCapture / AudioPlayback)
 
 // Core Audio Functions
 void AudioInit();
 void AudioStartListening();
 void AudioStopListening();
+void AudioStartConversationListening();  // Mic open, wake consumer off until AudioStartListening
 bool AudioIsListening();
 size_t AudioReadBuffer(uint8_t* buf, size_t len);
 void AudioPlayResponse(const uint8_t* data, size_t len);
 float AudioGetRms();
-
-// Audio Memory Buffer Class
-class AudioMemoryBuffer {
-private:
-    static const int BUFFER_SIZE = 16384; 
-    int16_t* buffer;
-    int writeIndex = 0;
-    int readIndex = 0; 
-    int samplesAvailable = 0;
-
-public:
-    AudioMemoryBuffer();
-    bool init();
-    bool write(const int16_t* data, int length);
-    bool read(int16_t* data, int length);
-    int available() const;
-    void clear();
-    int size() const { return BUFFER_SIZE; }
-};
+uint32_t AudioGetKernelCycles();  // Avg CPU cycles per frame for mic conditioning
+#ifdef AUDIO_KERNEL_BENCH
+void AudioBenchmarkKernels();     // Prints before/after cycle counts on serial
+#endif
 
 // Wake Word Detection
 void WakeInit(); // Might be internal to AudioInit
@@ -40,12 +28,21 @@ void WakeSetThreshold(float thresh);
 float WakeGetConfidence();
 float WakeGetAmbientNoise();
 float WakeGetThreshold();
+bool WakeEarlyEnergy();  // Last frame crossed the lower pre-threshold
 
 // Realtime Voice AI
 void RealtimeVoiceInit(); // Might be internal
 bool RealtimeVoiceConnect(const char* ServerUrl);
 void RealtimeVoiceDisconnect();
 bool RealtimeVoiceIsConnected();
+bool RealtimeVoiceIsStarted();  // Connect called and not yet disconnected (may still be handshaking)
+void RealtimeVoiceSetConnectionPolicy(ConnectionPolicy_t Policy);  // Saved to NVS
+ConnectionPolicy_t RealtimeVoiceGetConnectionPolicy();
+const char* RealtimeVoiceConnectionPolicyName(ConnectionPolicy_t Policy);
+uint32_t RealtimeVoiceGetConnectHeap();  // Heap held by the open session, bytes
+uint32_t RealtimeVoiceGetConnectMs();    // Connect call to auth reply, last session
+uint32_t RealtimeVoiceGetHeartbeatBytesPerMin();
+void RealtimeVoicePrintConnectionStats();
 void RealtimeVoiceLoop();
 void RealtimeVoiceStartListening();
 void RealtimeVoiceStopListening();
@@ -54,3 +51,12 @@ void RealtimeVoiceEndOfSpeech();
 void RealtimeVoiceInterrupt();
 void RealtimeVoiceSetVolume(uint8_t Volume);
 uint8_t RealtimeVoiceGetVolume();
+void RealtimeVoiceSetNoiseSuppression(bool Enable);  // Uplink spectral noise suppression
+bool RealtimeVoiceGetNoiseSuppression();
+float RealtimeVoiceGetMicGainDb();      // Uplink AGC gain
+uint32_t RealtimeVoiceGetMicClipPpm();  // Uplink samples clipped per million
+void RealtimeVoiceSetDspBypass(uint32_t MicMask, uint32_t SpeakerMask);  // Bit N skips chain stage N
+void RealtimeVoiceGetDspBypass(uint32_t* MicMask, uint32_t* SpeakerMask);
+void RealtimeVoiceSetDspProfiling(bool Enable);  // Per-stage cycles (runs the chains stage by stage)
+void RealtimeVoiceResetUplinkStats();  // Frames/bytes sent vs suppressed by DTX
+void RealtimeVoicePrintUplinkStats();
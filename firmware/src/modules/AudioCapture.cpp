@@ -0,0 +1,171 @@
+#include "AudioCapture.h"
+#include "AudioRingBuffer.h"
+#include "AudioDma.h"
+#include <driver/i2s.h>
+#include <esp_timer.h>
+
+// Each queued frame is its AudioFrameInfo_t header followed by the samples,
+// written with a single commit so consumers always see whole frames.
+static const size_t HEADER_SAMPLES = sizeof(AudioFrameInfo_t) / sizeof(int16_t);
+static const size_t UNIT_SAMPLES = HEADER_SAMPLES + AUDIO_FRAME_SAMPLES;
+
+typedef struct {
+  AudioFrameInfo_t Info;
+  int16_t Samples[AUDIO_FRAME_SAMPLES];
+} CaptureUnit_t;
+
+static AudioRingBuffer ConsumerRings[CAPTURE_CONSUMER_COUNT];
+static volatile bool ConsumerEnabled[CAPTURE_CONSUMER_COUNT] = {false};
+static volatile uint32_t ConsumerDropped[CAPTURE_CONSUMER_COUNT] = {0};
+static volatile uint32_t DmaOverflows = 0;
+
+static TaskHandle_t CaptureTask = NULL;
+static CaptureUnit_t Staging;
+static size_t StagingFill = 0;
+static uint32_t NextSeq = 0;
+static bool GapPending = false;  // Flag the next frame (set before the task starts)
+
+static void PublishFrame() {
+  for (int C = 0; C < CAPTURE_CONSUMER_COUNT; C++) {
+    if (!ConsumerEnabled[C]) continue;
+    if (!ConsumerRings[C].write((const int16_t*)&Staging, UNIT_SAMPLES)) {
+      ConsumerDropped[C]++;
+    }
+  }
+  NextSeq++;
+}
+
+static void CaptureTaskMain(void* Arg) {
+  QueueHandle_t Events = I2SGetMicEventQueue();
+
+  for (;;) {
+    i2s_event_t Event;
+    if (xQueueReceive(Events, &Event, portMAX_DELAY) != pdTRUE) continue;
+
+    if (Event.type == I2S_EVENT_RX_Q_OVF) {
+      DmaOverflows++;
+      AudioDmaNoteOverflow();
+      continue;
+    }
+    if (Event.type != I2S_EVENT_RX_DONE) continue;
+
+    // Drain everything the DMA has ready without blocking
+    int64_t Now = esp_timer_get_time();
+    uint32_t Rate = I2SGetMicRate();
+    size_t BufLen = I2SGetDmaBufLen();
+    size_t Drained = 0;
+    for (;;) {
+      size_t Want = AUDIO_FRAME_SAMPLES - StagingFill;
+      size_t Got = I2SReadMic((uint8_t*)(Staging.Samples + StagingFill), Want * sizeof(int16_t), 0) / sizeof(int16_t);
+      if (Got == 0) break;
+
+      if (StagingFill == 0) {
+        // The buffer that just completed ends at the event; a sample waited
+        // in it for the rest of the buffer (and any read behind it)
+        size_t Age = max(BufLen, Drained + Got) - Drained;
+        Staging.Info.Seq = NextSeq;
+        Staging.Info.Flags = GapPending ? AUDIO_FRAME_FLAG_GAP : 0;
+        GapPending = false;
+        Staging.Info.TimestampUs = Now - (int64_t)Age * 1000000 / Rate;
+      }
+
+      Drained += Got;
+      StagingFill += Got;
+      if (StagingFill == AUDIO_FRAME_SAMPLES) {
+        PublishFrame();
+        StagingFill = 0;
+      }
+    }
+  }
+}
+
+bool AudioCaptureStart() {
+  if (CaptureTask != NULL) return true;
+
+  if (I2SGetMicEventQueue() == NULL) {
+    Serial.println("[Capture] Mic not initialized");
+    return false;
+  }
+
+  // Rings survive a stop (DMA profile switch) with their queued frames
+  if ((ConsumerRings[CAPTURE_CONSUMER_WAKE].size() == 0 &&
+       !ConsumerRings[CAPTURE_CONSUMER_WAKE].init(UNIT_SAMPLES * AUDIO_CAPTURE_WAKE_FRAMES)) ||
+      (ConsumerRings[CAPTURE_CONSUMER_UPLINK].size() == 0 &&
+       !ConsumerRings[CAPTURE_CONSUMER_UPLINK].init(UNIT_SAMPLES * AUDIO_CAPTURE_UPLINK_FRAMES))) {
+    Serial.println("[Capture] Ring allocation failed");
+    return false;
+  }
+
+  // A partial frame is dropped, and so is whatever the mic heard while the
+  // task was down; the next frame says so. Seq keeps counting across
+  // restarts: the pre-roll uses it to skip frames it already holds.
+  GapPending = NextSeq > 0;
+  StagingFill = 0;
+
+  BaseType_t Created = xTaskCreatePinnedToCore(CaptureTaskMain, "AudioCapture", AUDIO_CAPTURE_STACK,
+                                               NULL, AUDIO_CAPTURE_PRIORITY, &CaptureTask, AUDIO_CAPTURE_CORE);
+  if (Created != pdPASS) {
+    CaptureTask = NULL;
+    Serial.println("[Capture] Task creation failed");
+    return false;
+  }
+
+  Serial.printf("[Capture] Task started on core %d (%d samples/frame)\n", AUDIO_CAPTURE_CORE, AUDIO_FRAME_SAMPLES);
+  return true;
+}
+
+void AudioCaptureStop() {
+  if (CaptureTask == NULL) return;
+  vTaskDelete(CaptureTask);
+  CaptureTask = NULL;
+  Serial.println("[Capture] Task stopped");
+}
+
+bool AudioCaptureIsRunning() {
+  return CaptureTask != NULL;
+}
+
+void AudioCaptureEnable(CaptureConsumer_t Consumer, bool Enable) {
+  if (Consumer >= CAPTURE_CONSUMER_COUNT) return;
+  if (Enable && !ConsumerEnabled[Consumer]) {
+    ConsumerRings[Consumer].clear();
+  }
+  ConsumerEnabled[Consumer] = Enable;
+}
+
+bool AudioCaptureIsEnabled(CaptureConsumer_t Consumer) {
+  if (Consumer >= CAPTURE_CONSUMER_COUNT) return false;
+  return ConsumerEnabled[Consumer];
+}
+
+size_t AudioCaptureRead(CaptureConsumer_t Consumer, int16_t* Frame, AudioFrameInfo_t* Info) {
+  if (Consumer >= CAPTURE_CONSUMER_COUNT || !Frame) return 0;
+
+  AudioRingBuffer& Ring = ConsumerRings[Consumer];
+  if (Ring.available() < UNIT_SAMPLES) return 0;
+
+  AudioFrameInfo_t Header;
+  Ring.read((int16_t*)&Header, HEADER_SAMPLES);
+  Ring.read(Frame, AUDIO_FRAME_SAMPLES);
+  if (Info) *Info = Header;
+  return AUDIO_FRAME_SAMPLES;
+}
+
+size_t AudioCaptureFramesAvailable(CaptureConsumer_t Consumer) {
+  if (Consumer >= CAPTURE_CONSUMER_COUNT) return 0;
+  return ConsumerRings[Consumer].available() / UNIT_SAMPLES;
+}
+
+void AudioCaptureFlush(CaptureConsumer_t Consumer) {
+  if (Consumer >= CAPTURE_CONSUMER_COUNT) return;
+  ConsumerRings[Consumer].clear();
+}
+
+uint32_t AudioCaptureGetDropped(CaptureConsumer_t Consumer) {
+  if (Consumer >= CAPTURE_CONSUMER_COUNT) return 0;
+  return ConsumerDropped[Consumer];
+}
+
+uint32_t AudioCaptureGetDmaOverflows() {
+  return DmaOverflows;
+}
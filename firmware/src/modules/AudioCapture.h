@@ -0,0 +1,63 @@
+#pragma once
+#include <Arduino.h>
+#include "hal/h/I2S.h"
+
+// --- Audio Capture ---
+// FreeRTOS task that blocks on the mic's I2S event queue and drains every
+// DMA buffer into per-consumer lock-free rings, so capture keeps running no
+// matter what loop() is doing. Audio is delivered in fixed 20 ms frames.
+
+#define AUDIO_FRAME_MS 20
+#define AUDIO_FRAME_SAMPLES (I2S_SAMPLE_RATE_MIC * AUDIO_FRAME_MS / 1000)
+
+// Task placement (Arduino loop() runs on core 1 at priority 1)
+#define AUDIO_CAPTURE_CORE 1
+#define AUDIO_CAPTURE_PRIORITY 5
+#define AUDIO_CAPTURE_STACK 4096
+
+// Frames each consumer may fall behind before frames are dropped
+#define AUDIO_CAPTURE_WAKE_FRAMES 8
+#define AUDIO_CAPTURE_UPLINK_FRAMES 16
+
+typedef enum {
+  CAPTURE_CONSUMER_WAKE,    // Wake detection (clock mode)
+  CAPTURE_CONSUMER_UPLINK,  // Realtime voice streaming
+  CAPTURE_CONSUMER_COUNT
+} CaptureConsumer_t;
+
+// Audio just before this frame was lost (the task restarted for a DMA
+// profile switch), so it does not follow on from the previous one
+#define AUDIO_FRAME_FLAG_GAP 0x01
+
+typedef struct {
+  uint32_t Seq;         // Frame number since boot
+  uint32_t Flags;       // AUDIO_FRAME_FLAG_*
+  int64_t TimestampUs;  // esp_timer time of the first sample (estimated)
+} AudioFrameInfo_t;
+
+// Start/stop the capture task (mic I2S must already be initialized). The
+// consumer rings and their enables survive a stop.
+bool AudioCaptureStart();
+void AudioCaptureStop();
+bool AudioCaptureIsRunning();
+
+// Enable a consumer; enabling drops anything it had queued.
+// Call from the consuming task.
+void AudioCaptureEnable(CaptureConsumer_t Consumer, bool Enable);
+bool AudioCaptureIsEnabled(CaptureConsumer_t Consumer);
+
+// Pop one frame (AUDIO_FRAME_SAMPLES samples) for a consumer.
+// Returns the number of samples copied, 0 if no full frame is ready.
+size_t AudioCaptureRead(CaptureConsumer_t Consumer, int16_t* Frame, AudioFrameInfo_t* Info);
+
+// Frames waiting for a consumer
+size_t AudioCaptureFramesAvailable(CaptureConsumer_t Consumer);
+
+// Drop all queued frames for a consumer (call from the consuming task)
+void AudioCaptureFlush(CaptureConsumer_t Consumer);
+
+// Frames dropped because a consumer ring was full
+uint32_t AudioCaptureGetDropped(CaptureConsumer_t Consumer);
+
+// DMA buffers lost inside the I2S driver (RX queue overflow)
+uint32_t AudioCaptureGetDmaOverflows();
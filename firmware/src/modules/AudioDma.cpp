@@ -0,0 +1,133 @@
+#include "AudioDma.h"
+#include "AudioCapture.h"
+#include "AudioPlayback.h"
+#include "config.h"
+
+typedef struct {
+  uint32_t CaptureFrames;
+  uint64_t CaptureSumUs;
+  uint32_t CaptureMaxUs;
+  uint32_t AirProbes;
+  uint64_t AirSumUs;
+  uint32_t AirMaxUs;
+  uint32_t Overflows;
+  uint32_t Underflows;
+  uint32_t ActiveMs;
+} DmaAccum_t;
+
+static I2SDmaProfile_t ClockProfile = QUIL_DMA_PROFILE_CLOCK;
+static I2SDmaProfile_t ConversationProfile = QUIL_DMA_PROFILE_CONVERSATION;
+
+// Written from loop(), the capture task and the playback task
+static portMUX_TYPE StatsLock = portMUX_INITIALIZER_UNLOCKED;
+static DmaAccum_t Accum[I2S_DMA_PROFILE_COUNT];
+static unsigned long EnteredMs = 0;
+
+static void AddActiveTime() {
+  unsigned long Now = millis();
+  Accum[I2SGetDmaProfile()].ActiveMs += Now - EnteredMs;
+  EnteredMs = Now;
+}
+
+void AudioDmaInit() {
+  I2SSetDmaProfile(ClockProfile);
+  EnteredMs = millis();
+}
+
+void AudioDmaEnterConversation(bool Conversation) {
+  I2SDmaProfile_t Profile = Conversation ? ConversationProfile : ClockProfile;
+  if (Profile == I2SGetDmaProfile()) return;
+
+  // Both tasks outrank loop() on its core, so they are parked on their
+  // event queues here and can be deleted safely
+  bool Capturing = AudioCaptureIsRunning();
+  bool Playing = AudioPlaybackIsRunning();
+  AudioCaptureStop();
+  AudioPlaybackStop();
+
+  AddActiveTime();
+  I2SDmaProfile_t Previous = I2SGetDmaProfile();
+  if (!I2SSetDmaProfile(Profile)) {
+    Serial.printf("[AudioDma] Switch to %s failed, back to %s\n",
+      I2SGetDmaConfig(Profile)->Name, I2SGetDmaConfig(Previous)->Name);
+    I2SSetDmaProfile(Previous);
+  }
+
+  if (Capturing) AudioCaptureStart();
+  if (Playing) AudioPlaybackStart();
+  Serial.printf("[AudioDma] %s profile (%u x %u samples)\n",
+    I2SGetDmaConfig(I2SGetDmaProfile())->Name, I2SGetDmaBufCount(), I2SGetDmaBufLen());
+}
+
+void AudioDmaSetProfiles(I2SDmaProfile_t Clock, I2SDmaProfile_t Conversation) {
+  if (Clock < I2S_DMA_PROFILE_COUNT) ClockProfile = Clock;
+  if (Conversation < I2S_DMA_PROFILE_COUNT) ConversationProfile = Conversation;
+  Serial.printf("[AudioDma] Clock %s, conversation %s\n",
+    I2SGetDmaConfig(ClockProfile)->Name, I2SGetDmaConfig(ConversationProfile)->Name);
+}
+
+void AudioDmaGetProfiles(I2SDmaProfile_t* Clock, I2SDmaProfile_t* Conversation) {
+  if (Clock) *Clock = ClockProfile;
+  if (Conversation) *Conversation = ConversationProfile;
+}
+
+void AudioDmaRecordCaptureToSend(uint32_t Us) {
+  portENTER_CRITICAL(&StatsLock);
+  DmaAccum_t& A = Accum[I2SGetDmaProfile()];
+  A.CaptureFrames++;
+  A.CaptureSumUs += Us;
+  if (Us > A.CaptureMaxUs) A.CaptureMaxUs = Us;
+  portEXIT_CRITICAL(&StatsLock);
+}
+
+void AudioDmaRecordReceiveToAir(uint32_t Us) {
+  portENTER_CRITICAL(&StatsLock);
+  DmaAccum_t& A = Accum[I2SGetDmaProfile()];
+  A.AirProbes++;
+  A.AirSumUs += Us;
+  if (Us > A.AirMaxUs) A.AirMaxUs = Us;
+  portEXIT_CRITICAL(&StatsLock);
+}
+
+void AudioDmaNoteOverflow() {
+  portENTER_CRITICAL(&StatsLock);
+  Accum[I2SGetDmaProfile()].Overflows++;
+  portEXIT_CRITICAL(&StatsLock);
+}
+
+void AudioDmaNoteUnderflow() {
+  portENTER_CRITICAL(&StatsLock);
+  Accum[I2SGetDmaProfile()].Underflows++;
+  portEXIT_CRITICAL(&StatsLock);
+}
+
+void AudioDmaGetStats(I2SDmaProfile_t Profile, AudioDmaStats_t* Stats) {
+  if (!Stats || Profile >= I2S_DMA_PROFILE_COUNT) return;
+
+  portENTER_CRITICAL(&StatsLock);
+  DmaAccum_t A = Accum[Profile];
+  portEXIT_CRITICAL(&StatsLock);
+  if (Profile == I2SGetDmaProfile()) A.ActiveMs += millis() - EnteredMs;
+
+  Stats->CaptureFrames = A.CaptureFrames;
+  Stats->CaptureAvgUs = A.CaptureFrames ? (uint32_t)(A.CaptureSumUs / A.CaptureFrames) : 0;
+  Stats->CaptureMaxUs = A.CaptureMaxUs;
+  Stats->AirProbes = A.AirProbes;
+  Stats->AirAvgUs = A.AirProbes ? (uint32_t)(A.AirSumUs / A.AirProbes) : 0;
+  Stats->AirMaxUs = A.AirMaxUs;
+  Stats->Overflows = A.Overflows;
+  Stats->Underflows = A.Underflows;
+  Stats->ActiveMs = A.ActiveMs;
+}
+
+void AudioDmaPrintStats() {
+  for (int P = 0; P < I2S_DMA_PROFILE_COUNT; P++) {
+    AudioDmaStats_t Stats;
+    AudioDmaGetStats((I2SDmaProfile_t)P, &Stats);
+    if (Stats.ActiveMs == 0) continue;
+    Serial.printf("[AudioDma] %-11s %lus capture->send avg/max=%u/%uus (%u) rx->air avg/max=%u/%uus (%u) overflows=%u underflows=%u\n",
+      I2SGetDmaConfig((I2SDmaProfile_t)P)->Name, (unsigned long)(Stats.ActiveMs / 1000),
+      Stats.CaptureAvgUs, Stats.CaptureMaxUs, Stats.CaptureFrames,
+      Stats.AirAvgUs, Stats.AirMaxUs, Stats.AirProbes, Stats.Overflows, Stats.Underflows);
+  }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+#include "hal/h/I2S.h"
+
+// --- Audio DMA Profiles ---
+// Picks the I2S DMA profile per mode: the clock face only runs wake
+// detection and can afford long buffers and few interrupts, a conversation
+// wants short ones. Switching stops the capture and playback tasks,
+// reinstalls both drivers and starts the tasks again (a few ms of audio are
+// lost), so it happens from loop() at the mode change. Latency and DMA
+// faults are kept per profile to show what each one costs.
+
+typedef struct {
+  uint32_t CaptureFrames;   // Mic frames sent
+  uint32_t CaptureAvgUs;    // First sample in the DMA to WebSocket send
+  uint32_t CaptureMaxUs;
+  uint32_t AirProbes;       // Downlink chunks measured
+  uint32_t AirAvgUs;        // Chunk received to its first sample at the DAC
+  uint32_t AirMaxUs;
+  uint32_t Overflows;       // Mic DMA buffers lost (RX queue overflow)
+  uint32_t Underflows;      // Speaker DMA ran dry mid-response
+  uint32_t ActiveMs;        // Time spent in the profile
+} AudioDmaStats_t;
+
+// Install the clock profile before the I2S drivers come up
+void AudioDmaInit();
+
+// Switch to the conversation or the clock profile (loop() only)
+void AudioDmaEnterConversation(bool Conversation);
+
+// Profiles for each mode; takes effect at the next mode change
+void AudioDmaSetProfiles(I2SDmaProfile_t Clock, I2SDmaProfile_t Conversation);
+void AudioDmaGetProfiles(I2SDmaProfile_t* Clock, I2SDmaProfile_t* Conversation);
+
+// Measurements, attributed to the profile running now (any task)
+void AudioDmaRecordCaptureToSend(uint32_t Us);
+void AudioDmaRecordReceiveToAir(uint32_t Us);
+void AudioDmaNoteOverflow();
+void AudioDmaNoteUnderflow();
+
+// Statistics since boot
+void AudioDmaGetStats(I2SDmaProfile_t Profile, AudioDmaStats_t* Stats);
+void AudioDmaPrintStats();
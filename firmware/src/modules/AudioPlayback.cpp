@@ -0,0 +1,457 @@
+#include "AudioPlayback.h"
+#include "AudioRingBuffer.h"
+#include "LatencyTrace.h"
+#include "AudioDma.h"
+#include "hal/h/I2S.h"
+#include "dsp/h/Jitter.h"
+#include "dsp/h/Plc.h"
+#include <driver/i2s.h>
+#include <esp_timer.h>
+
+typedef enum {
+  PLAYBACK_IDLE,     // Nothing to play, DMA auto-clears to silence
+  PLAYBACK_PLAYING,  // Feeding DMA from the ring
+  PLAYBACK_STARVED   // Ring ran dry; conceal if the DMA drains before more arrives
+} PlaybackState_t;
+
+static AudioRingBuffer PlaybackRing;
+static TaskHandle_t PlaybackTask = NULL;
+static volatile PlaybackState_t State = PLAYBACK_IDLE;
+// Clear: the producer marks its write position, the task drops everything
+// before the mark, so audio queued after the clear is kept
+static volatile bool ClearRequested = false;
+static volatile uint32_t ClearMark = 0;
+static volatile bool ResetRequested = false;
+static unsigned long StarvedSince = 0;
+
+// Position inside the current DMA buffer, so starvation can pad it out,
+// and an estimate of the samples still queued in the DMA. The layout comes
+// from the DMA profile the task was started with.
+static size_t DmaBufLen = 0;
+static uint32_t DmaQueueSamples = 0;
+static size_t DmaFill = 0;
+static int32_t DmaQueued = 0;
+static const int16_t Silence[256] = {0};
+
+// Jitter buffer: the producer measures arrivals and publishes the target
+// depth; the task conceals gaps once the DMA is about to run out
+static Jitter_t Jitter;
+static volatile uint32_t TargetSamples = 0;
+static volatile uint32_t LastArrivalMs = 0;
+static uint32_t SeenUnderruns = 0;
+static Plc_t Plc;
+static bool GapOpen = false;
+static int16_t ConcealBuffer[I2S_DMA_BUF_LEN_MAX];
+static int16_t FadeBuffer[PLC_RESUME_SAMPLES];
+
+// Echo reference: everything written to the DMA, indexed by a running
+// sample count, plus an anchor tying one index to the time it reached the
+// DAC. The anchor is taken whenever the DMA queue is full, so the sample at
+// the DAC is exactly one queue length behind the last one written.
+static int16_t* ReferenceHistory = NULL;
+static volatile uint32_t WrittenTotal = 0;
+static portMUX_TYPE AnchorLock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t AnchorIndex = 0;
+static int64_t AnchorUs = 0;
+static bool AnchorValid = false;
+
+// Receive-to-air probe: one chunk at a time is followed from its arrival to
+// the DAC; Ahead counts the ring samples still in front of its first sample
+static portMUX_TYPE ProbeLock = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool ProbeArmed = false;
+static uint32_t ProbeAhead = 0;
+static int64_t ProbeUs = 0;
+
+// Task-owned statistics
+static volatile uint32_t Underruns = 0;
+static volatile uint32_t SilenceSamples = 0;
+static volatile uint32_t ConcealedSamples = 0;
+static volatile uint32_t PlayedSamples = 0;
+static volatile uint32_t FillMin = 0;
+static volatile uint32_t FillMax = 0;
+static uint64_t FillSum = 0;
+static volatile uint32_t FillCount = 0;
+// Producer-owned
+static volatile uint32_t Overruns = 0;
+
+static void ResetTaskStats() {
+  Underruns = 0;
+  SilenceSamples = 0;
+  ConcealedSamples = 0;
+  PlayedSamples = 0;
+  FillMin = UINT32_MAX;
+  FillMax = 0;
+  FillSum = 0;
+  FillCount = 0;
+}
+
+// Hand samples to the DMA without blocking; returns samples accepted
+static size_t WriteDma(const int16_t* Samples, size_t Count) {
+  size_t Written = I2SWriteSpeaker((const uint8_t*)Samples, Count * sizeof(int16_t), 0) / sizeof(int16_t);
+  DmaFill = (DmaFill + Written) % DmaBufLen;
+  DmaQueued += Written;
+
+  if (ReferenceHistory) {
+    size_t Pos = WrittenTotal % AUDIO_PLAYBACK_REFERENCE_SAMPLES;
+    size_t First = min(Written, AUDIO_PLAYBACK_REFERENCE_SAMPLES - Pos);
+    memcpy(ReferenceHistory + Pos, Samples, First * sizeof(int16_t));
+    memcpy(ReferenceHistory, Samples + First, (Written - First) * sizeof(int16_t));
+  }
+  WrittenTotal += Written;
+  return Written;
+}
+
+static void SetAnchor(bool Valid, int64_t NowUs) {
+  portENTER_CRITICAL(&AnchorLock);
+  AnchorValid = Valid;
+  AnchorIndex = WrittenTotal - DmaQueueSamples;
+  AnchorUs = NowUs;
+  portEXIT_CRITICAL(&AnchorLock);
+}
+
+// Complete a partially written DMA buffer with zeros so it never goes out
+// holding stale samples
+static void PadDmaBuffer() {
+  while (DmaFill != 0) {
+    size_t Count = min(DmaBufLen - DmaFill, sizeof(Silence) / sizeof(Silence[0]));
+    size_t Written = WriteDma(Silence, Count);
+    SilenceSamples += Written;
+    if (Written < Count) break;
+  }
+}
+
+// Written ring samples went to the DMA behind QueuedBefore others; if the
+// probed chunk starts among them, record when it reaches the DAC
+static void TrackProbe(size_t Written, int32_t QueuedBefore, int64_t EventUs) {
+  if (!ProbeArmed) return;
+
+  portENTER_CRITICAL(&ProbeLock);
+  bool Hit = ProbeArmed && ProbeAhead < Written;
+  uint32_t Offset = ProbeAhead;
+  int64_t ArrivedUs = ProbeUs;
+  if (Hit) {
+    ProbeArmed = false;
+  } else if (ProbeArmed) {
+    ProbeAhead -= Written;
+  }
+  portEXIT_CRITICAL(&ProbeLock);
+
+  if (Hit) {
+    int64_t AirUs = EventUs + (int64_t)(QueuedBefore + Offset) * 1000000 / I2SGetSpeakerRate();
+    if (AirUs > ArrivedUs) AudioDmaRecordReceiveToAir((uint32_t)(AirUs - ArrivedUs));
+  }
+}
+
+static void DropProbe() {
+  portENTER_CRITICAL(&ProbeLock);
+  ProbeArmed = false;
+  portEXIT_CRITICAL(&ProbeLock);
+}
+
+// Move as much of the ring as the DMA queue will take. A dry ring leaves
+// the partial DMA buffer open so a late chunk can still continue it.
+static void TopUpDma(int64_t EventUs) {
+  for (;;) {
+    size_t Contiguous = 0;
+    const int16_t* Samples = PlaybackRing.peek(&Contiguous);
+    if (Contiguous == 0) {
+      State = PLAYBACK_STARVED;
+      StarvedSince = millis();
+      return;
+    }
+
+    // Fade real audio back in after concealment, from a copy
+    if (Plc.Resume || Plc.FadeIn > 0) {
+      Contiguous = min(Contiguous, (size_t)PLC_RESUME_SAMPLES);
+      memcpy(FadeBuffer, Samples, Contiguous * sizeof(int16_t));
+      PlcResume(&Plc, FadeBuffer, Contiguous);
+      Samples = FadeBuffer;
+    }
+
+    int32_t QueuedBefore = DmaQueued;
+    size_t Written = WriteDma(Samples, Contiguous);
+    if (Written > 0) LatencyTraceMark(LAT_FIRST_SPEAKER);
+    TrackProbe(Written, QueuedBefore, EventUs);
+    PlcRemember(&Plc, Samples, Written);
+    PlaybackRing.consume(Written);
+    PlayedSamples += Written;
+    if (Written < Contiguous) {
+      DmaQueued = DmaQueueSamples;
+      SetAnchor(true, EventUs);  // DMA queue is full
+      return;
+    }
+  }
+}
+
+// Starved: once the DMA is down to its last full buffer, fill the open
+// one with concealment, or with silence when the response has ended
+static void ConcealIfDry(bool Quiet) {
+  if (DmaQueued - (int32_t)DmaFill > (int32_t)DmaBufLen) return;
+
+  if (Quiet) {
+    PadDmaBuffer();
+    return;
+  }
+
+  if (!GapOpen) {
+    GapOpen = true;
+    Underruns++;
+    AudioDmaNoteUnderflow();
+  }
+
+  size_t Want = DmaBufLen - DmaFill;
+  size_t Made = PlcConceal(&Plc, ConcealBuffer, Want);
+  ConcealedSamples += WriteDma(ConcealBuffer, Made);
+  if (Made < Want) PadDmaBuffer();
+}
+
+static void RecordFill(uint32_t Fill) {
+  if (Fill < FillMin) FillMin = Fill;
+  if (Fill > FillMax) FillMax = Fill;
+  FillSum += Fill;
+  FillCount++;
+}
+
+static void PlaybackTaskMain(void* Arg) {
+  QueueHandle_t Events = I2SGetSpeakerEventQueue();
+
+  for (;;) {
+    i2s_event_t Event;
+    if (xQueueReceive(Events, &Event, portMAX_DELAY) != pdTRUE) continue;
+    if (Event.type != I2S_EVENT_TX_DONE) continue;
+    int64_t EventUs = esp_timer_get_time();
+    DmaQueued = max(DmaQueued - (int32_t)DmaBufLen, (int32_t)0);
+
+    if (ResetRequested) {
+      ResetTaskStats();
+      ResetRequested = false;
+    }
+
+    if (ClearRequested) {
+      ClearRequested = false;
+      PlaybackRing.discardTo(ClearMark);
+      DropProbe();
+      PadDmaBuffer();
+      PlcInit(&Plc);
+      GapOpen = false;
+      State = PLAYBACK_IDLE;
+      SetAnchor(false, EventUs);
+    }
+
+    size_t Buffered = PlaybackRing.available();
+    bool Quiet = millis() - LastArrivalMs >= AUDIO_PLAYBACK_FLUSH_MS;
+    bool Ready = Buffered > 0 && (Buffered >= TargetSamples || Quiet);
+
+    if (State == PLAYBACK_STARVED) {
+      // Before the DMA ran dry any new audio continues seamlessly; after a
+      // real gap, rebuild the target depth first
+      if (Buffered > 0 && (!GapOpen || Ready)) {
+        GapOpen = false;
+        State = PLAYBACK_PLAYING;
+      } else if (millis() - StarvedSince > AUDIO_PLAYBACK_STARVE_MS) {
+        PadDmaBuffer();
+        GapOpen = false;
+        State = PLAYBACK_IDLE;
+        SetAnchor(false, EventUs);
+        LatencyTraceMark(LAT_DRAIN);
+      } else {
+        ConcealIfDry(Quiet);
+      }
+    } else if (State == PLAYBACK_IDLE && Ready) {
+      State = PLAYBACK_PLAYING;
+    }
+
+    if (State == PLAYBACK_PLAYING) {
+      RecordFill(Buffered);
+      TopUpDma(EventUs);
+    }
+  }
+}
+
+bool AudioPlaybackStart() {
+  if (PlaybackTask != NULL) return true;
+
+  if (I2SGetSpeakerEventQueue() == NULL) {
+    Serial.println("[Playback] Speaker not initialized");
+    return false;
+  }
+
+  // The ring and the echo history survive a stop (DMA profile switch)
+  if (PlaybackRing.size() == 0 && !PlaybackRing.init(AUDIO_PLAYBACK_BUFFER_SAMPLES)) {
+    Serial.println("[Playback] Ring allocation failed");
+    return false;
+  }
+
+  if (!ReferenceHistory) {
+    if (psramFound()) {
+      ReferenceHistory = (int16_t*)ps_calloc(AUDIO_PLAYBACK_REFERENCE_SAMPLES, sizeof(int16_t));
+    } else {
+      ReferenceHistory = (int16_t*)calloc(AUDIO_PLAYBACK_REFERENCE_SAMPLES, sizeof(int16_t));
+    }
+    if (ReferenceHistory) {
+      Serial.printf("[Playback] Echo reference: %u bytes%s\n", (unsigned)(AUDIO_PLAYBACK_REFERENCE_SAMPLES * sizeof(int16_t)),
+        psramFound() ? " of PSRAM" : "");
+    } else {
+      Serial.println("[Playback] No memory for echo reference, AEC disabled");
+    }
+  }
+
+  // Freshly installed driver: nothing queued in the DMA yet
+  DmaBufLen = I2SGetDmaBufLen();
+  DmaQueueSamples = (uint32_t)I2SGetDmaBufCount() * DmaBufLen;
+  DmaFill = 0;
+  DmaQueued = 0;
+  GapOpen = false;
+  SetAnchor(false, 0);
+  DropProbe();
+
+  ResetTaskStats();
+  Overruns = 0;
+  State = PLAYBACK_IDLE;
+  PlcInit(&Plc);
+  JitterInit(&Jitter, AUDIO_PLAYBACK_PREBUFFER_MS * 1000, AUDIO_PLAYBACK_MAX_TARGET_MS * 1000);
+  TargetSamples = (uint64_t)JitterTargetUs(&Jitter) * I2SGetSpeakerRate() / 1000000;
+
+  BaseType_t Created = xTaskCreatePinnedToCore(PlaybackTaskMain, "AudioPlayback", AUDIO_PLAYBACK_STACK,
+                                               NULL, AUDIO_PLAYBACK_PRIORITY, &PlaybackTask, AUDIO_PLAYBACK_CORE);
+  if (Created != pdPASS) {
+    PlaybackTask = NULL;
+    Serial.println("[Playback] Task creation failed");
+    return false;
+  }
+
+  Serial.printf("[Playback] Task started on core %d\n", AUDIO_PLAYBACK_CORE);
+  return true;
+}
+
+void AudioPlaybackStop() {
+  if (PlaybackTask == NULL) return;
+  vTaskDelete(PlaybackTask);
+  PlaybackTask = NULL;
+  Serial.println("[Playback] Task stopped");
+}
+
+bool AudioPlaybackIsRunning() {
+  return PlaybackTask != NULL;
+}
+
+bool AudioPlaybackWrite(const int16_t* Samples, size_t Count) {
+  if (!PlaybackRing.write(Samples, Count)) {
+    Overruns++;
+    return false;
+  }
+  return true;
+}
+
+int16_t* AudioPlaybackReserve(size_t Count, size_t* Contiguous) {
+  if (PlaybackRing.space() < Count) {
+    *Contiguous = 0;
+    Overruns++;
+    return NULL;
+  }
+  return PlaybackRing.reserve(Contiguous);
+}
+
+void AudioPlaybackCommit(size_t Count) {
+  PlaybackRing.commit(Count);
+}
+
+void AudioPlaybackNoteArrival(size_t Samples) {
+  uint32_t Rate = I2SGetSpeakerRate();
+  if (Samples == 0 || Rate == 0) return;
+
+  // Every underrun since the last chunk means the target was too shallow
+  uint32_t Seen = Underruns;
+  if (Seen != SeenUnderruns) {
+    if (Seen > SeenUnderruns) JitterOnUnderrun(&Jitter);
+    SeenUnderruns = Seen;
+  }
+
+  int64_t Now = esp_timer_get_time();
+  JitterOnArrival(&Jitter, Now, (uint32_t)((uint64_t)Samples * 1000000 / Rate));
+  TargetSamples = (uint64_t)JitterTargetUs(&Jitter) * Rate / 1000000;
+  LastArrivalMs = millis();
+
+  // Follow this chunk to the DAC unless one is already on its way. The
+  // critical section keeps the playback task from consuming in between.
+  if (!ProbeArmed) {
+    portENTER_CRITICAL(&ProbeLock);
+    size_t Buffered = PlaybackRing.available();
+    if (!ProbeArmed && Buffered >= Samples) {
+      ProbeAhead = Buffered - Samples;
+      ProbeUs = Now;
+      ProbeArmed = true;
+    }
+    portEXIT_CRITICAL(&ProbeLock);
+  }
+}
+
+void AudioPlaybackClear() {
+  ClearMark = PlaybackRing.writeMark();
+  ClearRequested = true;
+}
+
+size_t AudioPlaybackBuffered() {
+  return PlaybackRing.available();
+}
+
+bool AudioPlaybackIsActive() {
+  return State != PLAYBACK_IDLE;
+}
+
+bool AudioPlaybackReferenceIndex(int64_t Us, uint32_t* Index) {
+  portENTER_CRITICAL(&AnchorLock);
+  bool Valid = AnchorValid;
+  uint32_t Anchor = AnchorIndex;
+  int64_t AnchorAt = AnchorUs;
+  portEXIT_CRITICAL(&AnchorLock);
+
+  if (!Valid || !ReferenceHistory) return false;
+  *Index = Anchor + (int32_t)((Us - AnchorAt) * (int64_t)I2SGetSpeakerRate() / 1000000);
+  return true;
+}
+
+bool AudioPlaybackCopyReference(uint32_t Index, int16_t* Out, size_t Count) {
+  int32_t Age = (int32_t)(WrittenTotal - Index);
+  // Must be written already and not yet overwritten (with a block of slack)
+  if (ReferenceHistory && Age >= (int32_t)Count &&
+      Age <= (int32_t)(AUDIO_PLAYBACK_REFERENCE_SAMPLES - I2S_DMA_BUF_LEN_MAX)) {
+    size_t Pos = Index % AUDIO_PLAYBACK_REFERENCE_SAMPLES;
+    size_t First = min(Count, AUDIO_PLAYBACK_REFERENCE_SAMPLES - Pos);
+    memcpy(Out, ReferenceHistory + Pos, First * sizeof(int16_t));
+    memcpy(Out + First, ReferenceHistory, (Count - First) * sizeof(int16_t));
+    return true;
+  }
+
+  memset(Out, 0, Count * sizeof(int16_t));
+  return false;
+}
+
+void AudioPlaybackGetStats(PlaybackStats_t* Stats) {
+  if (!Stats) return;
+  uint32_t Count = FillCount;
+  Stats->Underruns = Underruns;
+  Stats->Overruns = Overruns;
+  Stats->SilenceSamples = SilenceSamples;
+  Stats->ConcealedSamples = ConcealedSamples;
+  Stats->PlayedSamples = PlayedSamples;
+  Stats->FillMin = Count ? FillMin : 0;
+  Stats->FillMax = FillMax;
+  Stats->FillAvg = Count ? (uint32_t)(FillSum / Count) : 0;
+  Stats->JitterMs = Jitter.JitterUs / 1000;
+  Stats->TargetMs = JitterTargetUs(&Jitter) / 1000;
+}
+
+void AudioPlaybackResetStats() {
+  Overruns = 0;
+  ResetRequested = true;
+}
+
+void AudioPlaybackPrintStats() {
+  PlaybackStats_t Stats;
+  AudioPlaybackGetStats(&Stats);
+  Serial.printf("[Playback] played=%u underruns=%u overruns=%u silence=%u concealed=%u fill min/avg/max=%u/%u/%u\n",
+    Stats.PlayedSamples, Stats.Underruns, Stats.Overruns, Stats.SilenceSamples, Stats.ConcealedSamples,
+    Stats.FillMin, Stats.FillAvg, Stats.FillMax);
+  Serial.printf("[Playback] jitter=%ums target=%ums\n", Stats.JitterMs, Stats.TargetMs);
+}
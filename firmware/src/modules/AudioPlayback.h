@@ -0,0 +1,85 @@
+#pragma once
+#include <Arduino.h>
+
+// --- Audio Playback ---
+// FreeRTOS task driven by the speaker's I2S TX_DONE events. Every time the
+// DMA hands back a buffer the task tops the DMA queue up from the playback
+// ring, so UI or network stalls in loop() no longer turn into audible gaps.
+
+// Task placement (same core as capture, just below it)
+#define AUDIO_PLAYBACK_CORE 1
+#define AUDIO_PLAYBACK_PRIORITY 4
+#define AUDIO_PLAYBACK_STACK 4096
+
+#define AUDIO_PLAYBACK_BUFFER_SAMPLES 16384
+// Jitter buffer: playback starts once the adaptive target depth is queued.
+// The target follows measured arrival jitter between the prebuffer
+// watermark and the maximum.
+#define AUDIO_PLAYBACK_PREBUFFER_MS 40
+#define AUDIO_PLAYBACK_MAX_TARGET_MS 400
+// No audio for this long: start a short response below the target, and
+// treat a dry ring as the end of the response rather than a late chunk
+#define AUDIO_PLAYBACK_FLUSH_MS 100
+// A ring that stays dry this long ends the response and playback goes
+// back to idle
+#define AUDIO_PLAYBACK_STARVE_MS 500
+
+// History of samples handed to I2S, used as the echo canceller's far-end
+// reference. Must cover the DMA queue plus capture latency.
+#define AUDIO_PLAYBACK_REFERENCE_SAMPLES 16384
+
+typedef struct {
+  uint32_t Underruns;       // DMA ran dry mid-response
+  uint32_t Overruns;        // Incoming audio dropped, ring full
+  uint32_t SilenceSamples;  // Zero samples inserted to pad DMA buffers
+  uint32_t ConcealedSamples; // Samples synthesised for late audio
+  uint32_t PlayedSamples;   // Samples handed to I2S
+  uint32_t FillMin;         // Ring fill (samples) while playing
+  uint32_t FillMax;
+  uint32_t FillAvg;
+  uint32_t JitterMs;        // Smoothed arrival jitter
+  uint32_t TargetMs;        // Current jitter buffer target
+} PlaybackStats_t;
+
+// Start/stop the playback task (speaker I2S must already be initialized).
+// Queued audio survives a stop; the DMA layout is read at start.
+bool AudioPlaybackStart();
+void AudioPlaybackStop();
+bool AudioPlaybackIsRunning();
+
+// Queue PCM16 samples for playback (single producer).
+// Returns false and counts an overrun if there is not enough room.
+bool AudioPlaybackWrite(const int16_t* Samples, size_t Count);
+
+// Zero-copy producer path: reserve Count samples (returns NULL and counts an
+// overrun if they do not fit), fill up to *Contiguous of them, commit, and
+// reserve again for the rest when the ring wraps
+int16_t* AudioPlaybackReserve(size_t Count, size_t* Contiguous);
+void AudioPlaybackCommit(size_t Count);
+
+// Report a network chunk that produced Samples of audio (after queueing
+// them); drives the adaptive buffer target
+void AudioPlaybackNoteArrival(size_t Samples);
+
+// Drop everything queued so far (producer side). The playback task discards
+// it on its next pass; samples written after this call are kept.
+void AudioPlaybackClear();
+
+// Samples waiting in the ring
+size_t AudioPlaybackBuffered();
+
+// True while a response is being played (including short starvation)
+bool AudioPlaybackIsActive();
+
+// Echo reference. Every sample written to the DMA has a running index;
+// ReferenceIndex gives the one at the DAC at time Us (esp_timer time), to
+// within a DMA buffer, and fails while nothing is playing. CopyReference
+// fetches Count samples from Index on; it returns false and zero-fills Out
+// when they are not written yet or the history no longer covers them.
+bool AudioPlaybackReferenceIndex(int64_t Us, uint32_t* Index);
+bool AudioPlaybackCopyReference(uint32_t Index, int16_t* Out, size_t Count);
+
+// Statistics since the last reset (reset at conversation start)
+void AudioPlaybackGetStats(PlaybackStats_t* Stats);
+void AudioPlaybackResetStats();
+void AudioPlaybackPrintStats();
@@ -0,0 +1,85 @@
+#include "AudioPreRoll.h"
+#include "dsp/h/ImaAdpcm.h"
+#include "config.h"
+
+#define AUDIO_PREROLL_FRAMES (QUIL_PREROLL_MS / AUDIO_FRAME_MS)
+
+static const size_t BLOCK_BYTES = IMA_ADPCM_BLOCK_BYTES(AUDIO_FRAME_SAMPLES);
+
+typedef struct {
+  AudioFrameInfo_t Info;
+  uint8_t Block[BLOCK_BYTES];
+} PreRollSlot_t;
+
+static PreRollSlot_t* Slots = NULL;
+static size_t Capacity = 0;
+static size_t Oldest = 0;
+static size_t Count = 0;
+static bool HaveSeq = false;
+static uint32_t LastSeq = 0;
+static ImaAdpcmState_t Encoder;
+
+bool AudioPreRollInit() {
+  if (Slots) return true;
+  if (AUDIO_PREROLL_FRAMES == 0) return false;
+
+  size_t Bytes = AUDIO_PREROLL_FRAMES * sizeof(PreRollSlot_t);
+  if (psramFound()) {
+    Slots = (PreRollSlot_t*)ps_malloc(Bytes);
+  } else {
+    Slots = (PreRollSlot_t*)malloc(Bytes);
+  }
+  if (!Slots) {
+    Serial.println("[PreRoll] Allocation failed");
+    return false;
+  }
+  Capacity = AUDIO_PREROLL_FRAMES;
+  AudioPreRollClear();
+  Serial.printf("[PreRoll] %u ms in %u bytes%s\n", (unsigned)(Capacity * AUDIO_FRAME_MS), (unsigned)Bytes,
+    psramFound() ? " of PSRAM" : "");
+  return true;
+}
+
+void AudioPreRollPush(const int16_t* Frame, const AudioFrameInfo_t* Info) {
+  if (!Slots) return;
+
+  if (HaveSeq) {
+    int32_t Ahead = (int32_t)(Info->Seq - LastSeq);
+    if (Ahead <= 0) return;  // Already held
+    // Anything before a gap longer than the ring is stale
+    if ((uint32_t)Ahead > Capacity) AudioPreRollClear();
+  }
+  HaveSeq = true;
+  LastSeq = Info->Seq;
+
+  size_t Slot = (Oldest + Count) % Capacity;
+  if (Count == Capacity) {
+    Oldest = (Oldest + 1) % Capacity;
+  } else {
+    Count++;
+  }
+  Slots[Slot].Info = *Info;
+  ImaAdpcmEncode(&Encoder, Frame, AUDIO_FRAME_SAMPLES, Slots[Slot].Block);
+}
+
+size_t AudioPreRollPop(int16_t* Frame, AudioFrameInfo_t* Info) {
+  if (!Slots || Count == 0) return 0;
+
+  PreRollSlot_t& Slot = Slots[Oldest];
+  if (Info) *Info = Slot.Info;
+  size_t Samples = ImaAdpcmDecode(Slot.Block, BLOCK_BYTES, Frame, AUDIO_FRAME_SAMPLES);
+  Oldest = (Oldest + 1) % Capacity;
+  Count--;
+  return Samples;
+}
+
+size_t AudioPreRollFrames() {
+  return Count;
+}
+
+void AudioPreRollClear() {
+  Oldest = 0;
+  Count = 0;
+  HaveSeq = false;
+  ImaAdpcmReset(&Encoder);
+}
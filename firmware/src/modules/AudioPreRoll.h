@@ -0,0 +1,24 @@
+#pragma once
+#include <Arduino.h>
+#include "AudioCapture.h"
+
+// --- Audio Pre-Roll ---
+// Ring of the most recent raw mic frames, kept while waiting for wake and
+// for the server connection so the words spoken meanwhile can be sent
+// afterwards. Frames are stored IMA-ADPCM compressed (4:1) with their
+// capture info; once full, the oldest frame is overwritten. Frames whose
+// Seq is not newer than the last one stored are ignored, so the wake and
+// uplink consumers can both feed it while they overlap.
+// Single task only (the Arduino loop feeds and drains it).
+
+// Allocate the ring; false if disabled (QUIL_PREROLL_MS 0) or out of memory
+bool AudioPreRollInit();
+
+// Store one raw frame (AUDIO_FRAME_SAMPLES samples)
+void AudioPreRollPush(const int16_t* Frame, const AudioFrameInfo_t* Info);
+
+// Pop the oldest frame. Returns the number of samples, 0 if empty.
+size_t AudioPreRollPop(int16_t* Frame, AudioFrameInfo_t* Info);
+
+size_t AudioPreRollFrames();
+void AudioPreRollClear();
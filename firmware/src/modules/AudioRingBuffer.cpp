@@ -0,0 +1,143 @@
+#include "AudioRingBuffer.h"
+
+AudioRingBuffer::AudioRingBuffer() : buffer(NULL), capacity(0), mask(0), head(0), tail(0) {
+}
+
+AudioRingBuffer::~AudioRingBuffer() {
+    if (buffer != NULL) free(buffer);
+}
+
+bool AudioRingBuffer::init(size_t Capacity) {
+    if (buffer != NULL) free(buffer);
+    buffer = NULL;
+
+    size_t Rounded = 1;
+    while (Rounded < Capacity) Rounded <<= 1;
+
+    if (psramFound()) {
+        buffer = (int16_t*)ps_malloc(Rounded * sizeof(int16_t));
+    } else {
+        buffer = (int16_t*)malloc(Rounded * sizeof(int16_t));
+    }
+
+    if (!buffer) {
+        capacity = 0;
+        mask = 0;
+        Serial.println("[AudioRing] Failed to allocate memory");
+        return false;
+    }
+
+    capacity = Rounded;
+    mask = Rounded - 1;
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    Serial.printf("[AudioRing] Allocated %d bytes%s\n", capacity * sizeof(int16_t), psramFound() ? " of PSRAM" : "");
+    return true;
+}
+
+bool AudioRingBuffer::write(const int16_t* data, size_t length) {
+    if (!buffer || !data) return false;
+
+    uint32_t Head = head.load(std::memory_order_relaxed);
+    uint32_t Tail = tail.load(std::memory_order_acquire);
+    if (capacity - (Head - Tail) < length) {
+        return false;
+    }
+
+    // Two-segment copy: up to the end of storage, then wrap to the start
+    size_t Start = Head & mask;
+    size_t First = min(length, capacity - Start);
+    memcpy(buffer + Start, data, First * sizeof(int16_t));
+    if (length > First) {
+        memcpy(buffer, data + First, (length - First) * sizeof(int16_t));
+    }
+
+    head.store(Head + length, std::memory_order_release);
+    return true;
+}
+
+int16_t* AudioRingBuffer::reserve(size_t* contiguous) {
+    if (!buffer) {
+        *contiguous = 0;
+        return NULL;
+    }
+
+    uint32_t Head = head.load(std::memory_order_relaxed);
+    uint32_t Tail = tail.load(std::memory_order_acquire);
+    size_t Free = capacity - (Head - Tail);
+    size_t Start = Head & mask;
+    *contiguous = min(Free, capacity - Start);
+    return buffer + Start;
+}
+
+void AudioRingBuffer::commit(size_t length) {
+    uint32_t Head = head.load(std::memory_order_relaxed);
+    head.store(Head + length, std::memory_order_release);
+}
+
+bool AudioRingBuffer::read(int16_t* data, size_t length) {
+    if (!buffer || !data) return false;
+
+    uint32_t Tail = tail.load(std::memory_order_relaxed);
+    uint32_t Head = head.load(std::memory_order_acquire);
+    if (Head - Tail < length) {
+        return false;
+    }
+
+    size_t Start = Tail & mask;
+    size_t First = min(length, capacity - Start);
+    memcpy(data, buffer + Start, First * sizeof(int16_t));
+    if (length > First) {
+        memcpy(data + First, buffer, (length - First) * sizeof(int16_t));
+    }
+
+    tail.store(Tail + length, std::memory_order_release);
+    return true;
+}
+
+const int16_t* AudioRingBuffer::peek(size_t* contiguous) const {
+    if (!buffer) {
+        *contiguous = 0;
+        return NULL;
+    }
+
+    uint32_t Tail = tail.load(std::memory_order_relaxed);
+    uint32_t Head = head.load(std::memory_order_acquire);
+    size_t Used = Head - Tail;
+    size_t Start = Tail & mask;
+    *contiguous = min(Used, capacity - Start);
+    return buffer + Start;
+}
+
+void AudioRingBuffer::consume(size_t length) {
+    uint32_t Tail = tail.load(std::memory_order_relaxed);
+    tail.store(Tail + length, std::memory_order_release);
+}
+
+size_t AudioRingBuffer::available() const {
+    if (!buffer) return 0;
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+}
+
+size_t AudioRingBuffer::space() const {
+    if (!buffer) return 0;
+    return capacity - available();
+}
+
+void AudioRingBuffer::clear() {
+    if (!buffer) return;
+    tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+uint32_t AudioRingBuffer::writeMark() const {
+    return head.load(std::memory_order_relaxed);
+}
+
+void AudioRingBuffer::discardTo(uint32_t Mark) {
+    uint32_t Tail = tail.load(std::memory_order_relaxed);
+    uint32_t Head = head.load(std::memory_order_acquire);
+    // Only forward, and never past what has been written
+    if (Mark - Tail <= Head - Tail) {
+        tail.store(Mark, std::memory_order_release);
+    }
+}
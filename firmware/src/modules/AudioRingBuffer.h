@@ -0,0 +1,55 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// --- Audio Ring Buffer ---
+// Lock-free single-producer/single-consumer ring of PCM16 samples.
+// One task may write (write / reserve+commit) while another task reads
+// (read / peek+consume) without any lock. Capacity is a power of two so
+// indices wrap with a mask instead of a modulo.
+
+class AudioRingBuffer {
+private:
+    int16_t* buffer;
+    size_t capacity;
+    size_t mask;
+    // Free-running sample counters; head is owned by the producer,
+    // tail by the consumer. available = head - tail.
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+
+public:
+    AudioRingBuffer();
+    ~AudioRingBuffer();
+
+    // Allocate storage; capacity is rounded up to the next power of two.
+    // Not thread-safe, call before producer/consumer start.
+    bool init(size_t Capacity);
+
+    // Producer: copy all samples or none (returns false if not enough space)
+    bool write(const int16_t* data, size_t length);
+    // Producer: zero-copy. Returns pointer to contiguous free space and
+    // stores its length in *contiguous; commit() publishes the samples.
+    int16_t* reserve(size_t* contiguous);
+    void commit(size_t length);
+
+    // Consumer: copy all samples or none (returns false if not enough data)
+    bool read(int16_t* data, size_t length);
+    // Consumer: zero-copy. Returns pointer to contiguous readable samples and
+    // stores their count in *contiguous; consume() releases them.
+    const int16_t* peek(size_t* contiguous) const;
+    void consume(size_t length);
+
+    size_t available() const;
+    size_t space() const;
+
+    // Consumer-side: drop everything currently buffered
+    void clear();
+
+    // Producer-side: position just past the last committed sample
+    uint32_t writeMark() const;
+    // Consumer-side: drop everything written before Mark (a writeMark()
+    // value), keeping what the producer added since
+    void discardTo(uint32_t Mark);
+    size_t size() const { return capacity; }
+};
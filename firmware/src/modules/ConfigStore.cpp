@@ -1,5 +1,6 @@
 #include "ConfigStore.h"
 #include "config.h"
+#include "types.h"
 
 #include <Preferences.h>
 static Preferences prefs;
@@ -9,6 +10,7 @@ static Preferences prefs;
 #define CONFIG_KEY_TIMEZONE "timezone"
 #define CONFIG_KEY_CONTRAST "contrast"
 #define CONFIG_KEY_FIRST_BOOT "first_boot"
+#define CONFIG_KEY_CONN_POLICY "conn_policy"
 
 bool ConfigInit() {
   return prefs.begin(CONFIG_NAMESPACE, false);
@@ -89,6 +91,15 @@ bool ConfigLoadServerUrl(char* url) {
   return true;
 }
 
+bool ConfigSaveConnectionPolicy(uint8_t policy) {
+  return prefs.putUChar(CONFIG_KEY_CONN_POLICY, policy) > 0;
+}
+
+bool ConfigLoadConnectionPolicy(uint8_t* policy) {
+  *policy = prefs.getUChar(CONFIG_KEY_CONN_POLICY, QUIL_CONNECTION_POLICY);
+  return true;
+}
+
 void ConfigClear() {
   prefs.clear();
 }
@@ -15,4 +15,6 @@ bool ConfigLoadTimezone(int* offset_sec);
 bool ConfigSaveContrast(uint8_t level);
 bool ConfigLoadContrast(uint8_t* level);
 bool ConfigLoadServerUrl(char* url);
+bool ConfigSaveConnectionPolicy(uint8_t policy);
+bool ConfigLoadConnectionPolicy(uint8_t* policy);
 void ConfigClear();
@@ -2,6 +2,9 @@
 #include "AnimationManager.h"
 #include "hal/h/Display.h"
 #include "Audio.h"
+#include "AudioPlayback.h"
+#include "AudioDma.h"
+#include "LatencyTrace.h"
 
 static ConversationState_t convState = CONV_STATE_IDLE;
 static bool isMuted = false;
@@ -20,9 +23,12 @@ void ConversationStart() {
   isMuted = false;
   lastActivityTime = millis();
   conversationStartTime = millis();
+  AudioDmaEnterConversation(true);  // Short DMA buffers while talking
+  AudioPlaybackResetStats();
+  RealtimeVoiceResetUplinkStats();
   
-  // Start listening for voice input
-  AudioStartListening();
+  // Start listening for voice input; wake detection resumes after ConversationEnd
+  AudioStartConversationListening();
   
   // Play conversation animation
   AnimPlay(ANIM_CONVERSATION);
@@ -39,6 +45,13 @@ void ConversationEnd() {
   // Stop animation
   AnimStop();
   
+  AudioPlaybackPrintStats();
+  RealtimeVoicePrintUplinkStats();
+  RealtimeVoicePrintConnectionStats();
+  LatencyTraceEnd();
+  AudioDmaPrintStats();
+  AudioDmaEnterConversation(false);
+  
   Serial.println("[Conversation] Ended - returning to clock");
 }
 
@@ -127,7 +140,7 @@ void ConversationToggleMute() {
   if (isMuted) {
     AudioStopListening();
   } else if (convState == CONV_STATE_LISTENING || convState == CONV_STATE_WAITING) {
-    AudioStartListening();
+    AudioStartConversationListening();
   }
 }
 
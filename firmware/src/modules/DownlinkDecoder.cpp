@@ -0,0 +1,147 @@
+#include "DownlinkDecoder.h"
+#include <mp3_decoder/mp3_decoder.h>
+
+// Enough for a couple of 24 kHz MP3 frames plus a partial one
+static const size_t INPUT_BUFFER_SIZE = 4096;
+// One MPEG-1 Layer III frame, stereo
+static const size_t OUTPUT_SAMPLES = 1152 * 2;
+
+static DownlinkCodec_t CurrentCodec = DOWNLINK_CODEC_PCM16;
+static uint8_t* InputBuffer = NULL;
+static int16_t* OutputBuffer = NULL;
+static size_t InputFill = 0;
+static uint32_t SampleRate = 0;
+
+bool DownlinkDecoderBegin(DownlinkCodec_t Codec) {
+  if (Codec == CurrentCodec && (Codec == DOWNLINK_CODEC_PCM16 || InputBuffer)) {
+    DownlinkDecoderReset();
+    return true;
+  }
+
+  DownlinkDecoderEnd();
+  if (Codec == DOWNLINK_CODEC_PCM16) return true;
+
+  if (psramFound()) {
+    InputBuffer = (uint8_t*)ps_malloc(INPUT_BUFFER_SIZE);
+    OutputBuffer = (int16_t*)ps_malloc(OUTPUT_SAMPLES * sizeof(int16_t));
+  } else {
+    InputBuffer = (uint8_t*)malloc(INPUT_BUFFER_SIZE);
+    OutputBuffer = (int16_t*)malloc(OUTPUT_SAMPLES * sizeof(int16_t));
+  }
+  if (!InputBuffer || !OutputBuffer || !MP3Decoder_AllocateBuffers()) {
+    Serial.println("[Downlink] Decoder allocation failed");
+    DownlinkDecoderEnd();
+    return false;
+  }
+
+  CurrentCodec = Codec;
+  DownlinkDecoderReset();
+  Serial.printf("[Downlink] %s decoder ready, free heap: %u\n", DownlinkCodecName(Codec), ESP.getFreeHeap());
+  return true;
+}
+
+void DownlinkDecoderEnd() {
+  if (CurrentCodec == DOWNLINK_CODEC_MP3) {
+    MP3Decoder_FreeBuffers();
+  }
+  free(InputBuffer);
+  free(OutputBuffer);
+  InputBuffer = NULL;
+  OutputBuffer = NULL;
+  InputFill = 0;
+  SampleRate = 0;
+  CurrentCodec = DOWNLINK_CODEC_PCM16;
+}
+
+DownlinkCodec_t DownlinkDecoderGetCodec() {
+  return CurrentCodec;
+}
+
+void DownlinkDecoderReset() {
+  InputFill = 0;
+}
+
+// Decode every complete frame in the input buffer
+static size_t DecodeFrames(DownlinkPcmSink Sink) {
+  size_t Produced = 0;
+  size_t Pos = 0;
+
+  while (Pos < InputFill) {
+    int Sync = MP3FindSyncWord(InputBuffer + Pos, InputFill - Pos);
+    if (Sync < 0) {
+      // Keep a possible partial sync word at the tail (even when it is
+      // the only byte, as with one-byte WebSocket chunks)
+      Pos = InputFill - 1;
+      break;
+    }
+    Pos += Sync;
+
+    int BytesLeft = InputFill - Pos;
+    int Result = MP3Decode(InputBuffer + Pos, &BytesLeft, OutputBuffer, 0);
+
+    if (Result == ERR_MP3_INDATA_UNDERFLOW) {
+      break;  // Frame not complete yet
+    }
+
+    size_t Consumed = (InputFill - Pos) - BytesLeft;
+    if (Result == ERR_MP3_NONE) {
+      int Channels = MP3GetChannels();
+      size_t Samples = MP3GetOutputSamps() / (Channels > 1 ? Channels : 1);
+
+      // Downmix stereo in place
+      if (Channels == 2) {
+        for (size_t I = 0; I < Samples; I++) {
+          OutputBuffer[I] = (int16_t)(((int32_t)OutputBuffer[2 * I] + OutputBuffer[2 * I + 1]) >> 1);
+        }
+      }
+
+      SampleRate = MP3GetSampRate();
+      Sink(OutputBuffer, Samples);
+      Produced += Samples;
+    } else if (Result != ERR_MP3_MAINDATA_UNDERFLOW) {
+      // Corrupt frame: step past this sync word and resynchronise
+      Consumed = 1;
+    }
+    Pos += Consumed > 0 ? Consumed : 1;
+  }
+
+  // Move the undecoded tail to the front
+  if (Pos > 0) {
+    memmove(InputBuffer, InputBuffer + Pos, InputFill - Pos);
+    InputFill -= Pos;
+  }
+  return Produced;
+}
+
+size_t DownlinkDecoderFeed(const uint8_t* Data, size_t Length, DownlinkPcmSink Sink) {
+  if (CurrentCodec == DOWNLINK_CODEC_PCM16 || !InputBuffer) return 0;
+
+  size_t Produced = 0;
+  while (Length > 0) {
+    size_t Count = min(Length, INPUT_BUFFER_SIZE - InputFill);
+    memcpy(InputBuffer + InputFill, Data, Count);
+    InputFill += Count;
+    Data += Count;
+    Length -= Count;
+
+    Produced += DecodeFrames(Sink);
+
+    if (InputFill == INPUT_BUFFER_SIZE) {
+      // No decodable frame in a full buffer: drop it and resync
+      Serial.println("[Downlink] Decoder lost sync");
+      InputFill = 0;
+    }
+  }
+  return Produced;
+}
+
+uint32_t DownlinkDecoderGetSampleRate() {
+  return SampleRate;
+}
+
+const char* DownlinkCodecName(DownlinkCodec_t Codec) {
+  switch (Codec) {
+    case DOWNLINK_CODEC_MP3: return "mp3";
+    default: return "pcm16";
+  }
+}
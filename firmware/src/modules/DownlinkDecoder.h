@@ -0,0 +1,32 @@
+#pragma once
+#include <Arduino.h>
+
+// --- Downlink Decoder ---
+// Incremental decoder for compressed response audio, built on the libhelix
+// MP3 decoder shipped inside ESP32-audioI2S. WebSocket chunks are fed in as
+// they arrive; every complete frame is handed to a PCM sink immediately.
+
+typedef enum {
+  DOWNLINK_CODEC_PCM16,  // Raw PCM16, no decoder needed
+  DOWNLINK_CODEC_MP3
+} DownlinkCodec_t;
+
+// Receives decoded mono PCM16 at DownlinkDecoderGetSampleRate()
+typedef void (*DownlinkPcmSink)(const int16_t* Samples, size_t Count);
+
+// Allocate decoder state for a codec (PCM16 frees everything)
+bool DownlinkDecoderBegin(DownlinkCodec_t Codec);
+void DownlinkDecoderEnd();
+DownlinkCodec_t DownlinkDecoderGetCodec();
+
+// Drop partially received data (e.g. on interrupt)
+void DownlinkDecoderReset();
+
+// Feed compressed bytes; returns the number of PCM samples produced
+size_t DownlinkDecoderFeed(const uint8_t* Data, size_t Length, DownlinkPcmSink Sink);
+
+// Sample rate of the last decoded frame (0 before the first frame)
+uint32_t DownlinkDecoderGetSampleRate();
+
+// Name used in the config/auth negotiation
+const char* DownlinkCodecName(DownlinkCodec_t Codec);
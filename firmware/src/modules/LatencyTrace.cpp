@@ -0,0 +1,182 @@
+#include "LatencyTrace.h"
+#include <esp_timer.h>
+
+typedef struct {
+  LatencyMark_t From;
+  LatencyMark_t To;
+  const char* Name;
+} LatencyStageDef_t;
+
+static const LatencyStageDef_t STAGES[LAT_STAGE_COUNT] = {
+  {LAT_CONNECT_START, LAT_CONNECTED, "connect"},
+  {LAT_WAKE, LAT_FIRST_UPLINK, "uplink"},
+  {LAT_FIRST_UPLINK, LAT_END_OF_SPEECH, "speech"},
+  {LAT_END_OF_SPEECH, LAT_FIRST_DOWNLINK, "server"},
+  {LAT_FIRST_DOWNLINK, LAT_FIRST_SPEAKER, "buffer"},
+  {LAT_END_OF_SPEECH, LAT_FIRST_SPEAKER, "response"},
+  {LAT_FIRST_SPEAKER, LAT_DRAIN, "playback"},
+  {LAT_WAKE, LAT_FIRST_SPEAKER, "total"},
+};
+
+static const char* const MARK_NAMES[LAT_COUNT] = {
+  "wake", "connect_start", "connected", "first_uplink",
+  "end_of_speech", "first_downlink", "first_speaker", "drain"
+};
+
+// Open trace: written from the loop and the playback task
+static portMUX_TYPE TraceLock = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool Open = false;
+static volatile uint16_t Seen = 0;
+static uint32_t MarkUs[LAT_COUNT];
+
+// Kept traces, ms after wake
+static uint32_t History[LATENCY_HISTORY][LAT_COUNT];
+static size_t HistoryNext = 0;
+static size_t HistoryCount = 0;
+static uint32_t Completed = 0;
+static uint32_t Dropped = 0;
+
+// Lock held
+static void KeepTrace() {
+  uint32_t* Entry = History[HistoryNext];
+  for (int K = 0; K < LAT_COUNT; K++) {
+    Entry[K] = (Seen >> K) & 1 ? (MarkUs[K] - MarkUs[LAT_WAKE]) / 1000 : LATENCY_ABSENT;
+  }
+  HistoryNext = (HistoryNext + 1) % LATENCY_HISTORY;
+  if (HistoryCount < LATENCY_HISTORY) HistoryCount++;
+  Completed++;
+  Open = false;
+}
+
+void LatencyTraceBegin() {
+  uint32_t Now = (uint32_t)esp_timer_get_time();
+  portENTER_CRITICAL(&TraceLock);
+  if (Open) Dropped++;
+  Seen = 1 << LAT_WAKE;
+  MarkUs[LAT_WAKE] = Now;
+  Open = true;
+  portEXIT_CRITICAL(&TraceLock);
+}
+
+void LatencyTraceMark(LatencyMark_t Mark) {
+  // Cheap check first: this sits on the audio paths
+  if (!Open || (Seen >> Mark) & 1) return;
+  uint32_t Now = (uint32_t)esp_timer_get_time();
+
+  portENTER_CRITICAL(&TraceLock);
+  if (Open && !((Seen >> Mark) & 1)) {
+    if (Mark != LAT_DRAIN) {
+      MarkUs[Mark] = Now;
+      Seen |= 1 << Mark;
+    } else if ((Seen >> LAT_FIRST_SPEAKER) & 1) {
+      // A drain before any response audio is the tail of something older
+      MarkUs[Mark] = Now;
+      Seen |= 1 << Mark;
+      KeepTrace();
+    }
+  }
+  portEXIT_CRITICAL(&TraceLock);
+}
+
+void LatencyTraceEnd() {
+  portENTER_CRITICAL(&TraceLock);
+  if (Open) {
+    // Interrupted responses never drain but still count from wake to speaker
+    if ((Seen >> LAT_FIRST_SPEAKER) & 1) {
+      KeepTrace();
+    } else {
+      Open = false;
+      Dropped++;
+    }
+  }
+  portEXIT_CRITICAL(&TraceLock);
+  LatencyTracePrint();
+}
+
+const char* LatencyTraceMarkName(LatencyMark_t Mark) {
+  return Mark < LAT_COUNT ? MARK_NAMES[Mark] : "";
+}
+
+const char* LatencyTraceStageName(LatencyStage_t Stage) {
+  return Stage < LAT_STAGE_COUNT ? STAGES[Stage].Name : "";
+}
+
+bool LatencyTraceGetLast(uint32_t OffsetsMs[LAT_COUNT]) {
+  portENTER_CRITICAL(&TraceLock);
+  bool Have = HistoryCount > 0;
+  if (Have) {
+    memcpy(OffsetsMs, History[(HistoryNext + LATENCY_HISTORY - 1) % LATENCY_HISTORY], LAT_COUNT * sizeof(uint32_t));
+  }
+  portEXIT_CRITICAL(&TraceLock);
+  return Have;
+}
+
+// Nearest rank on a sorted array
+static uint32_t Percentile(const uint32_t* Sorted, size_t Count, uint32_t P) {
+  size_t Rank = (Count * P + 99) / 100;
+  return Sorted[Rank > 0 ? Rank - 1 : 0];
+}
+
+void LatencyTraceGetPercentiles(LatencyStage_t Stage, LatencyPercentiles_t* Out) {
+  memset(Out, 0, sizeof(*Out));
+  if (Stage >= LAT_STAGE_COUNT) return;
+  const LatencyStageDef_t& Def = STAGES[Stage];
+
+  uint32_t Values[LATENCY_HISTORY];
+  size_t Count = 0;
+  portENTER_CRITICAL(&TraceLock);
+  for (size_t I = 0; I < HistoryCount; I++) {
+    uint32_t From = History[I][Def.From];
+    uint32_t To = History[I][Def.To];
+    if (From != LATENCY_ABSENT && To != LATENCY_ABSENT && To >= From) Values[Count++] = To - From;
+  }
+  portEXIT_CRITICAL(&TraceLock);
+  if (Count == 0) return;
+
+  for (size_t I = 1; I < Count; I++) {
+    uint32_t Value = Values[I];
+    size_t J = I;
+    for (; J > 0 && Values[J - 1] > Value; J--) Values[J] = Values[J - 1];
+    Values[J] = Value;
+  }
+  Out->Samples = (uint16_t)Count;
+  Out->P50Ms = Percentile(Values, Count, 50);
+  Out->P95Ms = Percentile(Values, Count, 95);
+  Out->P99Ms = Percentile(Values, Count, 99);
+}
+
+uint32_t LatencyTraceCompleted() {
+  return Completed;
+}
+
+uint32_t LatencyTraceDropped() {
+  return Dropped;
+}
+
+void LatencyTracePrint() {
+  uint32_t Last[LAT_COUNT];
+  if (!LatencyTraceGetLast(Last)) {
+    Serial.printf("[Latency] No complete trace yet (%u dropped)\n", Dropped);
+    return;
+  }
+
+  Serial.print("[Latency] Last:");
+  for (int K = 0; K < LAT_COUNT; K++) {
+    if (Last[K] == LATENCY_ABSENT) {
+      Serial.printf(" %s=-", MARK_NAMES[K]);
+    } else {
+      Serial.printf(" %s=%u", MARK_NAMES[K], Last[K]);
+    }
+  }
+  Serial.println(" ms");
+
+  Serial.printf("[Latency] %u traces kept, %u dropped; per stage over the last %u (ms):\n",
+    Completed, Dropped, (unsigned)HistoryCount);
+  for (int S = 0; S < LAT_STAGE_COUNT; S++) {
+    LatencyPercentiles_t P;
+    LatencyTraceGetPercentiles((LatencyStage_t)S, &P);
+    if (P.Samples == 0) continue;
+    Serial.printf("[Latency]   %-8s n=%-3u p50=%-5u p95=%-5u p99=%u\n",
+      STAGES[S].Name, P.Samples, P.P50Ms, P.P95Ms, P.P99Ms);
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <Arduino.h>
+
+// --- Latency Trace ---
+// Timestamps (esp_timer, microseconds) for each milestone between wake and
+// the end of the first response of a conversation. A trace starts at wake
+// and is kept once the response has reached the speaker; the last
+// LATENCY_HISTORY traces feed rolling percentiles per stage. Marks may come
+// from any task (the playback task records the speaker milestones); only
+// the first mark of each kind counts.
+
+#define LATENCY_HISTORY 32
+#define LATENCY_ABSENT UINT32_MAX  // Milestone not reached in this trace
+
+typedef enum {
+  LAT_WAKE,            // Wake detected
+  LAT_CONNECT_START,   // RealtimeVoiceConnect called (absent if already connected)
+  LAT_CONNECTED,       // WebSocket handshake done
+  LAT_FIRST_UPLINK,    // First mic frame sent
+  LAT_END_OF_SPEECH,   // end_of_speech sent or the server committed the turn
+  LAT_FIRST_DOWNLINK,  // First response audio received
+  LAT_FIRST_SPEAKER,   // First response sample handed to I2S
+  LAT_DRAIN,           // Response played out
+  LAT_COUNT
+} LatencyMark_t;
+
+// Intervals the percentiles are kept for
+typedef enum {
+  LAT_STAGE_CONNECT,   // Connect call to handshake done
+  LAT_STAGE_UPLINK,    // Wake to first frame on the wire
+  LAT_STAGE_SPEECH,    // First frame to end of speech (the user talking)
+  LAT_STAGE_SERVER,    // End of speech to first response audio
+  LAT_STAGE_BUFFER,    // First response audio to the speaker
+  LAT_STAGE_RESPONSE,  // End of speech to the speaker: what the user waits
+  LAT_STAGE_PLAYBACK,  // Speaker to drained
+  LAT_STAGE_TOTAL,     // Wake to the speaker
+  LAT_STAGE_COUNT
+} LatencyStage_t;
+
+typedef struct {
+  uint16_t Samples;  // Traces that had both ends of the stage
+  uint32_t P50Ms;
+  uint32_t P95Ms;
+  uint32_t P99Ms;
+} LatencyPercentiles_t;
+
+// Start a new trace at wake; an unfinished previous one is dropped
+void LatencyTraceBegin();
+
+// Record a milestone now (ignored without an open trace or if already set)
+void LatencyTraceMark(LatencyMark_t Mark);
+
+// Conversation over: keep the trace if the response started, then print
+void LatencyTraceEnd();
+
+const char* LatencyTraceMarkName(LatencyMark_t Mark);
+const char* LatencyTraceStageName(LatencyStage_t Stage);
+
+// Milestones of the last kept trace, in ms after wake (LATENCY_ABSENT if
+// missed). False if no trace has been kept yet.
+bool LatencyTraceGetLast(uint32_t OffsetsMs[LAT_COUNT]);
+
+// Rolling percentiles over the kept traces
+void LatencyTraceGetPercentiles(LatencyStage_t Stage, LatencyPercentiles_t* Out);
+
+// Traces kept / dropped (no response) since boot
+uint32_t LatencyTraceCompleted();
+uint32_t LatencyTraceDropped();
+
+// Last trace and the percentile table to serial
+void LatencyTracePrint();
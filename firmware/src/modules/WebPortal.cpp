@@ -2,6 +2,9 @@
 #include "Connectivity.h"
 #include "ConfigStore.h"
 #include "BatteryManager.h"
+#include "Audio.h"
+#include "LatencyTrace.h"
+#include "AudioDma.h"
 #include "hal/h/Display.h"
 #include "modes/h/Time.h"
 #include "config.h"
@@ -35,6 +38,7 @@ static void handleRoot(AsyncWebServerRequest *request);
 static void handleScan(AsyncWebServerRequest *request);
 static void handleConnect(AsyncWebServerRequest *request, uint8_t *data, size_t len);
 static void handleStatus(AsyncWebServerRequest *request);
+static void handleLatency(AsyncWebServerRequest *request);
 static void handleNotFound(AsyncWebServerRequest *request);
 
 bool WebPortalInit() {
@@ -133,6 +137,20 @@ void WebPortalStart() {
           return;
         }
         
+        // Reject out-of-range values before applying anything
+        if (!doc["connPolicy"].isNull() &&
+            (!doc["connPolicy"].is<uint8_t>() || doc["connPolicy"].as<uint8_t>() >= CONN_POLICY_COUNT)) {
+          request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid connPolicy\"}");
+          return;
+        }
+        if ((!doc["dmaClock"].isNull() &&
+             (!doc["dmaClock"].is<uint8_t>() || doc["dmaClock"].as<uint8_t>() >= I2S_DMA_PROFILE_COUNT)) ||
+            (!doc["dmaConversation"].isNull() &&
+             (!doc["dmaConversation"].is<uint8_t>() || doc["dmaConversation"].as<uint8_t>() >= I2S_DMA_PROFILE_COUNT))) {
+          request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid DMA profile\"}");
+          return;
+        }
+        
         // Apply config values
         if (doc["tz"].is<int>()) {
           int tz = doc["tz"];
@@ -153,6 +171,35 @@ void WebPortalStart() {
           Serial.printf("[WebPortal] Theme saved: %d\n", theme);
         }
         
+        if (doc["ns"].is<bool>()) {
+          RealtimeVoiceSetNoiseSuppression(doc["ns"]);
+        }
+        
+        if (doc["micBypass"].is<uint32_t>() || doc["spkBypass"].is<uint32_t>()) {
+          uint32_t micMask = 0, spkMask = 0;
+          RealtimeVoiceGetDspBypass(&micMask, &spkMask);
+          if (doc["micBypass"].is<uint32_t>()) micMask = doc["micBypass"];
+          if (doc["spkBypass"].is<uint32_t>()) spkMask = doc["spkBypass"];
+          RealtimeVoiceSetDspBypass(micMask, spkMask);
+          Serial.printf("[WebPortal] DSP bypass mic=0x%02x speaker=0x%02x\n", micMask, spkMask);
+        }
+        
+        if (doc["dspProfile"].is<bool>()) {
+          RealtimeVoiceSetDspProfiling(doc["dspProfile"]);
+        }
+        
+        if (doc["connPolicy"].is<uint8_t>()) {
+          RealtimeVoiceSetConnectionPolicy((ConnectionPolicy_t)doc["connPolicy"].as<uint8_t>());
+        }
+        
+        if (doc["dmaClock"].is<uint8_t>() || doc["dmaConversation"].is<uint8_t>()) {
+          I2SDmaProfile_t clockProfile, convProfile;
+          AudioDmaGetProfiles(&clockProfile, &convProfile);
+          if (doc["dmaClock"].is<uint8_t>()) clockProfile = (I2SDmaProfile_t)doc["dmaClock"].as<uint8_t>();
+          if (doc["dmaConversation"].is<uint8_t>()) convProfile = (I2SDmaProfile_t)doc["dmaConversation"].as<uint8_t>();
+          AudioDmaSetProfiles(clockProfile, convProfile);
+        }
+        
         if (doc["ssid"].is<const char*>() && doc["password"].is<const char*>()) {
           const char* ssid = doc["ssid"];
           const char* pass = doc["password"];
@@ -178,6 +225,9 @@ void WebPortalStart() {
 
   server.on("/api/status", HTTP_GET, handleStatus);
   server.on("/api/status", HTTP_OPTIONS, [](AsyncWebServerRequest *request){ request->send(200); });
+
+  server.on("/api/latency", HTTP_GET, handleLatency);
+  server.on("/api/latency", HTTP_OPTIONS, [](AsyncWebServerRequest *request){ request->send(200); });
   
   // Captive portal detection endpoints
   server.on("/generate_204", HTTP_GET, handleRoot);        // Android
@@ -349,6 +399,80 @@ static void handleStatus(AsyncWebServerRequest *request) {
   ConfigLoadTheme(&theme);
   doc["theme"] = theme;
   
+  // Mic diagnostics
+  doc["micGainDb"] = RealtimeVoiceGetMicGainDb();
+  doc["micClipPpm"] = RealtimeVoiceGetMicClipPpm();
+  uint32_t micMask = 0, spkMask = 0;
+  RealtimeVoiceGetDspBypass(&micMask, &spkMask);
+  doc["micBypass"] = micMask;
+  doc["spkBypass"] = spkMask;
+  
+  // Server connection: what the policy costs in RAM and idle traffic
+  doc["connPolicy"] = (uint8_t)RealtimeVoiceGetConnectionPolicy();
+  doc["connected"] = RealtimeVoiceIsConnected();
+  doc["connectMs"] = RealtimeVoiceGetConnectMs();
+  doc["sessionHeap"] = RealtimeVoiceGetConnectHeap();
+  doc["heartbeatBytesPerMin"] = RealtimeVoiceGetHeartbeatBytesPerMin();
+  // I2S DMA profile per mode and the one running now
+  I2SDmaProfile_t clockProfile, convProfile;
+  AudioDmaGetProfiles(&clockProfile, &convProfile);
+  doc["dmaClock"] = (uint8_t)clockProfile;
+  doc["dmaConversation"] = (uint8_t)convProfile;
+  doc["dmaActive"] = (uint8_t)I2SGetDmaProfile();
+  
+  doc["freeHeap"] = ESP.getFreeHeap();
+  doc["minFreeHeap"] = ESP.getMinFreeHeap();
+  doc["largestBlock"] = ESP.getMaxAllocHeap();
+  
+  String response;
+  serializeJson(doc, response);
+  request->send(200, "application/json", response);
+}
+
+// Wake-to-speaker breakdown: the last conversation and rolling percentiles
+static void handleLatency(AsyncWebServerRequest *request) {
+  JsonDocument doc;
+  doc["completed"] = LatencyTraceCompleted();
+  doc["dropped"] = LatencyTraceDropped();
+  
+  uint32_t last[LAT_COUNT];
+  if (LatencyTraceGetLast(last)) {
+    JsonObject lastObj = doc["last"].to<JsonObject>();
+    for (int k = 0; k < LAT_COUNT; k++) {
+      if (last[k] != LATENCY_ABSENT) {
+        lastObj[LatencyTraceMarkName((LatencyMark_t)k)] = last[k];
+      }
+    }
+  }
+  
+  JsonObject stages = doc["stages"].to<JsonObject>();
+  for (int s = 0; s < LAT_STAGE_COUNT; s++) {
+    LatencyPercentiles_t p;
+    LatencyTraceGetPercentiles((LatencyStage_t)s, &p);
+    if (p.Samples == 0) continue;
+    JsonObject stage = stages[LatencyTraceStageName((LatencyStage_t)s)].to<JsonObject>();
+    stage["n"] = p.Samples;
+    stage["p50"] = p.P50Ms;
+    stage["p95"] = p.P95Ms;
+    stage["p99"] = p.P99Ms;
+  }
+  
+  // What each DMA profile adds at the two ends of the audio path
+  JsonObject dma = doc["dma"].to<JsonObject>();
+  for (int d = 0; d < I2S_DMA_PROFILE_COUNT; d++) {
+    AudioDmaStats_t stats;
+    AudioDmaGetStats((I2SDmaProfile_t)d, &stats);
+    if (stats.ActiveMs == 0) continue;
+    JsonObject profile = dma[I2SGetDmaConfig((I2SDmaProfile_t)d)->Name].to<JsonObject>();
+    profile["activeS"] = stats.ActiveMs / 1000;
+    profile["captureToSendAvgUs"] = stats.CaptureAvgUs;
+    profile["captureToSendMaxUs"] = stats.CaptureMaxUs;
+    profile["receiveToAirAvgUs"] = stats.AirAvgUs;
+    profile["receiveToAirMaxUs"] = stats.AirMaxUs;
+    profile["overflows"] = stats.Overflows;
+    profile["underflows"] = stats.Underflows;
+  }
+  
   String response;
   serializeJson(doc, response);
   request->send(200, "application/json", response);
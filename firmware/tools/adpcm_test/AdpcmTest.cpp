@@ -0,0 +1,211 @@
+#include "HostI2S.h"
+#include "dsp/h/ImaAdpcm.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// --- IMA-ADPCM Round Trip ---
+// Encodes clips frame by frame the way the uplink does (one coder state
+// carried across blocks), decodes every block on its own as the server
+// does, and reports the SNR of the result. Each clip also runs through an
+// odd frame length to cover the padded last nibble. Without WAV arguments
+// a set of synthetic signals is used. Exits 1 if a block decodes to the
+// wrong sample count or a clip falls below the SNR floor.
+
+static const char* USAGE =
+  "usage: adpcm_test [clip.wav ...] [options]\n"
+  "  --frame N    samples per block (default 480, one 20 ms frame)\n"
+  "  --min-snr D  fail below D dB (default 20; white noise has its own 12 dB)\n"
+  "  --out DIR    write each decoded clip to DIR as WAV\n";
+
+typedef struct {
+  std::string Name;
+  std::vector<int16_t> Samples;
+  double MinSnr;  // 0: the --min-snr floor
+} Clip_t;
+
+typedef struct {
+  double SnrDb;
+  size_t Blocks;
+  size_t Bytes;
+  bool CountsOk;
+} RoundTrip_t;
+
+static RoundTrip_t RoundTrip(const std::vector<int16_t>& In, size_t Frame, std::vector<int16_t>* Out) {
+  RoundTrip_t Result = {0, 0, 0, true};
+  ImaAdpcmState_t State;
+  ImaAdpcmReset(&State);
+  std::vector<uint8_t> Block(IMA_ADPCM_BLOCK_BYTES(Frame));
+  // One spare sample so an ignored padding nibble would show as a wrong count
+  std::vector<int16_t> Decoded(Frame + 1);
+  Out->clear();
+
+  for (size_t Pos = 0; Pos < In.size(); Pos += Frame) {
+    size_t Count = In.size() - Pos < Frame ? In.size() - Pos : Frame;
+    size_t Bytes = ImaAdpcmEncode(&State, &In[Pos], Count, Block.data());
+    size_t Got = ImaAdpcmDecode(Block.data(), Bytes, Decoded.data(), Decoded.size());
+    if (Bytes != IMA_ADPCM_BLOCK_BYTES(Count) || Got != Count) Result.CountsOk = false;
+    Out->insert(Out->end(), Decoded.begin(), Decoded.begin() + (Got < Count ? Got : Count));
+    Result.Blocks++;
+    Result.Bytes += Bytes;
+  }
+
+  double Signal = 0, Noise = 0;
+  for (size_t I = 0; I < Out->size(); I++) {
+    double Error = (double)In[I] - (*Out)[I];
+    Signal += (double)In[I] * In[I];
+    Noise += Error * Error;
+  }
+  Result.SnrDb = Noise > 0 ? 10.0 * log10(Signal / Noise) : 99.0;
+  return Result;
+}
+
+static void PutU16(FILE* File, uint16_t Value) {
+  uint8_t Bytes[2] = {(uint8_t)Value, (uint8_t)(Value >> 8)};
+  fwrite(Bytes, 1, 2, File);
+}
+
+static void PutU32(FILE* File, uint32_t Value) {
+  uint8_t Bytes[4] = {(uint8_t)Value, (uint8_t)(Value >> 8), (uint8_t)(Value >> 16), (uint8_t)(Value >> 24)};
+  fwrite(Bytes, 1, 4, File);
+}
+
+static bool WriteWav(const std::string& Path, const std::vector<int16_t>& Samples, uint32_t Rate) {
+  FILE* File = fopen(Path.c_str(), "wb");
+  if (!File) return false;
+  uint32_t DataBytes = (uint32_t)(Samples.size() * 2);
+  fwrite("RIFF", 1, 4, File);
+  PutU32(File, 36 + DataBytes);
+  fwrite("WAVEfmt ", 1, 8, File);
+  PutU32(File, 16);
+  PutU16(File, 1);
+  PutU16(File, 1);
+  PutU32(File, Rate);
+  PutU32(File, Rate * 2);
+  PutU16(File, 2);
+  PutU16(File, 16);
+  fwrite("data", 1, 4, File);
+  PutU32(File, DataBytes);
+  for (int16_t Sample : Samples) PutU16(File, (uint16_t)Sample);
+  return fclose(File) == 0;
+}
+
+// Two seconds each at the mic rate
+static std::vector<Clip_t> SyntheticClips(uint32_t Rate) {
+  size_t Length = Rate * 2;
+  std::vector<Clip_t> Clips(4, Clip_t{"", {}, 0.0});
+  const double Pi = 3.14159265358979;
+
+  Clips[0].Name = "sine 440 Hz, -6 dBFS";
+  for (size_t I = 0; I < Length; I++) {
+    Clips[0].Samples.push_back((int16_t)(16384 * sin(2 * Pi * 440 * I / Rate)));
+  }
+
+  // Linear sweep up to 4 kHz, the top of the band the server cares about
+  Clips[1].Name = "sweep 100-4000 Hz";
+  double Phase = 0;
+  for (size_t I = 0; I < Length; I++) {
+    double Freq = 100 + 3900.0 * I / Length;
+    Phase += 2 * Pi * Freq / Rate;
+    Clips[1].Samples.push_back((int16_t)(12000 * sin(Phase)));
+  }
+
+  // Voiced-speech stand-in: a 150 Hz pulse train through a decaying
+  // resonance, gated into syllables
+  Clips[2].Name = "speech-like bursts";
+  double Y1 = 0, Y2 = 0;
+  double R = 0.995, Theta = 2 * Pi * 700 / Rate;
+  for (size_t I = 0; I < Length; I++) {
+    double Excite = (I % (Rate / 150)) == 0 ? 4000.0 : 0.0;
+    double Y = Excite + 2 * R * cos(Theta) * Y1 - R * R * Y2;
+    Y2 = Y1;
+    Y1 = Y;
+    bool Voiced = (I / (Rate / 5)) % 2 == 0;
+    double Value = Voiced ? Y : 0;
+    if (Value > 32767) Value = 32767;
+    if (Value < -32768) Value = -32768;
+    Clips[2].Samples.push_back((int16_t)Value);
+  }
+
+  // The worst case for an adaptive predictor; speech never gets here
+  Clips[3].Name = "white noise, -12 dBFS";
+  Clips[3].MinSnr = 12.0;
+  uint32_t Seed = 1;
+  for (size_t I = 0; I < Length; I++) {
+    Seed = Seed * 1664525u + 1013904223u;
+    Clips[3].Samples.push_back((int16_t)((int32_t)(Seed >> 16) - 32768) / 4);
+  }
+  return Clips;
+}
+
+int main(int Argc, char** Argv) {
+  size_t Frame = 480;
+  double MinSnr = 20.0;
+  const char* OutDir = NULL;
+  std::vector<const char*> Paths;
+
+  for (int I = 1; I < Argc; I++) {
+    const char* Value = I + 1 < Argc ? Argv[I + 1] : NULL;
+    if (Argv[I][0] != '-') {
+      Paths.push_back(Argv[I]);
+      continue;
+    }
+    if (Value && !strcmp(Argv[I], "--frame")) {
+      Frame = (size_t)atol(Value);
+    } else if (Value && !strcmp(Argv[I], "--min-snr")) {
+      MinSnr = atof(Value);
+    } else if (Value && !strcmp(Argv[I], "--out")) {
+      OutDir = Value;
+    } else {
+      fputs(USAGE, stderr);
+      return 2;
+    }
+    I++;
+  }
+  if (Frame < 2) {
+    fputs(USAGE, stderr);
+    return 2;
+  }
+
+  uint32_t Rate = I2SGetMicRate();
+  std::vector<Clip_t> Clips;
+  if (Paths.empty()) {
+    Clips = SyntheticClips(Rate);
+  } else {
+    for (const char* Path : Paths) {
+      HostClip_t Loaded;
+      if (!HostI2SLoad(Path, &Loaded)) return 2;
+      Clips.push_back({Path, Loaded.Samples, 0.0});
+    }
+  }
+
+  // The odd length exercises the flagged final nibble on every block
+  size_t Frames[2] = {Frame, Frame | 1};
+  if (Frames[1] == Frames[0]) Frames[1] = Frame + 2;
+
+  printf("%u Hz, blocks of %zu and %zu samples, SNR floor %.1f dB\n\n", Rate, Frames[0], Frames[1], MinSnr);
+  printf("%-28s  frame  blocks  kbit/s  SNR dB  result\n", "");
+  bool Ok = true;
+  for (size_t C = 0; C < Clips.size(); C++) {
+    for (size_t Length : Frames) {
+      std::vector<int16_t> Decoded;
+      RoundTrip_t R = RoundTrip(Clips[C].Samples, Length, &Decoded);
+      double Floor = Clips[C].MinSnr > 0 ? Clips[C].MinSnr : MinSnr;
+      bool Pass = R.CountsOk && R.SnrDb >= Floor;
+      double Seconds = (double)Clips[C].Samples.size() / Rate;
+      printf("%-28.28s  %5zu  %6zu  %6.1f  %6.1f  %s\n", Clips[C].Name.c_str(), Length, R.Blocks,
+        Seconds > 0 ? R.Bytes * 8 / Seconds / 1000 : 0.0, R.SnrDb,
+        !R.CountsOk ? "FAIL (sample count)" : Pass ? "ok" : "FAIL (SNR)");
+      Ok = Ok && Pass;
+
+      if (OutDir && Length == Frame) {
+        std::string Path = std::string(OutDir) + "/adpcm_" + std::to_string(C) + ".wav";
+        if (!WriteWav(Path, Decoded, Rate)) fprintf(stderr, "cannot write %s\n", Path.c_str());
+      }
+    }
+  }
+  return Ok ? 0 : 1;
+}
@@ -0,0 +1,403 @@
+#include "HostI2S.h"
+#include "config.h"
+#include "dsp/h/WakeFrontEnd.h"
+#include "dsp/h/Aec.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// --- Echo Canceller Evaluation ---
+// Runs mic/reference pairs through the conversation uplink's echo path as
+// SendMicFrame does (mic chain, then the AEC, one 20 ms frame at a time)
+// and reports echo return loss enhancement, convergence time, the bulk
+// delay the canceller settles on and how its double-talk detector treats
+// near-end speech: barge-ins (three NearEnd frames in a row once the
+// delay is known, as Audio.cpp minus its VAD) inside near-end windows are
+// hits, any other is false.
+// Without a corpus, synthetic rooms are used: assistant speech through a
+// speaker response, a direct path at a known delay behind the reference
+// and a reverberant tail, plus the user talking over it now and then.
+// With --min-erle it exits 1 when a clip's ERLE falls short.
+//
+// Corpus file, one pair per line (paths relative to the corpus file):
+//   <mic.wav> <ref.wav> [start end]...
+// mic.wav is the raw capture, ref.wav the speaker signal as CancelEcho
+// fetches it (reference lead included), sample for sample with the mic.
+// Each start/end pair (seconds) marks near-end speech.
+
+static const char* USAGE =
+  "usage: aec_eval [corpus.txt] [options]\n"
+  "  --warmup S      seconds before ERLE is measured (default 3)\n"
+  "  --min-erle DB   fail if a clip's ERLE is below DB\n";
+
+static const uint8_t BARGE_IN_FRAMES = 3;  // As Audio.cpp
+
+typedef struct {
+  std::string Name;
+  std::vector<int16_t> Mic;
+  std::vector<int16_t> Ref;
+  std::vector<int16_t> Near;     // Near-end alone (synthetic only)
+  std::vector<std::pair<double, double>> Speech;
+  int32_t TrueDelay;             // Direct path behind the reference, -1 if unknown
+} Entry_t;
+
+typedef struct {
+  double ErleDb;                 // Far-end-only frames after the warm-up
+  double ConvergeSec;            // First 250 ms window above 10 dB, -1 if never
+  int32_t Delay;                 // Bulk delay in use at the end, -1 if none
+  double NearSnrBefore;          // Near-end vs echo during double talk (synthetic only)
+  double NearSnrAfter;
+  uint32_t Segments, Hits, False;
+  double FarMinutes;
+  double NsPerFrame;
+} Result_t;
+
+static double WarmupSec = 3.0;
+
+static double Uniform(uint32_t* Seed) {
+  *Seed = *Seed * 1664525u + 1013904223u;
+  return ((int32_t)(*Seed >> 16) - 32768) / 32768.0;
+}
+
+// One syllable as in dtx_eval: a pitch pulse train through two formant
+// resonators, or noise through the upper one for unvoiced sounds
+static void AddSyllable(std::vector<double>* Out, size_t Start, size_t Length, uint32_t Rate, uint32_t* Seed, double Peak) {
+  const double Pi = 3.14159265358979;
+  static const double Formants[][2] = {{700, 1200}, {400, 2000}, {300, 2300}, {600, 900}, {500, 1700}};
+  *Seed = *Seed * 1664525u + 1013904223u;
+  const double* F = Formants[(*Seed >> 8) % 5];
+  bool Voiced = ((*Seed >> 16) & 3) != 0;
+  double Pitch = 90 + ((*Seed >> 20) % 160);
+
+  double State[2][2] = {{0, 0}, {0, 0}};
+  for (size_t I = 0; I < Length && Start + I < Out->size(); I++) {
+    double Excite = Voiced ? (fmod(I * Pitch / Rate, 1.0) < Pitch / Rate ? 1.0 : 0.0) : Uniform(Seed) * 0.05;
+    double Y = 0;
+    for (int K = Voiced ? 0 : 1; K < 2; K++) {
+      double R = 0.97, Theta = 2 * Pi * F[K] / Rate;
+      double V = Excite + 2 * R * cos(Theta) * State[K][0] - R * R * State[K][1];
+      State[K][1] = State[K][0];
+      State[K][0] = V;
+      Y += V;
+    }
+    double Envelope = 0.5 - 0.5 * cos(2 * Pi * I / Length);
+    (*Out)[Start + I] += Y * Envelope * Peak * 0.02;
+  }
+}
+
+// Talk from Begin to End (seconds): words of 2-4 syllables with short gaps
+static void AddTalk(std::vector<double>* Out, double Begin, double End, uint32_t Rate, uint32_t* Seed, double Peak) {
+  double Pos = Begin;
+  while (Pos < End) {
+    int Syllables = 2 + (int)((Uniform(Seed) + 1) * 1.5);
+    for (int K = 0; K < Syllables && Pos < End; K++) {
+      double Syllable = 0.15 + (Uniform(Seed) + 1) * 0.075;
+      AddSyllable(Out, (size_t)(Pos * Rate), (size_t)(Syllable * Rate), Rate, Seed, Peak);
+      Pos += Syllable + 0.02;
+    }
+    Pos += 0.05 + (Uniform(Seed) + 1) * 0.05;
+  }
+}
+
+// Speaker-to-mic impulse response: a small driver's band-limited direct
+// path, then a diffuse tail DrrDb below it that decays by 60 dB in T60
+static std::vector<double> RoomResponse(uint32_t Rate, double Gain, double DrrDb, double T60, uint32_t Seed) {
+  std::vector<double> H((size_t)(Rate * (T60 < 0.15 ? T60 : 0.15)) + 64, 0.0);
+  // Direct path: impulse through a 300 Hz high-pass and a 6 kHz low-pass
+  double Hp = exp(-2 * 3.14159265358979 * 300 / Rate), Lp = exp(-2 * 3.14159265358979 * 6000 / Rate);
+  double PrevIn = 0, HpOut = 0, LpOut = 0, Direct = 0;
+  for (size_t I = 0; I < 64; I++) {
+    double In = I == 0 ? 1.0 : 0.0;
+    HpOut = Hp * (HpOut + In - PrevIn);
+    PrevIn = In;
+    LpOut = (1 - Lp) * HpOut + Lp * LpOut;
+    H[I] = LpOut;
+    Direct += LpOut * LpOut;
+  }
+  // Tail from the first reflection (~2 ms) on
+  size_t First = Rate / 500;
+  double Tail = 0;
+  std::vector<double> T(H.size(), 0.0);
+  for (size_t I = First; I < H.size(); I++) {
+    T[I] = Uniform(&Seed) * exp(-6.9 * (I - First) / (T60 * Rate));
+    Tail += T[I] * T[I];
+  }
+  double Scale = sqrt(Direct / Tail * pow(10.0, -DrrDb / 10));
+  double Norm = Gain / sqrt(Direct);
+  for (size_t I = 0; I < H.size(); I++) H[I] = (H[I] + T[I] * Scale) * Norm;
+  return H;
+}
+
+static int16_t Clip16(double Value) {
+  return (int16_t)(Value > 32767 ? 32767 : Value < -32768 ? -32768 : lround(Value));
+}
+
+// 40 s per room: the assistant talks in 2-6 s turns, the user talks over
+// it twice and once into a pause. Levels are raw INMP441 samples (see
+// dtx_eval); the echo is far louder than the user a metre away.
+static std::vector<Entry_t> SyntheticCorpus(uint32_t Rate) {
+  static const struct { const char* Name; int32_t DelayMs10; double DrrDb; double T60; } Rooms[] = {
+    {"aligned, small room", 15, 12, 0.15},
+    {"one buffer late, small room", 210, 12, 0.15},
+    {"one buffer late, living room", 210, 6, 0.40},
+    {"one buffer early, living room", 5, 6, 0.40},
+  };
+  std::vector<Entry_t> Corpus;
+  uint32_t RoomSeed = 99;
+  for (const auto& Room : Rooms) {
+    Entry_t Entry;
+    Entry.Name = Room.Name;
+    size_t Length = Rate * 40;
+    std::vector<double> Far(Length, 0.0), Near(Length, 0.0);
+
+    uint32_t Seed = 2024;
+    double T = 0.5;
+    while (T < 38.0) {
+      double Turn = 2.0 + (Uniform(&Seed) + 1) * 2.0;
+      AddTalk(&Far, T, T + Turn < 39.0 ? T + Turn : 39.0, Rate, &Seed, 16000);
+      T += Turn + 0.4 + (Uniform(&Seed) + 1) * 0.4;
+    }
+    static const double Barge[][2] = {{12.0, 13.5}, {24.0, 26.0}, {35.0, 36.5}};
+    for (const auto& B : Barge) {
+      AddTalk(&Near, B[0], B[1], Rate, &Seed, 1430);
+      Entry.Speech.push_back({B[0], B[1]});
+    }
+    // The user replies into a silence in the far end
+    for (size_t I = (size_t)(34.5 * Rate); I < (size_t)(37.0 * Rate); I++) Far[I] = 0;
+
+    // The reference is the speaker signal, echo arrives Delay samples later
+    int32_t Delay = Room.DelayMs10 * (int32_t)Rate / 10000;
+    Entry.TrueDelay = Delay;
+    std::vector<double> H = RoomResponse(Rate, 0.25, Room.DrrDb, Room.T60, RoomSeed++);
+    Entry.Ref.resize(Length);
+    for (size_t I = 0; I < Length; I++) Entry.Ref[I] = Clip16(Far[I]);
+
+    Entry.Mic.resize(Length);
+    Entry.Near.resize(Length);
+    uint32_t NoiseSeed = 7;
+    for (size_t I = 0; I < Length; I++) {
+      double Echo = 0;
+      for (size_t K = 0; K < H.size() && K + Delay <= I; K++) Echo += H[K] * Entry.Ref[I - Delay - K];
+      double Noise = 2.0 * Uniform(&NoiseSeed) * 1.732;
+      Entry.Near[I] = Clip16(Near[I]);
+      Entry.Mic[I] = Clip16(Echo + Near[I] + Noise);
+    }
+    Corpus.push_back(Entry);
+  }
+  return Corpus;
+}
+
+static bool LoadCorpus(const char* Path, std::vector<Entry_t>* Corpus) {
+  FILE* File = fopen(Path, "r");
+  if (!File) {
+    fprintf(stderr, "[AecEval] %s: cannot open\n", Path);
+    return false;
+  }
+  std::string Dir(Path);
+  size_t Slash = Dir.find_last_of('/');
+  Dir = Slash == std::string::npos ? "" : Dir.substr(0, Slash + 1);
+
+  char Line[4096];
+  int LineNo = 0;
+  bool Ok = true;
+  while (fgets(Line, sizeof(Line), File)) {
+    LineNo++;
+    char Mic[768], Ref[768];
+    int Used;
+    if (Line[0] == '#' || sscanf(Line, "%767s %767s%n", Mic, Ref, &Used) != 2) continue;
+    Entry_t Entry;
+    Entry.Name = Mic;
+    Entry.TrueDelay = -1;
+    const char* Rest = Line + Used;
+    double Start, End;
+    int More;
+    while (sscanf(Rest, "%lf %lf%n", &Start, &End, &More) == 2) {
+      Entry.Speech.push_back({Start, End});
+      Rest += More;
+    }
+    if (sscanf(Rest, " %*s") != EOF) {
+      fprintf(stderr, "[AecEval] %s:%d: expected <mic.wav> <ref.wav> [start end]...\n", Path, LineNo);
+      Ok = false;
+      continue;
+    }
+    HostClip_t MicClip, RefClip;
+    std::string MicPath = Mic[0] == '/' ? std::string(Mic) : Dir + Mic;
+    std::string RefPath = Ref[0] == '/' ? std::string(Ref) : Dir + Ref;
+    if (!HostI2SLoad(MicPath.c_str(), &MicClip) || !HostI2SLoad(RefPath.c_str(), &RefClip)) {
+      Ok = false;
+      continue;
+    }
+    size_t Length = MicClip.Samples.size() < RefClip.Samples.size() ? MicClip.Samples.size() : RefClip.Samples.size();
+    Entry.Mic.assign(MicClip.Samples.begin(), MicClip.Samples.begin() + Length);
+    Entry.Ref.assign(RefClip.Samples.begin(), RefClip.Samples.begin() + Length);
+    Corpus->push_back(Entry);
+  }
+  fclose(File);
+  return Ok && !Corpus->empty();
+}
+
+static double Db(double Num, double Den) {
+  return Den > 0 && Num > 0 ? 10.0 * log10(Num / Den) : 0.0;
+}
+
+static uint64_t NowNs() {
+  return (uint64_t)DspCycles();
+}
+
+static Result_t RunClip(const Entry_t& Entry) {
+  Result_t R;
+  memset(&R, 0, sizeof(R));
+  R.ConvergeSec = -1;
+  R.Delay = -1;
+
+  uint32_t Rate = I2SGetMicRate();
+  size_t FrameSamples = Rate * AUDIO_FRAME_MS / 1000;
+  static MicChain_t Chain, NearChain;
+  static Aec_t Aec;
+  MicChainDesign(&Chain, Rate, QUIL_MIC_DSP_BYPASS);
+  MicChainDesign(&NearChain, Rate, QUIL_MIC_DSP_BYPASS);
+  Chain.Reset();
+  NearChain.Reset();
+  AecInit(&Aec);
+
+  std::vector<int16_t> Frame(FrameSamples), NearFrame(FrameSamples), Mic(FrameSamples);
+  double MicSum = 0, ResSum = 0, NearSum = 0, EchoSum = 0, LeftSum = 0;
+  double WinMic = 0, WinRes = 0;
+  size_t WinFrames = 0;
+  uint64_t Ns = 0;
+  size_t Frames = Entry.Mic.size() / FrameSamples;
+  uint8_t Run = 0;
+  size_t FarFrames = 0;
+  std::vector<bool> Hit(Entry.Speech.size(), false), Overlap(Entry.Speech.size(), false);
+
+  for (size_t F = 0; F < Frames; F++) {
+    const int16_t* Ref = Entry.Ref.data() + F * FrameSamples;
+    memcpy(Frame.data(), Entry.Mic.data() + F * FrameSamples, FrameSamples * sizeof(int16_t));
+    Chain.Process(Frame.data(), FrameSamples);
+    memcpy(Mic.data(), Frame.data(), FrameSamples * sizeof(int16_t));
+    if (!Entry.Near.empty()) {
+      memcpy(NearFrame.data(), Entry.Near.data() + F * FrameSamples, FrameSamples * sizeof(int16_t));
+      NearChain.Process(NearFrame.data(), FrameSamples);
+    }
+
+    uint64_t Start = NowNs();
+    AecProcess(&Aec, Ref, Frame.data(), FrameSamples);
+    Ns += (uint32_t)(NowNs() - Start);
+
+    double Time = (F + 0.5) * AUDIO_FRAME_MS / 1000.0;
+    int Window = -1;
+    for (size_t W = 0; W < Entry.Speech.size(); W++) {
+      if (Time >= Entry.Speech[W].first && Time <= Entry.Speech[W].second + 0.3) Window = (int)W;
+    }
+    double RefEnergy = 0, MicEnergy = 0, ResEnergy = 0;
+    for (size_t I = 0; I < FrameSamples; I++) {
+      RefEnergy += (double)Ref[I] * Ref[I];
+      MicEnergy += (double)Mic[I] * Mic[I];
+      ResEnergy += (double)Frame[I] * Frame[I];
+    }
+    bool Far = RefEnergy / FrameSamples > 100.0 * 100.0;
+    if (Far) FarFrames++;
+
+    if (Far && Window < 0) {
+      if (Time >= WarmupSec) {
+        MicSum += MicEnergy;
+        ResSum += ResEnergy;
+      }
+      WinMic += MicEnergy;
+      WinRes += ResEnergy;
+      if (++WinFrames == 250 / AUDIO_FRAME_MS) {
+        if (R.ConvergeSec < 0 && Db(WinMic, WinRes) >= 10.0) R.ConvergeSec = Time;
+        WinMic = WinRes = 0;
+        WinFrames = 0;
+      }
+    }
+    // Near-end quality while both talk: how far the echo sits below the user
+    if (Far && Window >= 0 && !Entry.Near.empty()) {
+      for (size_t I = 0; I < FrameSamples; I++) {
+        double N = NearFrame[I];
+        NearSum += N * N;
+        EchoSum += (Mic[I] - N) * (Mic[I] - N);
+        LeftSum += (Frame[I] - N) * (Frame[I] - N);
+      }
+    }
+
+    if (Far && Window >= 0) Overlap[Window] = true;
+    if (Far && Aec.DelayValid && Aec.NearEnd) {
+      if (++Run >= BARGE_IN_FRAMES) {
+        Run = 0;
+        if (Window >= 0) Hit[Window] = true;
+        else R.False++;
+      }
+    } else {
+      Run = 0;
+    }
+  }
+
+  R.ErleDb = Db(MicSum, ResSum);
+  R.NearSnrBefore = Db(NearSum, EchoSum);
+  R.NearSnrAfter = Db(NearSum, LeftSum);
+  // Only talk over playback can be a barge-in
+  for (size_t W = 0; W < Hit.size(); W++) {
+    R.Segments += Overlap[W];
+    R.Hits += Hit[W] && Overlap[W];
+  }
+  R.Delay = Aec.DelayValid ? Aec.Delay : -1;
+  R.FarMinutes = FarFrames * AUDIO_FRAME_MS / 60000.0;
+  R.NsPerFrame = Frames ? (double)Ns / Frames : 0;
+  return R;
+}
+
+int main(int Argc, char** Argv) {
+  const char* CorpusPath = NULL;
+  double MinErle = -1000;  // Off
+
+  for (int I = 1; I < Argc; I++) {
+    const char* Value = I + 1 < Argc ? Argv[I + 1] : NULL;
+    if (Argv[I][0] != '-' && !CorpusPath) {
+      CorpusPath = Argv[I];
+      continue;
+    }
+    if (Value && !strcmp(Argv[I], "--warmup")) {
+      WarmupSec = atof(Value);
+    } else if (Value && !strcmp(Argv[I], "--min-erle")) {
+      MinErle = atof(Value);
+    } else {
+      fputs(USAGE, stderr);
+      return 2;
+    }
+    I++;
+  }
+
+  std::vector<Entry_t> Corpus;
+  if (CorpusPath) {
+    if (!LoadCorpus(CorpusPath, &Corpus)) return 2;
+  } else {
+    Corpus = SyntheticCorpus(I2SGetMicRate());
+  }
+
+  printf("%u Hz, %d-tap filter, ERLE on far-end-only frames after %.1f s\n\n", I2SGetMicRate(), AEC_TAPS, WarmupSec);
+  printf("%-30s  %6s  %8s  %11s  %13s  %8s  %7s  %9s\n", "", "ERLE", "converge", "delay", "near SNR",
+    "barge-in", "false", "us/frame");
+
+  bool Ok = true;
+  for (const Entry_t& Entry : Corpus) {
+    Result_t R = RunClip(Entry);
+    char Converge[16] = "never", Delay[24] = "-", Near[24] = "-";
+    if (R.ConvergeSec >= 0) snprintf(Converge, sizeof(Converge), "%.2f s", R.ConvergeSec);
+    if (Entry.TrueDelay >= 0) snprintf(Delay, sizeof(Delay), "%d (%d)", R.Delay, Entry.TrueDelay);
+    else if (R.Delay >= 0) snprintf(Delay, sizeof(Delay), "%d", R.Delay);
+    if (!Entry.Near.empty()) snprintf(Near, sizeof(Near), "%+.1f>%+.1f", R.NearSnrBefore, R.NearSnrAfter);
+    printf("%-30.30s  %6.1f  %8s  %11s  %13s  %4u/%-3u  %7u  %9.1f\n", Entry.Name.c_str(), R.ErleDb, Converge,
+      Delay, Near, R.Hits, R.Segments, R.False, R.NsPerFrame / 1000.0);
+    if (R.ErleDb < MinErle) {
+      printf("FAIL: %s ERLE below %.1f dB\n", Entry.Name.c_str(), MinErle);
+      Ok = false;
+    }
+  }
+  printf("\ndelay: samples behind the reference the filter starts at (true direct path)\n");
+  printf("near SNR: user vs echo before > after the AEC while both talk (dB)\n");
+  return Ok ? 0 : 1;
+}
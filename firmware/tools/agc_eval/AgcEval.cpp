@@ -0,0 +1,362 @@
+#include "HostI2S.h"
+#include "config.h"
+#include "dsp/h/WakeFrontEnd.h"
+#include "dsp/h/NoiseSuppressor.h"
+#include "dsp/h/Agc.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// --- AGC Evaluation ---
+// Plays each talker at near, mid and far distance through the uplink's
+// front half as SendMicFrame does (mic chain, noise suppression, AGC) and
+// measures the output level over labelled speech once the warm-up is over.
+// Every clip runs twice: in 20 ms frames, as the firmware calls AgcProcess,
+// and in random lengths from 1 sample to two frames, which goes through
+// the partial-block carry. The second run has to hold the same level and
+// be the first one delayed by less than a block, sample for sample.
+// Exits 1 if a speech level is off QUIL_AGC_TARGET_DBFS by more than
+// --tolerance or the two runs differ.
+// Without a corpus a set of synthetic talkers (syllable bursts between
+// pauses over room noise) is used.
+//
+// Corpus file, one clip per line (paths relative to the corpus file):
+//   <clip.wav> [start end]...
+// Clips are taken as recorded at 1 m. Each start/end pair (seconds) marks
+// a stretch of speech; at least one is needed.
+
+static const char* USAGE =
+  "usage: agc_eval [corpus.txt] [options]\n"
+  "  --warmup S       seconds before the level is measured (default 2)\n"
+  "  --tolerance DB   allowed distance of the speech level from the target (default 3)\n"
+  "  --no-ns          leave noise suppression off\n";
+
+typedef struct {
+  std::string Name;
+  HostClip_t Clip;
+  std::vector<std::pair<double, double>> Speech;
+} Entry_t;
+
+typedef struct {
+  const char* Name;
+  double GainDb;                 // Against the 1 m recording
+} Distance_t;
+
+// Level falls ~6 dB per doubling of distance
+static const Distance_t DISTANCES[] = {
+  {"near 0.3 m", 10.5},
+  {"mid 1 m", 0.0},
+  {"far 3 m", -9.5},
+};
+
+typedef struct {
+  double InputDb;                // Speech level into the AGC, dBFS
+  double LevelDb;                // Output speech level, dBFS
+  double GainDb;                 // Applied gain at the end
+  uint32_t ClipPpm;
+  uint32_t Limited;
+} Result_t;
+
+static double WarmupSec = 2.0;
+static bool UseNs = QUIL_NOISE_SUPPRESSION;
+
+// One syllable as in dtx_eval: a pitch pulse train through two formant
+// resonators, or noise through the upper one for unvoiced sounds
+static void AddSyllable(std::vector<int16_t>* Out, size_t Start, size_t Length, uint32_t Rate, uint32_t* Seed, double Peak) {
+  const double Pi = 3.14159265358979;
+  static const double Formants[][2] = {{700, 1200}, {400, 2000}, {300, 2300}, {600, 900}, {500, 1700}};
+  *Seed = *Seed * 1664525u + 1013904223u;
+  const double* F = Formants[(*Seed >> 8) % 5];
+  bool Voiced = ((*Seed >> 16) & 3) != 0;
+  double Pitch = 110 + ((*Seed >> 20) % 90);
+
+  double State[2][2] = {{0, 0}, {0, 0}};
+  for (size_t I = 0; I < Length && Start + I < Out->size(); I++) {
+    double Excite;
+    if (Voiced) {
+      Excite = fmod(I * Pitch / Rate, 1.0) < Pitch / Rate ? 1.0 : 0.0;
+    } else {
+      *Seed = *Seed * 1664525u + 1013904223u;
+      Excite = ((int32_t)(*Seed >> 16) - 32768) / 32768.0 * 0.05;
+    }
+    double Y = 0;
+    for (int K = Voiced ? 0 : 1; K < 2; K++) {
+      double R = 0.97, Theta = 2 * Pi * F[K] / Rate;
+      double V = Excite + 2 * R * cos(Theta) * State[K][0] - R * R * State[K][1];
+      State[K][1] = State[K][0];
+      State[K][0] = V;
+      Y += V;
+    }
+    double Envelope = 0.5 - 0.5 * cos(2 * Pi * I / Length);
+    double Value = (*Out)[Start + I] + Y * Envelope * Peak * 0.02;
+    (*Out)[Start + I] = (int16_t)(Value > 32767 ? 32767 : Value < -32768 ? -32768 : Value);
+  }
+}
+
+// 20 s of talk at 1 m and the raw INMP441 level (speech RMS ~33), a loud
+// and a soft talker, over the mic's own noise (RMS ~2)
+static std::vector<Entry_t> SyntheticCorpus(uint32_t Rate) {
+  static const struct { const char* Name; double Peak; uint32_t Seed; } Talkers[] = {
+    {"talker", 1430, 12345},
+    {"soft talker", 720, 777},
+  };
+  std::vector<Entry_t> Corpus;
+  for (const auto& Talker : Talkers) {
+    Entry_t Entry;
+    Entry.Name = Talker.Name;
+    std::vector<int16_t>& S = Entry.Clip.Samples;
+    S.resize(Rate * 20);
+    uint32_t Seed = Talker.Seed;
+    double Low = 0;
+    for (size_t I = 0; I < S.size(); I++) {
+      Seed = Seed * 1664525u + 1013904223u;
+      double White = ((int32_t)(Seed >> 16) - 32768) / 32768.0 * 1.732;
+      Low = 0.9 * Low + 0.436 * White;
+      S[I] = (int16_t)(2 * Low);
+    }
+
+    // Turns of 2-4 s with 1-2 s pauses between them
+    double T = 0.5;
+    while (T < 17.0) {
+      Seed = Seed * 1664525u + 1013904223u;
+      double Length = 2.0 + (Seed >> 8) % 2000 / 1000.0;
+      if (T + Length > 19.5) break;
+      double Pos = T;
+      while (Pos < T + Length) {
+        Seed = Seed * 1664525u + 1013904223u;
+        int Syllables = 2 + (Seed >> 8) % 3;
+        for (int K = 0; K < Syllables && Pos < T + Length; K++) {
+          Seed = Seed * 1664525u + 1013904223u;
+          double Syllable = 0.15 + (Seed >> 8) % 150 / 1000.0;
+          AddSyllable(&S, (size_t)(Pos * Rate), (size_t)(Syllable * Rate), Rate, &Seed, Talker.Peak);
+          Pos += Syllable + 0.02;
+        }
+        Seed = Seed * 1664525u + 1013904223u;
+        Pos += 0.05 + (Seed >> 8) % 100 / 1000.0;
+      }
+      Entry.Speech.push_back({T, Pos});
+      Seed = Seed * 1664525u + 1013904223u;
+      T = Pos + 1.0 + (Seed >> 8) % 1000 / 1000.0;
+    }
+    Entry.Clip.Seconds = (double)S.size() / Rate;
+    Corpus.push_back(Entry);
+  }
+  return Corpus;
+}
+
+static bool LoadCorpus(const char* Path, std::vector<Entry_t>* Corpus) {
+  FILE* File = fopen(Path, "r");
+  if (!File) {
+    fprintf(stderr, "[AgcEval] %s: cannot open\n", Path);
+    return false;
+  }
+  std::string Dir(Path);
+  size_t Slash = Dir.find_last_of('/');
+  Dir = Slash == std::string::npos ? "" : Dir.substr(0, Slash + 1);
+
+  char Line[4096];
+  int LineNo = 0;
+  bool Ok = true;
+  while (fgets(Line, sizeof(Line), File)) {
+    LineNo++;
+    char Clip[768];
+    int Used;
+    if (Line[0] == '#' || sscanf(Line, "%767s%n", Clip, &Used) != 1) continue;
+    Entry_t Entry;
+    Entry.Name = Clip;
+    const char* Rest = Line + Used;
+    double Start, End;
+    int More;
+    while (sscanf(Rest, "%lf %lf%n", &Start, &End, &More) == 2) {
+      Entry.Speech.push_back({Start, End});
+      Rest += More;
+    }
+    if (Entry.Speech.empty() || sscanf(Rest, " %*s") != EOF) {
+      fprintf(stderr, "[AgcEval] %s:%d: expected <clip.wav> start end [start end]...\n", Path, LineNo);
+      Ok = false;
+      continue;
+    }
+    std::string Full = Clip[0] == '/' ? std::string(Clip) : Dir + Clip;
+    if (!HostI2SLoad(Full.c_str(), &Entry.Clip)) {
+      Ok = false;
+      continue;
+    }
+    Corpus->push_back(Entry);
+  }
+  fclose(File);
+  return Ok && !Corpus->empty();
+}
+
+// Active speech level over the labelled speech after the warm-up, in
+// dBFS: the mean power of the 20 ms frames within 16 dB of that level, as
+// P.56 measures it, so pauses between words do not drag it down
+static double SpeechLevel(const std::vector<int16_t>& Output, const Entry_t& Entry, size_t Lag) {
+  uint32_t Rate = I2SGetMicRate();
+  size_t FrameSamples = Rate * AUDIO_FRAME_MS / 1000;
+  std::vector<double> Powers;
+  for (const auto& Window : Entry.Speech) {
+    size_t Start = (size_t)(fmax(Window.first, WarmupSec) * Rate) + Lag;
+    size_t End = (size_t)(Window.second * Rate) + Lag;
+    for (size_t I = Start; I + FrameSamples <= End && I + FrameSamples <= Output.size(); I += FrameSamples) {
+      double Energy = 0;
+      for (size_t K = I; K < I + FrameSamples; K++) Energy += (double)Output[K] * Output[K];
+      Powers.push_back(Energy / FrameSamples);
+    }
+  }
+
+  double Level = 0;
+  for (double Power : Powers) Level += Power;
+  Level = Powers.empty() ? 0 : Level / Powers.size();
+  for (int Pass = 0; Pass < 10 && Level > 0; Pass++) {
+    double Sum = 0;
+    size_t Count = 0;
+    for (double Power : Powers) {
+      if (Power * 40 < Level) continue;
+      Sum += Power;
+      Count++;
+    }
+    Level = Sum / Count;
+  }
+  if (Level <= 0) return -120.0;
+  return 10.0 * log10(Level / (32768.0 * 32768.0));
+}
+
+// Mic chain and noise suppression per 20 ms frame, then the AGC in frames
+// (Chunked false) or random lengths. Output is sample-aligned with the
+// input apart from the AGC's own lag.
+static std::vector<int16_t> RunUplink(const Entry_t& Entry, const std::vector<int16_t>& Input, bool Chunked, Result_t* Result) {
+  uint32_t Rate = I2SGetMicRate();
+  size_t FrameSamples = Rate * AUDIO_FRAME_MS / 1000;
+
+  static MicChain_t Chain;
+  static Ns_t Ns;
+  static Agc_t Agc;
+  MicChainDesign(&Chain, Rate, QUIL_MIC_DSP_BYPASS);
+  Chain.Reset();
+  bool NsReady = UseNs && NsInit(&Ns, FrameSamples);
+  AgcInit(&Agc, Rate, QUIL_AGC_TARGET_DBFS, AGC_INITIAL_GAIN, AGC_MAX_GAIN);
+
+  size_t Frames = Input.size() / FrameSamples;
+  std::vector<int16_t> Output(Input.begin(), Input.begin() + Frames * FrameSamples);
+  for (size_t F = 0; F < Frames; F++) {
+    Chain.Process(Output.data() + F * FrameSamples, FrameSamples);
+    if (NsReady) NsProcess(&Ns, Output.data() + F * FrameSamples);
+  }
+  Result->InputDb = SpeechLevel(Output, Entry, 0);
+
+  uint32_t Seed = 99;
+  for (size_t Done = 0; Done < Output.size();) {
+    size_t Count = FrameSamples;
+    if (Chunked) {
+      Seed = Seed * 1664525u + 1013904223u;
+      Count = 1 + (Seed >> 8) % (2 * FrameSamples);
+    }
+    if (Count > Output.size() - Done) Count = Output.size() - Done;
+    AgcProcess(&Agc, Output.data() + Done, Count);
+    Done += Count;
+  }
+
+  Result->GainDb = AgcGainDb10(&Agc) / 10.0;
+  Result->ClipPpm = AgcClipPpm(&Agc);
+  Result->Limited = Agc.LimitedBlocks;
+  return Output;
+}
+
+// The chunked run is the framed one with fewer than Block zeros let in
+// where a call held back more input than before. Returns how many, the
+// extra lag, or -1 if it is not.
+static int ExtraLag(const std::vector<int16_t>& Framed, const std::vector<int16_t>& Chunked, size_t Block) {
+  // Feasible[K]: the chunked output so far is the framed one with K zeros
+  std::vector<char> Feasible(Block, 0), Next(Block);
+  Feasible[0] = 1;
+  for (size_t J = 0; J < Chunked.size(); J++) {
+    bool Any = false;
+    for (size_t K = 0; K < Block; K++) {
+      bool Keep = Feasible[K] && J >= K && Chunked[J] == Framed[J - K];
+      bool Insert = K > 0 && Feasible[K - 1] && Chunked[J] == 0;
+      Next[K] = Keep || Insert;
+      Any = Any || Next[K];
+    }
+    if (!Any) return -1;
+    Feasible.swap(Next);
+  }
+  for (size_t K = 0; K < Block; K++) {
+    if (Feasible[K]) return (int)K;
+  }
+  return -1;
+}
+
+int main(int Argc, char** Argv) {
+  const char* CorpusPath = NULL;
+  double Tolerance = 3.0;
+
+  for (int I = 1; I < Argc; I++) {
+    const char* Value = I + 1 < Argc ? Argv[I + 1] : NULL;
+    if (Argv[I][0] != '-' && !CorpusPath) {
+      CorpusPath = Argv[I];
+      continue;
+    }
+    if (!strcmp(Argv[I], "--no-ns")) {
+      UseNs = false;
+      continue;
+    }
+    if (Value && !strcmp(Argv[I], "--warmup")) {
+      WarmupSec = atof(Value);
+    } else if (Value && !strcmp(Argv[I], "--tolerance")) {
+      Tolerance = atof(Value);
+    } else {
+      fputs(USAGE, stderr);
+      return 2;
+    }
+    I++;
+  }
+  if (WarmupSec < 0 || Tolerance <= 0) {
+    fputs(USAGE, stderr);
+    return 2;
+  }
+
+  std::vector<Entry_t> Corpus;
+  if (CorpusPath) {
+    if (!LoadCorpus(CorpusPath, &Corpus)) return 2;
+  } else {
+    Corpus = SyntheticCorpus(I2SGetMicRate());
+  }
+
+  size_t Block = I2SGetMicRate() / 400;
+  printf("Target -%d dBFS +/- %.1f dB, warm-up %.1f s, noise suppression %s\n\n", QUIL_AGC_TARGET_DBFS,
+    Tolerance, WarmupSec, UseNs ? "on" : "off");
+  printf("%-24s  %-10s  %8s  %8s  %7s  %7s  %8s  %5s\n", "", "distance", "in dBFS", "out dBFS", "gain dB",
+    "clip ppm", "chunked", "lag");
+
+  bool Ok = true;
+  for (const Entry_t& Entry : Corpus) {
+    for (const Distance_t& Distance : DISTANCES) {
+      double Scale = pow(10.0, Distance.GainDb / 20.0);
+      std::vector<int16_t> Input(Entry.Clip.Samples.size());
+      for (size_t I = 0; I < Input.size(); I++) {
+        double Value = Entry.Clip.Samples[I] * Scale;
+        Input[I] = (int16_t)(Value > 32767 ? 32767 : Value < -32768 ? -32768 : lround(Value));
+      }
+
+      Result_t Framed, Chunked;
+      std::vector<int16_t> FramedOut = RunUplink(Entry, Input, false, &Framed);
+      std::vector<int16_t> ChunkedOut = RunUplink(Entry, Input, true, &Chunked);
+      int Extra = ExtraLag(FramedOut, ChunkedOut, Block);
+      Framed.LevelDb = SpeechLevel(FramedOut, Entry, Block);
+      Chunked.LevelDb = SpeechLevel(ChunkedOut, Entry, Block + (Extra > 0 ? Extra : 0));
+
+      double Target = -(double)QUIL_AGC_TARGET_DBFS;
+      bool Row = fabs(Framed.LevelDb - Target) <= Tolerance && fabs(Chunked.LevelDb - Target) <= Tolerance && Extra >= 0;
+      char Lag[16] = "differ";
+      if (Extra >= 0) snprintf(Lag, sizeof(Lag), "+%d", Extra);
+      printf("%-24.24s  %-10s  %8.1f  %8.1f  %7.1f  %7u  %8.1f  %5s  %s\n", Entry.Name.c_str(), Distance.Name,
+        Framed.InputDb, Framed.LevelDb, Framed.GainDb, Framed.ClipPpm, Chunked.LevelDb, Lag,
+        Row ? "ok" : "FAIL");
+      Ok = Ok && Row;
+    }
+  }
+  return Ok ? 0 : 1;
+}
@@ -0,0 +1,241 @@
+#include <Arduino.h>
+#include "modules/DownlinkDecoder.h"
+#include "mp3_decoder/mp3_decoder.h"
+#include <string>
+#include <vector>
+
+// --- Downlink Decode Test ---
+// Feeds MP3 streams through DownlinkDecoder in chunk sizes from one byte up
+// to the whole stream, the way WebSocket frames arrive, and checks that the
+// PCM length, sample rate and duration match the stream, frame for frame,
+// whatever the split. Built against a header-accurate stand-in for libhelix
+// (mp3_decoder/), so the samples are per-frame markers rather than audio;
+// that makes lost, repeated and reordered frames visible. Without arguments
+// synthetic 24 kHz streams cover sync loss, garbage, the bit reservoir, a
+// truncated tail and an interrupt; captured .mp3 files can be given
+// instead. Exits 1 on any mismatch.
+
+static const char* USAGE =
+  "usage: downlink_test [stream.mp3 ...]\n";
+
+static const size_t CHUNKS[] = {1, 2, 7, 96, 500, 1400, 4096, 0};  // 0: whole stream
+
+static std::vector<int16_t> Pcm;
+
+static void CollectPcm(const int16_t* Samples, size_t Count) {
+  Pcm.insert(Pcm.end(), Samples, Samples + Count);
+}
+
+// MPEG-2 Layer III at 24 kHz: 32 kbit/s mono (96-byte frames) or
+// 64 kbit/s stereo (192 bytes), 576 samples per channel
+static void AddFrame(std::vector<uint8_t>* Stream, bool Stereo, uint8_t MainDataBegin) {
+  size_t Bytes = Stereo ? 192 : 96;
+  size_t Start = Stream->size();
+  Stream->resize(Start + Bytes, 0x55);
+  uint8_t* Frame = &(*Stream)[Start];
+  Frame[0] = 0xFF;
+  Frame[1] = 0xF3;
+  Frame[2] = Stereo ? 0x84 : 0x44;
+  Frame[3] = Stereo ? 0x00 : 0xC0;
+  Frame[4] = MainDataBegin;
+}
+
+// Bytes without a valid header: stray 0xFF and a reserved-layer sync
+static void AddGarbage(std::vector<uint8_t>* Stream, size_t Bytes) {
+  uint32_t Seed = (uint32_t)Stream->size() + 1;
+  for (size_t I = 0; I < Bytes; I++) {
+    Seed = Seed * 1664525u + 1013904223u;
+    uint8_t Byte = (uint8_t)(Seed >> 24);
+    if (Byte == 0xFF) Byte = 0xFE;
+    Stream->push_back(Byte);
+  }
+  if (Bytes >= 4) {
+    uint8_t* Tail = &(*Stream)[Stream->size() - 4];
+    Tail[0] = 0xFF;
+    Tail[1] = 0xE1;
+    Tail[2] = 0xFF;
+    Tail[3] = 0x00;
+  }
+}
+
+typedef struct {
+  std::string Name;
+  std::vector<uint8_t> Stream;
+  std::vector<uint8_t> After;   // Fed after DownlinkDecoderReset (interrupt case)
+  uint32_t ExpectFrames;        // Frames that must come out
+  bool Synthetic;               // Markers known, so order is checked
+} Case_t;
+
+static std::vector<Case_t> SyntheticCases() {
+  std::vector<Case_t> Cases;
+  Case_t C;
+
+  C = Case_t{"mono, 6 s", {}, {}, 250, true};
+  for (int I = 0; I < 250; I++) AddFrame(&C.Stream, false, 0);
+  Cases.push_back(C);
+
+  C = Case_t{"stereo downmix, 3 s", {}, {}, 125, true};
+  for (int I = 0; I < 125; I++) AddFrame(&C.Stream, true, 0);
+  Cases.push_back(C);
+
+  // Leading bytes and noise between frames, as after a lost chunk
+  C = Case_t{"garbage between frames", {}, {}, 100, true};
+  AddGarbage(&C.Stream, 37);
+  for (int I = 0; I < 100; I++) {
+    AddFrame(&C.Stream, false, 0);
+    if (I % 10 == 9) AddGarbage(&C.Stream, 5 + I);
+  }
+  Cases.push_back(C);
+
+  // A full buffer with no frame in it makes the decoder drop and resync
+  C = Case_t{"resync after 6 KB of noise", {}, {}, 60, true};
+  for (int I = 0; I < 30; I++) AddFrame(&C.Stream, false, 0);
+  AddGarbage(&C.Stream, 6000);
+  for (int I = 0; I < 30; I++) AddFrame(&C.Stream, false, 0);
+  Cases.push_back(C);
+
+  // Joining mid-stream: the first frame borrows from data never received
+  C = Case_t{"bit reservoir at the start", {}, {}, 99, true};
+  AddFrame(&C.Stream, false, 40);
+  for (int I = 1; I < 100; I++) AddFrame(&C.Stream, false, I % 3 ? 20 : 0);
+  Cases.push_back(C);
+
+  C = Case_t{"truncated last frame", {}, {}, 49, true};
+  for (int I = 0; I < 50; I++) AddFrame(&C.Stream, false, 0);
+  C.Stream.resize(C.Stream.size() - 30);
+  Cases.push_back(C);
+
+  // Interrupt: half a frame pending when the response is cancelled, then
+  // the next response must decode from its first frame
+  C = Case_t{"reset mid-frame", {}, {}, 40, true};
+  for (int I = 0; I < 20; I++) AddFrame(&C.Stream, false, 0);
+  C.Stream.resize(C.Stream.size() + 48, 0x55);
+  C.Stream[C.Stream.size() - 48] = 0xFF;
+  C.Stream[C.Stream.size() - 47] = 0xF3;
+  C.Stream[C.Stream.size() - 46] = 0x44;
+  C.Stream[C.Stream.size() - 45] = 0xC0;
+  C.Stream[C.Stream.size() - 44] = 0x00;
+  for (int I = 0; I < 20; I++) AddFrame(&C.After, false, 0);
+  Cases.push_back(C);
+  return Cases;
+}
+
+// Frames and duration straight from the headers, skipping an ID3v2 tag
+static uint32_t WalkFrames(const std::vector<uint8_t>& Stream, double* Seconds) {
+  size_t Pos = 0;
+  if (Stream.size() >= 10 && memcmp(&Stream[0], "ID3", 3) == 0) {
+    Pos = 10 + (((size_t)Stream[6] & 0x7F) << 21 | ((size_t)Stream[7] & 0x7F) << 14 |
+      ((size_t)Stream[8] & 0x7F) << 7 | ((size_t)Stream[9] & 0x7F));
+  }
+  uint32_t Frames = 0;
+  *Seconds = 0;
+  while (Pos + 4 <= Stream.size()) {
+    HostMp3Header_t Header;
+    if (!HostMp3ParseHeader(&Stream[Pos], (int)(Stream.size() - Pos), &Header) ||
+        Pos + Header.FrameBytes > Stream.size()) {
+      Pos++;
+      continue;
+    }
+    Frames++;
+    *Seconds += (double)Header.SamplesPerChannel / Header.SampleRate;
+    Pos += Header.FrameBytes;
+  }
+  return Frames;
+}
+
+static void Feed(const std::vector<uint8_t>& Stream, size_t Chunk) {
+  if (Chunk == 0) Chunk = Stream.size();
+  for (size_t Pos = 0; Pos < Stream.size(); Pos += Chunk) {
+    DownlinkDecoderFeed(&Stream[Pos], min(Chunk, Stream.size() - Pos), CollectPcm);
+  }
+}
+
+// One case at every chunk size; true if all agree with the expectation
+static bool RunCase(const Case_t& C) {
+  double StreamSeconds = 0;
+  uint32_t HeaderFrames = WalkFrames(C.Stream, &StreamSeconds);
+  if (!C.After.empty()) {
+    double AfterSeconds;
+    HeaderFrames += WalkFrames(C.After, &AfterSeconds);
+    StreamSeconds += AfterSeconds;
+  }
+
+  bool Ok = true;
+  size_t FirstCount = 0;
+  uint32_t Rate = 0;
+  for (size_t Chunk : CHUNKS) {
+    Pcm.clear();
+    DownlinkDecoderEnd();
+    DownlinkDecoderBegin(DOWNLINK_CODEC_MP3);
+    Feed(C.Stream, Chunk);
+    if (!C.After.empty()) {
+      DownlinkDecoderReset();
+      Feed(C.After, Chunk);
+    }
+    Rate = DownlinkDecoderGetSampleRate();
+
+    const char* Error = NULL;
+    size_t PerFrame = Rate > 32000 ? 1152 : 576;
+    if (Rate == 0) {
+      Error = "no sample rate";
+    } else if (Pcm.size() % PerFrame != 0) {
+      Error = "partial frame of PCM";
+    } else if (Chunk == CHUNKS[0]) {
+      FirstCount = Pcm.size();
+    } else if (Pcm.size() != FirstCount) {
+      Error = "PCM length depends on the chunk size";
+    }
+    if (!Error && C.Synthetic) {
+      if (Pcm.size() != C.ExpectFrames * PerFrame) Error = "wrong PCM length";
+      for (size_t I = 0; !Error && I < Pcm.size(); I++) {
+        if (Pcm[I] != HostMp3FrameMarker((uint32_t)(I / PerFrame))) Error = "frames lost, repeated or out of order";
+      }
+    }
+    if (!Error && !C.Synthetic) {
+      // A captured stream may open on frames whose reservoir was never sent
+      double PcmSeconds = (double)Pcm.size() / Rate;
+      if (PcmSeconds > StreamSeconds + 1e-6 || PcmSeconds < StreamSeconds - 2.0 * PerFrame / Rate) {
+        Error = "PCM duration does not match the stream";
+      }
+    }
+    if (Error) {
+      printf("  %s: %s with %zu-byte chunks (%zu samples)\n", C.Name.c_str(), Error,
+        Chunk ? Chunk : C.Stream.size(), Pcm.size());
+      Ok = false;
+    }
+  }
+
+  double PcmSeconds = Rate ? (double)FirstCount / Rate : 0;
+  printf("%-28.28s  %6u  %7.3f  %8zu  %7.3f  %5u  %s\n", C.Name.c_str(), HeaderFrames, StreamSeconds,
+    FirstCount, PcmSeconds, Rate, Ok ? "ok" : "FAIL");
+  return Ok;
+}
+
+int main(int Argc, char** Argv) {
+  std::vector<Case_t> Cases;
+  for (int I = 1; I < Argc; I++) {
+    if (Argv[I][0] == '-') {
+      fputs(USAGE, stderr);
+      return 2;
+    }
+    FILE* File = fopen(Argv[I], "rb");
+    if (!File) {
+      fprintf(stderr, "%s: cannot open\n", Argv[I]);
+      return 2;
+    }
+    Case_t C = Case_t{Argv[I], {}, {}, 0, false};
+    uint8_t Buffer[65536];
+    size_t Got;
+    while ((Got = fread(Buffer, 1, sizeof(Buffer), File)) > 0) C.Stream.insert(C.Stream.end(), Buffer, Buffer + Got);
+    fclose(File);
+    Cases.push_back(C);
+  }
+  if (Cases.empty()) Cases = SyntheticCases();
+
+  printf("Chunk sizes 1 to 4096 bytes and whole streams\n\n");
+  printf("%-28s  frames  stream s  samples    pcm s   rate  result\n", "");
+  bool Ok = true;
+  for (const Case_t& C : Cases) Ok = RunCase(C) && Ok;
+  DownlinkDecoderEnd();
+  return Ok ? 0 : 1;
+}
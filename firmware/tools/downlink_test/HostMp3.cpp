@@ -0,0 +1,117 @@
+#include "mp3_decoder/mp3_decoder.h"
+
+// kbit/s by bitrate index, Layer III
+static const int BitrateV1[15] = {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320};
+static const int BitrateV2[15] = {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160};
+static const int RateV1[3] = {44100, 48000, 32000};
+
+static bool Allocated = false;
+static int Channels = 0;
+static int SampleRate = 0;
+static int OutputSamps = 0;
+static int Reservoir = 0;       // Main data bytes carried from previous frames (max 511)
+static uint32_t Decoded = 0;
+
+bool HostMp3ParseHeader(const unsigned char* Buf, int NBytes, HostMp3Header_t* Header) {
+  if (NBytes < 4 || Buf[0] != 0xFF || (Buf[1] & 0xE0) != 0xE0) return false;
+
+  int Version = (Buf[1] >> 3) & 3;   // 0: MPEG-2.5, 2: MPEG-2, 3: MPEG-1
+  int Layer = (Buf[1] >> 1) & 3;     // 1: Layer III
+  bool Crc = !(Buf[1] & 1);
+  int BitrateIndex = Buf[2] >> 4;
+  int RateIndex = (Buf[2] >> 2) & 3;
+  int Padding = (Buf[2] >> 1) & 1;
+  int Mode = Buf[3] >> 6;
+  if (Version == 1 || Layer != 1 || BitrateIndex == 0 || BitrateIndex == 15 || RateIndex == 3) return false;
+
+  bool V1 = Version == 3;
+  int Rate = RateV1[RateIndex] >> (V1 ? 0 : Version == 2 ? 1 : 2);
+  int Kbps = V1 ? BitrateV1[BitrateIndex] : BitrateV2[BitrateIndex];
+
+  Header->SampleRate = Rate;
+  Header->Channels = Mode == 3 ? 1 : 2;
+  Header->SamplesPerChannel = V1 ? 1152 : 576;
+  Header->FrameBytes = (V1 ? 144 : 72) * Kbps * 1000 / Rate + Padding;
+  Header->SideInfoBytes = (V1 ? (Header->Channels == 1 ? 17 : 32) : (Header->Channels == 1 ? 9 : 17)) + (Crc ? 2 : 0);
+
+  // main_data_begin: 9 bits (MPEG-1) or 8 bits (MPEG-2/2.5) after the header
+  int Side = 4 + (Crc ? 2 : 0);
+  if (NBytes >= Side + 2) {
+    Header->MainDataBegin = V1 ? (Buf[Side] << 1) | (Buf[Side + 1] >> 7) : Buf[Side];
+  } else {
+    Header->MainDataBegin = 0;
+  }
+  return true;
+}
+
+short HostMp3FrameMarker(uint32_t Index) {
+  return (short)(100 + (Index % 150) * 100);
+}
+
+bool MP3Decoder_AllocateBuffers() {
+  Allocated = true;
+  Channels = SampleRate = OutputSamps = Reservoir = 0;
+  Decoded = 0;
+  return true;
+}
+
+void MP3Decoder_FreeBuffers() {
+  Allocated = false;
+}
+
+int MP3FindSyncWord(unsigned char* Buf, int NBytes) {
+  for (int I = 0; I < NBytes - 1; I++) {
+    if (Buf[I] == 0xFF && (Buf[I + 1] & 0xE0) == 0xE0) return I;
+  }
+  return -1;
+}
+
+int MP3Decode(unsigned char* InBuf, int* BytesLeft, short* OutBuf, int UseSize) {
+  (void)UseSize;
+  if (!Allocated || !InBuf || !OutBuf) return ERR_MP3_NULL_POINTER;
+
+  HostMp3Header_t Header;
+  if (*BytesLeft < 6) return ERR_MP3_INDATA_UNDERFLOW;
+  if (!HostMp3ParseHeader(InBuf, *BytesLeft, &Header)) {
+    Reservoir = 0;
+    return ERR_MP3_INVALID_FRAMEHEADER;
+  }
+  if (*BytesLeft < Header.FrameBytes) return ERR_MP3_INDATA_UNDERFLOW;
+  *BytesLeft -= Header.FrameBytes;
+
+  // The frame's own main data joins the reservoir for the frames after it
+  int MainData = Header.FrameBytes - 4 - Header.SideInfoBytes;
+  bool Underflow = Header.MainDataBegin > Reservoir;
+  Reservoir += MainData > 0 ? MainData : 0;
+  if (Reservoir > 511) Reservoir = 511;
+  if (Underflow) return ERR_MP3_MAINDATA_UNDERFLOW;
+
+  Channels = Header.Channels;
+  SampleRate = Header.SampleRate;
+  OutputSamps = Header.SamplesPerChannel * Header.Channels;
+
+  // Stereo frames carry twice the marker left and zero right, so the
+  // downmix has to land on the marker
+  short Marker = HostMp3FrameMarker(Decoded++);
+  for (int I = 0; I < Header.SamplesPerChannel; I++) {
+    if (Channels == 2) {
+      OutBuf[2 * I] = (short)(Marker * 2);
+      OutBuf[2 * I + 1] = 0;
+    } else {
+      OutBuf[I] = Marker;
+    }
+  }
+  return ERR_MP3_NONE;
+}
+
+int MP3GetChannels() {
+  return Channels;
+}
+
+int MP3GetSampRate() {
+  return SampleRate;
+}
+
+int MP3GetOutputSamps() {
+  return OutputSamps;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+
+// --- Host MP3 Decoder Stand-In ---
+// The slice of the libhelix API (as bundled with ESP32-audioI2S) that
+// DownlinkDecoder uses. Frames are found and sized from their real MPEG
+// audio headers and the bit reservoir is tracked from main_data_begin, so
+// sync, underflow and frame accounting behave like the real decoder; the
+// PCM is a marker per frame instead of decoded audio.
+
+enum {
+  ERR_MP3_NONE = 0,
+  ERR_MP3_INDATA_UNDERFLOW = -1,
+  ERR_MP3_MAINDATA_UNDERFLOW = -2,
+  ERR_MP3_FREE_BITRATE_SYNC = -3,
+  ERR_MP3_OUT_OF_MEMORY = -4,
+  ERR_MP3_NULL_POINTER = -5,
+  ERR_MP3_INVALID_FRAMEHEADER = -6,
+};
+
+bool MP3Decoder_AllocateBuffers();
+void MP3Decoder_FreeBuffers();
+int MP3FindSyncWord(unsigned char* Buf, int NBytes);
+int MP3Decode(unsigned char* InBuf, int* BytesLeft, short* OutBuf, int UseSize);
+int MP3GetChannels();
+int MP3GetSampRate();
+int MP3GetOutputSamps();
+
+// Parsed MPEG audio Layer III header
+typedef struct {
+  int SampleRate;
+  int Channels;
+  int FrameBytes;
+  int SamplesPerChannel;
+  int SideInfoBytes;      // Including the CRC when present
+  int MainDataBegin;      // Bytes the frame borrows from earlier frames
+} HostMp3Header_t;
+
+// false if the four bytes at Buf are not a Layer III header this
+// decoder handles (free format included)
+bool HostMp3ParseHeader(const unsigned char* Buf, int NBytes, HostMp3Header_t* Header);
+
+// Value of every output sample of the Index-th decoded frame (mono, or
+// after the downmix)
+short HostMp3FrameMarker(uint32_t Index);
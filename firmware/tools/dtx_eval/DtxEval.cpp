@@ -0,0 +1,354 @@
+#include "HostI2S.h"
+#include "config.h"
+#include "core/h/WireProtocol.h"
+#include "dsp/h/WakeFrontEnd.h"
+#include "dsp/h/NoiseSuppressor.h"
+#include "dsp/h/Agc.h"
+#include "dsp/h/Vad.h"
+#include "dsp/h/ImaAdpcm.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// --- Uplink DTX Evaluation ---
+// Runs clips through the conversation uplink as SendMicFrame does (mic
+// chain, noise suppression, AGC, VAD) and counts the bytes the device
+// would send with and without DTX, markers included, for PCM16 and
+// IMA-ADPCM. The last few withheld frames go out ahead of the frame that
+// ends a silence, as Audio.cpp's lookback sends them. With speech windows in the corpus it also reports how much
+// labelled speech the VAD withheld. Without a corpus a set of synthetic
+// conversations (syllable bursts between pauses over room noise) is used.
+// With --min-reduction or --max-clipped it exits 1 when a limit is missed.
+//
+// Corpus file, one clip per line (paths relative to the corpus file):
+//   <clip.wav> [start end]...
+// Each start/end pair (seconds) marks a stretch of speech.
+
+static const char* USAGE =
+  "usage: dtx_eval [corpus.txt] [options]\n"
+  "  --hangover N        VAD hangover frames (default 15, as the firmware)\n"
+  "  --lookback N        withheld frames sent ahead of a talkspurt (default 4, as the firmware)\n"
+  "  --no-ns             leave noise suppression off\n"
+  "  --raw               count unframed messages (no quil1 headers)\n"
+  "  --min-reduction P   fail if DTX saves less than P% of the bytes\n"
+  "  --max-clipped P     fail if more than P% of labelled speech frames are withheld\n";
+
+static const uint32_t DTX_MARKER_FRAMES = 200 / AUDIO_FRAME_MS;  // As Audio.cpp
+static const uint32_t DTX_LOOKBACK_MAX = 50;
+
+typedef struct {
+  std::string Name;
+  HostClip_t Clip;
+  std::vector<std::pair<double, double>> Speech;
+} Entry_t;
+
+typedef struct {
+  uint64_t Frames;
+  uint64_t Sent;
+  uint64_t Markers;
+  uint64_t SpeechFrames;
+  uint64_t SpeechWithheld;
+  uint64_t PcmFull, PcmDtx;      // Bytes, PCM16 uplink
+  uint64_t AdpcmFull, AdpcmDtx;  // Bytes, IMA-ADPCM uplink
+} Tally_t;
+
+static uint16_t Hangover = 300 / AUDIO_FRAME_MS;
+static uint32_t Lookback = 80 / AUDIO_FRAME_MS;
+static bool UseNs = QUIL_NOISE_SUPPRESSION;
+static bool Framed = true;
+
+// One voiced syllable: a pitch pulse train through two formant resonators,
+// or for unvoiced ones, noise through the upper formant only
+static void AddSyllable(std::vector<int16_t>* Out, size_t Start, size_t Length, uint32_t Rate, uint32_t* Seed, double Peak) {
+  const double Pi = 3.14159265358979;
+  static const double Formants[][2] = {{700, 1200}, {400, 2000}, {300, 2300}, {600, 900}, {500, 1700}};
+  *Seed = *Seed * 1664525u + 1013904223u;
+  const double* F = Formants[(*Seed >> 8) % 5];
+  bool Voiced = ((*Seed >> 16) & 3) != 0;
+  double Pitch = 110 + ((*Seed >> 20) % 90);
+
+  double State[2][2] = {{0, 0}, {0, 0}};
+  for (size_t I = 0; I < Length && Start + I < Out->size(); I++) {
+    double Excite;
+    if (Voiced) {
+      Excite = fmod(I * Pitch / Rate, 1.0) < Pitch / Rate ? 1.0 : 0.0;
+    } else {
+      *Seed = *Seed * 1664525u + 1013904223u;
+      Excite = ((int32_t)(*Seed >> 16) - 32768) / 32768.0 * 0.05;
+    }
+    double Y = 0;
+    for (int K = Voiced ? 0 : 1; K < 2; K++) {
+      double R = 0.97, Theta = 2 * Pi * F[K] / Rate;
+      double V = Excite + 2 * R * cos(Theta) * State[K][0] - R * R * State[K][1];
+      State[K][1] = State[K][0];
+      State[K][0] = V;
+      Y += V;
+    }
+    // Raised-cosine envelope so syllables fade in and out
+    double Envelope = 0.5 - 0.5 * cos(2 * Pi * I / Length);
+    double Value = (*Out)[Start + I] + Y * Envelope * Peak * 0.02;
+    (*Out)[Start + I] = (int16_t)(Value > 32767 ? 32767 : Value < -32768 ? -32768 : Value);
+  }
+}
+
+// 30 s conversations at the raw INMP441 level, before the firmware's x32
+// gain: conversational speech at 1 m (~60 dB SPL) is around RMS 33, a
+// quiet room sits near the mic's own noise (RMS ~2), a fan adds ~15 dB.
+static std::vector<Entry_t> SyntheticCorpus(uint32_t Rate) {
+  static const struct { const char* Name; double NoiseRms; double Hum; double Peak; } Rooms[] = {
+    {"quiet room", 2, 0, 1430},
+    {"fan noise", 10, 0, 1430},
+    {"mains hum, soft voice", 2, 3, 520},
+  };
+  std::vector<Entry_t> Corpus;
+  for (const auto& Room : Rooms) {
+    Entry_t Entry;
+    Entry.Name = Room.Name;
+    std::vector<int16_t>& S = Entry.Clip.Samples;
+    S.resize(Rate * 30);
+    uint32_t Seed = 12345;
+    double Low = 0;
+    for (size_t I = 0; I < S.size(); I++) {
+      Seed = Seed * 1664525u + 1013904223u;
+      double White = ((int32_t)(Seed >> 16) - 32768) / 32768.0 * 1.732;
+      Low = 0.9 * Low + 0.436 * White;  // Unit RMS, tilted towards the lows
+      S[I] = (int16_t)(Room.NoiseRms * Low + Room.Hum * sin(2 * 3.14159265358979 * 50 * I / Rate));
+    }
+
+    // User turns of 1-4 s (words of 2-4 syllables, short gaps between
+    // them) while the assistant's replies take 3-7 s in between; the mic
+    // stays open through those for barge-in
+    double T = 1.0;
+    while (T < 28.0) {
+      Seed = Seed * 1664525u + 1013904223u;
+      double Length = 1.0 + (Seed >> 8) % 3000 / 1000.0;
+      if (T + Length > 29.0) break;
+      double Pos = T;
+      while (Pos < T + Length) {
+        Seed = Seed * 1664525u + 1013904223u;
+        int Syllables = 2 + (Seed >> 8) % 3;
+        for (int K = 0; K < Syllables && Pos < T + Length; K++) {
+          Seed = Seed * 1664525u + 1013904223u;
+          double Syllable = 0.15 + (Seed >> 8) % 150 / 1000.0;
+          AddSyllable(&S, (size_t)(Pos * Rate), (size_t)(Syllable * Rate), Rate, &Seed, Room.Peak);
+          Pos += Syllable + 0.02;
+        }
+        Seed = Seed * 1664525u + 1013904223u;
+        Pos += 0.05 + (Seed >> 8) % 100 / 1000.0;
+      }
+      Entry.Speech.push_back({T, Pos});
+      Seed = Seed * 1664525u + 1013904223u;
+      T = Pos + 3.0 + (Seed >> 8) % 4000 / 1000.0;
+    }
+    Entry.Clip.Seconds = (double)S.size() / Rate;
+    Corpus.push_back(Entry);
+  }
+  return Corpus;
+}
+
+static bool LoadCorpus(const char* Path, std::vector<Entry_t>* Corpus) {
+  FILE* File = fopen(Path, "r");
+  if (!File) {
+    fprintf(stderr, "[DtxEval] %s: cannot open\n", Path);
+    return false;
+  }
+  std::string Dir(Path);
+  size_t Slash = Dir.find_last_of('/');
+  Dir = Slash == std::string::npos ? "" : Dir.substr(0, Slash + 1);
+
+  char Line[4096];
+  int LineNo = 0;
+  bool Ok = true;
+  while (fgets(Line, sizeof(Line), File)) {
+    LineNo++;
+    char Clip[768];
+    int Used;
+    if (Line[0] == '#' || sscanf(Line, "%767s%n", Clip, &Used) != 1) continue;
+    Entry_t Entry;
+    Entry.Name = Clip;
+    const char* Rest = Line + Used;
+    double Start, End;
+    int More;
+    while (sscanf(Rest, "%lf %lf%n", &Start, &End, &More) == 2) {
+      Entry.Speech.push_back({Start, End});
+      Rest += More;
+    }
+    if (sscanf(Rest, " %*s") != EOF) {
+      fprintf(stderr, "[DtxEval] %s:%d: expected <clip.wav> [start end]...\n", Path, LineNo);
+      Ok = false;
+      continue;
+    }
+    std::string Full = Clip[0] == '/' ? std::string(Clip) : Dir + Clip;
+    if (!HostI2SLoad(Full.c_str(), &Entry.Clip)) {
+      Ok = false;
+      continue;
+    }
+    Corpus->push_back(Entry);
+  }
+  fclose(File);
+  return Ok && !Corpus->empty();
+}
+
+static Tally_t RunClip(const Entry_t& Entry) {
+  Tally_t Tally;
+  memset(&Tally, 0, sizeof(Tally));
+
+  uint32_t Rate = I2SGetMicRate();
+  size_t FrameSamples = Rate * AUDIO_FRAME_MS / 1000;
+  size_t SessionSamples = QUIL_SESSION_SAMPLE_RATE * AUDIO_FRAME_MS / 1000;
+  size_t Header = Framed ? WIRE_HEADER_BYTES : 0;
+  size_t PcmBytes = Header + SessionSamples * sizeof(int16_t);
+  size_t AdpcmBytes = Header + IMA_ADPCM_BLOCK_BYTES(SessionSamples);
+  size_t MarkerBytes = Framed ? WIRE_HEADER_BYTES + 1 : 3;
+
+  static MicChain_t Chain;
+  static Ns_t Ns;
+  static Agc_t Agc;
+  Vad_t Vad;
+  MicChainDesign(&Chain, Rate, QUIL_MIC_DSP_BYPASS);
+  bool NsReady = UseNs && NsInit(&Ns, FrameSamples);
+  AgcInit(&Agc, Rate, QUIL_AGC_TARGET_DBFS, AGC_INITIAL_GAIN, AGC_MAX_GAIN);
+  VadInit(&Vad, Hangover);
+
+  std::vector<int16_t> Frame(FrameSamples);
+  uint32_t SilentFrames = 0;
+  bool Held[DTX_LOOKBACK_MAX];  // Labels of the withheld frames the lookback still has, oldest first
+  uint32_t HeldCount = 0;
+  HostI2SSetSource(&Entry.Clip);
+  while (I2SReadMic((uint8_t*)Frame.data(), FrameSamples * 2) == FrameSamples * 2) {
+    Chain.Process(Frame.data(), FrameSamples);
+    if (NsReady) NsProcess(&Ns, Frame.data());
+    AgcProcess(&Agc, Frame.data(), FrameSamples);
+    bool Active = VadProcess(&Vad, Frame.data(), FrameSamples);
+
+    double Center = (Tally.Frames + 0.5) * AUDIO_FRAME_MS / 1000.0;
+    bool Speech = false;
+    for (const auto& Window : Entry.Speech) Speech = Speech || (Center >= Window.first && Center <= Window.second);
+    Tally.Frames++;
+    Tally.PcmFull += PcmBytes;
+    Tally.AdpcmFull += AdpcmBytes;
+    if (Speech) Tally.SpeechFrames++;
+
+    if (Active) {
+      for (uint32_t I = 0; I < HeldCount; I++) {
+        if (Held[I]) Tally.SpeechWithheld--;
+      }
+      Tally.Sent += 1 + HeldCount;
+      Tally.PcmDtx += PcmBytes * (1 + HeldCount);
+      Tally.AdpcmDtx += AdpcmBytes * (1 + HeldCount);
+      SilentFrames = 0;
+      HeldCount = 0;
+      continue;
+    }
+    if (Speech) Tally.SpeechWithheld++;
+    if (Lookback > 0) {
+      if (HeldCount == Lookback) memmove(Held, Held + 1, --HeldCount * sizeof(Held[0]));
+      Held[HeldCount++] = Speech;
+    }
+    if (SilentFrames++ % DTX_MARKER_FRAMES == 0) {
+      Tally.Markers++;
+      Tally.PcmDtx += MarkerBytes;
+      Tally.AdpcmDtx += MarkerBytes;
+    }
+  }
+  return Tally;
+}
+
+static double Percent(uint64_t Part, uint64_t Whole) {
+  return Whole ? 100.0 * Part / Whole : 0.0;
+}
+
+static void PrintRow(const char* Name, const Tally_t& T, bool Labelled) {
+  char Clipped[16] = "-";
+  if (Labelled) snprintf(Clipped, sizeof(Clipped), "%.1f", Percent(T.SpeechWithheld, T.SpeechFrames));
+  printf("%-24.24s  %6.1f  %5.1f  %5.1f  %9.1f  %9.1f  %5.1f  %9.1f  %9.1f  %5.1f  %7s\n", Name,
+    T.Frames * AUDIO_FRAME_MS / 1000.0, Percent(T.SpeechFrames, T.Frames), Percent(T.Sent, T.Frames),
+    T.PcmFull / 1024.0, T.PcmDtx / 1024.0, 100.0 - Percent(T.PcmDtx, T.PcmFull),
+    T.AdpcmFull / 1024.0, T.AdpcmDtx / 1024.0, 100.0 - Percent(T.AdpcmDtx, T.AdpcmFull), Clipped);
+}
+
+int main(int Argc, char** Argv) {
+  const char* CorpusPath = NULL;
+  double MinReduction = -1;  // Off
+  double MaxClipped = -1;
+
+  for (int I = 1; I < Argc; I++) {
+    const char* Value = I + 1 < Argc ? Argv[I + 1] : NULL;
+    if (Argv[I][0] != '-' && !CorpusPath) {
+      CorpusPath = Argv[I];
+      continue;
+    }
+    if (!strcmp(Argv[I], "--no-ns")) {
+      UseNs = false;
+      continue;
+    }
+    if (!strcmp(Argv[I], "--raw")) {
+      Framed = false;
+      continue;
+    }
+    if (Value && !strcmp(Argv[I], "--hangover")) {
+      Hangover = (uint16_t)atoi(Value);
+    } else if (Value && !strcmp(Argv[I], "--lookback") && (uint32_t)atoi(Value) <= DTX_LOOKBACK_MAX) {
+      Lookback = (uint32_t)atoi(Value);
+    } else if (Value && !strcmp(Argv[I], "--min-reduction")) {
+      MinReduction = atof(Value);
+    } else if (Value && !strcmp(Argv[I], "--max-clipped")) {
+      MaxClipped = atof(Value);
+    } else {
+      fputs(USAGE, stderr);
+      return 2;
+    }
+    I++;
+  }
+
+  std::vector<Entry_t> Corpus;
+  if (CorpusPath) {
+    if (!LoadCorpus(CorpusPath, &Corpus)) return 2;
+  } else {
+    Corpus = SyntheticCorpus(I2SGetMicRate());
+  }
+
+  printf("%s messages, hangover %u frames, lookback %u frames, noise suppression %s, KB per clip\n\n",
+    Framed ? "quil1 framed" : "Unframed", Hangover, Lookback, UseNs ? "on" : "off");
+  printf("%-24s  %6s  %5s  %5s  %9s  %9s  %5s  %9s  %9s  %5s  %7s\n", "", "sec", "talk%", "sent%",
+    "pcm full", "pcm dtx", "save%", "adpcm", "adpcm dtx", "save%", "clip%");
+
+  Tally_t Total;
+  memset(&Total, 0, sizeof(Total));
+  bool Labelled = false;
+  for (const Entry_t& Entry : Corpus) {
+    Tally_t T = RunClip(Entry);
+    PrintRow(Entry.Name.c_str(), T, !Entry.Speech.empty());
+    Labelled = Labelled || !Entry.Speech.empty();
+    Total.Frames += T.Frames;
+    Total.Sent += T.Sent;
+    Total.Markers += T.Markers;
+    Total.SpeechFrames += T.SpeechFrames;
+    Total.SpeechWithheld += T.SpeechWithheld;
+    Total.PcmFull += T.PcmFull;
+    Total.PcmDtx += T.PcmDtx;
+    Total.AdpcmFull += T.AdpcmFull;
+    Total.AdpcmDtx += T.AdpcmDtx;
+  }
+  PrintRow("total", Total, Labelled);
+
+  double Reduction = 100.0 - Percent(Total.PcmDtx, Total.PcmFull);
+  double Clipped = Percent(Total.SpeechWithheld, Total.SpeechFrames);
+  printf("\n%llu comfort-noise markers; DTX saves %.1f%% of uplink bytes", (unsigned long long)Total.Markers, Reduction);
+  if (Labelled) printf(" and withholds %.1f%% of speech frames", Clipped);
+  printf("\n");
+
+  bool Ok = true;
+  if (MinReduction >= 0 && Reduction < MinReduction) {
+    printf("FAIL: saving below %.1f%%\n", MinReduction);
+    Ok = false;
+  }
+  if (MaxClipped >= 0 && Labelled && Clipped > MaxClipped) {
+    printf("FAIL: more than %.1f%% of speech withheld\n", MaxClipped);
+    Ok = false;
+  }
+  return Ok ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <chrono>
+
+// --- Host Arduino Shim ---
+// Just enough of the Arduino core for firmware modules that only use
+// Serial, min/max, timing and the heap to build in the tools/ harnesses.
+
+template <typename T> static inline T min(T A, T B) { return B < A ? B : A; }
+template <typename T> static inline T max(T A, T B) { return A < B ? B : A; }
+
+static inline unsigned long micros() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+static inline unsigned long millis() { return micros() / 1000; }
+
+// No PSRAM on the host
+static inline bool psramFound() { return false; }
+static inline void* ps_malloc(size_t Size) { return malloc(Size); }
+
+class HostEsp {
+public:
+  uint32_t getFreeHeap() { return 0; }
+};
+inline HostEsp ESP;
+
+// Serial goes to stderr so tool output on stdout stays clean
+class HostSerial {
+public:
+  int printf(const char* Format, ...) {
+    va_list Args;
+    va_start(Args, Format);
+    int Written = vfprintf(stderr, Format, Args);
+    va_end(Args);
+    return Written;
+  }
+  void print(const char* Text) { fputs(Text, stderr); }
+  void println(const char* Text = "") { fprintf(stderr, "%s\n", Text); }
+};
+inline HostSerial Serial;
@@ -0,0 +1,548 @@
+#include <Arduino.h>
+#include "modules/AudioRingBuffer.h"
+#include "modules/AudioPlayback.h"
+#include "dsp/h/Jitter.h"
+#include "dsp/h/Plc.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+// --- Jitter Buffer Replay ---
+// Replays downlink arrival traces through the playback task's jitter
+// buffer (Jitter target depth, Plc concealment, the task's state machine as
+// in AudioPlayback.cpp) against a simulated DMA queue, and through the
+// fixed 512-sample start it replaced. For every trace it reports start
+// latency, arrival-to-air latency, gaps inside a response and what was
+// concealed. Exits 1 if the jitter buffer loses or invents audio, or with
+// --max-gap-ms when it leaves more gap per minute than allowed.
+//
+// Trace file, one chunk per line ('#' starts a comment):
+//   <arrival ms> <samples>
+// Samples are at the speaker rate. Arrivals more than a second apart
+// start a new response, as Jitter.cpp treats them.
+
+static const char* USAGE =
+  "usage: jitter_replay [trace.txt ...] [options]\n"
+  "  --profile P      DMA profile: low-latency, balanced (default), robust\n"
+  "  --max-gap-ms N   fail if the jitter buffer leaves more than N ms of gap per minute\n";
+
+static const uint32_t RATE = 24000;                    // I2S_SAMPLE_RATE_SPEAKER
+static const int64_t NEW_RESPONSE_US = 1000000;        // As Jitter.cpp
+static const size_t LEGACY_CHUNK = 512;                // The old PlayBufferedAudio
+static const size_t DMA_BUF_LEN_MAX = 1024;            // I2S_DMA_BUF_LEN_MAX
+
+// As I2S.cpp
+static const struct { const char* Name; uint16_t BufCount; uint16_t BufLen; } Profiles[] = {
+  {"low-latency", 4, 240},
+  {"balanced", 4, 480},
+  {"robust", 8, 1024},
+};
+
+typedef struct {
+  int64_t ArrivalUs;
+  uint32_t Samples;
+} Chunk_t;
+
+typedef struct {
+  std::string Name;
+  std::vector<Chunk_t> Chunks;
+} Trace_t;
+
+typedef enum { SEG_AUDIO, SEG_CONCEAL, SEG_SILENCE } SegmentKind_t;
+
+typedef struct {
+  SegmentKind_t Kind;
+  uint32_t Count;
+} Segment_t;
+
+typedef struct {
+  double StartMs;          // First arrival to first sample at the DAC, mean per response
+  double LatencyMs;        // Arrival to air per chunk, mean and max
+  double MaxLatencyMs;
+  uint32_t Gaps;           // Breaks between two samples of one response
+  double GapMs;
+  double ConcealedMs;      // Inside gaps
+  double TailConcealedMs;  // After the last sample of a response
+  uint64_t Received;
+  uint64_t Played;
+  uint32_t Overruns;
+  double Minutes;
+  uint32_t TargetMs;       // Jitter target at the end
+} Result_t;
+
+// --- Simulated DMA and DAC ---
+// The DMA queue holds segments of audio, concealment and padding; each
+// TX_DONE plays one buffer's worth and anything it is short of is a dropout
+typedef struct {
+  std::deque<Segment_t> Queue;
+  uint32_t Queued;
+  uint32_t QueueSamples;
+  uint32_t BufLen;
+  uint32_t Fill;           // Position in the buffer being written
+} Dma_t;
+
+static uint32_t DmaWrite(Dma_t* Dma, SegmentKind_t Kind, uint32_t Count) {
+  uint32_t Written = min(Count, Dma->QueueSamples - Dma->Queued);
+  if (Written == 0) return 0;
+  if (!Dma->Queue.empty() && Dma->Queue.back().Kind == Kind) {
+    Dma->Queue.back().Count += Written;
+  } else {
+    Dma->Queue.push_back({Kind, Written});
+  }
+  Dma->Queued += Written;
+  Dma->Fill = (Dma->Fill + Written) % Dma->BufLen;
+  return Written;
+}
+
+// Follows what reaches the DAC, sample by sample in runs
+typedef struct {
+  std::vector<uint32_t> ChunkStart;    // Running audio index of each chunk's first sample
+  std::vector<uint32_t> ChunkResponse;
+  size_t NextChunk;                    // First chunk not yet on air
+  uint64_t AudioPlayed;
+  int32_t LastResponse;                // Of the last audio sample played, -1 before any
+  uint32_t PendingGap;                 // Non-audio since then
+  uint32_t PendingConceal;
+} Air_t;
+
+static void AirPlay(Air_t* Air, const Trace_t& Trace, Result_t* R, SegmentKind_t Kind, uint32_t Count,
+                    int64_t StartUs, std::vector<double>* Latencies, std::vector<bool>* ResponseStarted) {
+  if (Kind != SEG_AUDIO) {
+    Air->PendingGap += Count;
+    if (Kind == SEG_CONCEAL) Air->PendingConceal += Count;
+    return;
+  }
+  for (uint32_t Done = 0; Done < Count;) {
+    // Run up to the next chunk boundary
+    size_t Chunk = Air->NextChunk;
+    uint32_t Run = Count - Done;
+    if (Chunk < Trace.Chunks.size() && Air->ChunkStart[Chunk] > Air->AudioPlayed) {
+      Run = min(Run, (uint32_t)(Air->ChunkStart[Chunk] - Air->AudioPlayed));
+    }
+    if (Chunk < Trace.Chunks.size() && Air->ChunkStart[Chunk] == Air->AudioPlayed) {
+      int64_t AirUs = StartUs + (int64_t)Done * 1000000 / RATE;
+      double Latency = (AirUs - Trace.Chunks[Chunk].ArrivalUs) / 1000.0;
+      Latencies->push_back(Latency);
+      uint32_t Response = Air->ChunkResponse[Chunk];
+      if (!(*ResponseStarted)[Response]) {
+        (*ResponseStarted)[Response] = true;
+        R->StartMs += Latency;
+      }
+      // A break between two samples of the same response is a gap
+      if (Air->PendingGap > 0 && Air->LastResponse == (int32_t)Response) {
+        R->Gaps++;
+        R->GapMs += Air->PendingGap * 1000.0 / RATE;
+        R->ConcealedMs += Air->PendingConceal * 1000.0 / RATE;
+      } else {
+        R->TailConcealedMs += Air->PendingConceal * 1000.0 / RATE;
+      }
+      Air->PendingGap = 0;
+      Air->PendingConceal = 0;
+      Air->LastResponse = (int32_t)Response;
+      Air->NextChunk++;
+      // Zero-length chunks share the position
+      while (Air->NextChunk < Trace.Chunks.size() && Air->ChunkStart[Air->NextChunk] == Air->AudioPlayed) {
+        Air->NextChunk++;
+      }
+      continue;
+    }
+    Air->AudioPlayed += Run;
+    R->Played += Run;
+    Done += Run;
+  }
+}
+
+// One TX_DONE: the oldest buffer has played
+static void DmaPlayBuffer(Dma_t* Dma, Air_t* Air, const Trace_t& Trace, Result_t* R, int64_t NowUs,
+                          std::vector<double>* Latencies, std::vector<bool>* Started) {
+  int64_t BufferUs = NowUs - (int64_t)Dma->BufLen * 1000000 / RATE;
+  uint32_t Left = Dma->BufLen;
+  while (Left > 0 && !Dma->Queue.empty()) {
+    Segment_t& Front = Dma->Queue.front();
+    uint32_t Take = min(Left, Front.Count);
+    int64_t StartUs = BufferUs + (int64_t)(Dma->BufLen - Left) * 1000000 / RATE;
+    AirPlay(Air, Trace, R, Front.Kind, Take, StartUs, Latencies, Started);
+    Front.Count -= Take;
+    Left -= Take;
+    Dma->Queued -= Take;
+    if (Front.Count == 0) Dma->Queue.pop_front();
+  }
+  // Dropout: the DMA auto-clears to silence
+  if (Left > 0) AirPlay(Air, Trace, R, SEG_SILENCE, Left, 0, Latencies, Started);
+  if (Dma->Queued == 0) Dma->Fill = 0;
+}
+
+// --- Playback strategies ---
+
+typedef enum { PLAYBACK_IDLE, PLAYBACK_PLAYING, PLAYBACK_STARVED } PlaybackState_t;
+
+// The playback task, as AudioPlayback.cpp, on simulated time
+typedef struct {
+  AudioRingBuffer Ring;
+  Jitter_t Jitter;
+  Plc_t Plc;
+  PlaybackState_t State;
+  bool GapOpen;
+  int64_t StarvedSinceUs;
+  int64_t LastArrivalUs;
+  uint32_t TargetSamples;
+  uint32_t Underruns, SeenUnderruns;
+  int16_t Scratch[DMA_BUF_LEN_MAX];
+} Adaptive_t;
+
+static void AdaptiveArrival(Adaptive_t* A, const int16_t* Samples, uint32_t Count, int64_t ArrivalUs, Result_t* R) {
+  if (!A->Ring.write(Samples, Count)) R->Overruns++;
+  if (A->Underruns != A->SeenUnderruns) {
+    JitterOnUnderrun(&A->Jitter);
+    A->SeenUnderruns = A->Underruns;
+  }
+  JitterOnArrival(&A->Jitter, ArrivalUs, (uint32_t)((uint64_t)Count * 1000000 / RATE));
+  A->TargetSamples = (uint32_t)((uint64_t)JitterTargetUs(&A->Jitter) * RATE / 1000000);
+  A->LastArrivalUs = ArrivalUs;
+}
+
+static void PadDma(Dma_t* Dma) {
+  if (Dma->Fill != 0) DmaWrite(Dma, SEG_SILENCE, Dma->BufLen - Dma->Fill);
+}
+
+static void AdaptiveTopUp(Adaptive_t* A, Dma_t* Dma, int64_t NowUs) {
+  for (;;) {
+    size_t Contiguous = 0;
+    const int16_t* Samples = A->Ring.peek(&Contiguous);
+    if (Contiguous == 0) {
+      A->State = PLAYBACK_STARVED;
+      A->StarvedSinceUs = NowUs;
+      return;
+    }
+    if (A->Plc.Resume || A->Plc.FadeIn > 0) {
+      Contiguous = min(Contiguous, (size_t)PLC_RESUME_SAMPLES);
+      memcpy(A->Scratch, Samples, Contiguous * sizeof(int16_t));
+      PlcResume(&A->Plc, A->Scratch, Contiguous);
+      Samples = A->Scratch;
+    }
+    uint32_t Written = DmaWrite(Dma, SEG_AUDIO, (uint32_t)Contiguous);
+    PlcRemember(&A->Plc, Samples, Written);
+    A->Ring.consume(Written);
+    if (Written < Contiguous) return;
+  }
+}
+
+static void AdaptiveConcealIfDry(Adaptive_t* A, Dma_t* Dma, bool Quiet) {
+  if ((int32_t)Dma->Queued - (int32_t)Dma->Fill > (int32_t)Dma->BufLen) return;
+  if (Quiet) {
+    PadDma(Dma);
+    return;
+  }
+  if (!A->GapOpen) {
+    A->GapOpen = true;
+    A->Underruns++;
+  }
+  size_t Want = Dma->BufLen - Dma->Fill;
+  size_t Made = PlcConceal(&A->Plc, A->Scratch, Want);
+  DmaWrite(Dma, SEG_CONCEAL, (uint32_t)Made);
+  if (Made < Want) PadDma(Dma);
+}
+
+static void AdaptiveEvent(Adaptive_t* A, Dma_t* Dma, int64_t NowUs) {
+  size_t Buffered = A->Ring.available();
+  bool Quiet = NowUs - A->LastArrivalUs >= AUDIO_PLAYBACK_FLUSH_MS * 1000;
+  bool Ready = Buffered > 0 && (Buffered >= A->TargetSamples || Quiet);
+
+  if (A->State == PLAYBACK_STARVED) {
+    if (Buffered > 0 && (!A->GapOpen || Ready)) {
+      A->GapOpen = false;
+      A->State = PLAYBACK_PLAYING;
+    } else if (NowUs - A->StarvedSinceUs > AUDIO_PLAYBACK_STARVE_MS * 1000) {
+      PadDma(Dma);
+      A->GapOpen = false;
+      A->State = PLAYBACK_IDLE;
+    } else {
+      AdaptiveConcealIfDry(A, Dma, Quiet);
+    }
+  } else if (A->State == PLAYBACK_IDLE && Ready) {
+    A->State = PLAYBACK_PLAYING;
+  }
+  if (A->State == PLAYBACK_PLAYING) AdaptiveTopUp(A, Dma, NowUs);
+}
+
+// The loop() code it replaced: 512 samples at a time whenever there are
+// 512, nothing otherwise
+static void LegacyEvent(AudioRingBuffer* Ring, Dma_t* Dma) {
+  while (Ring->available() >= LEGACY_CHUNK && Dma->QueueSamples - Dma->Queued >= LEGACY_CHUNK) {
+    Ring->consume(LEGACY_CHUNK);
+    DmaWrite(Dma, SEG_AUDIO, LEGACY_CHUNK);
+  }
+}
+
+// A vowel-like test signal so the concealment has a pitch to find
+static void FillVoice(int16_t* Out, uint32_t Count, uint64_t* Phase) {
+  for (uint32_t I = 0; I < Count; I++, (*Phase)++) {
+    double T = (double)*Phase / RATE;
+    double V = sin(2 * M_PI * 140 * T) + 0.5 * sin(2 * M_PI * 280 * T) + 0.3 * sin(2 * M_PI * 700 * T);
+    Out[I] = (int16_t)(V * 6000 * (0.75 + 0.25 * sin(2 * M_PI * 3 * T)));
+  }
+}
+
+static Result_t Replay(const Trace_t& Trace, uint32_t BufCount, uint32_t BufLen, bool Adaptive) {
+  Result_t R;
+  memset(&R, 0, sizeof(R));
+
+  Dma_t Dma;
+  Dma.Queued = 0;
+  Dma.QueueSamples = BufCount * BufLen;
+  Dma.BufLen = BufLen;
+  Dma.Fill = 0;
+
+  Air_t Air;
+  Air.NextChunk = 0;
+  Air.AudioPlayed = 0;
+  Air.LastResponse = -1;
+  Air.PendingGap = 0;
+  Air.PendingConceal = 0;
+  uint32_t Responses = 0;
+  uint64_t Position = 0;
+  for (size_t I = 0; I < Trace.Chunks.size(); I++) {
+    if (I > 0 && Trace.Chunks[I].ArrivalUs - Trace.Chunks[I - 1].ArrivalUs > NEW_RESPONSE_US) Responses++;
+    Air.ChunkStart.push_back((uint32_t)Position);
+    Air.ChunkResponse.push_back(Responses);
+    Position += Trace.Chunks[I].Samples;
+    R.Received += Trace.Chunks[I].Samples;
+  }
+  std::vector<bool> Started(Responses + 1, false);
+  std::vector<double> Latencies;
+
+  static Adaptive_t A;
+  if (A.Ring.size() == 0) A.Ring.init(AUDIO_PLAYBACK_BUFFER_SAMPLES);
+  A.Ring.clear();
+  JitterInit(&A.Jitter, AUDIO_PLAYBACK_PREBUFFER_MS * 1000, AUDIO_PLAYBACK_MAX_TARGET_MS * 1000);
+  PlcInit(&A.Plc);
+  A.State = PLAYBACK_IDLE;
+  A.GapOpen = false;
+  A.StarvedSinceUs = 0;
+  A.LastArrivalUs = INT64_MIN / 2;
+  A.TargetSamples = (uint32_t)((uint64_t)JitterTargetUs(&A.Jitter) * RATE / 1000000);
+  A.Underruns = A.SeenUnderruns = 0;
+
+  std::vector<int16_t> Samples;
+  uint64_t Phase = 0;
+  int64_t PeriodUs = (int64_t)BufLen * 1000000 / RATE;
+  int64_t NowUs = Trace.Chunks.empty() ? 0 : Trace.Chunks[0].ArrivalUs;
+  size_t Next = 0;
+  // Run until everything has played out (the legacy path can strand a
+  // partial chunk, so stop when nothing moves for a while after the end)
+  int64_t EndUs = Trace.Chunks.empty() ? 0 : Trace.Chunks.back().ArrivalUs;
+  for (;;) {
+    NowUs += PeriodUs;
+    DmaPlayBuffer(&Dma, &Air, Trace, &R, NowUs, &Latencies, &Started);
+
+    while (Next < Trace.Chunks.size() && Trace.Chunks[Next].ArrivalUs <= NowUs) {
+      const Chunk_t& Chunk = Trace.Chunks[Next++];
+      Samples.resize(Chunk.Samples);
+      FillVoice(Samples.data(), Chunk.Samples, &Phase);
+      if (Adaptive) {
+        AdaptiveArrival(&A, Samples.data(), Chunk.Samples, Chunk.ArrivalUs, &R);
+      } else if (!A.Ring.write(Samples.data(), Chunk.Samples)) {
+        R.Overruns++;
+      }
+    }
+
+    if (Adaptive) {
+      AdaptiveEvent(&A, &Dma, NowUs);
+    } else {
+      LegacyEvent(&A.Ring, &Dma);
+    }
+
+    bool Drained = Dma.Queued == 0 && (A.Ring.available() == 0 || !Adaptive);
+    if (Next == Trace.Chunks.size() && Drained && NowUs > EndUs + 1000000) break;
+  }
+
+  R.TailConcealedMs += Air.PendingConceal * 1000.0 / RATE;
+  R.StartMs /= Started.size();
+  double Sum = 0;
+  for (double L : Latencies) {
+    Sum += L;
+    if (L > R.MaxLatencyMs) R.MaxLatencyMs = L;
+  }
+  R.LatencyMs = Latencies.empty() ? 0 : Sum / Latencies.size();
+  R.Minutes = R.Received / (RATE * 60.0);
+  R.TargetMs = Adaptive ? JitterTargetUs(&A.Jitter) / 1000 : 0;
+  return R;
+}
+
+// --- Traces ---
+
+static double Uniform(uint32_t* Seed) {
+  *Seed = *Seed * 1664525u + 1013904223u;
+  return (*Seed >> 8) / 16777216.0;
+}
+
+typedef double (*Delay_t)(size_t Index, uint32_t* Seed, double* State);
+
+// Responses of 6, 10 and 4 s two seconds apart, in ChunkMs chunks sent in
+// real time; Delay gives each chunk's network delay in ms. TCP delivers in
+// order, so a late chunk holds up the ones behind it.
+static Trace_t Synthetic(const char* Name, double ChunkMs, Delay_t Delay, uint32_t Seed) {
+  Trace_t Trace;
+  Trace.Name = Name;
+  static const double Lengths[] = {6.0, 10.0, 4.0};
+  double StartMs = 0, State = 0;
+  int64_t Previous = 0;
+  size_t Index = 0;
+  for (double Length : Lengths) {
+    for (double Sent = 0; Sent < Length * 1000; Sent += ChunkMs, Index++) {
+      int64_t ArrivalUs = (int64_t)((StartMs + Sent + Delay(Index, &Seed, &State)) * 1000);
+      if (ArrivalUs < Previous) ArrivalUs = Previous;
+      Trace.Chunks.push_back({ArrivalUs, (uint32_t)(ChunkMs * RATE / 1000)});
+      Previous = ArrivalUs;
+    }
+    StartMs += Length * 1000 + 2000;
+  }
+  return Trace;
+}
+
+static double SteadyDelay(size_t, uint32_t* Seed, double*) {
+  return 5 + 3 * Uniform(Seed);
+}
+
+// Wi-Fi: exponential jitter around 10 ms with the odd 60-120 ms spike
+static double WifiDelay(size_t, uint32_t* Seed, double*) {
+  double D = 5 - 10 * log(1 - Uniform(Seed));
+  if (Uniform(Seed) < 0.03) D += 60 + 60 * Uniform(Seed);
+  return D;
+}
+
+// A 300 ms stall (retransmission) every 4 s, the backlog then arrives at once
+static double StallDelay(size_t Index, uint32_t* Seed, double*) {
+  return 5 + 2 * Uniform(Seed) + (Index % 40 == 20 ? 300 : 0);
+}
+
+// Congestion: a delay that wanders between 0 and 150 ms
+static double CongestedDelay(size_t, uint32_t* Seed, double* State) {
+  *State += (Uniform(Seed) - 0.5) * 20;
+  if (*State < 0) *State = 0;
+  if (*State > 150) *State = 150;
+  return 5 + *State;
+}
+
+static std::vector<Trace_t> SyntheticTraces() {
+  return {
+    Synthetic("steady, 20 ms chunks", 20, SteadyDelay, 1),
+    Synthetic("wi-fi jitter, 20 ms chunks", 20, WifiDelay, 2),
+    Synthetic("stalls, 100 ms chunks", 100, StallDelay, 3),
+    Synthetic("congested, 40 ms chunks", 40, CongestedDelay, 4),
+  };
+}
+
+static bool LoadTrace(const char* Path, Trace_t* Trace) {
+  FILE* File = fopen(Path, "r");
+  if (!File) {
+    fprintf(stderr, "[JitterReplay] %s: cannot open\n", Path);
+    return false;
+  }
+  Trace->Name = Path;
+  char Line[256];
+  int LineNo = 0;
+  bool Ok = true;
+  int64_t Previous = INT64_MIN;
+  while (fgets(Line, sizeof(Line), File)) {
+    LineNo++;
+    char* Comment = strchr(Line, '#');
+    if (Comment) *Comment = 0;
+    double Ms;
+    long Samples;
+    char Extra;
+    int Fields = sscanf(Line, "%lf %ld %c", &Ms, &Samples, &Extra);
+    if (Fields <= 0) continue;
+    int64_t ArrivalUs = (int64_t)(Ms * 1000);
+    if (Fields != 2 || Samples < 0 || ArrivalUs < Previous) {
+      fprintf(stderr, "[JitterReplay] %s:%d: expected <arrival ms> <samples>, in arrival order\n", Path, LineNo);
+      Ok = false;
+      break;
+    }
+    Trace->Chunks.push_back({ArrivalUs, (uint32_t)Samples});
+    Previous = ArrivalUs;
+  }
+  fclose(File);
+  if (Ok && Trace->Chunks.empty()) {
+    fprintf(stderr, "[JitterReplay] %s: no chunks\n", Path);
+    Ok = false;
+  }
+  return Ok;
+}
+
+static void PrintRow(const char* Name, const Result_t& R) {
+  printf("%-28.28s  %7.0f  %6.0f/%-6.0f  %4u  %8.0f  %9.0f  %6.0f  %6u\n", Name, R.StartMs, R.LatencyMs,
+    R.MaxLatencyMs, R.Gaps, R.GapMs / R.Minutes, R.ConcealedMs, R.TailConcealedMs, R.TargetMs);
+}
+
+int main(int Argc, char** Argv) {
+  std::vector<const char*> Paths;
+  int Profile = 1;
+  double MaxGapMs = -1;  // Off
+
+  for (int I = 1; I < Argc; I++) {
+    const char* Value = I + 1 < Argc ? Argv[I + 1] : NULL;
+    if (Argv[I][0] != '-') {
+      Paths.push_back(Argv[I]);
+      continue;
+    }
+    if (Value && !strcmp(Argv[I], "--profile")) {
+      Profile = -1;
+      for (int P = 0; P < (int)(sizeof(Profiles) / sizeof(Profiles[0])); P++) {
+        if (!strcmp(Value, Profiles[P].Name)) Profile = P;
+      }
+      if (Profile < 0) {
+        fputs(USAGE, stderr);
+        return 2;
+      }
+    } else if (Value && !strcmp(Argv[I], "--max-gap-ms")) {
+      MaxGapMs = atof(Value);
+    } else {
+      fputs(USAGE, stderr);
+      return 2;
+    }
+    I++;
+  }
+
+  std::vector<Trace_t> Traces;
+  if (Paths.empty()) {
+    Traces = SyntheticTraces();
+  } else {
+    for (const char* Path : Paths) {
+      Trace_t Trace;
+      if (!LoadTrace(Path, &Trace)) return 2;
+      Traces.push_back(Trace);
+    }
+  }
+
+  printf("%s DMA (%u x %u), prebuffer %u ms, target up to %u ms\n\n", Profiles[Profile].Name,
+    Profiles[Profile].BufCount, Profiles[Profile].BufLen, AUDIO_PLAYBACK_PREBUFFER_MS, AUDIO_PLAYBACK_MAX_TARGET_MS);
+  printf("%-28s  %7s  %13s  %4s  %8s  %9s  %6s  %6s\n", "", "start", "latency", "gaps", "gap/min",
+    "concealed", "tail", "target");
+
+  bool Ok = true;
+  for (const Trace_t& Trace : Traces) {
+    Result_t Legacy = Replay(Trace, Profiles[Profile].BufCount, Profiles[Profile].BufLen, false);
+    Result_t Adaptive = Replay(Trace, Profiles[Profile].BufCount, Profiles[Profile].BufLen, true);
+    printf("%s\n", Trace.Name.c_str());
+    PrintRow("  512-sample start", Legacy);
+    PrintRow("  jitter buffer", Adaptive);
+    if (Adaptive.Played != Adaptive.Received || Adaptive.Overruns > 0) {
+      printf("FAIL: %s played %llu of %llu samples (%u overruns)\n", Trace.Name.c_str(),
+        (unsigned long long)Adaptive.Played, (unsigned long long)Adaptive.Received, Adaptive.Overruns);
+      Ok = false;
+    }
+    if (MaxGapMs >= 0 && Adaptive.GapMs / Adaptive.Minutes > MaxGapMs) {
+      printf("FAIL: %s leaves %.0f ms of gap per minute\n", Trace.Name.c_str(), Adaptive.GapMs / Adaptive.Minutes);
+      Ok = false;
+    }
+  }
+  printf("\nstart: first arrival to the DAC, ms (mean per response)\n");
+  printf("latency: arrival to the DAC per chunk, mean/max ms\n");
+  printf("gaps: silence or concealment between two samples of a response; concealed and tail in ms\n");
+  return Ok ? 0 : 1;
+}
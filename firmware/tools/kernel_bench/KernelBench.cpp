@@ -0,0 +1,56 @@
+#include "dsp/h/DspBench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- Kernel Benchmark ---
+// Host run of DspBenchKernels, the same comparison the firmware prints at
+// boot with -DAUDIO_KERNEL_BENCH, plus the noise suppressor's cost per
+// frame. Costs are ns per frame here, so only the ratios carry over to the
+// ESP32. Exits 1 if a kernel's output drifts from the loop it replaced.
+
+static const char* USAGE =
+  "usage: kernel_bench [--frame N] [--runs N]\n"
+  "  --frame N  samples per frame (default 480, one 20 ms frame; max 2048)\n"
+  "  --runs N   frames per kernel (default 20000)\n";
+
+int main(int Argc, char** Argv) {
+  size_t Frame = 480;
+  int Runs = 20000;
+
+  for (int I = 1; I < Argc; I++) {
+    const char* Value = I + 1 < Argc ? Argv[I + 1] : NULL;
+    if (Value && !strcmp(Argv[I], "--frame")) {
+      Frame = (size_t)atol(Value);
+    } else if (Value && !strcmp(Argv[I], "--runs")) {
+      Runs = atoi(Value);
+    } else {
+      fputs(USAGE, stderr);
+      return 2;
+    }
+    I++;
+  }
+  if (Frame == 0 || Frame > DSP_BENCH_MAX_FRAME || Runs < 1) {
+    fputs(USAGE, stderr);
+    return 2;
+  }
+
+  // One untimed pass to warm the caches
+  DspBenchResult_t Results[DSP_BENCH_COUNT];
+  DspBenchKernels(Frame, 100, Results);
+  DspBenchKernels(Frame, Runs, Results);
+
+  printf("%zu-sample frames, %d runs\n\n", Frame, Runs);
+  printf("%-18s  before ns  after ns  speedup  output\n", "");
+  bool Ok = true;
+  for (int K = 0; K < DSP_BENCH_COUNT; K++) {
+    const DspBenchResult_t& R = Results[K];
+    printf("%-18s  %9u  %8u  %6.1fx  %s\n", R.Name, R.Before, R.After,
+      R.After ? (double)R.Before / R.After : 0.0, R.Match ? "match" : "MISMATCH");
+    Ok = Ok && R.Match;
+  }
+
+  uint32_t Ns = DspBenchNoiseSuppressor(Frame, Runs / 10 + 1);
+  if (Ns) printf("\nNoise suppressor  %u ns per frame\n", Ns);
+  return Ok ? 0 : 1;
+}
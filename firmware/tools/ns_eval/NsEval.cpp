@@ -0,0 +1,334 @@
+#include "HostI2S.h"
+#include "dsp/h/NoiseSuppressor.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// --- Noise Suppressor Evaluation ---
+// Mixes clean speech with noise at several SNRs and runs the mixture
+// through the noise suppressor one 20 ms frame at a time, as SendMicFrame
+// does (the output is realigned for the suppressor's half-frame lag).
+// Scoring follows ITU-T G.160: the speech level is what the labelled
+// speech adds over the noise-alone level, and SNR is that over the
+// noise-alone level, before and after. The SNR gain is the difference;
+// speech dB is how much the speech itself lost and noise dB how far noise
+// alone was cut, which the NS_MAX_ATTENUATION_DB floor bounds.
+// Exits 1 if a row gains less than --min-gain, loses more speech than
+// --max-speech-loss, cuts noise alone by less than --min-cut or past the
+// floor. ns/frame is host time, not ESP32 cycles.
+// Without a corpus, synthetic speech (syllable bursts between pauses at
+// the raw INMP441 level) is mixed with white hiss and fan noise.
+//
+// Corpus file, one pair per line (paths relative to the corpus file):
+//   <speech.wav> <noise.wav> start end [start end]...
+// speech.wav is clean; noise.wav is looped to its length. Each start/end
+// pair (seconds) marks speech; the rest of the clip counts as noise alone.
+
+static const char* USAGE =
+  "usage: ns_eval [corpus.txt] [options]\n"
+  "  --min-gain DB         fail if a row's SNR gain is below DB (default 6)\n"
+  "  --min-cut DB          fail if noise alone is cut by less than DB (default 8)\n"
+  "  --max-speech-loss DB  fail if speech drops by more than DB (default 5)\n"
+  "  --warmup S            seconds before scoring, for the noise estimate (default 1)\n";
+
+static const double SNRS[] = {0.0, 5.0, 10.0, 20.0};
+static const double FLOOR_SLACK_DB = 1.0;  // Window edges and rounding
+
+typedef struct {
+  std::string Name;
+  std::vector<int16_t> Speech;
+  std::vector<int16_t> Noise;
+  std::vector<std::pair<double, double>> Windows;
+} Entry_t;
+
+typedef struct {
+  double SnrIn, SnrOut;     // Labelled speech over noise alone, dB
+  double SpeechDb;          // Speech level change
+  double NoiseCutDb;        // Noise alone, input over output power
+  double NsPerFrame;
+} Result_t;
+
+static double WarmupSec = 1.0;
+
+static double Uniform(uint32_t* Seed) {
+  *Seed = *Seed * 1664525u + 1013904223u;
+  return ((int32_t)(*Seed >> 16) - 32768) / 32768.0;
+}
+
+// One syllable as in dtx_eval: a pitch pulse train through two formant
+// resonators, or noise through the upper one for unvoiced sounds
+static void AddSyllable(std::vector<double>* Out, size_t Start, size_t Length, uint32_t Rate, uint32_t* Seed, double Peak) {
+  const double Pi = 3.14159265358979;
+  static const double Formants[][2] = {{700, 1200}, {400, 2000}, {300, 2300}, {600, 900}, {500, 1700}};
+  *Seed = *Seed * 1664525u + 1013904223u;
+  const double* F = Formants[(*Seed >> 8) % 5];
+  bool Voiced = ((*Seed >> 16) & 3) != 0;
+  double Pitch = 90 + ((*Seed >> 20) % 160);
+
+  double State[2][2] = {{0, 0}, {0, 0}};
+  for (size_t I = 0; I < Length && Start + I < Out->size(); I++) {
+    double Excite = Voiced ? (fmod(I * Pitch / Rate, 1.0) < Pitch / Rate ? 1.0 : 0.0) : Uniform(Seed) * 0.05;
+    double Y = 0;
+    for (int K = Voiced ? 0 : 1; K < 2; K++) {
+      double R = 0.97, Theta = 2 * Pi * F[K] / Rate;
+      double V = Excite + 2 * R * cos(Theta) * State[K][0] - R * R * State[K][1];
+      State[K][1] = State[K][0];
+      State[K][0] = V;
+      Y += V;
+    }
+    double Envelope = 0.5 - 0.5 * cos(2 * Pi * I / Length);
+    (*Out)[Start + I] += Y * Envelope * Peak * 0.02;
+  }
+}
+
+static std::vector<int16_t> ToPcm(const std::vector<double>& Samples) {
+  std::vector<int16_t> Pcm(Samples.size());
+  for (size_t I = 0; I < Samples.size(); I++) {
+    double Value = Samples[I];
+    Pcm[I] = (int16_t)(Value > 32767 ? 32767 : Value < -32768 ? -32768 : lround(Value));
+  }
+  return Pcm;
+}
+
+// 20 s of talk at 1 m and the raw INMP441 level (speech RMS ~33), over
+// white hiss and over fan noise tilted towards the lows
+static std::vector<Entry_t> SyntheticCorpus(uint32_t Rate) {
+  std::vector<double> Speech(Rate * 20, 0.0);
+  std::vector<std::pair<double, double>> Windows;
+  uint32_t Seed = 2024;
+  double T = 1.5;
+  while (T < 17.0) {
+    double Length = 1.5 + (Uniform(&Seed) + 1.0) * 1.0;
+    double Pos = T;
+    while (Pos < T + Length) {
+      int Syllables = 2 + (int)((Uniform(&Seed) + 1.0) * 1.5);
+      for (int K = 0; K < Syllables && Pos < T + Length; K++) {
+        double Syllable = 0.15 + (Uniform(&Seed) + 1.0) * 0.075;
+        AddSyllable(&Speech, (size_t)(Pos * Rate), (size_t)(Syllable * Rate), Rate, &Seed, 1430);
+        Pos += Syllable + 0.02;
+      }
+      Pos += 0.05 + (Uniform(&Seed) + 1.0) * 0.05;
+    }
+    Windows.push_back({T, Pos});
+    T = Pos + 1.0 + (Uniform(&Seed) + 1.0) * 0.5;
+  }
+
+  static const struct { const char* Name; double Tilt; } Noises[] = {
+    {"white hiss", 0.0},
+    {"fan", 0.9},
+  };
+  std::vector<Entry_t> Corpus;
+  for (const auto& Kind : Noises) {
+    Entry_t Entry;
+    Entry.Name = Kind.Name;
+    Entry.Speech = ToPcm(Speech);
+    Entry.Windows = Windows;
+    std::vector<double> Noise(Speech.size());
+    double Low = 0;
+    for (size_t I = 0; I < Noise.size(); I++) {
+      Low = Kind.Tilt * Low + Uniform(&Seed) * 1.732;
+      Noise[I] = Low * 1000.0;
+    }
+    Entry.Noise = ToPcm(Noise);
+    Corpus.push_back(Entry);
+  }
+  return Corpus;
+}
+
+static bool LoadCorpus(const char* Path, std::vector<Entry_t>* Corpus) {
+  FILE* File = fopen(Path, "r");
+  if (!File) {
+    fprintf(stderr, "[NsEval] %s: cannot open\n", Path);
+    return false;
+  }
+  std::string Dir(Path);
+  size_t Slash = Dir.find_last_of('/');
+  Dir = Slash == std::string::npos ? "" : Dir.substr(0, Slash + 1);
+
+  char Line[4096];
+  int LineNo = 0;
+  bool Ok = true;
+  while (fgets(Line, sizeof(Line), File)) {
+    LineNo++;
+    char Speech[768], Noise[768];
+    int Used;
+    if (Line[0] == '#' || sscanf(Line, "%767s%n", Speech, &Used) != 1) continue;
+    const char* Rest = Line + Used;
+    if (sscanf(Rest, "%767s%n", Noise, &Used) != 1) {
+      fprintf(stderr, "[NsEval] %s:%d: expected <speech.wav> <noise.wav> start end [start end]...\n", Path, LineNo);
+      Ok = false;
+      continue;
+    }
+    Rest += Used;
+    Entry_t Entry;
+    Entry.Name = Speech;
+    double Start, End;
+    int More;
+    while (sscanf(Rest, "%lf %lf%n", &Start, &End, &More) == 2) {
+      Entry.Windows.push_back({Start, End});
+      Rest += More;
+    }
+    if (Entry.Windows.empty() || sscanf(Rest, " %*s") != EOF) {
+      fprintf(stderr, "[NsEval] %s:%d: expected <speech.wav> <noise.wav> start end [start end]...\n", Path, LineNo);
+      Ok = false;
+      continue;
+    }
+    HostClip_t SpeechClip, NoiseClip;
+    std::string SpeechPath = Speech[0] == '/' ? std::string(Speech) : Dir + Speech;
+    std::string NoisePath = Noise[0] == '/' ? std::string(Noise) : Dir + Noise;
+    if (!HostI2SLoad(SpeechPath.c_str(), &SpeechClip) || !HostI2SLoad(NoisePath.c_str(), &NoiseClip) ||
+        NoiseClip.Samples.empty()) {
+      Ok = false;
+      continue;
+    }
+    Entry.Speech = SpeechClip.Samples;
+    Entry.Noise.resize(Entry.Speech.size());
+    for (size_t I = 0; I < Entry.Noise.size(); I++) Entry.Noise[I] = NoiseClip.Samples[I % NoiseClip.Samples.size()];
+    Corpus->push_back(Entry);
+  }
+  fclose(File);
+  return Ok && !Corpus->empty();
+}
+
+static double Db(double Ratio) {
+  return 10.0 * log10(Ratio > 1e-12 ? Ratio : 1e-12);
+}
+
+// Mix at SnrDb (speech over noise, both over the labelled speech), run the
+// suppressor and score
+static Result_t RunMix(const Entry_t& Entry, double SnrDb) {
+  uint32_t Rate = I2SGetMicRate();
+  size_t FrameSamples = Rate * AUDIO_FRAME_MS / 1000;
+  size_t Lag = FrameSamples / 2;
+  size_t Warmup = (size_t)(WarmupSec * Rate);
+
+  // Labelled speech after the warm-up, and the noise-only stretches
+  std::vector<char> IsSpeech(Entry.Speech.size(), 0);
+  for (const auto& Window : Entry.Windows) {
+    for (size_t I = (size_t)(Window.first * Rate); I < (size_t)(Window.second * Rate) && I < IsSpeech.size(); I++) {
+      IsSpeech[I] = 1;
+    }
+  }
+  double SpeechPower = 0, NoisePower = 0;
+  for (size_t I = Warmup; I < IsSpeech.size(); I++) {
+    if (!IsSpeech[I]) continue;
+    SpeechPower += (double)Entry.Speech[I] * Entry.Speech[I];
+    NoisePower += (double)Entry.Noise[I] * Entry.Noise[I];
+  }
+  double Scale = NoisePower > 0 ? sqrt(SpeechPower / NoisePower / pow(10.0, SnrDb / 10.0)) : 0.0;
+
+  std::vector<int16_t> Noise(Entry.Noise.size());
+  std::vector<int16_t> Mix(Entry.Speech.size());
+  for (size_t I = 0; I < Mix.size(); I++) {
+    double N = Entry.Noise[I] * Scale;
+    Noise[I] = (int16_t)(N > 32767 ? 32767 : N < -32768 ? -32768 : lround(N));
+    int32_t M = Entry.Speech[I] + Noise[I];
+    Mix[I] = (int16_t)(M > 32767 ? 32767 : M < -32768 ? -32768 : M);
+  }
+
+  static Ns_t Ns;
+  NsInit(&Ns, FrameSamples);
+  std::vector<int16_t> Output = Mix;
+  size_t Frames = Output.size() / FrameSamples;
+  uint32_t Start = DspCycles();
+  for (size_t F = 0; F < Frames; F++) NsProcess(&Ns, Output.data() + F * FrameSamples);
+  uint32_t Elapsed = DspCycles() - Start;
+
+  // Output sample I + Lag belongs to input sample I. As in ITU-T G.160,
+  // speech power is what the labelled speech adds over the noise-alone level
+  double SpeechIn = 0, SpeechOut = 0, NoiseIn = 0, NoiseOut = 0;
+  size_t SpeechCount = 0, NoiseCount = 0;
+  for (size_t I = Warmup; I + Lag < Frames * FrameSamples; I++) {
+    double In = Mix[I];
+    double Out = Output[I + Lag];
+    if (IsSpeech[I]) {
+      SpeechIn += In * In;
+      SpeechOut += Out * Out;
+      SpeechCount++;
+    } else {
+      NoiseIn += In * In;
+      NoiseOut += Out * Out;
+      NoiseCount++;
+    }
+  }
+  SpeechIn /= SpeechCount ? SpeechCount : 1;
+  SpeechOut /= SpeechCount ? SpeechCount : 1;
+  NoiseIn /= NoiseCount ? NoiseCount : 1;
+  NoiseOut /= NoiseCount ? NoiseCount : 1;
+
+  Result_t Result;
+  Result.SnrIn = Db((SpeechIn - NoiseIn) / NoiseIn);
+  Result.SnrOut = Db((SpeechOut - NoiseOut) / NoiseOut);
+  Result.SpeechDb = Db((SpeechOut - NoiseOut) / (SpeechIn - NoiseIn));
+  Result.NoiseCutDb = Db(NoiseIn / NoiseOut);
+  Result.NsPerFrame = Frames ? (double)Elapsed / Frames : 0.0;
+  return Result;
+}
+
+int main(int Argc, char** Argv) {
+  const char* CorpusPath = NULL;
+  double MinGain = 6.0;
+  double MinCut = 8.0;
+  double MaxSpeechLoss = 5.0;
+
+  for (int I = 1; I < Argc; I++) {
+    const char* Value = I + 1 < Argc ? Argv[I + 1] : NULL;
+    if (Argv[I][0] != '-' && !CorpusPath) {
+      CorpusPath = Argv[I];
+      continue;
+    }
+    if (Value && !strcmp(Argv[I], "--min-gain")) {
+      MinGain = atof(Value);
+    } else if (Value && !strcmp(Argv[I], "--min-cut")) {
+      MinCut = atof(Value);
+    } else if (Value && !strcmp(Argv[I], "--max-speech-loss")) {
+      MaxSpeechLoss = atof(Value);
+    } else if (Value && !strcmp(Argv[I], "--warmup")) {
+      WarmupSec = atof(Value);
+    } else {
+      fputs(USAGE, stderr);
+      return 2;
+    }
+    I++;
+  }
+  if (WarmupSec < 0) {
+    fputs(USAGE, stderr);
+    return 2;
+  }
+
+  std::vector<Entry_t> Corpus;
+  if (CorpusPath) {
+    if (!LoadCorpus(CorpusPath, &Corpus)) return 2;
+  } else {
+    Corpus = SyntheticCorpus(I2SGetMicRate());
+  }
+
+  printf("Floor %d dB, warm-up %.1f s\n\n", NS_MAX_ATTENUATION_DB, WarmupSec);
+  printf("%-20s  %6s  %7s  %7s  %9s  %8s  %8s\n", "", "snr in", "snr out", "gain dB", "speech dB", "noise dB",
+    "ns/frame");
+
+  bool Ok = true;
+  for (const Entry_t& Entry : Corpus) {
+    for (double Snr : SNRS) {
+      Result_t R = RunMix(Entry, Snr);
+      double Gain = R.SnrOut - R.SnrIn;
+      const char* Verdict = "ok";
+      if (R.NoiseCutDb > NS_MAX_ATTENUATION_DB + FLOOR_SLACK_DB) {
+        Verdict = "FAIL: past floor";
+      } else if (R.NoiseCutDb < MinCut) {
+        Verdict = "FAIL: noise kept";
+      } else if (-R.SpeechDb > MaxSpeechLoss) {
+        Verdict = "FAIL: speech cut";
+      } else if (Gain < MinGain) {
+        Verdict = "FAIL: gain";
+      }
+      printf("%-20.20s  %6.1f  %7.1f  %7.1f  %9.1f  %8.1f  %8.0f  %s\n", Entry.Name.c_str(), R.SnrIn, R.SnrOut, Gain,
+        R.SpeechDb, -R.NoiseCutDb, R.NsPerFrame, Verdict);
+      Ok = Ok && !strcmp(Verdict, "ok");
+    }
+  }
+  return Ok ? 0 : 1;
+}
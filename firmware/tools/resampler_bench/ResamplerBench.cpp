@@ -0,0 +1,189 @@
+#include "dsp/h/Resampler.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// --- Resampler Benchmark ---
+// Runs the downlink and uplink rate pairs through the resampler in 20 ms
+// blocks. Tones across the passband are fitted (sine, cosine and DC at the
+// exact frequency) on the output; whatever the fit leaves is distortion,
+// imaging and quantisation, reported as SNR. Down-conversions also get a
+// tone above the output Nyquist to measure how far its alias is rejected.
+// Costs are ns per output sample here, not ESP32 cycles. Exits 1 if any
+// pair falls below --min-snr.
+
+static const char* USAGE =
+  "usage: resampler_bench [--seconds S] [--min-snr DB] [--in HZ --out HZ]\n"
+  "  --seconds S   audio per tone (default 2)\n"
+  "  --min-snr DB  worst passband SNR accepted (default 60)\n"
+  "  --in/--out    one rate pair instead of the built-in list (max 65535)\n";
+
+static const double AMPLITUDE = 16384.0;  // -6 dBFS
+static const size_t SETTLE = 64;          // Output samples skipped for the filter to fill
+
+typedef struct {
+  uint32_t In, Out;
+} Pair_t;
+
+static const Pair_t PAIRS[] = {
+  {24000, 24000},
+  {16000, 24000},
+  {24000, 16000},
+  {8000, 24000},
+  {24000, 48000},
+  {44100, 24000},
+  {22050, 24000},
+  {11025, 24000},  // Up = 320: interpolated phases
+  {24000, 11025},
+};
+
+// Resample a tone at Freq Hz in 20 ms blocks; returns the output
+static std::vector<int16_t> Convert(Resampler_t* Resampler, double Freq, double Seconds, double* NsPerSample) {
+  uint32_t In = Resampler->InRate;
+  size_t Total = (size_t)(Seconds * In);
+  size_t Block = In / 50;
+  std::vector<int16_t> Input(Total);
+  for (size_t N = 0; N < Total; N++) {
+    Input[N] = (int16_t)lround(AMPLITUDE * sin(2.0 * M_PI * Freq * N / In));
+  }
+
+  std::vector<int16_t> Output(ResamplerMaxOutput(Resampler, Block) * (Total / Block + 1));
+  size_t Produced = 0;
+  ResamplerReset(Resampler);
+  uint32_t Start = DspCycles();
+  for (size_t Done = 0; Done + Block <= Total; Done += Block) {
+    Produced += ResamplerProcess(Resampler, Input.data() + Done, Block, Output.data() + Produced);
+  }
+  uint32_t Elapsed = DspCycles() - Start;
+  Output.resize(Produced);
+  if (NsPerSample) *NsPerSample = Produced ? (double)Elapsed / Produced : 0.0;
+  return Output;
+}
+
+// Least-squares fit of A sin + B cos + C at the known frequency; returns the
+// tone power and the residual power
+static void FitTone(const std::vector<int16_t>& Samples, double Freq, uint32_t Rate,
+                    double* TonePower, double* ResidualPower) {
+  double Sxx[3][3] = {}, Sxy[3] = {};
+  size_t Count = 0;
+  for (size_t N = SETTLE; N < Samples.size(); N++, Count++) {
+    double Basis[3] = {sin(2.0 * M_PI * Freq * N / Rate), cos(2.0 * M_PI * Freq * N / Rate), 1.0};
+    for (int I = 0; I < 3; I++) {
+      for (int J = 0; J < 3; J++) Sxx[I][J] += Basis[I] * Basis[J];
+      Sxy[I] += Basis[I] * Samples[N];
+    }
+  }
+
+  // Gaussian elimination on the 3x3 normal equations
+  double Coef[3];
+  for (int I = 0; I < 3; I++) {
+    for (int R = I + 1; R < 3; R++) {
+      double F = Sxx[R][I] / Sxx[I][I];
+      for (int J = I; J < 3; J++) Sxx[R][J] -= F * Sxx[I][J];
+      Sxy[R] -= F * Sxy[I];
+    }
+  }
+  for (int I = 2; I >= 0; I--) {
+    double Sum = Sxy[I];
+    for (int J = I + 1; J < 3; J++) Sum -= Sxx[I][J] * Coef[J];
+    Coef[I] = Sum / Sxx[I][I];
+  }
+
+  double Residual = 0.0;
+  for (size_t N = SETTLE; N < Samples.size(); N++) {
+    double Fit = Coef[0] * sin(2.0 * M_PI * Freq * N / Rate) + Coef[1] * cos(2.0 * M_PI * Freq * N / Rate) + Coef[2];
+    Residual += (Samples[N] - Fit) * (Samples[N] - Fit);
+  }
+  *TonePower = (Coef[0] * Coef[0] + Coef[1] * Coef[1]) / 2.0;
+  *ResidualPower = Count ? Residual / Count : 0.0;
+}
+
+static double Db(double Ratio) {
+  return 10.0 * log10(Ratio > 1e-12 ? Ratio : 1e-12);
+}
+
+// Worst SNR over tones at 5-85% of the lower Nyquist frequency
+static bool RunPair(const Pair_t& Pair, double Seconds, double MinSnr) {
+  Resampler_t Resampler;
+  memset(&Resampler, 0, sizeof(Resampler));
+  if (!ResamplerInit(&Resampler, Pair.In, Pair.Out)) {
+    printf("%5u -> %5u  no converter\n", Pair.In, Pair.Out);
+    return false;
+  }
+
+  double Nyquist = 0.5 * (Pair.In < Pair.Out ? Pair.In : Pair.Out);
+  double WorstSnr = 1e9, WorstFreq = 0.0, MaxGainDb = 0.0, NsPerSample = 0.0;
+  for (double Fraction = 0.05; Fraction < 0.86; Fraction += 0.2) {
+    double Freq = Fraction * Nyquist;
+    double Ns;
+    std::vector<int16_t> Output = Convert(&Resampler, Freq, Seconds, &Ns);
+    double Tone, Residual;
+    FitTone(Output, Freq, Pair.Out, &Tone, &Residual);
+    double Snr = Db(Tone / Residual);
+    double GainDb = fabs(Db(Tone / (AMPLITUDE * AMPLITUDE / 2.0)));
+    if (Snr < WorstSnr) {
+      WorstSnr = Snr;
+      WorstFreq = Freq;
+    }
+    if (GainDb > MaxGainDb) MaxGainDb = GainDb;
+    if (Ns > NsPerSample) NsPerSample = Ns;
+  }
+
+  // A tone the output cannot carry should vanish rather than fold back
+  char Alias[16] = "-";
+  if (Pair.Out < Pair.In) {
+    double Freq = 0.5 * (Pair.Out / 2.0 + Pair.In / 2.0) + 0.1 * Pair.Out;
+    if (Freq > 0.95 * Pair.In / 2.0) Freq = 0.95 * Pair.In / 2.0;
+    std::vector<int16_t> Output = Convert(&Resampler, Freq, Seconds, NULL);
+    double Power = 0.0;
+    for (size_t N = SETTLE; N < Output.size(); N++) Power += (double)Output[N] * Output[N];
+    Power /= Output.size() > SETTLE ? Output.size() - SETTLE : 1;
+    snprintf(Alias, sizeof(Alias), "%.1f", -Db(Power / (AMPLITUDE * AMPLITUDE / 2.0)));
+  }
+
+  bool Ok = WorstSnr >= MinSnr;
+  printf("%5u -> %5u  %6u/%-5u  %-6s  %7.2f  %7.1f @ %5.0f Hz  %7.2f  %9s  %s\n", Pair.In, Pair.Out,
+    Resampler.Up, Resampler.Down, ResamplerIsBypass(&Resampler) ? "bypass" : Resampler.Phases == Resampler.Up ? "exact" : "interp",
+    NsPerSample, WorstSnr, WorstFreq, MaxGainDb, Alias, Ok ? "ok" : "FAIL");
+  ResamplerFree(&Resampler);
+  return Ok;
+}
+
+int main(int Argc, char** Argv) {
+  double Seconds = 2.0;
+  double MinSnr = 60.0;
+  Pair_t Single = {0, 0};
+
+  for (int I = 1; I < Argc; I++) {
+    const char* Value = I + 1 < Argc ? Argv[I + 1] : NULL;
+    if (Value && !strcmp(Argv[I], "--seconds")) {
+      Seconds = atof(Value);
+    } else if (Value && !strcmp(Argv[I], "--min-snr")) {
+      MinSnr = atof(Value);
+    } else if (Value && !strcmp(Argv[I], "--in")) {
+      Single.In = (uint32_t)atol(Value);
+    } else if (Value && !strcmp(Argv[I], "--out")) {
+      Single.Out = (uint32_t)atol(Value);
+    } else {
+      fputs(USAGE, stderr);
+      return 2;
+    }
+    I++;
+  }
+  if (Seconds < 0.1 || (Single.In == 0) != (Single.Out == 0)) {
+    fputs(USAGE, stderr);
+    return 2;
+  }
+
+  printf("%-14s  %-11s  %-6s  %7s  %-19s  %7s  %9s\n", "rates", "up/down", "path", "ns/out",
+    "worst SNR dB", "gain dB", "alias dB");
+  bool Ok = true;
+  if (Single.In != 0) {
+    Ok = RunPair(Single, Seconds, MinSnr);
+  } else {
+    for (const Pair_t& Pair : PAIRS) Ok = RunPair(Pair, Seconds, MinSnr) && Ok;
+  }
+  return Ok ? 0 : 1;
+}
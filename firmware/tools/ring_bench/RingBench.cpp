@@ -0,0 +1,256 @@
+#include <Arduino.h>
+#include "modules/AudioRingBuffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// --- Ring Buffer Benchmark ---
+// Times AudioRingBuffer against the AudioMemoryBuffer it replaced (copied
+// below as it was) on the transfer shapes the firmware uses, then runs a
+// producer and a consumer thread over the ring to check that every sample
+// arrives once and in order. Exits 1 if the threaded check fails.
+
+static const char* USAGE =
+  "usage: ring_bench [--chunk N] [--mb N] [--seconds S]\n"
+  "  --chunk N    samples per transfer (default 480, one 20 ms frame)\n"
+  "  --mb N       MB moved per timed run (default 256)\n"
+  "  --seconds S  length of the threaded check (default 2)\n";
+
+// The previous buffer, unchanged apart from the name
+class LegacyMemoryBuffer {
+private:
+    static const int BUFFER_SIZE = 16384;
+    int16_t* buffer;
+    int writeIndex = 0;
+    int readIndex = 0;
+    int samplesAvailable = 0;
+
+public:
+    LegacyMemoryBuffer() { buffer = NULL; }
+    ~LegacyMemoryBuffer() { free(buffer); }
+
+    bool init() {
+        buffer = (int16_t*)malloc(BUFFER_SIZE * sizeof(int16_t));
+        if (!buffer) return false;
+        clear();
+        return true;
+    }
+
+    bool write(const int16_t* data, int length) {
+        if (!buffer || !data) return false;
+        if (samplesAvailable + length > BUFFER_SIZE) {
+            return false;
+        }
+        for (int i = 0; i < length; i++) {
+            buffer[writeIndex] = data[i];
+            writeIndex = (writeIndex + 1) % BUFFER_SIZE;
+        }
+        samplesAvailable += length;
+        return true;
+    }
+
+    bool read(int16_t* data, int length) {
+        if (!buffer || !data) return false;
+        if (samplesAvailable < length) {
+            return false;
+        }
+        for (int i = 0; i < length; i++) {
+            data[i] = buffer[readIndex];
+            readIndex = (readIndex + 1) % BUFFER_SIZE;
+        }
+        samplesAvailable -= length;
+        return true;
+    }
+
+    void clear() {
+        writeIndex = 0;
+        readIndex = 0;
+        samplesAvailable = 0;
+        memset(buffer, 0, BUFFER_SIZE * sizeof(int16_t));
+    }
+};
+
+static const size_t RING_SAMPLES = 16384;
+
+static uint64_t NowNs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Defeats dead-store elimination of the read side
+static volatile int16_t Sink;
+
+typedef struct {
+  const char* Name;
+  double NsPerSample;
+} Timing_t;
+
+static Timing_t TimeLegacy(size_t Chunk, uint64_t Samples) {
+  LegacyMemoryBuffer Buffer;
+  Buffer.init();
+  std::vector<int16_t> In(Chunk, 1), Out(Chunk);
+  uint64_t Start = NowNs();
+  for (uint64_t Moved = 0; Moved < Samples; Moved += Chunk) {
+    Buffer.write(In.data(), (int)Chunk);
+    Buffer.read(Out.data(), (int)Chunk);
+    Sink = Out[Chunk - 1];
+  }
+  return {"AudioMemoryBuffer write/read", (double)(NowNs() - Start) / Samples};
+}
+
+static Timing_t TimeCopy(size_t Chunk, uint64_t Samples) {
+  AudioRingBuffer Ring;
+  Ring.init(RING_SAMPLES);
+  std::vector<int16_t> In(Chunk, 1), Out(Chunk);
+  uint64_t Start = NowNs();
+  for (uint64_t Moved = 0; Moved < Samples; Moved += Chunk) {
+    Ring.write(In.data(), Chunk);
+    Ring.read(Out.data(), Chunk);
+    Sink = Out[Chunk - 1];
+  }
+  return {"AudioRingBuffer write/read", (double)(NowNs() - Start) / Samples};
+}
+
+// The playback path: the producer fills reserved space in place, the
+// consumer hands peeked samples on (to I2S on the device, a sum here)
+static Timing_t TimeZeroCopy(size_t Chunk, uint64_t Samples) {
+  AudioRingBuffer Ring;
+  Ring.init(RING_SAMPLES);
+  int16_t Value = 1;
+  uint64_t Start = NowNs();
+  for (uint64_t Moved = 0; Moved < Samples; Moved += Chunk) {
+    for (size_t Left = Chunk; Left > 0;) {
+      size_t Contiguous;
+      int16_t* Space = Ring.reserve(&Contiguous);
+      size_t Count = min(Left, Contiguous);
+      for (size_t I = 0; I < Count; I++) Space[I] = Value;
+      Ring.commit(Count);
+      Left -= Count;
+    }
+    int32_t Sum = 0;
+    for (size_t Left = Chunk; Left > 0;) {
+      size_t Contiguous;
+      const int16_t* Data = Ring.peek(&Contiguous);
+      size_t Count = min(Left, Contiguous);
+      for (size_t I = 0; I < Count; I++) Sum += Data[I];
+      Ring.consume(Count);
+      Left -= Count;
+    }
+    Sink = (int16_t)Sum;
+  }
+  return {"AudioRingBuffer reserve/peek", (double)(NowNs() - Start) / Samples};
+}
+
+// Producer and consumer on two threads with uneven chunk sizes; samples
+// carry a running counter so loss, repeats and reordering all show
+static bool CheckThreaded(double Seconds, uint64_t* Transferred) {
+  AudioRingBuffer Ring;
+  Ring.init(RING_SAMPLES);
+  std::atomic<bool> Stop(false);
+  std::atomic<uint64_t> Errors(0);
+  uint64_t Received = 0;
+
+  std::thread Producer([&]() {
+    uint16_t Next = 0;
+    uint32_t Seed = 1;
+    int16_t Chunk[1500];
+    while (!Stop.load(std::memory_order_relaxed)) {
+      Seed = Seed * 1664525u + 1013904223u;
+      size_t Count = 1 + (Seed >> 8) % 1500;
+      if ((Seed >> 4) & 1) {
+        for (size_t I = 0; I < Count; I++) Chunk[I] = (int16_t)(Next + I);
+        if (Ring.write(Chunk, Count)) Next += (uint16_t)Count;
+      } else {
+        size_t Contiguous;
+        int16_t* Space = Ring.reserve(&Contiguous);
+        Count = min(Count, Contiguous);
+        for (size_t I = 0; I < Count; I++) Space[I] = (int16_t)(Next + I);
+        Ring.commit(Count);
+        Next += (uint16_t)Count;
+      }
+    }
+  });
+
+  std::thread Consumer([&]() {
+    uint16_t Expect = 0;
+    uint32_t Seed = 7;
+    int16_t Chunk[1500];
+    uint64_t End = NowNs() + (uint64_t)(Seconds * 1e9);
+    while (NowNs() < End) {
+      Seed = Seed * 1664525u + 1013904223u;
+      size_t Count = 1 + (Seed >> 8) % 1500;
+      size_t Got = 0;
+      const int16_t* Data = Chunk;
+      if ((Seed >> 4) & 1) {
+        if (Ring.read(Chunk, Count)) Got = Count;
+      } else {
+        size_t Contiguous;
+        Data = Ring.peek(&Contiguous);
+        Got = min(Count, Contiguous);
+      }
+      for (size_t I = 0; I < Got; I++) {
+        if ((uint16_t)Data[I] != Expect) {
+          Errors++;
+          Expect = (uint16_t)Data[I];
+        }
+        Expect++;
+      }
+      if (Data != Chunk) Ring.consume(Got);
+      Received += Got;
+    }
+    Stop = true;
+  });
+
+  Producer.join();
+  Consumer.join();
+  *Transferred = Received;
+  return Errors.load() == 0 && Received > 0;
+}
+
+int main(int Argc, char** Argv) {
+  size_t Chunk = 480;
+  uint64_t Megabytes = 256;
+  double Seconds = 2.0;
+
+  for (int I = 1; I < Argc; I++) {
+    const char* Value = I + 1 < Argc ? Argv[I + 1] : NULL;
+    if (Value && !strcmp(Argv[I], "--chunk")) {
+      Chunk = (size_t)atol(Value);
+    } else if (Value && !strcmp(Argv[I], "--mb")) {
+      Megabytes = (uint64_t)atol(Value);
+    } else if (Value && !strcmp(Argv[I], "--seconds")) {
+      Seconds = atof(Value);
+    } else {
+      fputs(USAGE, stderr);
+      return 2;
+    }
+    I++;
+  }
+  if (Chunk == 0 || Chunk > RING_SAMPLES / 2 || Megabytes == 0) {
+    fputs(USAGE, stderr);
+    return 2;
+  }
+
+  uint64_t Samples = Megabytes * 1024 * 1024 / sizeof(int16_t);
+  Timing_t Timings[] = {
+    TimeLegacy(Chunk, Samples),
+    TimeCopy(Chunk, Samples),
+    TimeZeroCopy(Chunk, Samples),
+  };
+
+  printf("%zu-sample transfers, %llu MB through a %zu-sample buffer\n\n", Chunk,
+    (unsigned long long)Megabytes, RING_SAMPLES);
+  printf("%-30s  ns/sample  vs legacy\n", "");
+  for (const Timing_t& T : Timings) {
+    printf("%-30s  %9.3f  %8.1fx\n", T.Name, T.NsPerSample, Timings[0].NsPerSample / T.NsPerSample);
+  }
+
+  uint64_t Transferred = 0;
+  bool Ok = CheckThreaded(Seconds, &Transferred);
+  printf("\nThreaded SPSC check: %llu samples in %.1f s, %s\n", (unsigned long long)Transferred,
+    Seconds, Ok ? "in order, none lost" : "FAILED");
+  return Ok ? 0 : 1;
+}
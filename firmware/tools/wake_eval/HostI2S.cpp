@@ -0,0 +1,109 @@
+#include "HostI2S.h"
+#include "dsp/h/Resampler.h"
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t MicRate = 24000;
+static const HostClip_t* Source = NULL;
+static size_t SourcePos = 0;
+
+void HostI2SSetMicRate(uint32_t Rate) {
+  MicRate = Rate;
+}
+
+uint32_t I2SGetMicRate() {
+  return MicRate;
+}
+
+static uint16_t ReadU16(const uint8_t* P) {
+  return (uint16_t)(P[0] | (P[1] << 8));
+}
+
+static uint32_t ReadU32(const uint8_t* P) {
+  return (uint32_t)P[0] | ((uint32_t)P[1] << 8) | ((uint32_t)P[2] << 16) | ((uint32_t)P[3] << 24);
+}
+
+bool HostI2SLoad(const char* Path, HostClip_t* Clip) {
+  FILE* File = fopen(Path, "rb");
+  if (!File) {
+    fprintf(stderr, "[HostI2S] %s: cannot open\n", Path);
+    return false;
+  }
+  std::vector<uint8_t> Data;
+  uint8_t Chunk[65536];
+  size_t Got;
+  while ((Got = fread(Chunk, 1, sizeof(Chunk), File)) > 0) Data.insert(Data.end(), Chunk, Chunk + Got);
+  fclose(File);
+
+  if (Data.size() < 12 || memcmp(&Data[0], "RIFF", 4) != 0 || memcmp(&Data[8], "WAVE", 4) != 0) {
+    fprintf(stderr, "[HostI2S] %s: not a WAV file\n", Path);
+    return false;
+  }
+
+  // Walk the chunks for fmt and data
+  uint16_t Format = 0, Channels = 0, Bits = 0;
+  uint32_t Rate = 0;
+  const uint8_t* Pcm = NULL;
+  size_t PcmBytes = 0;
+  size_t Pos = 12;
+  while (Pos + 8 <= Data.size()) {
+    uint32_t Size = ReadU32(&Data[Pos + 4]);
+    const uint8_t* Body = &Data[Pos + 8];
+    size_t Avail = Data.size() - (Pos + 8);
+    if (memcmp(&Data[Pos], "fmt ", 4) == 0 && Size >= 16 && Avail >= 16) {
+      Format = ReadU16(Body);
+      Channels = ReadU16(Body + 2);
+      Rate = ReadU32(Body + 4);
+      Bits = ReadU16(Body + 14);
+      // WAVE_FORMAT_EXTENSIBLE: the real format is the first subformat word
+      if (Format == 0xFFFE && Size >= 26 && Avail >= 26) Format = ReadU16(Body + 24);
+    } else if (memcmp(&Data[Pos], "data", 4) == 0) {
+      Pcm = Body;
+      PcmBytes = Size < Avail ? Size : Avail;
+      break;
+    }
+    Pos += 8 + Size + (Size & 1);
+  }
+
+  if (Format != 1 || Bits != 16 || Channels == 0 || Rate == 0 || !Pcm) {
+    fprintf(stderr, "[HostI2S] %s: need 16-bit PCM (format %u, %u bits, %u ch)\n", Path, Format, Bits, Channels);
+    return false;
+  }
+
+  size_t Frames = PcmBytes / (2u * Channels);
+  std::vector<int16_t> Mono(Frames);
+  for (size_t I = 0; I < Frames; I++) Mono[I] = (int16_t)ReadU16(Pcm + I * 2u * Channels);
+
+  // Convert to the mic rate with the firmware's own resampler
+  if (Rate != MicRate) {
+    Resampler_t Resampler;
+    memset(&Resampler, 0, sizeof(Resampler));
+    if (!ResamplerInit(&Resampler, Rate, MicRate)) {
+      fprintf(stderr, "[HostI2S] %s: cannot resample %u -> %u Hz\n", Path, Rate, MicRate);
+      return false;
+    }
+    Clip->Samples.resize(ResamplerMaxOutput(&Resampler, Frames));
+    Clip->Samples.resize(ResamplerProcess(&Resampler, Mono.data(), Frames, Clip->Samples.data()));
+    ResamplerFree(&Resampler);
+  } else {
+    Clip->Samples.swap(Mono);
+  }
+  Clip->Seconds = (double)Clip->Samples.size() / MicRate;
+  return true;
+}
+
+void HostI2SSetSource(const HostClip_t* Clip) {
+  Source = Clip;
+  SourcePos = 0;
+}
+
+size_t I2SReadMic(uint8_t* Buffer, size_t Length, uint32_t TimeoutMs) {
+  (void)TimeoutMs;
+  if (!Source) return 0;
+  size_t Want = Length / sizeof(int16_t);
+  size_t Left = Source->Samples.size() - SourcePos;
+  if (Want > Left) Want = Left;
+  memcpy(Buffer, Source->Samples.data() + SourcePos, Want * sizeof(int16_t));
+  SourcePos += Want;
+  return Want * sizeof(int16_t);
+}
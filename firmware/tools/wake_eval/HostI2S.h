@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// --- Host I2S ---
+// Stand-in for the mic half of hal/h/I2S.h on a desktop build: reads come
+// from a WAV clip loaded into memory instead of the INMP441's DMA ring.
+
+#define AUDIO_FRAME_MS 20
+
+typedef struct {
+  std::vector<int16_t> Samples;  // Mono, at the host mic rate
+  double Seconds;
+} HostClip_t;
+
+// Rate clips are converted to and I2SReadMic delivers (default 24 kHz, as
+// I2S_SAMPLE_RATE_MIC)
+void HostI2SSetMicRate(uint32_t Rate);
+uint32_t I2SGetMicRate();
+
+// Load a PCM16 WAV file (any rate; first channel only). Returns false with
+// a message on stderr when the file cannot be used.
+bool HostI2SLoad(const char* Path, HostClip_t* Clip);
+
+// Point I2SReadMic at the start of Clip (NULL: nothing to read)
+void HostI2SSetSource(const HostClip_t* Clip);
+
+// Same contract as the firmware: bytes copied, 0 at the end of the clip.
+// Never blocks, so TimeoutMs is ignored.
+size_t I2SReadMic(uint8_t* Buffer, size_t Length, uint32_t TimeoutMs = 100);
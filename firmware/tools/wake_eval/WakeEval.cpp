@@ -0,0 +1,428 @@
+#include "HostI2S.h"
+#include "config.h"
+#include "dsp/h/WakeFrontEnd.h"
+#include "dsp/h/Agc.h"
+#include "dsp/h/Vad.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// --- Wake / VAD Evaluation ---
+// Runs the firmware's wake front end (the code behind AudioReadBuffer and
+// WakeDetect) and the uplink VAD over a labeled WAV corpus, much faster
+// than real time. Every combination of the swept gate parameters is scored
+// for false accepts per hour and false reject rate; the points that are not
+// beaten on both form the ROC curve. Jobs are spread over forked worker
+// processes, so the DSP modules' static state needs no locking.
+//
+// Corpus file, one clip per line (paths relative to the corpus file):
+//   <clip.wav> <1|0> [start end]
+// 1 marks a clip containing the wake word; start/end (seconds) bound the
+// spoken part. A wake counts as a hit inside [start, end + tolerance];
+// any other wake is a false accept. The VAD is scored per frame on clips
+// with a window (speech inside it) and on 0 clips without one (all silence).
+// Clips should open with ~0.5 s of room tone, as the gate calibrates on
+// its first frames.
+
+// Largest capture frame the evaluation buffers (20 ms at 96 kHz)
+static const size_t MAX_FRAME = 1920;
+
+static const char* USAGE =
+  "usage: wake_eval <corpus.txt> [options]\n"
+  "  --min a,b,..       MinThreshold values\n"
+  "  --mult a,b,..      ThresholdMultiplier values\n"
+  "  --decay a,b,..     AmbientDecay values\n"
+  "  --rise a,b,..      AmbientRise values\n"
+  "  --frames a,b,..    RequiredFrames values\n"
+  "  --hangover a,b,..  VAD hangover frames (default 15)\n"
+  "  --jobs N           worker processes (default: all cores)\n"
+  "  --rate HZ          mic rate to evaluate at (default 24000)\n"
+  "  --lockout S        ignore wakes for S seconds after one (default 2)\n"
+  "  --tolerance S      accept wakes up to S after the word (default 0.5)\n"
+  "  --csv PATH         also write the wake sweep as CSV\n"
+  "Unswept parameters keep the firmware defaults.\n";
+
+typedef struct {
+  std::string Path;
+  bool Wake;
+  bool HasWindow;
+  double Start;
+  double End;
+  HostClip_t Clip;
+} Entry_t;
+
+typedef enum {
+  JOB_WAKE,
+  JOB_VAD
+} JobKind_t;
+
+typedef struct {
+  JobKind_t Kind;
+  WakeParams_t Params;
+  uint16_t Hangover;
+} Job_t;
+
+// Sent back from the workers through a pipe
+typedef struct {
+  uint32_t Job;
+  uint32_t Positives;
+  uint32_t Hits;
+  uint32_t FalseAccepts;
+  uint32_t VadSilence;       // Silence frames scored
+  uint32_t VadSpeech;        // Speech frames scored
+  uint32_t VadFalseAccept;   // Silence sent
+  uint32_t VadFalseReject;   // Speech dropped
+  uint64_t Frames;
+  uint64_t FrameNs;          // Total CPU time in the front end
+  uint64_t MaxFrameNs;
+} Result_t;
+
+static std::vector<Entry_t> Corpus;
+static std::vector<Job_t> Jobs;
+static WakeFrontEnd_t Wake;
+static size_t FrameSamples = 0;
+static double Lockout = 2.0;
+static double Tolerance = 0.5;
+
+static bool ParseList(const char* Text, std::vector<float>* Values) {
+  Values->clear();
+  while (*Text) {
+    char* End;
+    float Value = strtof(Text, &End);
+    if (End == Text) return false;
+    Values->push_back(Value);
+    Text = *End == ',' ? End + 1 : End;
+    if (*End && *End != ',') return false;
+  }
+  return !Values->empty();
+}
+
+static bool LoadCorpus(const char* Path) {
+  FILE* File = fopen(Path, "r");
+  if (!File) {
+    fprintf(stderr, "[WakeEval] %s: cannot open\n", Path);
+    return false;
+  }
+  std::string Dir(Path);
+  size_t Slash = Dir.find_last_of('/');
+  Dir = Slash == std::string::npos ? "" : Dir.substr(0, Slash + 1);
+
+  char Line[1024];
+  int LineNo = 0;
+  bool Ok = true;
+  while (fgets(Line, sizeof(Line), File)) {
+    LineNo++;
+    char Clip[768];
+    int Label;
+    double Start, End;
+    if (Line[0] == '#' || sscanf(Line, "%767s", Clip) != 1) continue;
+    int Fields = sscanf(Line, "%767s %d %lf %lf", Clip, &Label, &Start, &End);
+    if (Fields != 2 && Fields != 4) {
+      fprintf(stderr, "[WakeEval] %s:%d: expected <clip.wav> <1|0> [start end]\n", Path, LineNo);
+      Ok = false;
+      continue;
+    }
+    Entry_t Entry;
+    Entry.Path = Clip[0] == '/' ? std::string(Clip) : Dir + Clip;
+    Entry.Wake = Label != 0;
+    Entry.HasWindow = Fields == 4;
+    Entry.Start = Entry.HasWindow ? Start : 0.0;
+    Entry.End = Entry.HasWindow ? End : 0.0;
+    if (!HostI2SLoad(Entry.Path.c_str(), &Entry.Clip)) {
+      Ok = false;
+      continue;
+    }
+    Corpus.push_back(Entry);
+  }
+  fclose(File);
+  return Ok && !Corpus.empty();
+}
+
+static uint64_t NowNs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static Result_t RunJob(uint32_t Index) {
+  const Job_t& Job = Jobs[Index];
+  Result_t Result;
+  memset(&Result, 0, sizeof(Result));
+  Result.Job = Index;
+
+  const double FrameSeconds = AUDIO_FRAME_MS / 1000.0;
+  const uint64_t LockoutFrames = (uint64_t)(Lockout / FrameSeconds);
+  const size_t FrameBytes = FrameSamples * sizeof(int16_t);
+  int16_t Frame[MAX_FRAME];
+  Vad_t Vad;
+  // The uplink conditions and levels frames before its VAD
+  MicChain_t Chain;
+  Agc_t Agc;
+  MicChainDesign(&Chain, Wake.SampleRate, QUIL_MIC_DSP_BYPASS);
+
+  for (const Entry_t& Entry : Corpus) {
+    bool ScoreVad = Entry.HasWindow || !Entry.Wake;
+    if (Job.Kind == JOB_VAD && !ScoreVad) continue;
+
+    WakeFrontEndReset(&Wake);
+    Wake.Params = Job.Kind == JOB_WAKE ? Job.Params : WAKE_DEFAULT_PARAMS;
+    VadInit(&Vad, Job.Hangover);
+    Chain.Reset();
+    AgcInit(&Agc, Wake.SampleRate, QUIL_AGC_TARGET_DBFS, AGC_INITIAL_GAIN, AGC_MAX_GAIN);
+    HostI2SSetSource(&Entry.Clip);
+
+    uint64_t FrameIndex = 0;
+    uint64_t QuietUntil = 0;
+    bool Hit = false;
+    while (I2SReadMic((uint8_t*)Frame, FrameBytes) == FrameBytes) {
+      uint64_t Start = NowNs();
+      WakeFrontEndProcess(&Wake, Frame);
+      bool Fired = false;
+      bool Active = false;
+      if (Job.Kind == JOB_WAKE) {
+        Fired = WakeFrontEndDetect(&Wake) == WAKE_EVENT_WAKE;
+      } else {
+        Chain.Process(Frame, FrameSamples);
+        AgcProcess(&Agc, Frame, FrameSamples);
+        Active = VadProcess(&Vad, Frame, FrameSamples);
+      }
+      uint64_t Spent = NowNs() - Start;
+      Result.FrameNs += Spent;
+      if (Spent > Result.MaxFrameNs) Result.MaxFrameNs = Spent;
+      Result.Frames++;
+
+      double FrameEnd = (FrameIndex + 1) * FrameSeconds;
+      if (Fired && FrameIndex >= QuietUntil) {
+        // The device would be in a conversation for a while after a wake
+        QuietUntil = FrameIndex + LockoutFrames;
+        bool InWindow = !Entry.HasWindow || (FrameEnd >= Entry.Start && FrameEnd <= Entry.End + Tolerance);
+        if (Entry.Wake && !Hit && InWindow) {
+          Hit = true;
+        } else {
+          Result.FalseAccepts++;
+        }
+      }
+      if (Job.Kind == JOB_VAD) {
+        double Center = FrameEnd - FrameSeconds / 2;
+        bool Speech = Entry.HasWindow && Center >= Entry.Start && Center <= Entry.End;
+        if (Speech) {
+          Result.VadSpeech++;
+          if (!Active) Result.VadFalseReject++;
+        } else {
+          Result.VadSilence++;
+          if (Active) Result.VadFalseAccept++;
+        }
+      }
+      FrameIndex++;
+    }
+    if (Job.Kind == JOB_WAKE && Entry.Wake) {
+      Result.Positives++;
+      if (Hit) Result.Hits++;
+    }
+  }
+  return Result;
+}
+
+// Jobs Worker, Worker + Workers, ... ; results go to Fd
+static void RunWorker(int Worker, int Workers, int Fd) {
+  for (size_t J = Worker; J < Jobs.size(); J += Workers) {
+    Result_t Result = RunJob((uint32_t)J);
+    if (write(Fd, &Result, sizeof(Result)) != (ssize_t)sizeof(Result)) _exit(1);
+  }
+  _exit(0);
+}
+
+static bool RunAll(int Workers, std::vector<Result_t>* Results) {
+  int Fds[2];
+  if (pipe(Fds) != 0) return false;
+  std::vector<pid_t> Pids;
+  for (int W = 0; W < Workers; W++) {
+    pid_t Pid = fork();
+    if (Pid < 0) return false;
+    if (Pid == 0) {
+      close(Fds[0]);
+      RunWorker(W, Workers, Fds[1]);
+    }
+    Pids.push_back(Pid);
+  }
+  close(Fds[1]);
+
+  Results->assign(Jobs.size(), Result_t());
+  size_t Received = 0;
+  Result_t Result;
+  // Records are far below PIPE_BUF, so writes from different workers never interleave
+  while (read(Fds[0], &Result, sizeof(Result)) == (ssize_t)sizeof(Result)) {
+    if (Result.Job < Jobs.size()) (*Results)[Result.Job] = Result;
+    Received++;
+  }
+  close(Fds[0]);
+
+  bool Ok = Received == Jobs.size();
+  for (pid_t Pid : Pids) {
+    int Status;
+    waitpid(Pid, &Status, 0);
+    if (!WIFEXITED(Status) || WEXITSTATUS(Status) != 0) Ok = false;
+  }
+  return Ok;
+}
+
+int main(int Argc, char** Argv) {
+  if (Argc < 2 || Argv[1][0] == '-') {
+    fputs(USAGE, stderr);
+    return 2;
+  }
+
+  const WakeParams_t& D = WAKE_DEFAULT_PARAMS;
+  std::vector<float> Mins(1, D.MinThreshold), Mults(1, D.ThresholdMultiplier);
+  std::vector<float> Decays(1, D.AmbientDecay), Rises(1, D.AmbientRise);
+  std::vector<float> Required(1, D.RequiredFrames), Hangovers(1, 300 / AUDIO_FRAME_MS);
+  long Workers = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t Rate = 24000;
+  const char* CsvPath = NULL;
+
+  for (int I = 2; I < Argc; I++) {
+    const char* Opt = Argv[I];
+    const char* Value = I + 1 < Argc ? Argv[I + 1] : NULL;
+    bool Ok = true;
+    if (!Value) {
+      Ok = false;
+    } else if (!strcmp(Opt, "--min")) {
+      Ok = ParseList(Value, &Mins);
+    } else if (!strcmp(Opt, "--mult")) {
+      Ok = ParseList(Value, &Mults);
+    } else if (!strcmp(Opt, "--decay")) {
+      Ok = ParseList(Value, &Decays);
+    } else if (!strcmp(Opt, "--rise")) {
+      Ok = ParseList(Value, &Rises);
+    } else if (!strcmp(Opt, "--frames")) {
+      Ok = ParseList(Value, &Required);
+    } else if (!strcmp(Opt, "--hangover")) {
+      Ok = ParseList(Value, &Hangovers);
+    } else if (!strcmp(Opt, "--jobs")) {
+      Workers = atol(Value);
+    } else if (!strcmp(Opt, "--rate")) {
+      Rate = (uint32_t)atol(Value);
+    } else if (!strcmp(Opt, "--lockout")) {
+      Lockout = atof(Value);
+    } else if (!strcmp(Opt, "--tolerance")) {
+      Tolerance = atof(Value);
+    } else if (!strcmp(Opt, "--csv")) {
+      CsvPath = Value;
+    } else {
+      Ok = false;
+    }
+    if (!Ok) {
+      fprintf(stderr, "[WakeEval] bad option %s\n%s", Opt, USAGE);
+      return 2;
+    }
+    I++;
+  }
+
+  FrameSamples = Rate * AUDIO_FRAME_MS / 1000;
+  if (FrameSamples == 0 || FrameSamples > MAX_FRAME) {
+    fprintf(stderr, "[WakeEval] --rate %u: frames must be 1..%zu samples\n", Rate, MAX_FRAME);
+    return 2;
+  }
+  HostI2SSetMicRate(Rate);
+  if (!LoadCorpus(Argv[1])) return 1;
+
+  // Set up once here; forked workers inherit the tables
+  WakeFrontEndInit(&Wake, Rate, FrameSamples);
+
+  for (float Min : Mins)
+    for (float Mult : Mults)
+      for (float Decay : Decays)
+        for (float Rise : Rises)
+          for (float Frames : Required) {
+            Job_t Job = {JOB_WAKE, D, 0};
+            Job.Params.MinThreshold = Min;
+            Job.Params.ThresholdMultiplier = Mult;
+            Job.Params.AmbientDecay = Decay;
+            Job.Params.AmbientRise = Rise;
+            Job.Params.RequiredFrames = (uint16_t)(Frames < 1 ? 1 : Frames);
+            Jobs.push_back(Job);
+          }
+  size_t WakeJobs = Jobs.size();
+  for (float Hangover : Hangovers) {
+    Job_t Job = {JOB_VAD, D, (uint16_t)(Hangover < 0 ? 0 : Hangover)};
+    Jobs.push_back(Job);
+  }
+
+  double AudioSeconds = 0.0;
+  size_t Positives = 0;
+  for (const Entry_t& Entry : Corpus) {
+    AudioSeconds += Entry.Clip.Seconds;
+    if (Entry.Wake) Positives++;
+  }
+  if (Workers < 1) Workers = 1;
+  if ((size_t)Workers > Jobs.size()) Workers = (long)Jobs.size();
+
+  printf("Corpus: %zu clips (%zu with the wake word), %.1f min at %u Hz\n",
+    Corpus.size(), Positives, AudioSeconds / 60.0, Rate);
+  printf("Sweep: %zu wake points, %zu VAD points on %ld workers\n\n", WakeJobs, Jobs.size() - WakeJobs, Workers);
+
+  std::vector<Result_t> Results;
+  uint64_t WallStart = NowNs();
+  if (!RunAll((int)Workers, &Results)) {
+    fprintf(stderr, "[WakeEval] a worker failed\n");
+    return 1;
+  }
+  double WallSeconds = (NowNs() - WallStart) / 1e9;
+
+  // Wake points by false accepts per hour; the ROC curve keeps each point
+  // that lowers the reject rate over every cheaper one
+  std::vector<size_t> Order;
+  for (size_t J = 0; J < WakeJobs; J++) Order.push_back(J);
+  double Hours = AudioSeconds / 3600.0;
+  auto FaPerHour = [&](size_t J) { return Results[J].FalseAccepts / Hours; };
+  auto RejectRate = [&](size_t J) {
+    return Results[J].Positives ? 1.0 - (double)Results[J].Hits / Results[J].Positives : 0.0;
+  };
+  std::sort(Order.begin(), Order.end(), [&](size_t A, size_t B) {
+    return FaPerHour(A) != FaPerHour(B) ? FaPerHour(A) < FaPerHour(B) : RejectRate(A) < RejectRate(B);
+  });
+
+  FILE* Csv = CsvPath ? fopen(CsvPath, "w") : NULL;
+  if (CsvPath && !Csv) fprintf(stderr, "[WakeEval] %s: cannot write\n", CsvPath);
+  if (Csv) fprintf(Csv, "min,mult,decay,rise,frames,fa_per_hour,frr,roc,us_per_frame,max_us\n");
+
+  printf("roc    min  mult  decay  rise frames    FA/h    FRR%%  us/frame  max_us\n");
+  double BestReject = 2.0;
+  for (size_t J : Order) {
+    const WakeParams_t& P = Jobs[J].Params;
+    const Result_t& R = Results[J];
+    bool Roc = RejectRate(J) < BestReject;
+    if (Roc) BestReject = RejectRate(J);
+    double UsPerFrame = R.Frames ? R.FrameNs / 1e3 / R.Frames : 0.0;
+    printf(" %s  %5.0f  %4.2f  %5.3f  %4.2f  %5u  %6.2f  %6.1f  %8.1f  %6.1f\n",
+      Roc ? "*" : " ", P.MinThreshold, P.ThresholdMultiplier, P.AmbientDecay, P.AmbientRise,
+      P.RequiredFrames, FaPerHour(J), RejectRate(J) * 100.0, UsPerFrame, R.MaxFrameNs / 1e3);
+    if (Csv) {
+      fprintf(Csv, "%g,%g,%g,%g,%u,%.3f,%.4f,%d,%.2f,%.2f\n", P.MinThreshold, P.ThresholdMultiplier,
+        P.AmbientDecay, P.AmbientRise, P.RequiredFrames, FaPerHour(J), RejectRate(J), Roc ? 1 : 0,
+        UsPerFrame, R.MaxFrameNs / 1e3);
+    }
+  }
+  if (Csv) fclose(Csv);
+
+  printf("\nVAD hangover  false accept%%  false reject%%  us/frame\n");
+  for (size_t J = WakeJobs; J < Jobs.size(); J++) {
+    const Result_t& R = Results[J];
+    printf("  %8u      %8.2f       %8.2f  %8.1f\n", Jobs[J].Hangover,
+      R.VadSilence ? 100.0 * R.VadFalseAccept / R.VadSilence : 0.0,
+      R.VadSpeech ? 100.0 * R.VadFalseReject / R.VadSpeech : 0.0,
+      R.Frames ? R.FrameNs / 1e3 / R.Frames : 0.0);
+  }
+
+  uint64_t Frames = 0;
+  for (const Result_t& R : Results) Frames += R.Frames;
+  double Processed = Frames * (AUDIO_FRAME_MS / 1000.0);
+  printf("\n%.2f h of audio in %.2f s wall (%.0fx real time)\n",
+    Processed / 3600.0, WallSeconds, WallSeconds > 0 ? Processed / WallSeconds : 0.0);
+  return 0;
+}
@@ -0,0 +1,261 @@
+#include "core/h/WireProtocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <set>
+#include <vector>
+
+// --- Wire Protocol Fuzzer ---
+// Round-trips every message type through WireWriteHeader and WireParse,
+// then throws random and mutated messages at WireParse. Each one lives in a
+// buffer of exactly its length, so a sanitizer build catches any read past
+// the end. Every verdict is checked against the header's rules, written out
+// again below. Finally WireRxTrack is fed reordered, repeated and dropped
+// sequence numbers, including a wrap past 2^32, and its counts are compared
+// with ones kept from a set of every number seen. Exits 1 on the first
+// disagreement.
+
+static const char* USAGE =
+  "usage: wire_fuzz [--iterations N] [--seed N]\n"
+  "  --iterations N  mutated messages (default 1000000)\n"
+  "  --seed N        random seed (default 1)\n";
+
+static uint32_t Seed = 1;
+
+static uint32_t Random() {
+  Seed ^= Seed << 13;
+  Seed ^= Seed >> 17;
+  Seed ^= Seed << 5;
+  return Seed;
+}
+
+static const uint8_t TYPES[] = {
+  WIRE_AUDIO, WIRE_COMFORT_NOISE, WIRE_END_OF_SPEECH, WIRE_PING, WIRE_INTERRUPT, WIRE_PREROLL_START,
+  WIRE_PREROLL_END, WIRE_PONG, WIRE_RESPONSE_COMPLETE, WIRE_AUDIO_COMMITTED, WIRE_ERROR,
+};
+
+// The acceptance rules from WireProtocol.h, independent of the parser
+static bool Expected(const std::vector<uint8_t>& Message) {
+  if (Message.size() < WIRE_HEADER_BYTES || Message[3] != WIRE_VERSION) return false;
+  size_t Bytes = Message.size() - WIRE_HEADER_BYTES;
+  uint8_t Codec = Message[1];
+  switch (Message[0]) {
+    case WIRE_AUDIO:
+      if (Bytes == 0) return false;
+      if (Codec == WIRE_CODEC_PCM16) return Bytes % 2 == 0;
+      return Codec == WIRE_CODEC_IMA_ADPCM || Codec == WIRE_CODEC_MP3;
+    case WIRE_COMFORT_NOISE:
+      return Codec == WIRE_CODEC_NONE && Bytes == 1;
+    case WIRE_PREROLL_START:
+    case WIRE_PREROLL_END:
+      return Codec == WIRE_CODEC_NONE && Bytes == 4;
+    case WIRE_ERROR:
+      return Codec == WIRE_CODEC_NONE;
+    case WIRE_END_OF_SPEECH:
+    case WIRE_PING:
+    case WIRE_INTERRUPT:
+    case WIRE_PONG:
+    case WIRE_RESPONSE_COMPLETE:
+    case WIRE_AUDIO_COMMITTED:
+      return Codec == WIRE_CODEC_NONE && Bytes == 0;
+    default:
+      return false;
+  }
+}
+
+// A well-formed message of the given type with a random header and payload
+static std::vector<uint8_t> MakeValid(uint8_t Type) {
+  WireHeader_t Header;
+  Header.Type = Type;
+  Header.Codec = WIRE_CODEC_NONE;
+  Header.Flags = (uint8_t)Random();
+  Header.Seq = Random();
+  Header.TimestampUs = Random();
+  size_t Bytes = 0;
+  switch (Type) {
+    case WIRE_AUDIO:
+      Header.Codec = (uint8_t)(WIRE_CODEC_PCM16 + Random() % 3);
+      Bytes = 2 * (1 + Random() % 600);
+      break;
+    case WIRE_COMFORT_NOISE: Bytes = 1; break;
+    case WIRE_PREROLL_START:
+    case WIRE_PREROLL_END: Bytes = 4; break;
+    case WIRE_ERROR: Bytes = Random() % 80; break;
+    default: break;
+  }
+  std::vector<uint8_t> Message(WIRE_HEADER_BYTES + Bytes);
+  WireWriteHeader(&Header, Message.data());
+  for (size_t I = WIRE_HEADER_BYTES; I < Message.size(); I++) Message[I] = (uint8_t)Random();
+  return Message;
+}
+
+static void Mutate(std::vector<uint8_t>* Message) {
+  int Edits = 1 + Random() % 3;
+  for (int E = 0; E < Edits; E++) {
+    switch (Random() % 6) {
+      case 0:
+        if (!Message->empty()) (*Message)[Random() % Message->size()] ^= (uint8_t)(1 << (Random() % 8));
+        break;
+      case 1:
+        if (!Message->empty()) (*Message)[Random() % Message->size()] = (uint8_t)Random();
+        break;
+      case 2:
+        Message->resize(Random() % (Message->size() + 1));
+        break;
+      case 3:
+        for (uint32_t N = Random() % 8; N > 0; N--) Message->push_back((uint8_t)Random());
+        break;
+      case 4:
+        if (Message->size() > 1) (*Message)[Random() % 2] = (uint8_t)(Random() % 0x40);
+        break;
+      default:
+        Message->resize(Random() % 32);
+        for (uint8_t& Byte : *Message) Byte = (uint8_t)Random();
+        break;
+    }
+  }
+}
+
+// Parse Message from an exact-size copy and check the verdict and fields
+static bool CheckParse(const std::vector<uint8_t>& Message) {
+  uint8_t* Copy = (uint8_t*)malloc(Message.size() ? Message.size() : 1);
+  memcpy(Copy, Message.data(), Message.size());
+  WireHeader_t Header;
+  const uint8_t* Payload = NULL;
+  size_t PayloadBytes = 0;
+  bool Accepted = WireParse(Copy, Message.size(), &Header, &Payload, &PayloadBytes);
+
+  bool Ok = Accepted == Expected(Message);
+  if (Ok && Accepted) {
+    Ok = Header.Type == Copy[0] && Header.Codec == Copy[1] && Header.Flags == Copy[2] &&
+      Header.Seq == WireGetU32(Copy + 4) && Header.TimestampUs == WireGetU32(Copy + 8) &&
+      Payload == Copy + WIRE_HEADER_BYTES && PayloadBytes == Message.size() - WIRE_HEADER_BYTES;
+  }
+  if (!Ok) {
+    printf("FAIL: %zu bytes, parser %s, rules %s:", Message.size(), Accepted ? "accepts" : "rejects",
+      Expected(Message) ? "accept" : "reject");
+    for (size_t I = 0; I < Message.size() && I < 24; I++) printf(" %02x", Message[I]);
+    printf("\n");
+  }
+  free(Copy);
+  return Ok;
+}
+
+static bool CheckRoundTrip() {
+  for (uint8_t Type : TYPES) {
+    for (int N = 0; N < 100; N++) {
+      std::vector<uint8_t> Message = MakeValid(Type);
+      if (!Expected(Message) || !CheckParse(Message)) return false;
+    }
+  }
+  WireHeader_t Header = {WIRE_PING, WIRE_CODEC_NONE, 0, 0, 0};
+  uint8_t Short[WIRE_HEADER_BYTES];
+  WireWriteHeader(&Header, Short);
+  const uint8_t* Payload;
+  size_t Bytes;
+  if (WireParse(NULL, 0, &Header, &Payload, &Bytes) || WireParse(Short, 0, &Header, &Payload, &Bytes)) {
+    printf("FAIL: empty message accepted\n");
+    return false;
+  }
+  return true;
+}
+
+// One receive stream: in-order numbers from Start, some dropped, some sent
+// twice, and some pushed back behind later ones (now and then past the
+// window). The expected counts come from a set of every number seen.
+static bool CheckRxStream(uint32_t Start, size_t Count) {
+  std::vector<uint32_t> Order;
+  for (size_t I = 0; I < Count; I++) {
+    uint32_t Seq = Start + (uint32_t)I;
+    if (I > 0 && Random() % 10 == 0) continue;
+    Order.push_back(Seq);
+    if (Random() % 20 == 0) Order.push_back(Seq);
+  }
+  for (size_t I = 1; I + 1 < Order.size(); I++) {
+    if (Random() % 8 == 0) {
+      size_t J = I + 1 + Random() % 8;
+      if (J < Order.size()) std::swap(Order[I], Order[J]);
+    }
+  }
+
+  WireRxStats_t Stats;
+  WireRxReset(&Stats);
+  std::set<uint32_t> Seen;
+  uint32_t Newest = Order[0];
+  uint32_t Received = 0, Lost = 0, Late = 0, Duplicates = 0;
+  for (size_t I = 0; I < Order.size(); I++) {
+    uint32_t Seq = Order[I];
+    WireHeader_t Header = {WIRE_AUDIO, WIRE_CODEC_PCM16, 0, Seq, (uint32_t)I * 20000};
+    WireRxTrack(&Stats, &Header, (uint32_t)I * 20000 + Random() % 5000);
+
+    int32_t Ahead = (int32_t)(Seq - Newest);
+    if (I == 0 || Ahead > 0) {
+      if (I > 0) Lost += (uint32_t)Ahead - 1;
+      Newest = Seq;
+      Seen.insert(Seq);
+      Received++;
+    } else if ((uint32_t)-Ahead >= WIRE_RX_WINDOW) {
+      // Too far back to tell a late message from a repeat
+      Received++;
+      Late++;
+    } else if (!Seen.insert(Seq).second) {
+      Duplicates++;
+    } else {
+      Received++;
+      Late++;
+      if (Lost > 0) Lost--;
+    }
+  }
+
+  bool Ok = Stats.Received == Received && Stats.Duplicates == Duplicates && Stats.Lost == Lost &&
+    Stats.Late == Late && Stats.NextSeq == Newest + 1;
+  if (!Ok) {
+    printf("FAIL: rx from %u: received %u/%u late %u/%u duplicates %u/%u lost %u/%u\n", Start, Stats.Received,
+      Received, Stats.Late, Late, Stats.Duplicates, Duplicates, Stats.Lost, Lost);
+  }
+  return Ok;
+}
+
+int main(int Argc, char** Argv) {
+  long Iterations = 1000000;
+
+  for (int I = 1; I < Argc; I++) {
+    const char* Value = I + 1 < Argc ? Argv[I + 1] : NULL;
+    if (Value && !strcmp(Argv[I], "--iterations")) {
+      Iterations = atol(Value);
+    } else if (Value && !strcmp(Argv[I], "--seed")) {
+      Seed = (uint32_t)strtoul(Value, NULL, 0);
+    } else {
+      fputs(USAGE, stderr);
+      return 2;
+    }
+    I++;
+  }
+  if (Iterations < 1 || Seed == 0) {
+    fputs(USAGE, stderr);
+    return 2;
+  }
+
+  if (!CheckRoundTrip()) return 1;
+  printf("Round trip: %zu message types ok\n", sizeof(TYPES));
+
+  long Accepted = 0;
+  for (long N = 0; N < Iterations; N++) {
+    std::vector<uint8_t> Message = MakeValid(TYPES[Random() % sizeof(TYPES)]);
+    Mutate(&Message);
+    if (!CheckParse(Message)) return 1;
+    Accepted += Expected(Message);
+  }
+  printf("Parser: %ld mutated messages, %ld accepted, all as the rules say\n", Iterations, Accepted);
+
+  // Start the wrap case just short of 2^32
+  const uint32_t STARTS[] = {0, 1000, 0xFFFFFF00u};
+  for (uint32_t Start : STARTS) {
+    for (int N = 0; N < 200; N++) {
+      if (!CheckRxStream(Start + Random() % 64, 2000)) return 1;
+    }
+  }
+  printf("Receive stats: %zu reordered streams, counts match\n", 3 * (size_t)200);
+  return 0;
+}
@@ -3,7 +3,9 @@
 import { EnergyVad } from "../lib/audio/EnergyVad.ts";
 import { RestClient } from "../lib/OpenAI/RestClient.ts";
 import { ChunkAudioData } from "../lib/audio/AudioUtils.ts";
-import { GetQuilPersona, DefaultVoice, DefaultLanguage, VadConfig } from "../lib/Config.ts";
+import { DecodeImaAdpcmBlock } from "../lib/audio/ImaAdpcm.ts";
+import { WireParse, WireWrite, WireReadU32, WireNowUs, WireRxStats, WireType, WireCodec, WireFlag, WireFramingName, type IWireFrame } from "../lib/protocol/WireProtocol.ts";
+import { GetQuilPersona, DefaultVoice, DefaultLanguage, VadConfig, AudioSampleRate } from "../lib/Config.ts";
 
 export interface IEsp32Session {
     Ws: WebSocket;
@@ -12,6 +14,30 @@ export interface IEsp32Session {
     IsActive: boolean;
     Voice: string;
     Language: string;
+    UplinkCodec: UplinkCodec;
+    DownlinkCodec: DownlinkCodec;
+    Dtx: boolean;
+    InPreRoll: boolean;  // Between preroll_start and preroll_end
+    Framing: boolean;    // Binary wire headers negotiated
+    TxSeq: number;
+    Rx: WireRxStats;
+}
+
+// Mic audio formats the server can accept from the device
+export type UplinkCodec = "pcm16" | "ima_adpcm";
+
+// Response audio formats the device can decode
+export type DownlinkCodec = "pcm16" | "mp3";
+
+// DTX comfort-noise marker: 'C', 'N', noise level (dB below full scale).
+// The device sends one per 200 ms of suppressed silence.
+const ComfortNoiseIntervalMs = 200;
+
+// Device mic frame length; pre-roll markers count frames
+const DeviceFrameMs = 20;
+
+function IsComfortNoiseMarker(Chunk: Uint8Array): boolean {
+    return Chunk.length === 3 && Chunk[0] === 0x43 && Chunk[1] === 0x4E;
 }
 
 const ActiveSessions = new Map<string, IEsp32Session>();
@@ -27,30 +53,45 @@ export function HandleEsp32Connection(Ws: WebSocket): void {
         IsActive: true,
         Voice: DefaultVoice,
         Language: DefaultLanguage,
+        UplinkCodec: "pcm16",
+        DownlinkCodec: "pcm16",
+        Dtx: false,
+        InPreRoll: false,
+        Framing: false,
+        TxSeq: 0,
+        Rx: new WireRxStats(),
     };
 
     ActiveSessions.set(SessionId, Session);
 
     // Setup VAD Handlers
     Session.Vad.onSpeechStart = () => {
-        console.log(`[Session ${SessionId}] User started speaking...`);
+        console.log(`[Session ${SessionId}] User started speaking${Session.InPreRoll ? " (in pre-roll)" : ""}...`);
     };
 
     Session.Vad.onSpeechEnd = async (AudioBuffer: Uint8Array) => {
         console.log(`[Session ${SessionId}] Speech processing... (${AudioBuffer.length} bytes)`);
         
         // Send to OpenAI
-        const ResponseAudio = await Session.RestClient.SendAudioInteraction(AudioBuffer, Session.Voice, GetQuilPersona(Session.Language));
+        const ResponseAudio = await Session.RestClient.SendAudioInteraction(AudioBuffer, Session.Voice, GetQuilPersona(Session.Language), Session.DownlinkCodec);
         
         if (ResponseAudio) {
             console.log(`[Session ${SessionId}] Playing response...`);
             // Stream back to ESP32
             // We need to chunk it because ESP32 buffer is small
              const Chunks = ChunkAudioData(ResponseAudio, 1024);
-             for (const Chunk of Chunks) {
-                 if (Ws.readyState === WebSocket.OPEN) {
+             const Codec = Session.DownlinkCodec === "mp3" ? WireCodec.Mp3 : WireCodec.Pcm16;
+             Chunks.forEach((Chunk, Index) => {
+                 if (Ws.readyState !== WebSocket.OPEN) return;
+                 if (Session.Framing) {
+                     const Flags = Index === Chunks.length - 1 ? WireFlag.End : 0;
+                     Ws.send(WireWrite(WireType.Audio, Codec, Flags, Session.TxSeq++, WireNowUs(), Chunk));
+                 } else {
                      Ws.send(Chunk);
                  }
+             });
+             if (Session.Framing && Ws.readyState === WebSocket.OPEN) {
+                 Ws.send(WireWrite(WireType.ResponseComplete, WireCodec.None, 0, Session.TxSeq++, WireNowUs()));
              }
         } else {
             console.log(`[Session ${SessionId}] No audio response.`);
@@ -65,16 +106,38 @@ export function HandleEsp32Connection(Ws: WebSocket): void {
                 if (Message.type === "config") {
                      Session.Voice = Message.voice || DefaultVoice;
                      Session.Language = Message.language || DefaultLanguage;
-                     console.log(`[Session ${SessionId}] Configured: voice=${Session.Voice}, language=${Session.Language}`);
-                     // Send Auth/Ready
-                     Ws.send(JSON.stringify({ type: "auth", status: "connected", voice: Session.Voice, language: Session.Language }));
+                     Session.UplinkCodec = Message.uplink_codec === "ima_adpcm" ? "ima_adpcm" : "pcm16";
+                     Session.DownlinkCodec = Message.downlink_codec === "mp3" ? "mp3" : "pcm16";
+                     Session.Dtx = Message.dtx === true;
+                     Session.Framing = Message.framing === WireFramingName;
+                     console.log(`[Session ${SessionId}] Configured: voice=${Session.Voice}, language=${Session.Language}, uplink=${Session.UplinkCodec}, downlink=${Session.DownlinkCodec}, dtx=${Session.Dtx}, framing=${Session.Framing}`);
+                     // Send Auth/Ready (uplink_codec/downlink_codec/dtx acknowledge the negotiated formats,
+                     // sample_rate is what audio is exchanged at; the device resamples to it)
+                     Ws.send(JSON.stringify({ type: "auth", status: "connected", voice: Session.Voice, language: Session.Language, uplink_codec: Session.UplinkCodec, downlink_codec: Session.DownlinkCodec, dtx: Session.Dtx, sample_rate: AudioSampleRate, framing: Session.Framing ? WireFramingName : "none" }));
                 } else if (Message.type === "instruction" && Message.msg === "ping") {
                     Ws.send(JSON.stringify({ type: "pong" }));
+                } else if (Message.type === "instruction" && (Message.msg === "preroll_start" || Message.msg === "preroll_end")) {
+                    // Buffered audio from before the stream: it arrives in a burst but
+                    // is ordinary, continuous audio for the VAD
+                    Session.InPreRoll = Message.msg === "preroll_start";
+                    console.log(`[Session ${SessionId}] Pre-roll ${Session.InPreRoll ? "start" : "end"}: ${Message.ms ?? 0} ms`);
+                }
+            } else if (Event.data instanceof ArrayBuffer && Session.Framing) {
+                const Frame = WireParse(new Uint8Array(Event.data));
+                if (!Frame) {
+                    Session.Rx.Malformed++;
+                    return;
                 }
+                Session.Rx.Track(Frame, WireNowUs());
+                HandleWireFrame(Session, SessionId, Frame);
             } else if (Event.data instanceof ArrayBuffer) {
                 // Audio Data
                 const Chunk = new Uint8Array(Event.data);
-                Session.Vad.Process(Chunk);
+                if (Session.Dtx && IsComfortNoiseMarker(Chunk)) {
+                    Session.Vad.ProcessSilence(AudioSampleRate * ComfortNoiseIntervalMs / 1000);
+                    return;
+                }
+                Session.Vad.Process(Session.UplinkCodec === "ima_adpcm" ? DecodeImaAdpcmBlock(Chunk) : Chunk);
             }
         } catch (Err) {
             console.error("Handler Error:", Err);
@@ -82,7 +145,7 @@ export function HandleEsp32Connection(Ws: WebSocket): void {
     };
 
     Ws.onclose = () => {
-        console.log(`[ESP32] Connection closed: ${SessionId}`);
+        console.log(`[ESP32] Connection closed: ${SessionId}${Session.Framing ? ` (uplink ${Session.Rx})` : ""}`);
         ActiveSessions.delete(SessionId);
     };
 
@@ -98,6 +161,27 @@ export function HandleEsp32Connection(Ws: WebSocket): void {
     }));
 }
 
+function HandleWireFrame(Session: IEsp32Session, SessionId: string, Frame: IWireFrame): void {
+    switch (Frame.Type) {
+        case WireType.Audio:
+            Session.Vad.Process(Frame.Codec === WireCodec.ImaAdpcm ? DecodeImaAdpcmBlock(Frame.Payload) : Frame.Payload);
+            break;
+        case WireType.ComfortNoise:
+            if (Session.Dtx) Session.Vad.ProcessSilence(AudioSampleRate * ComfortNoiseIntervalMs / 1000);
+            break;
+        case WireType.Ping:
+            Session.Ws.send(WireWrite(WireType.Pong, WireCodec.None, 0, Session.TxSeq++, WireNowUs()));
+            break;
+        case WireType.PreRollStart:
+        case WireType.PreRollEnd:
+            Session.InPreRoll = Frame.Type === WireType.PreRollStart;
+            console.log(`[Session ${SessionId}] Pre-roll ${Session.InPreRoll ? "start" : "end"}: ${WireReadU32(Frame.Payload) * DeviceFrameMs} ms`);
+            break;
+        default:
+            break;
+    }
+}
+
 export function GetActiveSessionCount(): number {
     return ActiveSessions.size;
 }
@@ -2,7 +2,8 @@ import { OpenAiApiKey } from "../Config.ts";
 import { EncodeBase64, DecodeBase64 } from "../audio/AudioUtils.ts";
 
 export class RestClient {
-    public async SendAudioInteraction(AudioData: Uint8Array, Voice: string = "alloy", Instructions: string = ""): Promise<Uint8Array | null> {
+    // OutputFormat: "pcm16" (raw 24kHz) or "mp3" for devices that decode on-board
+    public async SendAudioInteraction(AudioData: Uint8Array, Voice: string = "alloy", Instructions: string = "", OutputFormat: "pcm16" | "mp3" = "pcm16"): Promise<Uint8Array | null> {
         const Base64Audio = EncodeBase64(AudioData);
 
         const Payload = {
@@ -10,7 +11,7 @@ export class RestClient {
             modalities: ["text", "audio"],
             audio: {
                 voice: Voice,
-                format: "pcm16"
+                format: OutputFormat
             },
             messages: [
                 {
@@ -63,6 +63,17 @@ export class EnergyVad {
         }
     }
 
+    // Silence the device did not transmit (DTX comfort-noise marker).
+    // Zero PCM keeps the committed buffer's timing intact.
+    public ProcessSilence(Samples: number): void {
+        this.Process(new Uint8Array(Samples * 2));
+    }
+
+    // End the turn now (device sent end_of_speech); nothing if no speech yet
+    public Flush(): void {
+        if (this.state === "speech") this.Commit();
+    }
+
     private Commit(): void {
         console.log(`[VAD] Speech Committed (${this.buffer.length} chunks)`);
         
@@ -0,0 +1,71 @@
+/// <reference lib="deno.ns" />
+
+// IMA-ADPCM reference decoder for the ESP32 mic uplink
+// Block layout (matches firmware dsp/ImaAdpcm):
+//   int16 predictor (LE) | uint8 step index | uint8 flags | 4-bit codes
+// The header carries the coder state before the block; the first sample of
+// each byte is in the low nibble. With ImaAdpcmFlagOdd set the block holds an
+// odd sample count and the high nibble of its last byte is padding.
+
+export const ImaAdpcmHeaderBytes = 4;
+export const ImaAdpcmFlagOdd = 0x01;
+
+const IndexTable: number[] = [
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8,
+];
+
+const StepTable: number[] = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+];
+
+function ClampIndex(Index: number): number {
+    return Index < 0 ? 0 : Index > 88 ? 88 : Index;
+}
+
+function Clamp16(Value: number): number {
+    return Value > 32767 ? 32767 : Value < -32768 ? -32768 : Value;
+}
+
+// Decode one block to PCM16 little-endian bytes (same format as the raw uplink)
+export function DecodeImaAdpcmBlock(Block: Uint8Array): Uint8Array {
+    if (Block.length < ImaAdpcmHeaderBytes) {
+        return new Uint8Array(0);
+    }
+
+    const View = new DataView(Block.buffer, Block.byteOffset, Block.byteLength);
+    let Predictor = View.getInt16(0, true);
+    let Index = ClampIndex(Block[2]);
+
+    let SampleCount = (Block.length - ImaAdpcmHeaderBytes) * 2;
+    if ((Block[3] & ImaAdpcmFlagOdd) && SampleCount > 0) SampleCount--;
+    const Pcm = new Uint8Array(SampleCount * 2);
+    const Out = new DataView(Pcm.buffer);
+
+    let Sample = 0;
+    for (let B = ImaAdpcmHeaderBytes; B < Block.length; B++) {
+        for (const Code of [Block[B] & 0x0f, Block[B] >> 4]) {
+            if (Sample >= SampleCount) break;
+            const Step = StepTable[Index];
+            let Delta = Step >> 3;
+            if (Code & 4) Delta += Step;
+            if (Code & 2) Delta += Step >> 1;
+            if (Code & 1) Delta += Step >> 2;
+
+            Predictor = Clamp16(Predictor + ((Code & 8) ? -Delta : Delta));
+            Index = ClampIndex(Index + IndexTable[Code]);
+            Out.setInt16(Sample * 2, Predictor, true);
+            Sample++;
+        }
+    }
+
+    return Pcm;
+}
@@ -0,0 +1,174 @@
+/// <reference lib="deno.ns" />
+
+// Binary framing for the ESP32 socket (matches firmware core/WireProtocol).
+// Negotiated with "framing":"quil1" in config/auth. Every binary message
+// starts with a 12-byte little-endian header:
+//   uint8 Type | uint8 Codec | uint8 Flags | uint8 Version |
+//   uint32 Seq (+1 per message, per direction) | uint32 Timestamp (us, wrapping)
+// followed by the payload.
+
+export const WireHeaderBytes = 12;
+export const WireVersion = 1;
+export const WireFramingName = "quil1";
+
+export const WireType = {
+    Audio: 0x01,
+    ComfortNoise: 0x02,        // uint8 noise level, dB below full scale
+    EndOfSpeech: 0x10,
+    Ping: 0x11,
+    Interrupt: 0x12,
+    PreRollStart: 0x13,        // uint32 frames that follow
+    PreRollEnd: 0x14,          // uint32 frames sent
+    Pong: 0x20,
+    ResponseComplete: 0x21,
+    AudioCommitted: 0x22,
+    Error: 0x2F,               // UTF-8 message
+} as const;
+
+export const WireCodec = {
+    None: 0,
+    Pcm16: 1,
+    ImaAdpcm: 2,
+    Mp3: 3,
+} as const;
+
+export const WireFlag = {
+    PreRoll: 0x01,
+    Discontinuity: 0x02,
+    End: 0x04,
+} as const;
+
+export interface IWireFrame {
+    Type: number;
+    Codec: number;
+    Flags: number;
+    Seq: number;
+    TimestampUs: number;
+    Payload: Uint8Array;
+}
+
+// Exact payload size per type, -1 for any
+const PayloadRules = new Map<number, number>([
+    [WireType.Audio, -1],
+    [WireType.ComfortNoise, 1],
+    [WireType.EndOfSpeech, 0],
+    [WireType.Ping, 0],
+    [WireType.Interrupt, 0],
+    [WireType.PreRollStart, 4],
+    [WireType.PreRollEnd, 4],
+    [WireType.Pong, 0],
+    [WireType.ResponseComplete, 0],
+    [WireType.AudioCommitted, 0],
+    [WireType.Error, -1],
+]);
+
+export function WireWrite(Type: number, Codec: number, Flags: number, Seq: number, TimestampUs: number, Payload?: Uint8Array): Uint8Array {
+    const Bytes = new Uint8Array(WireHeaderBytes + (Payload?.length ?? 0));
+    const View = new DataView(Bytes.buffer);
+    Bytes[0] = Type;
+    Bytes[1] = Codec;
+    Bytes[2] = Flags;
+    Bytes[3] = WireVersion;
+    View.setUint32(4, Seq >>> 0, true);
+    View.setUint32(8, TimestampUs >>> 0, true);
+    if (Payload) Bytes.set(Payload, WireHeaderBytes);
+    return Bytes;
+}
+
+// Validate and split one message; null for anything malformed
+export function WireParse(Data: Uint8Array): IWireFrame | null {
+    if (Data.length < WireHeaderBytes || Data[3] !== WireVersion) return null;
+
+    const Rule = PayloadRules.get(Data[0]);
+    if (Rule === undefined) return null;
+    const Bytes = Data.length - WireHeaderBytes;
+    if (Rule >= 0 && Bytes !== Rule) return null;
+
+    const Codec = Data[1];
+    if (Data[0] === WireType.Audio) {
+        if (Codec < WireCodec.Pcm16 || Codec > WireCodec.Mp3 || Bytes === 0) return null;
+        if (Codec === WireCodec.Pcm16 && Bytes % 2 !== 0) return null;
+    } else if (Codec !== WireCodec.None) {
+        return null;
+    }
+
+    const View = new DataView(Data.buffer, Data.byteOffset, Data.byteLength);
+    return {
+        Type: Data[0],
+        Codec,
+        Flags: Data[2],
+        Seq: View.getUint32(4, true),
+        TimestampUs: View.getUint32(8, true),
+        Payload: Data.subarray(WireHeaderBytes),
+    };
+}
+
+export function WireU32(Value: number): Uint8Array {
+    const Bytes = new Uint8Array(4);
+    new DataView(Bytes.buffer).setUint32(0, Value >>> 0, true);
+    return Bytes;
+}
+
+export function WireReadU32(Payload: Uint8Array): number {
+    return new DataView(Payload.buffer, Payload.byteOffset, Payload.byteLength).getUint32(0, true);
+}
+
+// Microsecond clock for outgoing timestamps (wraps like the device's)
+export function WireNowUs(): number {
+    return Math.floor(performance.now() * 1000) >>> 0;
+}
+
+// Sequence numbers remembered behind the newest, to tell late from repeated
+const RX_WINDOW = 32;
+
+// Receive-side loss and RFC 3550 interarrival jitter
+export class WireRxStats {
+    Received = 0;
+    Lost = 0;
+    Late = 0;
+    Duplicates = 0;
+    Malformed = 0;
+    JitterUs = 0;
+    private NextSeq = -1;
+    private Seen = 0;  // Bit N: NextSeq - 1 - N arrived
+    private LastTimestampUs = 0;
+    private LastArrivalUs = 0;
+
+    Track(Frame: IWireFrame, ArrivalUs: number): void {
+        if (this.NextSeq < 0) {
+            this.Seen = 1;
+        } else {
+            const Ahead = (Frame.Seq - this.NextSeq) | 0;
+            if (Ahead < 0) {
+                const Back = -(Ahead + 1);
+                if (Back >= RX_WINDOW) {
+                    // Too old to tell from a repeat: late, Lost left alone
+                    this.Received++;
+                    this.Late++;
+                    return;
+                }
+                if (this.Seen & (1 << Back)) {
+                    this.Duplicates++;
+                    return;
+                }
+                this.Seen |= 1 << Back;
+                this.Received++;
+                this.Late++;
+                if (this.Lost > 0) this.Lost--;
+                return;
+            }
+            this.Lost += Ahead;
+            this.Seen = Ahead + 1 >= RX_WINDOW ? 1 : (this.Seen << (Ahead + 1)) | 1;
+            const D = (((ArrivalUs - this.LastArrivalUs) >>> 0) | 0) - (((Frame.TimestampUs - this.LastTimestampUs) >>> 0) | 0);
+            this.JitterUs += (Math.min(Math.abs(D), 10_000_000) - this.JitterUs) / 16;
+        }
+        this.Received++;
+        this.NextSeq = (Frame.Seq + 1) >>> 0;
+        this.LastTimestampUs = Frame.TimestampUs;
+        this.LastArrivalUs = ArrivalUs;
+    }
+
+    toString(): string {
+        return `received=${this.Received} lost=${this.Lost} late=${this.Late} duplicate=${this.Duplicates} malformed=${this.Malformed} jitter=${Math.round(this.JitterUs)}us`;
+    }
+}
@@ -0,0 +1,89 @@
+/// <reference lib="deno.ns" />
+
+// Network impairment for the mock server: one shaper per direction delays
+// every message by a fixed latency plus uniform jitter, serialises it over
+// a bandwidth-capped link and can drop audio. Delivery order is kept, as it
+// would be on the TCP connection underneath a WebSocket; "dropped" audio
+// models a frame the sender gave up on (the sequence gap shows it).
+
+export interface ILinkProfile {
+    DelayMs: number;       // Added to every message
+    JitterMs: number;      // Extra delay, uniform in [0, JitterMs)
+    BandwidthBps: number;  // Bytes per second, 0 = unlimited
+    DropRate: number;      // Fraction of audio messages discarded (0..1)
+}
+
+export const IdealLink: ILinkProfile = { DelayMs: 0, JitterMs: 0, BandwidthBps: 0, DropRate: 0 };
+
+// Mulberry32: small, fast and reproducible for a given --seed
+export class SeededRandom {
+    private State: number;
+
+    constructor(Seed: number) {
+        this.State = Seed >>> 0;
+    }
+
+    Next(): number {
+        this.State = (this.State + 0x6D2B79F5) >>> 0;
+        let T = this.State;
+        T = Math.imul(T ^ (T >>> 15), T | 1);
+        T ^= T + Math.imul(T ^ (T >>> 7), T | 61);
+        return ((T ^ (T >>> 14)) >>> 0) / 4294967296;
+    }
+}
+
+export type LinkPayload = Uint8Array | string;
+
+export class LinkShaper {
+    Sent = 0;
+    SentBytes = 0;
+    Dropped = 0;
+    MaxQueueMs = 0;        // Longest wait behind the bandwidth cap
+    private BusyUntilMs = 0;
+    private LastArrivalMs = 0;
+    private Timers = new Set<number>();
+
+    constructor(private Profile: ILinkProfile, private Random: SeededRandom) { }
+
+    // Deliver(Data) runs once the message has "arrived"
+    Send(Data: LinkPayload, Droppable: boolean, Deliver: (Data: LinkPayload) => void): void {
+        if (Droppable && this.Profile.DropRate > 0 && this.Random.Next() < this.Profile.DropRate) {
+            this.Dropped++;
+            return;
+        }
+
+        const NowMs = performance.now();
+        const Bytes = Data.length;
+        const StartMs = Math.max(NowMs, this.BusyUntilMs);
+        const WireMs = this.Profile.BandwidthBps > 0 ? Bytes * 1000 / this.Profile.BandwidthBps : 0;
+        this.BusyUntilMs = StartMs + WireMs;
+        this.MaxQueueMs = Math.max(this.MaxQueueMs, StartMs - NowMs);
+
+        const Jitter = this.Profile.JitterMs > 0 ? this.Random.Next() * this.Profile.JitterMs : 0;
+        const ArrivalMs = Math.max(this.BusyUntilMs + this.Profile.DelayMs + Jitter, this.LastArrivalMs);
+        this.LastArrivalMs = ArrivalMs;
+        this.Sent++;
+        this.SentBytes += Bytes;
+
+        const WaitMs = ArrivalMs - NowMs;
+        if (WaitMs <= 0) {
+            Deliver(Data);
+            return;
+        }
+        const Timer = setTimeout(() => {
+            this.Timers.delete(Timer);
+            Deliver(Data);
+        }, WaitMs);
+        this.Timers.add(Timer);
+    }
+
+    // Forget everything in flight (connection closed)
+    Cancel(): void {
+        for (const Timer of this.Timers) clearTimeout(Timer);
+        this.Timers.clear();
+    }
+
+    toString(): string {
+        return `sent=${this.Sent} bytes=${this.SentBytes} dropped=${this.Dropped} maxQueue=${Math.round(this.MaxQueueMs)}ms`;
+    }
+}
@@ -0,0 +1,411 @@
+/// <reference lib="deno.ns" />
+
+// Quil Mock Server
+// Offline stand-in for the voice server: same /ws protocol (config/auth,
+// instruction, server, error JSON messages, PCM16 or IMA-ADPCM audio, quil1
+// framing), but the response is the user's own utterance echoed back or a
+// synthesized tone instead of an OpenAI reply. Latency, jitter, bandwidth
+// caps, audio loss and disconnects are injected per direction, and every
+// turn's timing is logged, so jitter buffering, reconnects and throughput
+// can be benchmarked reproducibly.
+//
+//   deno task Mock --delay 80 --jitter 40 --bandwidth 32000 --log mock.jsonl
+
+import { parseArgs } from "@std/cli/parse_args.ts";
+import { EnergyVad } from "../lib/audio/EnergyVad.ts";
+import { ChunkAudioData } from "../lib/audio/AudioUtils.ts";
+import { DecodeImaAdpcmBlock } from "../lib/audio/ImaAdpcm.ts";
+import { WireParse, WireWrite, WireReadU32, WireNowUs, WireRxStats, WireType, WireCodec, WireFlag, WireFramingName, type IWireFrame } from "../lib/protocol/WireProtocol.ts";
+import { VadConfig, AudioSampleRate, DefaultVoice, DefaultLanguage } from "../lib/Config.ts";
+import { LinkShaper, SeededRandom, type ILinkProfile, type LinkPayload } from "./LinkShaper.ts";
+
+const Usage = `deno task Mock [options]
+  --port N              listen port (default 8000)
+  --rate HZ             session sample rate sent in auth (default ${AudioSampleRate})
+  --response echo|tone  play the utterance back, or a tone (default echo)
+  --tone-ms N           tone length (default 1500)
+  --max-response-ms N   cap on echoed audio (default 10000)
+  --think-ms N          delay from commit to the first response chunk (default 300)
+  --pace burst|realtime send the response at once, as the server does, or at 1x (default burst)
+  --chunk N             response chunk bytes (default 1024)
+  --delay MS            one-way latency, both directions
+  --jitter MS           extra uniform delay, both directions
+  --bandwidth BPS       bytes per second cap, both directions (0 = none)
+  --loss P              fraction of audio messages dropped, both directions
+  --down-* / --up-*     the same four, for one direction (e.g. --down-loss 0.05)
+  --disconnect-ms N     close each session N ms after auth
+  --refuse N            answer the first N connection attempts with 503
+  --error-every N       answer every Nth turn with an error message instead of audio
+  --seed N              random seed for jitter and loss (default 1)
+  --log PATH            append timing events as JSON lines`;
+
+const Args = parseArgs(Deno.args, {
+    string: ["response", "pace", "log"],
+    boolean: ["help"],
+    default: {
+        port: 8000, rate: AudioSampleRate, response: "echo", "tone-ms": 1500, "max-response-ms": 10000,
+        "think-ms": 300, pace: "burst", chunk: 1024, delay: 0, jitter: 0, bandwidth: 0, loss: 0,
+        "disconnect-ms": 0, refuse: 0, "error-every": 0, seed: 1,
+    },
+});
+
+if (Args.help) {
+    console.log(Usage);
+    Deno.exit(0);
+}
+
+function Num(Name: string, Fallback = 0): number {
+    const Value = Number((Args as Record<string, unknown>)[Name] ?? Fallback);
+    if (!Number.isFinite(Value) || Value < 0) {
+        console.error(`[Mock] --${Name} must be a non-negative number\n${Usage}`);
+        Deno.exit(2);
+    }
+    return Value;
+}
+
+function LinkFor(Direction: "down" | "up"): ILinkProfile {
+    return {
+        DelayMs: Num(`${Direction}-delay`, Num("delay")),
+        JitterMs: Num(`${Direction}-jitter`, Num("jitter")),
+        BandwidthBps: Num(`${Direction}-bandwidth`, Num("bandwidth")),
+        DropRate: Math.min(1, Num(`${Direction}-loss`, Num("loss"))),
+    };
+}
+
+const Port = Num("port");
+const SessionRate = Num("rate");
+const ToneResponse = Args.response === "tone";
+const ToneMs = Num("tone-ms");
+const MaxResponseMs = Num("max-response-ms");
+const ThinkMs = Num("think-ms");
+const RealtimePace = Args.pace === "realtime";
+const ChunkBytes = Math.max(2, Num("chunk") & ~1);
+const DisconnectMs = Num("disconnect-ms");
+const ErrorEvery = Num("error-every");
+const DownLink = LinkFor("down");
+const UpLink = LinkFor("up");
+const Random = new SeededRandom(Num("seed"));
+let RefuseLeft = Num("refuse");
+
+// Device mic frame length; pre-roll markers count frames
+const DeviceFrameMs = 20;
+const ComfortNoiseIntervalMs = 200;
+
+interface IMockSession {
+    Id: number;
+    Ws: WebSocket;
+    Vad: EnergyVad;
+    Down: LinkShaper;
+    Up: LinkShaper;
+    Rx: WireRxStats;
+    Framing: boolean;
+    UplinkCodec: "pcm16" | "ima_adpcm";
+    Dtx: boolean;
+    TxSeq: number;
+    Turns: number;
+    ResponseId: number;       // Bumped to cancel the response in flight
+    OpenedMs: number;
+    UplinkBytes: number;
+}
+
+let NextSessionId = 1;
+let ActiveSessions = 0;
+let TotalTurns = 0;
+let Refused = 0;
+
+const LogFile = Args.log ? await Deno.open(Args.log, { create: true, append: true }) : null;
+const Encoder = new TextEncoder();
+
+function Log(Session: IMockSession | null, Event: string, Fields: Record<string, unknown> = {}): void {
+    const Ms = Math.round(performance.now() * 10) / 10;
+    const Line = { Ms, Session: Session?.Id ?? 0, Event, ...Fields };
+    console.log(`[Mock ${Session?.Id ?? "-"}] ${Event} ${JSON.stringify(Fields)}`);
+    LogFile?.writeSync(Encoder.encode(JSON.stringify(Line) + "\n"));
+}
+
+// Outgoing messages go through the downlink shaper
+function Send(Session: IMockSession, Data: LinkPayload, IsAudio: boolean, Delivered?: () => void): void {
+    Session.Down.Send(Data, IsAudio, (Payload) => {
+        if (Session.Ws.readyState !== WebSocket.OPEN) return;
+        Session.Ws.send(Payload);
+        Delivered?.();
+    });
+}
+
+function SendServerEvent(Session: IMockSession, Msg: string, WireEvent: number): void {
+    if (Session.Framing) {
+        Send(Session, WireWrite(WireEvent, WireCodec.None, 0, Session.TxSeq++, WireNowUs()), false);
+    } else {
+        Send(Session, JSON.stringify({ type: "server", msg: Msg }), false);
+    }
+}
+
+function SynthesizeTone(Ms: number): Uint8Array {
+    const Samples = Math.round(SessionRate * Ms / 1000);
+    const Pcm = new Uint8Array(Samples * 2);
+    const View = new DataView(Pcm.buffer);
+    const FadeSamples = Math.min(Samples / 2, SessionRate / 100);  // 10 ms, no clicks
+    for (let I = 0; I < Samples; I++) {
+        const Fade = Math.min(1, I / FadeSamples, (Samples - 1 - I) / FadeSamples);
+        // 440 Hz with a slow tremolo, so gaps and repeats are audible
+        const Level = 8000 * Fade * (0.75 + 0.25 * Math.sin(2 * Math.PI * 3 * I / SessionRate));
+        View.setInt16(I * 2, Math.round(Level * Math.sin(2 * Math.PI * 440 * I / SessionRate)), true);
+    }
+    return Pcm;
+}
+
+function Respond(Session: IMockSession, Utterance: Uint8Array, CommitMs: number): void {
+    const Turn = ++Session.Turns;
+    TotalTurns++;
+    const ResponseId = ++Session.ResponseId;
+    SendServerEvent(Session, "AUDIO.COMMITTED", WireType.AudioCommitted);
+    Log(Session, "commit", { Turn, UtteranceMs: Math.round(Utterance.length / 2 * 1000 / SessionRate) });
+
+    setTimeout(() => {
+        if (ResponseId !== Session.ResponseId || Session.Ws.readyState !== WebSocket.OPEN) return;
+
+        if (ErrorEvery > 0 && Turn % ErrorEvery === 0) {
+            Send(Session, JSON.stringify({ type: "error", message: "mock: injected error" }), false);
+            Log(Session, "error", { Turn });
+            return;
+        }
+
+        const MaxBytes = Math.round(SessionRate * MaxResponseMs / 1000) * 2;
+        const Audio = ToneResponse ? SynthesizeTone(ToneMs) : Utterance.subarray(0, MaxBytes);
+        const Chunks = ChunkAudioData(Audio, ChunkBytes);
+        if (Chunks.length === 0) {
+            SendServerEvent(Session, "RESPONSE.COMPLETE", WireType.ResponseComplete);
+            return;
+        }
+
+        const StartMs = performance.now();
+        let FirstDeliveredMs = 0;
+        let Delivered = 0;
+        const SendChunk = (Index: number) => {
+            if (ResponseId !== Session.ResponseId) return;
+            const Chunk = Chunks[Index];
+            const Last = Index === Chunks.length - 1;
+            const Payload = Session.Framing
+                ? WireWrite(WireType.Audio, WireCodec.Pcm16, Last ? WireFlag.End : 0, Session.TxSeq++, WireNowUs(), Chunk)
+                : Chunk;
+            Send(Session, Payload, true, () => {
+                const NowMs = performance.now();
+                if (Delivered++ === 0) FirstDeliveredMs = NowMs;
+                if (!Last) return;
+                const AudioMs = Audio.length / 2 * 1000 / SessionRate;
+                const SpanMs = NowMs - StartMs;
+                Log(Session, "response", {
+                    Turn,
+                    CommitToFirstMs: Math.round(FirstDeliveredMs - CommitMs),
+                    SpanMs: Math.round(SpanMs),
+                    AudioMs: Math.round(AudioMs),
+                    Chunks: Chunks.length,
+                    Delivered,
+                    Bps: SpanMs > 0 ? Math.round(Audio.length * 1000 / SpanMs) : 0,
+                });
+            });
+            if (Last) SendServerEvent(Session, "RESPONSE.COMPLETE", WireType.ResponseComplete);
+        };
+
+        if (!RealtimePace) {
+            Chunks.forEach((_, Index) => SendChunk(Index));
+            return;
+        }
+        // One chunk per chunk duration, against the start time so timer slack does not add up
+        const ChunkMs = ChunkBytes / 2 * 1000 / SessionRate;
+        const SendPaced = (Index: number) => {
+            SendChunk(Index);
+            if (Index + 1 < Chunks.length && ResponseId === Session.ResponseId) {
+                setTimeout(() => SendPaced(Index + 1), StartMs + (Index + 1) * ChunkMs - performance.now());
+            }
+        };
+        SendPaced(0);
+    }, ThinkMs);
+}
+
+function HandleConfig(Session: IMockSession, Message: Record<string, unknown>): void {
+    Session.UplinkCodec = Message.uplink_codec === "ima_adpcm" ? "ima_adpcm" : "pcm16";
+    Session.Dtx = Message.dtx === true;
+    Session.Framing = Message.framing === WireFramingName;
+    // Response audio is always PCM16: MP3 is not acknowledged, so the device falls back
+    Send(Session, JSON.stringify({
+        type: "auth", status: "connected", voice: Message.voice ?? DefaultVoice, language: Message.language ?? DefaultLanguage,
+        uplink_codec: Session.UplinkCodec, downlink_codec: "pcm16", dtx: Session.Dtx, sample_rate: SessionRate,
+        framing: Session.Framing ? WireFramingName : "none",
+    }), false);
+    Log(Session, "auth", { Uplink: Session.UplinkCodec, Dtx: Session.Dtx, Framing: Session.Framing, ConfigMs: Math.round(performance.now() - Session.OpenedMs) });
+
+    if (DisconnectMs > 0) {
+        setTimeout(() => {
+            if (Session.Ws.readyState !== WebSocket.OPEN) return;
+            Log(Session, "disconnect", { AfterMs: DisconnectMs });
+            Session.Ws.close(1001, "mock disconnect");
+        }, DisconnectMs);
+    }
+}
+
+function HandleInstruction(Session: IMockSession, Msg: string, Message: Record<string, unknown>): void {
+    if (Msg === "ping") {
+        Send(Session, JSON.stringify({ type: "pong" }), false);
+    } else if (Msg === "end_of_speech") {
+        Session.Vad.Flush();
+    } else if (Msg === "INTERRUPT") {
+        Session.ResponseId++;
+        Log(Session, "interrupt");
+    } else if (Msg === "preroll_start" || Msg === "preroll_end") {
+        Log(Session, Msg, { Ms: Message.ms ?? 0 });
+    }
+}
+
+function HandleWireFrame(Session: IMockSession, Frame: IWireFrame): void {
+    switch (Frame.Type) {
+        case WireType.Audio:
+            Session.Vad.Process(Frame.Codec === WireCodec.ImaAdpcm ? DecodeImaAdpcmBlock(Frame.Payload) : Frame.Payload);
+            break;
+        case WireType.ComfortNoise:
+            if (Session.Dtx) Session.Vad.ProcessSilence(SessionRate * ComfortNoiseIntervalMs / 1000);
+            break;
+        case WireType.Ping:
+            Send(Session, WireWrite(WireType.Pong, WireCodec.None, 0, Session.TxSeq++, WireNowUs()), false);
+            break;
+        case WireType.EndOfSpeech:
+            Session.Vad.Flush();
+            break;
+        case WireType.Interrupt:
+            Session.ResponseId++;
+            Log(Session, "interrupt");
+            break;
+        case WireType.PreRollStart:
+        case WireType.PreRollEnd:
+            Log(Session, Frame.Type === WireType.PreRollStart ? "preroll_start" : "preroll_end", { Ms: WireReadU32(Frame.Payload) * DeviceFrameMs });
+            break;
+        default:
+            break;
+    }
+}
+
+// Runs once the uplink shaper has delivered the message
+function HandleMessage(Session: IMockSession, Data: LinkPayload): void {
+    try {
+        if (typeof Data === "string") {
+            const Message = JSON.parse(Data);
+            if (Message.type === "config") {
+                HandleConfig(Session, Message);
+            } else if (Message.type === "instruction" && typeof Message.msg === "string") {
+                HandleInstruction(Session, Message.msg, Message);
+            }
+            return;
+        }
+        Session.UplinkBytes += Data.length;
+        if (Session.Framing) {
+            const Frame = WireParse(Data);
+            if (!Frame) {
+                Session.Rx.Malformed++;
+                return;
+            }
+            Session.Rx.Track(Frame, WireNowUs());
+            HandleWireFrame(Session, Frame);
+        } else if (Session.Dtx && Data.length === 3 && Data[0] === 0x43 && Data[1] === 0x4E) {
+            Session.Vad.ProcessSilence(SessionRate * ComfortNoiseIntervalMs / 1000);
+        } else {
+            Session.Vad.Process(Session.UplinkCodec === "ima_adpcm" ? DecodeImaAdpcmBlock(Data) : Data);
+        }
+    } catch (Err) {
+        console.error("[Mock] Handler error:", Err);
+    }
+}
+
+// Audio is the only thing the uplink shaper may drop
+function IsUplinkAudio(Session: IMockSession, Data: Uint8Array): boolean {
+    if (Session.Framing) return Data.length > 0 && Data[0] === WireType.Audio;
+    return !(Data.length === 3 && Data[0] === 0x43 && Data[1] === 0x4E);
+}
+
+function HandleConnection(Ws: WebSocket): void {
+    const Session: IMockSession = {
+        Id: NextSessionId++,
+        Ws,
+        Vad: new EnergyVad(VadConfig),
+        Down: new LinkShaper(DownLink, Random),
+        Up: new LinkShaper(UpLink, Random),
+        Rx: new WireRxStats(),
+        Framing: false,
+        UplinkCodec: "pcm16",
+        Dtx: false,
+        TxSeq: 0,
+        Turns: 0,
+        ResponseId: 0,
+        OpenedMs: performance.now(),
+        UplinkBytes: 0,
+    };
+    ActiveSessions++;
+    Log(Session, "open");
+
+    Session.Vad.onSpeechEnd = (Utterance: Uint8Array) => Respond(Session, Utterance, performance.now());
+
+    Ws.binaryType = "arraybuffer";
+    Ws.onmessage = (Event: MessageEvent) => {
+        const Data: LinkPayload = typeof Event.data === "string" ? Event.data : new Uint8Array(Event.data as ArrayBuffer);
+        const IsAudio = typeof Data !== "string" && IsUplinkAudio(Session, Data);
+        Session.Up.Send(Data, IsAudio, (Payload) => HandleMessage(Session, Payload));
+    };
+
+    Ws.onclose = () => {
+        ActiveSessions--;
+        Session.ResponseId++;
+        Session.Down.Cancel();
+        Session.Up.Cancel();
+        const Seconds = (performance.now() - Session.OpenedMs) / 1000;
+        Log(Session, "close", {
+            Seconds: Math.round(Seconds * 10) / 10,
+            Turns: Session.Turns,
+            UplinkBps: Seconds > 0 ? Math.round(Session.UplinkBytes / Seconds) : 0,
+            Down: `${Session.Down}`,
+            Up: `${Session.Up}`,
+            Rx: Session.Framing ? `${Session.Rx}` : "unframed",
+        });
+    };
+
+    Ws.onerror = (Err) => {
+        console.error(`[Mock ${Session.Id}] WebSocket error:`, Err);
+    };
+
+    Send(Session, JSON.stringify({ type: "ready", message: "Mock Mode Ready", defaultVoice: DefaultVoice }), false);
+}
+
+function HandleHttpRequest(Request: Request): Response {
+    const Path = new URL(Request.url).pathname;
+
+    if (Path === "/health" || Path === "/") {
+        return new Response(JSON.stringify({
+            Status: "ok",
+            Service: "Quil Mock Server",
+            ActiveSessions,
+            Turns: TotalTurns,
+            Refused,
+            Downlink: DownLink,
+            Uplink: UpLink,
+        }), { status: 200, headers: { "Content-Type": "application/json" } });
+    }
+
+    if (Path === "/ws" || Path === "/esp32") {
+        if (Request.headers.get("upgrade")?.toLowerCase() !== "websocket") {
+            return new Response("WebSocket upgrade required", { status: 426 });
+        }
+        if (RefuseLeft > 0) {
+            RefuseLeft--;
+            Refused++;
+            Log(null, "refused", { Left: RefuseLeft });
+            return new Response("Mock refusal", { status: 503 });
+        }
+        const { socket: Ws, response: UpgradeResponse } = Deno.upgradeWebSocket(Request);
+        Ws.onopen = () => HandleConnection(Ws);
+        return UpgradeResponse;
+    }
+
+    return new Response("Not Found", { status: 404 });
+}
+
+console.log(`Mock server on ws://0.0.0.0:${Port}/ws (rate ${SessionRate} Hz, response ${ToneResponse ? "tone" : "echo"}, pace ${RealtimePace ? "realtime" : "burst"})`);
+console.log(`Downlink ${JSON.stringify(DownLink)}, uplink ${JSON.stringify(UpLink)}`);
+Deno.serve({ hostname: "0.0.0.0", port: Port }, HandleHttpRequest);